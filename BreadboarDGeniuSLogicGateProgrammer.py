@@ -4,8 +4,14 @@
 import os
 import sys
 import platform
+import zlib
+import struct
+import logging
 import subprocess
+import threading
+import argparse
 import xml.etree.ElementTree as ET
+from concurrent.futures import ThreadPoolExecutor
 import tkinter as tk
 from tkinter import filedialog, messagebox, ttk
 from datetime import datetime
@@ -19,6 +25,26 @@ HEX_COUNTER = []   # List of {name, path}
 PROG_PY_PATH = ""
 COM_PORT = None
 LOG_FILENAME = ""
+LOG_LOCK = threading.Lock()   # batch workers finish concurrently
+
+# Flash size per MCU, used to reject a hex that cannot fit before any device is touched
+MCU_FLASH_SIZE = {"attiny1616": 16 * 1024, "atmega4809": 48 * 1024}
+FLASH_PAGE_SIZE = {"attiny1616": 64, "atmega4809": 128}
+# Signature bytes, checked when a UPDI session opens
+MCU_DEVICE_ID = {"attiny1616": "1E9421", "atmega4809": "1E9651"}
+
+# Fuses written with every image ({offset: value}), and compared on read-back
+TARGET_FUSES = {0: 0b00000000, 2: 0x01, 6: 0x04, 7: 0x00, 8: 0x00}
+
+# UPDI baud. Fast UPDI tries the fastest first and falls back; the rate that worked is kept per
+# port for the rest of the batch (a later session of the same job starts there).
+DEFAULT_BAUD = 57600
+UPDI_BAUDS = [460800, 345600, 230400, 115200, 57600]
+PORT_BAUD = {}
+
+# Smart programming: read back first, skip matching devices, rewrite only differing pages
+SMART_PROGRAM = False
+FAST_UPDI = False
 
 # --- Utility Functions ---
 def get_next_log_filename():
@@ -30,13 +56,15 @@ def get_next_log_filename():
         index += 1
 
 def load_config():
-    global PROG_PY_PATH, HEX_LOGIC, HEX_COUNTER
+    global PROG_PY_PATH, HEX_LOGIC, HEX_COUNTER, SMART_PROGRAM, FAST_UPDI
     if not os.path.exists(CONFIG_FILE):
         return
     tree = ET.parse(CONFIG_FILE)
     root = tree.getroot()
     
     PROG_PY_PATH = root.findtext("progPyPath", default="")
+    SMART_PROGRAM = root.findtext("smartProgram", default="0") == "1"
+    FAST_UPDI = root.findtext("fastUpdi", default="0") == "1"
 
     HEX_LOGIC.clear()
     for file in root.findall("LogicHexFiles/File"):
@@ -49,6 +77,8 @@ def load_config():
 def save_config():
     root = ET.Element("Configuration")
     ET.SubElement(root, "progPyPath").text = PROG_PY_PATH
+    ET.SubElement(root, "smartProgram").text = "1" if SMART_PROGRAM else "0"
+    ET.SubElement(root, "fastUpdi").text = "1" if FAST_UPDI else "0"
 
     logic_elem = ET.SubElement(root, "LogicHexFiles")
     for entry in HEX_LOGIC:
@@ -62,33 +92,529 @@ def save_config():
 
     ET.ElementTree(root).write(CONFIG_FILE)
 
-def detect_ch340_port():
+def detect_updi_ports():
+    # Every CH340/CH34x serial adapter attached, in a stable order
+    ports = []
     for port in list_ports.comports():
         if "CH340" in port.description or "CH34" in port.description:
-            return port.device
-    return None
+            ports.append(port.device)
+    return sorted(ports)
 
-def log_device_output(option_name, output):
+def detect_ch340_port():
+    ports = detect_updi_ports()
+    return ports[0] if ports else None
+
+def parse_device_info(output):
+    info = {"serial": "Not found", "devid": "Not found", "rev": "Not found", "famid": "Not found"}
+    for line in output.splitlines():
+        try:
+            if "Device serial number:" in line:
+                info["serial"] = line.split(":")[-1].strip()
+            elif "Device ID:" in line:
+                info["devid"] = line.split("'")[1]
+            elif "Device revision:" in line:
+                info["rev"] = line.split("'")[1]
+            elif "Device family ID:" in line:
+                info["famid"] = line.split("'")[1]
+        except IndexError:
+            pass
+    return info
+
+def format_device_line(info, option_name):
+    return f"Device family ID: {info['famid']}, Device ID: {info['devid']}, Device serial number: {info['serial']}, Device revision: {info['rev']}, {option_name}"
+
+def write_log_lines(lines):
     global LOG_FILENAME
-    if not LOG_FILENAME:
-        LOG_FILENAME = get_next_log_filename()
-
-    lines = output.splitlines()
-    serial = rev = famid = devid = "Not found"
-    for line in lines:
-        if "Device serial number:" in line:
-            serial = line.split(":")[-1].strip()
-        elif "Device ID:" in line:
-            devid = line.split("'")[1]
-        elif "Device revision:" in line:
-            rev = line.split("'")[1]
-        elif "Device family ID:" in line:
-            famid = line.split("'")[1]
-
-    with open(LOG_FILENAME, "a") as f:
-        f.write(f"Device family ID: {famid}, Device ID: {devid}, Device serial number: {serial}, Device revision: {rev}, {option_name}\n")
+    with LOG_LOCK:
+        if not LOG_FILENAME:
+            LOG_FILENAME = get_next_log_filename()
+        with open(LOG_FILENAME, "a") as f:
+            for line in lines:
+                f.write(line + "\n")
+
+def log_device_output(option_name, output):
+    write_log_lines([format_device_line(parse_device_info(output), option_name)])
+
+# --- Hex Files ---
+HEX_CACHE = {}   # path -> HexImage, reparsed only if the file changes
+
+class HexImage:
+    def __init__(self, path, data, size):
+        self.path = path
+        self.data = data    # bytearray from address 0, unused bytes 0xFF
+        self.size = size    # highest used address + 1
+        self.crc = zlib.crc32(bytes(data[:size])) & 0xFFFFFFFF
+
+def parse_hex(path):
+    # Intel HEX: data (00), EOF (01), extended segment (02) and linear (04) address records
+    data = bytearray()
+    size = 0
+    base = 0
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.strip()
+            if not line:
+                continue
+            if not line.startswith(":"):
+                raise ValueError(f"{os.path.basename(path)}:{lineno}: not an Intel HEX record")
+            rec = bytes.fromhex(line[1:])
+            if len(rec) < 5 or len(rec) != rec[0] + 5 or sum(rec) & 0xFF:
+                raise ValueError(f"{os.path.basename(path)}:{lineno}: bad record length or checksum")
+            count, addr, rtype, payload = rec[0], (rec[1] << 8) | rec[2], rec[3], rec[4:-1]
+            if rtype == 0x00:
+                start = base + addr
+                end = start + count
+                if end > len(data):
+                    data.extend(b"\xFF" * (end - len(data)))
+                data[start:end] = payload
+                size = max(size, end)
+            elif rtype == 0x01:
+                break
+            elif rtype == 0x02:
+                base = ((payload[0] << 8) | payload[1]) << 4
+            elif rtype == 0x04:
+                base = ((payload[0] << 8) | payload[1]) << 16
+    return HexImage(path, data, size)
+
+def load_hex(path, mcu=None):
+    key = os.path.abspath(path)
+    mtime = os.path.getmtime(key)
+    cached = HEX_CACHE.get(key)
+    if cached is None or cached[0] != mtime:
+        cached = (mtime, parse_hex(key))
+        HEX_CACHE[key] = cached
+    image = cached[1]
+    limit = MCU_FLASH_SIZE.get(mcu)
+    if limit and image.size > limit:
+        raise ValueError(f"{os.path.basename(path)} needs {image.size} bytes, {mcu} has {limit}")
+    return image
 
 # --- Command Execution ---
+def fuse_args():
+    return [f"{offset}:0x{value:02X}" for offset, value in sorted(TARGET_FUSES.items())]
+
+def build_prog_command(hex_path, mcu, port, baud=DEFAULT_BAUD):
+    return [
+        sys.executable, PROG_PY_PATH,
+        "-t", "uart", "-u", port,
+        "-b", str(baud), "-d", mcu,
+        "--fuses", *fuse_args(),
+        "-f", hex_path,
+        "-a", "write", "-v",
+    ]
+
+def baud_candidates(port):
+    # Fast UPDI: start at the last rate that worked on this port, then step down
+    if not FAST_UPDI:
+        return [DEFAULT_BAUD]
+    known = PORT_BAUD.get(port)
+    return [b for b in UPDI_BAUDS if known is None or b <= known]
+
+def flash_device(hex_path, mcu, port, line_callback):
+    # prog.py on one port, retried at lower bauds if UPDI does not come up. Returns (returncode, full output).
+    output = ""
+    for baud in baud_candidates(port):
+        if FAST_UPDI:
+            line_callback(f"UPDI at {baud} baud\n")
+        proc = subprocess.Popen(build_prog_command(hex_path, mcu, port, baud), stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+        output = ""
+        for line in proc.stdout:
+            output += line
+            line_callback(line)
+        proc.wait()
+        if "UPDI init failed" not in output:
+            PORT_BAUD[port] = baud
+            break
+    return proc.returncode, output
+
+def classify_result(returncode, output, mcu, action="full"):
+    # (ok, message) from the prog.py exit code and the lines it prints
+    if "UPDI init failed" in output:
+        return False, "UPDI Failed. Reseat the device."
+    if "Device ID mismatch" in output:
+        return False, f"Device ID mismatch. Expected device for MCU {mcu}."
+    if returncode == 0:
+        return True, {"skipped": "Already up to date", "pages": "Changed pages programmed",
+                      "fuses": "Fuses programmed", "pages+fuses": "Changed pages and fuses programmed",
+                      "config": "Function set"}.get(action, "Programming successful")
+    return False, "Programming failed"
+
+# --- Read-back / Differential Programming ---
+# Talks UPDI directly through pymcuprog, the library prog.py is built on (megaTinyCore ships it
+# in tools/libs next to prog.py; a pip install works too). Changed pages are rewritten with the
+# NVM page erase-write command, so EEPROM and the unchanged pages stay as they are, and the whole
+# flash is read back against the image afterwards. If pymcuprog gives no NVM access, or a read,
+# write or verify fails, the device gets a full write (chip erase, which clears EEPROM too).
+def import_pymcuprog():
+    libs = os.path.join(os.path.dirname(os.path.abspath(PROG_PY_PATH)), "libs")
+    if os.path.isdir(libs) and libs not in sys.path:
+        sys.path.insert(0, libs)
+    from pymcuprog.backend import Backend, SessionConfig
+    from pymcuprog.toolconnection import ToolSerialConnection
+    return Backend, SessionConfig, ToolSerialConnection
+
+class DeviceInfoLines(logging.Handler):
+    # pymcuprog logs "Device family ID/ID/revision/serial number" lines as it starts a session,
+    # the same lines prog.py prints. Each goes to the session opening on the logging thread
+    # (batch sessions run in parallel). One handler, installed once: Logger.handlers is a plain
+    # list, and removing one session's handler while another thread logs can make it skip its own.
+    def __init__(self):
+        super().__init__(logging.INFO)
+        self.sinks = {}   # thread id -> [say, seen]
+
+    def watch(self, say):
+        self.sinks[threading.get_ident()] = sink = [say, False]
+        return sink
+
+    def unwatch(self):
+        self.sinks.pop(threading.get_ident(), None)
+
+    def emit(self, record):
+        sink = self.sinks.get(record.thread)
+        message = record.getMessage()
+        if sink and message.startswith("Device "):
+            sink[1] = True
+            sink[0](message + "\n")
+
+DEVICE_INFO_LINES = DeviceInfoLines()
+logging.getLogger("pymcuprog").addHandler(DEVICE_INFO_LINES)
+
+class DeviceMismatch(Exception):
+    # Another chip answered: final, a lower baud or a full write would not change it
+    pass
+
+class UpdiSession:
+    def __init__(self, port, mcu, baud):
+        self.port, self.mcu, self.baud = port, mcu, baud
+        self.backend = None
+
+    def open(self, say=None):
+        Backend, SessionConfig, ToolSerialConnection = import_pymcuprog()
+        self.backend = Backend()
+        self.backend.connect_to_tool(ToolSerialConnection(serialport=self.port, baudrate=self.baud))
+        logger = logging.getLogger("pymcuprog")
+        if logger.level == logging.NOTSET or logger.level > logging.INFO:
+            logger.setLevel(logging.INFO)
+        lines = DEVICE_INFO_LINES.watch(say or (lambda line: None))
+        try:
+            self.backend.start_session(SessionConfig(self.mcu))
+        except Exception as e:
+            self.backend.disconnect_from_tool()
+            if "mismatch" in str(e).lower():
+                raise DeviceMismatch(str(e)) from e
+            raise
+        finally:
+            DEVICE_INFO_LINES.unwatch()
+        device_id = self.device_id()
+        if say and not lines[1]:
+            say(f"Device ID: '{device_id}'\n")
+        if device_id != MCU_DEVICE_ID.get(self.mcu, device_id):
+            self.__exit__()
+            raise DeviceMismatch(f"{device_id}, expected {self.mcu}")
+        return self
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        try:
+            self.backend.end_session()
+        finally:
+            self.backend.disconnect_from_tool()
+
+    def device_id(self):
+        return bytes(self.backend.read_device_id()).hex().upper()
+
+    def read(self, memory, offset, numbytes):
+        return bytes(self.backend.read_memory(memory_name=memory, offset_byte=offset, numbytes=numbytes)[0].data)
+
+    def page_writer(self):
+        # write(offset, data) for one flash page, by NVMCTRL ERASE_WRITE_PAGE (tinyAVR 0/1/2 and
+        # megaAVR 0 NVM). Not backend.erase(): on Serial UPDI that is always a chip erase.
+        from pymcuprog.serialupdi import constants
+        nvm = self.backend.programmer.device_model.avr.nvm
+        base = self.backend.device_memory_info.memory_info_by_name("flash")["address"]
+
+        def write(offset, data):
+            nvm.write_nvm(base + offset, bytearray(data), use_word_access=True,
+                          nvmcommand=constants.UPDI_V0_NVMCTRL_CTRLA_ERASE_WRITE_PAGE)
+        return write
+
+    def write_fuses(self):
+        for offset, value in sorted(TARGET_FUSES.items()):
+            self.backend.write_memory(data=bytearray([value]), memory_name="fuses", offset_byte=offset)
+
+    def fuses_match(self):
+        fuses = self.read("fuses", 0, max(TARGET_FUSES) + 1)
+        return all(fuses[o] == v for o, v in TARGET_FUSES.items())
+
+    def write_image(self, target, used):
+        # What prog.py -a write does: chip erase (flash and EEPROM), flash, fuses, then verify
+        self.backend.erase()
+        self.backend.write_memory(data=bytearray(target[:used]), memory_name="flash", offset_byte=0)
+        self.write_fuses()
+        return self.read("flash", 0, len(target)) == target and self.fuses_match()
+
+def open_updi_session(port, mcu, line_callback):
+    last_error = None
+    for baud in baud_candidates(port):
+        try:
+            session = UpdiSession(port, mcu, baud).open(line_callback)
+            PORT_BAUD[port] = baud
+            line_callback(f"UPDI session at {baud} baud\n")
+            return session
+        except (ImportError, DeviceMismatch):
+            raise
+        except Exception as e:
+            last_error = e
+    raise last_error
+
+def diff_pages(current, target, page_size):
+    return [a for a in range(0, len(target), page_size) if current[a:a + page_size] != target[a:a + page_size]]
+
+def flash_target(image, mcu):
+    # Whole flash as it should read back: the image, erased (0xFF) above it
+    return bytes(image.data[:image.size]) + b"\xFF" * (MCU_FLASH_SIZE[mcu] - image.size)
+
+def full_write(image, mcu, port, line_callback):
+    # The already parsed image through a UPDI session; prog.py with the .hex file only when
+    # pymcuprog is missing. Returns (returncode, output).
+    output = ""
+
+    def say(line):
+        nonlocal output
+        output += line
+        line_callback(line)
+
+    try:
+        session = open_updi_session(port, mcu, say)
+    except ImportError:
+        returncode, prog_output = flash_device(image.path, mcu, port, line_callback)
+        return returncode, output + prog_output
+    except DeviceMismatch as e:
+        say(f"Device ID mismatch ({e})\n")
+        return 1, output
+    except Exception as e:
+        say(f"UPDI init failed ({e})\n")
+        return 1, output
+    try:
+        with session:
+            ok = session.write_image(flash_target(image, mcu), image.size)
+    except Exception as e:
+        say(f"Write failed ({e})\n")
+        return 1, output
+    say(f"Flash CRC32 {image.crc:08X}, {image.size} bytes written, {'verified' if ok else 'VERIFY FAILED'}\n")
+    return (0 if ok else 1), output
+
+def smart_program(hex_path, mcu, port, line_callback):
+    # Returns (returncode, output, action) with action "skipped", "pages", "fuses", "pages+fuses" or "full"
+    image = load_hex(hex_path, mcu)
+    flash_size = MCU_FLASH_SIZE[mcu]
+    page_size = FLASH_PAGE_SIZE[mcu]
+    target = flash_target(image, mcu)
+    output = ""
+
+    def say(line):
+        nonlocal output
+        output += line
+        line_callback(line)
+
+    try:
+        session = open_updi_session(port, mcu, say)
+    except ImportError:
+        say("pymcuprog not found next to prog.py, full write\n")
+        return (*full_write(image, mcu, port, line_callback), "full")
+    except DeviceMismatch as e:
+        say(f"Device ID mismatch ({e})\n")
+        return 1, output, "full"
+    except Exception as e:
+        say(f"Read-back failed ({e}), full write\n")
+        return (*full_write(image, mcu, port, line_callback), "full")
+
+    try:
+        with session:
+            fuses_ok = session.fuses_match()
+            pages = diff_pages(session.read("flash", 0, flash_size), target, page_size)
+            say(f"Flash CRC32 target {image.crc:08X}, {len(pages)} page(s) differ, fuses {'match' if fuses_ok else 'differ'}\n")
+            if not pages and fuses_ok:
+                return 0, output, "skipped"
+            if pages:
+                write_page = session.page_writer()
+                for a in pages:
+                    write_page(a, target[a:a + page_size])
+                # Whole flash, not just the pages written
+                readback = session.read("flash", 0, flash_size)
+                say(f"Flash CRC32 read back {zlib.crc32(readback[:image.size]) & 0xFFFFFFFF:08X}\n")
+                if readback != target:
+                    bad = diff_pages(readback, target, page_size)
+                    say(f"{len(bad)} page(s) failed verify, full write\n")
+                    return (*full_write(image, mcu, port, line_callback), "full")
+            if not fuses_ok:
+                session.write_fuses()
+                if not session.fuses_match():
+                    say("Fuse verify failed\n")
+                    return 1, output, "fuses"
+    except Exception as e:
+        say(f"Differential write failed ({e}), full write\n")
+        return (*full_write(image, mcu, port, line_callback), "full")
+
+    if fuses_ok:
+        return 0, output, "pages"
+    return 0, output, "pages+fuses" if pages else "fuses"
+
+# --- Gate Function (config record) ---
+# Mirrors ConfigRecord in "Universal Logic Gate.cpp": 16 bytes at EEPROM offset EE_CONFIG,
+# read by the firmware at boot. Writing it re-tasks a module without touching flash.
+CONFIG_EEPROM_OFFSET = 16
+CONFIG_MAGIC = 0x47
+CONFIG_VERSION = 1
+
+# GateFamily enum order
+GATE_FAMILIES = ["AND/NAND", "OR/NOR", "XOR/XNOR", "MAJ/MIN", "Dual NOT", "USER",
+                 "D latch", "D FF", "JK FF", "T FF"]
+
+# FILT_PRESETS in the firmware (the same choices as the OLED filter page)
+FILTER_PRESETS = {"RAW": 0x00, "2/3": 0x53, "3/5": 0x5D, "5/7": 0x6F,
+                  "INT 2ms": 0x88, "INT 10ms": 0xA8, "TMR 1ms": 0xC4, "TMR 5ms": 0xD4}
+DEFAULT_FILTER = "2/3"
+
+def crc16(data):
+    # avr-libc _crc16_update, init 0xFFFF
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+def build_config_record(family, filters=None, brightness=255, tt_y=0x0000, tt_yb=0xFFFF):
+    filters = filters or [DEFAULT_FILTER] * 4
+    if family not in GATE_FAMILIES:
+        raise ValueError(f"Unknown gate family {family}")
+    if len(filters) != 4 or any(f not in FILTER_PRESETS for f in filters):
+        raise ValueError("Need 4 row filters from: " + ", ".join(FILTER_PRESETS))
+    if not 0 <= brightness <= 255 or not 0 <= tt_y <= 0xFFFF or not 0 <= tt_yb <= 0xFFFF:
+        raise ValueError("Brightness is 0..255, truth tables 0x0000..0xFFFF")
+    body = bytes([CONFIG_MAGIC, CONFIG_VERSION, GATE_FAMILIES.index(family)]
+                 + [FILTER_PRESETS[f] for f in filters]
+                 + [brightness, tt_y & 0xFF, tt_y >> 8, tt_yb & 0xFF, tt_yb >> 8, 0xFF, 0xFF])
+    crc = crc16(body)
+    return body + bytes([crc & 0xFF, crc >> 8])
+
+def describe_config_record(record):
+    family = GATE_FAMILIES[record[2]] if record[2] < len(GATE_FAMILIES) else str(record[2])
+    names = {v: k for k, v in FILTER_PRESETS.items()}
+    filters = "/".join(names.get(b, f"0x{b:02X}") for b in record[3:7])
+    return f"{family}, filters {filters}, brightness {record[7]}, USER Y=0x{record[8] | record[9] << 8:04X} /Y=0x{record[10] | record[11] << 8:04X}"
+
+def write_config_record(record, port, line_callback):
+    # EEPROM-only write + read-back over UPDI. Returns (returncode, output, action).
+    output = ""
+
+    def say(line):
+        nonlocal output
+        output += line
+        line_callback(line)
+
+    try:
+        with open_updi_session(port, "attiny1616", say) as session:
+            if session.read("eeprom", CONFIG_EEPROM_OFFSET, len(record)) == record:
+                say("Function already set\n")
+                return 0, output, "skipped"
+            session.backend.write_memory(data=bytearray(record), memory_name="eeprom", offset_byte=CONFIG_EEPROM_OFFSET)
+            if session.read("eeprom", CONFIG_EEPROM_OFFSET, len(record)) != record:
+                say("EEPROM verify failed\n")
+                return 1, output, "config"
+    except ImportError:
+        say("Set function needs pymcuprog (megaTinyCore tools/libs next to prog.py, or pip install pymcuprog)\n")
+        return 1, output, "config"
+    except DeviceMismatch as e:
+        say(f"Device ID mismatch ({e})\n")
+        return 1, output, "config"
+    except Exception as e:
+        say(f"UPDI init failed ({e})\n")
+        return 1, output, "config"
+    say("Function set: " + describe_config_record(record) + "\n")
+    return 0, output, "config"
+
+# --- Capture dump (Universal firmware, CAPTURE 1) ---
+# g_cap lives in SRAM: "CAP1", depth, head, count, running, tickHz (u32), then depth events of
+# lo (u16), hi (u16), state (u8). state bit0..3 = rows 1..4, bit4 = Y, bit5 = /Y.
+# Reading SRAM over UPDI doesn't stop the firmware, so HOLD the capture first for a clean copy.
+CAPTURE_MAGIC = b"CAP1"
+CAPTURE_HEADER = struct.Struct("<4sBBBBI")
+CAPTURE_EVENT = struct.Struct("<HHB")
+SRAM_SIZE = {"attiny1616": 2048, "atmega4809": 6144}
+CAPTURE_SIGNALS = ["row1", "row2", "row3", "row4", "Y", "nY"]
+
+def parse_capture(sram):
+    # Returns (tick_hz, running, [(ticks, state), ...] oldest first)
+    at = sram.find(CAPTURE_MAGIC)
+    if at < 0:
+        raise ValueError("no capture buffer in SRAM (firmware built without CAPTURE?)")
+    magic, depth, head, count, running, tick_hz = CAPTURE_HEADER.unpack_from(sram, at)
+    if depth == 0 or depth & (depth - 1) or count > depth or head >= depth or not tick_hz:
+        raise ValueError("capture header looks corrupt")
+    base = at + CAPTURE_HEADER.size
+    events = []
+    for n in range(count):
+        i = (head - count + n) % depth
+        lo, hi, state = CAPTURE_EVENT.unpack_from(sram, base + i * CAPTURE_EVENT.size)
+        events.append(((hi << 16) | lo, state))
+    return tick_hz, running, events
+
+def write_vcd(path, tick_hz, events):
+    # Time unit 1 ns, first event at t=0
+    ids = [chr(ord("!") + i) for i in range(len(CAPTURE_SIGNALS))]
+    t0 = events[0][0] if events else 0
+    with open(path, "w") as f:
+        f.write(f"$date {datetime.now():%Y-%m-%d %H:%M:%S} $end\n")
+        f.write("$version BreadboarD GeniuS capture $end\n$timescale 1ns $end\n$scope module gate $end\n")
+        for sig, ident in zip(CAPTURE_SIGNALS, ids):
+            f.write(f"$var wire 1 {ident} {sig} $end\n")
+        f.write("$upscope $end\n$enddefinitions $end\n")
+        last = None
+        for ticks, state in events:
+            changed = [b for b in range(len(ids)) if last is None or (state ^ last) >> b & 1]
+            if not changed:
+                continue
+            f.write(f"#{((ticks - t0) & 0xFFFFFFFF) * 1000000000 // tick_hz}\n")
+            for b in changed:
+                f.write(f"{state >> b & 1}{ids[b]}\n")
+            last = state
+
+def dump_capture(vcd_path, mcu, port, line_callback):
+    # Returns (returncode, output)
+    output = ""
+
+    def say(line):
+        nonlocal output
+        output += line
+        line_callback(line)
+
+    try:
+        with open_updi_session(port, mcu, say) as session:
+            sram = session.read("internal_sram", 0, SRAM_SIZE[mcu])
+        tick_hz, running, events = parse_capture(sram)
+    except ImportError:
+        say("Capture dump needs pymcuprog (megaTinyCore tools/libs next to prog.py, or pip install pymcuprog)\n")
+        return 1, output
+    except Exception as e:
+        say(f"Capture read failed ({e})\n")
+        return 1, output
+    if not running and not events:
+        say("Capture is not armed (open the CAP page, or build with CAPTURE_AT_BOOT 1)\n")
+    write_vcd(vcd_path, tick_hz, events)
+    span_us = (events[-1][0] - events[0][0]) * 1000000 // tick_hz if events else 0
+    say(f"{len(events)} events over {span_us} us ({'RUN' if running else 'HOLD'}) -> {vcd_path}\n")
+    return 0, output
+
+def program_device(hex_path, mcu, port, line_callback):
+    # Returns (returncode, output, action)
+    if SMART_PROGRAM:
+        return smart_program(hex_path, mcu, port, line_callback)
+    return (*full_write(load_hex(hex_path, mcu), mcu, port, line_callback), "full")
+
 def run_prog_py(hex_path, mcu, console_output_callback):
     global PROG_PY_PATH, COM_PORT
     if not PROG_PY_PATH or not os.path.exists(PROG_PY_PATH):
@@ -99,36 +625,90 @@ def run_prog_py(hex_path, mcu, console_output_callback):
         messagebox.showerror("Error", "CH340 COM port not detected")
         return
 
-    command = [
-        sys.executable, PROG_PY_PATH,
-        "-t", "uart", "-u", COM_PORT,
-        "-b", "57600", "-d", mcu,
-        "--fuses", "0:0b00000000", "2:0x01", "6:0x04", "7:0x00", "8:0x00",
-        "-f", hex_path, "-a", "write", "-v"
-    ]
-
     try:
-        proc = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
-        output = ""
-        for line in proc.stdout:
-            output += line
-            console_output_callback(line)
-        proc.wait()
+        load_hex(hex_path, mcu)
+        PORT_BAUD.clear()
+        returncode, output, action = program_device(hex_path, mcu, COM_PORT, console_output_callback)
 
         log_device_output(os.path.basename(hex_path), output)
 
-        if "UPDI init failed" in output:
-            messagebox.showerror("Error", "UPDI Failed. Reseat the device.")
-        elif "Device ID mismatch" in output:
-            messagebox.showerror("Error", f"Device ID mismatch. Expected device for MCU {mcu}.")
-        elif proc.returncode == 0:
-            messagebox.showinfo("Success", "Programming successful")
+        ok, message = classify_result(returncode, output, mcu, action)
+        if ok:
+            messagebox.showinfo("Success", message)
         else:
-            messagebox.showerror("Error", "Programming failed")
+            messagebox.showerror("Error", message)
 
     except Exception as e:
         messagebox.showerror("Exception", str(e))
 
+# --- Batch Programming ---
+# One worker per attached adapter, all running the same job at once.
+# The hex is parsed and checked once up front (HEX_CACHE); each worker writes that image through
+# its own UPDI session, and only runs prog.py on the .hex file when pymcuprog is missing.
+# Results are written to the log as one block, one line per device, in port order.
+def run_parallel(option_name, header, mcu, ports, line_callback, job):
+    # job(port, line_callback) -> (returncode, output, action)
+    PORT_BAUD.clear()   # adapters may have been swapped since the last batch
+    def worker(port):
+        started = datetime.now()
+        try:
+            returncode, output, action = job(port, lambda line: line_callback(f"[{port}] {line}"))
+            ok, message = classify_result(returncode, output, mcu, action)
+        except Exception as e:
+            output, ok, message = "", False, str(e)
+        seconds = (datetime.now() - started).total_seconds()
+        return {"port": port, "ok": ok, "message": message, "seconds": seconds, "info": parse_device_info(output)}
+
+    with ThreadPoolExecutor(max_workers=max(1, len(ports))) as pool:
+        results = list(pool.map(worker, ports))
+
+    passed = sum(r["ok"] for r in results)
+    lines = [f"--- Batch {datetime.now():%Y-%m-%d %H:%M:%S}, {option_name} ({header}), {passed}/{len(results)} OK"]
+    for r in results:
+        status = r["message"] if r["ok"] else "FAIL: " + r["message"]
+        lines.append(f"{r['port']}, {format_device_line(r['info'], option_name)}, {status}, {r['seconds']:.1f}s")
+    write_log_lines(lines)
+    return results
+
+def run_batch(hex_path, mcu, ports, line_callback):
+    image = load_hex(hex_path, mcu)
+    return run_parallel(os.path.basename(hex_path), f"CRC32 {image.crc:08X}, {image.size} bytes", mcu, ports, line_callback,
+                        lambda port, cb: program_device(hex_path, mcu, port, cb))
+
+def run_set_function(record, ports, line_callback):
+    return run_parallel("Set function", describe_config_record(record), "attiny1616", ports, line_callback,
+                        lambda port, cb: write_config_record(record, port, cb))
+
+def run_batch_gui(root, hex_path, mcu, console_output_callback, ports=None, job=None):
+    # Runs the batch off the Tk thread; console and dialogs are marshalled back with after()
+    # job(ports, line_callback) replaces the default hex batch (used by Set function).
+    if not job and (not PROG_PY_PATH or not os.path.exists(PROG_PY_PATH)):
+        messagebox.showerror("Error", "prog.py path not set or missing")
+        return
+    ports = ports or detect_updi_ports()
+    if not ports:
+        messagebox.showerror("Error", "No CH340 COM ports detected")
+        return
+    job = job or (lambda ports, cb: run_batch(hex_path, mcu, ports, cb))
+
+    def report(results):
+        failed = [r for r in results if not r["ok"]]
+        summary = f"{len(results) - len(failed)}/{len(results)} devices programmed"
+        if failed:
+            messagebox.showerror("Batch", summary + "\n\n" + "\n".join(f"{r['port']}: {r['message']}" for r in failed))
+        else:
+            messagebox.showinfo("Batch", summary)
+
+    def task():
+        try:
+            results = job(ports, lambda line: root.after(0, console_output_callback, line))
+            root.after(0, report, results)
+        except Exception as e:
+            root.after(0, messagebox.showerror, "Exception", str(e))
+
+    console_output_callback(f"Batch: {os.path.basename(hex_path) if hex_path else 'Set function'} on {', '.join(ports)}\n")
+    threading.Thread(target=task, daemon=True).start()
+
 # --- GUI Setup ---
 def create_main_gui():
     global COM_PORT
@@ -144,6 +724,19 @@ def create_main_gui():
 
     com_label = tk.Label(top_frame, text=f"COM Port: {COM_PORT if COM_PORT else 'Not found'}")
     com_label.pack(side="left")
+    batch_label = tk.Label(top_frame, text=f"Batch ports: {', '.join(detect_updi_ports()) or 'None'}")
+    batch_label.pack(side="left", padx=20)
+
+    def set_option(name, var):
+        globals()[name] = bool(var.get())
+        save_config()
+
+    smart_var = tk.IntVar(value=int(SMART_PROGRAM))
+    tk.Checkbutton(top_frame, text="Smart (skip identical / changed pages only)", variable=smart_var,
+                   command=lambda: set_option("SMART_PROGRAM", smart_var)).pack(side="left", padx=10)
+    fast_var = tk.IntVar(value=int(FAST_UPDI))
+    tk.Checkbutton(top_frame, text="Fast UPDI (auto baud)", variable=fast_var,
+                   command=lambda: set_option("FAST_UPDI", fast_var)).pack(side="left", padx=10)
 
     def update_console(text):
         console.insert("end", text)
@@ -170,10 +763,50 @@ def create_main_gui():
             frame.pack(fill="x", pady=2)
             btn = tk.Button(frame, text=entry["name"], command=lambda e=entry: run_prog_py(e["path"], mcu, update_console))
             btn.pack(side="left")
+            batch = tk.Button(frame, text="Batch", command=lambda e=entry: run_batch_gui(root, e["path"], mcu, update_console))
+            batch.pack(side="left", padx=5)
             rmv = tk.Button(frame, text="X", fg="red", command=lambda e=entry: (hex_list.remove(e), save_config(), root.destroy(), create_main_gui()))
             rmv.pack(side="right")
         tk.Button(parent, text="Add HEX", command=lambda: add_hex_file("logic" if mcu == "attiny1616" else "counter")).pack(pady=5)
 
+    def open_set_function():
+        # Family, filters, brightness and USER tables -> config record in EEPROM (no reflash)
+        dlg = tk.Toplevel(root)
+        dlg.title("Set function (ATtiny1616, Universal firmware)")
+        family_var = tk.StringVar(value=GATE_FAMILIES[0])
+        tk.Label(dlg, text="Gate family").grid(row=0, column=0, sticky="w", padx=5, pady=2)
+        ttk.Combobox(dlg, textvariable=family_var, values=GATE_FAMILIES, state="readonly").grid(row=0, column=1, padx=5, pady=2)
+        filter_vars = []
+        for r in range(4):
+            var = tk.StringVar(value=DEFAULT_FILTER)
+            tk.Label(dlg, text=f"Row {r + 1} filter").grid(row=1 + r, column=0, sticky="w", padx=5, pady=2)
+            ttk.Combobox(dlg, textvariable=var, values=list(FILTER_PRESETS), state="readonly").grid(row=1 + r, column=1, padx=5, pady=2)
+            filter_vars.append(var)
+        bright_var = tk.IntVar(value=255)
+        tk.Label(dlg, text="LED brightness").grid(row=5, column=0, sticky="w", padx=5, pady=2)
+        tk.Scale(dlg, from_=0, to=255, orient="horizontal", variable=bright_var).grid(row=5, column=1, padx=5, pady=2)
+        tt_y_var, tt_yb_var = tk.StringVar(value="0x0000"), tk.StringVar(value="0xFFFF")
+        tk.Label(dlg, text="USER truth table Y").grid(row=6, column=0, sticky="w", padx=5, pady=2)
+        tk.Entry(dlg, textvariable=tt_y_var).grid(row=6, column=1, padx=5, pady=2)
+        tk.Label(dlg, text="USER truth table /Y").grid(row=7, column=0, sticky="w", padx=5, pady=2)
+        tk.Entry(dlg, textvariable=tt_yb_var).grid(row=7, column=1, padx=5, pady=2)
+
+        def write(all_ports):
+            try:
+                record = build_config_record(family_var.get(), [v.get() for v in filter_vars], bright_var.get(),
+                                             int(tt_y_var.get(), 0), int(tt_yb_var.get(), 0))
+            except ValueError as e:
+                messagebox.showerror("Error", str(e))
+                return
+            ports = detect_updi_ports() if all_ports else ([COM_PORT] if COM_PORT else [])
+            run_batch_gui(root, None, "attiny1616", update_console, ports,
+                          lambda ports, cb: run_set_function(record, ports, cb))
+
+        tk.Button(dlg, text="Write", command=lambda: write(False)).grid(row=8, column=0, pady=5)
+        tk.Button(dlg, text="Write to all ports", command=lambda: write(True)).grid(row=8, column=1, pady=5)
+
+    tk.Button(top_frame, text="Set function", command=open_set_function).pack(side="right")
+
     content = tk.Frame(root)
     content.pack(fill="both", expand=True, padx=10, pady=5)
 
@@ -190,5 +823,56 @@ def create_main_gui():
 
     root.mainloop()
 
+# --- Command Line ---
+# Headless batch, e.g. for a bench script or a local stand-in prog.py:
+#   python BreadboarDGeniuSLogicGateProgrammer.py --batch and-nand.hex --mcu attiny1616 [--ports COM3 COM4] [--prog prog.py] [--smart] [--fast]
+#   python BreadboarDGeniuSLogicGateProgrammer.py --set-function "OR/NOR" [--filters RAW RAW 2/3 2/3] [--brightness 128] [--ports ...]
+#   python BreadboarDGeniuSLogicGateProgrammer.py --dump-capture trace.vcd [--ports COM3]
+def main_cli(argv):
+    global PROG_PY_PATH, SMART_PROGRAM, FAST_UPDI
+    parser = argparse.ArgumentParser(description="BreadboarD GeniuS Programmer")
+    parser.add_argument("--batch", metavar="HEX", help="flash HEX on every attached adapter in parallel")
+    parser.add_argument("--mcu", default="attiny1616", choices=sorted(MCU_FLASH_SIZE))
+    parser.add_argument("--ports", nargs="+", help="ports to use instead of auto-detected CH340 adapters")
+    parser.add_argument("--prog", help="prog.py to run instead of the configured one")
+    parser.add_argument("--smart", action="store_true", help="read back first: skip identical devices, write only changed pages")
+    parser.add_argument("--fast", action="store_true", help="highest UPDI baud the adapter manages, with fallback")
+    parser.add_argument("--set-function", metavar="FAMILY", choices=GATE_FAMILIES, help="write only the config record (Universal firmware)")
+    parser.add_argument("--filters", nargs=4, choices=list(FILTER_PRESETS), help="row 1..4 input filters for --set-function")
+    parser.add_argument("--brightness", type=int, default=255, help="LED brightness 0..255 for --set-function")
+    parser.add_argument("--tt-y", type=lambda v: int(v, 0), default=0x0000, help="USER truth table for Y")
+    parser.add_argument("--tt-yb", type=lambda v: int(v, 0), default=0xFFFF, help="USER truth table for /Y")
+    parser.add_argument("--dump-capture", metavar="VCD", help="read the Universal firmware's capture buffer (first port) into a VCD file")
+    args = parser.parse_args(argv)
+    if not args.batch and not args.set_function and not args.dump_capture:
+        create_main_gui()
+        return 0
+
+    load_config()
+    if args.prog:
+        PROG_PY_PATH = args.prog
+    SMART_PROGRAM = SMART_PROGRAM or args.smart
+    FAST_UPDI = FAST_UPDI or args.fast
+    if not PROG_PY_PATH or not os.path.exists(PROG_PY_PATH):
+        print("prog.py path not set or missing")
+        return 1
+    ports = args.ports or detect_updi_ports()
+    if not ports:
+        print("No CH340 COM ports detected")
+        return 1
+
+    echo = lambda line: print(line, end="", flush=True)
+    if args.dump_capture:
+        return dump_capture(args.dump_capture, args.mcu, ports[0], echo)[0]
+    if args.set_function:
+        record = build_config_record(args.set_function, args.filters, args.brightness, args.tt_y, args.tt_yb)
+        results = run_set_function(record, ports, echo)
+    else:
+        results = run_batch(args.batch, args.mcu, ports, echo)
+    for r in results:
+        print(f"{r['port']}: {'OK' if r['ok'] else 'FAIL'} - {r['message']} ({r['seconds']:.1f}s)")
+    print(f"Log: {LOG_FILENAME}")
+    return 0 if all(r["ok"] for r in results) else 1
+
 if __name__ == "__main__":
-    create_main_gui()
+    sys.exit(main_cli(sys.argv[1:]))
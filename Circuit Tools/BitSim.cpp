@@ -0,0 +1,271 @@
+#include "BitSim.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace gatesim {
+
+namespace {
+
+// Lane i of LANE_PATTERN[k] = bit k of i: the first six inputs of an exhaustive run.
+const uint64_t LANE_PATTERN[6] = {
+  0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+  0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL };
+
+inline uint64_t mux(uint64_t s, uint64_t x0, uint64_t x1) { return x0 ^ (s & (x0 ^ x1)); }
+
+// Any function of two inputs. q bit j = output for a = bit 0 of j, b = bit 1 of j.
+inline uint64_t lut2(uint8_t q, uint64_t a, uint64_t b) {
+  switch (q & 15) {
+    case 0:  return 0;
+    case 1:  return ~(a | b);
+    case 2:  return a & ~b;
+    case 3:  return ~b;
+    case 4:  return ~a & b;
+    case 5:  return ~a;
+    case 6:  return a ^ b;
+    case 7:  return ~(a & b);
+    case 8:  return a & b;
+    case 9:  return ~(a ^ b);
+    case 10: return a;
+    case 11: return a | ~b;
+    case 12: return b;
+    case 13: return ~a | b;
+    case 14: return a | b;
+    default: return ~0ULL;
+  }
+}
+
+// A 16-entry truth table as four LUT2s on rows 1/2, picked by rows 3/4.
+inline uint64_t lut4(const uint8_t* q, bool four, uint64_t a, uint64_t b, uint64_t c, uint64_t d) {
+  uint64_t y = mux(c, lut2(q[0], a, b), lut2(q[1], a, b));
+  if (four) y = mux(d, y, mux(c, lut2(q[2], a, b), lut2(q[3], a, b)));
+  return y;
+}
+
+inline uint64_t splitmix64(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+} // namespace
+
+BitSim::BitSim(const Netlist& nl) : nl_(nl), v_(nl.netCount()), st_(nl.modules.size()), nib_(nl.modules.size() * 8) {
+  for (uint32_t m = 0; m < nl.modules.size(); m++) {
+    const Module& mod = nl.modules[m];
+    if (mod.kind == MK_COUNTER || isSeqFamily(mod.family)) seqMods_.push_back(m);
+    for (int k = 0; k < 4; k++) {
+      nib_[m * 8 + k]     = (mod.tt.y  >> (4 * k)) & 15;
+      nib_[m * 8 + 4 + k] = (mod.tt.yb >> (4 * k)) & 15;
+    }
+  }
+  reset();
+}
+
+void BitSim::reset() {
+  std::fill(v_.begin(), v_.end(), 0);
+  v_[NET_1] = ~0ULL;
+  for (ModState& s : st_) s = ModState{};
+  primed_ = false;
+}
+
+uint64_t BitSim::row(const std::vector<NetId>& pins) const {
+  uint64_t r = 0;
+  for (NetId n : pins) r |= v_[n];
+  return r;
+}
+
+uint64_t BitSim::evalOutputs(uint32_t m) {
+  const Module& mod = nl_.modules[m];
+  const ModState& s = st_[m];
+  uint64_t changed = 0;
+  auto drive = [&](NetId n, uint64_t x) { changed |= v_[n] ^ x; v_[n] = x; };
+
+  if (mod.kind == MK_GATE) {
+    uint64_t y;
+    if (isSeqFamily(mod.family)) {
+      y = s.q[0];
+      drive(mod.out[0], y);
+      drive(mod.out[1], ~y);
+    } else {
+      const uint64_t a = row(mod.in[0]), b = row(mod.in[1]), c = row(mod.in[2]), d = row(mod.in[3]);
+      drive(mod.out[0], lut4(&nib_[m * 8], mod.four, a, b, c, d));
+      drive(mod.out[1], lut4(&nib_[m * 8 + 4], mod.four, a, b, c, d));
+    }
+    return changed;
+  }
+
+  // Counter: BO = count, D1..D10 = one-hot, RCO from the count and the enables.
+  const uint64_t enp = row(mod.in[CI_ENP]), ent = row(mod.in[CI_ENT]);
+  for (int b = 0; b < 4; b++) drive(mod.out[CO_BO1 + b], s.q[b]);
+  drive(mod.out[CO_RCO], ent & (mod.cascade ? ~0ULL : enp) & s.q[0] & s.q[1] & s.q[2] & s.q[3]);
+  for (int n = 1; n <= 10; n++) {
+    uint64_t eq = ~0ULL;
+    for (int b = 0; b < 4; b++) eq &= (n >> b & 1) ? s.q[b] : ~s.q[b];
+    drive(mod.out[CO_D1 + n - 1], eq);
+  }
+  return changed;
+}
+
+uint64_t BitSim::clockModule(uint32_t m) {
+  const Module& mod = nl_.modules[m];
+  ModState& s = st_[m];
+
+  if (mod.kind == MK_GATE) {
+    const uint64_t d = row(mod.in[0]), clk = row(mod.in[1]), k = row(mod.in[2]), clr = row(mod.in[3]);
+    const uint64_t q = s.q[0], rise = clk & ~s.prevClk;
+    uint64_t nq = q;
+    switch (mod.family) {
+      case GF_DLATCH: nq = mux(clk, q, d);                              break;
+      case GF_DFF:    nq = mux(rise, q, d);                             break;
+      case GF_JKFF:   nq = mux(rise, q, (d & ~q) | (~k & q));           break;
+      case GF_TFF:    nq = q ^ (rise & d);                              break;
+    }
+    nq &= ~clr;   // row 4 = asynchronous clear (always low in 3-input mode)
+    s.q[0] = nq;
+    s.prevClk = clk;
+    return q ^ nq;
+  }
+
+  const uint64_t clk = row(mod.in[CI_CLK]), clr = row(mod.in[CI_CLR]);
+  const uint64_t enp = row(mod.in[CI_ENP]), ent = row(mod.in[CI_ENT]);
+  if (!primed_) s.prevClk = clk;
+  const uint64_t rise = clk & ~s.prevClk & clr;
+  const uint64_t load = mod.cascade ? 0 : rise & ~ent;   // LOAD active low (kit firmware)
+  uint64_t carry = rise & enp & ent;
+  uint64_t changed = 0;
+  for (int b = 0; b < 4; b++) {
+    uint64_t q = mux(load, s.q[b], row(mod.in[CI_BI1 + b]));
+    uint64_t nq = (q ^ carry) & clr;
+    carry &= q;
+    changed |= s.q[b] ^ nq;
+    s.q[b] = nq;
+  }
+  s.prevClk = clk;
+  return changed;
+}
+
+uint64_t BitSim::settle() {
+  if (!nl_.cyclic) {
+    for (uint32_t m : nl_.order) evalOutputs(m);
+    return 0;
+  }
+  // Feedback: sweep until nothing moves. A loop with a stable state gets there within
+  // one sweep per module; what is still moving after that is oscillating.
+  uint64_t changed = ~0ULL;
+  for (size_t pass = 0; changed && pass < nl_.modules.size() + 2; pass++) {
+    changed = 0;
+    for (uint32_t m : nl_.order) changed |= evalOutputs(m);
+  }
+  return changed;
+}
+
+uint64_t BitSim::step() {
+  const size_t maxDelta = 8 + 4 * nl_.modules.size();
+  uint64_t unstable = 0;
+  for (size_t delta = 0;; delta++) {
+    unstable |= settle();
+    uint64_t changed = 0;
+    for (uint32_t m : seqMods_) changed |= clockModule(m);
+    primed_ = true;
+    if (!changed) break;
+    if (delta == maxDelta) {
+      unstable |= changed;
+      settle();
+      break;
+    }
+  }
+  return unstable;
+}
+
+// ========================= Exhaustive / random check =========================
+
+CheckResult checkVectors(const Netlist& nl, const CheckOptions& opt) {
+  const size_t n = nl.inputs.size();
+  const bool random = opt.randomVectors != 0;
+  if (n > 64) throw NetlistError("more than 64 circuit inputs");
+  if (!random && n > 36) throw NetlistError(std::to_string(n) + " inputs is too many to check exhaustively, use random vectors");
+
+  const uint64_t total = random ? opt.randomVectors : 1ULL << n;
+  const uint64_t words = (total + 63) / 64;
+  const uint64_t CHUNK = 256;   // words per work item
+  unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+  threads = (unsigned)std::min<uint64_t>(threads, (words + CHUNK - 1) / CHUNK);
+
+  std::atomic<uint64_t> next{ 0 };
+  std::mutex lock;
+  CheckResult res;
+  res.vectors = total;
+  res.threads = threads;
+
+  auto worker = [&]() {
+    BitSim sim(nl);
+    std::vector<uint64_t> in(n), vars, scratch;
+    uint64_t failures = 0, unstableCount = 0;
+    std::vector<CheckFailure> first;
+
+    for (uint64_t w0; (w0 = next.fetch_add(CHUNK)) < words;) {
+      for (uint64_t w = w0; w < std::min(words, w0 + CHUNK); w++) {
+        const uint64_t left = total - w * 64;
+        const uint64_t mask = left >= 64 ? ~0ULL : (1ULL << left) - 1;
+        sim.reset();
+        for (size_t i = 0; i < n; i++) {
+          if (random)     in[i] = splitmix64(opt.seed ^ splitmix64(w * 64 + i));
+          else if (i < 6) in[i] = LANE_PATTERN[i];
+          else            in[i] = (w >> (i - 6)) & 1 ? ~0ULL : 0;
+          sim.set(nl.inputs[i], in[i]);
+        }
+        const uint64_t unstable = sim.step() & mask;
+        uint64_t bad = unstable;
+        for (size_t e = 0; e < nl.expects.size(); e++) {
+          const Expect& x = nl.expects[e];
+          vars.resize(x.vars.size());
+          for (size_t j = 0; j < x.vars.size(); j++) vars[j] = sim.get(x.vars[j]);
+          uint64_t diff = (evalExpr(x.expr, vars.data(), scratch) ^ sim.get(x.net)) & mask & ~unstable;
+          bad |= diff;
+          if (diff && first.size() < opt.maxReports) {
+            for (uint64_t l = diff; l && first.size() < opt.maxReports; l &= l - 1) {
+              const int lane = __builtin_ctzll(l);
+              uint64_t vec = 0;
+              for (size_t i = 0; i < n; i++) vec |= ((in[i] >> lane) & 1) << i;
+              first.push_back({ vec, e, (bool)((sim.get(x.net) >> lane) & 1) });
+            }
+          }
+        }
+        for (uint64_t l = unstable; l && first.size() < opt.maxReports; l &= l - 1) {
+          const int lane = __builtin_ctzll(l);
+          uint64_t vec = 0;
+          for (size_t i = 0; i < n; i++) vec |= ((in[i] >> lane) & 1) << i;
+          first.push_back({ vec, SIZE_MAX, false });
+        }
+        failures += __builtin_popcountll(bad);
+        unstableCount += __builtin_popcountll(unstable);
+      }
+    }
+
+    std::lock_guard<std::mutex> g(lock);
+    res.failures += failures;
+    res.unstable += unstableCount;
+    res.first.insert(res.first.end(), first.begin(), first.end());
+  };
+
+  const auto t0 = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads; t++) pool.emplace_back(worker);
+  worker();
+  for (std::thread& t : pool) t.join();
+  res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  if (!random)
+    std::sort(res.first.begin(), res.first.end(), [](const CheckFailure& a, const CheckFailure& b) { return a.vector < b.vector; });
+  if (res.first.size() > opt.maxReports) res.first.resize(opt.maxReports);
+  return res;
+}
+
+} // namespace gatesim
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Netlist.h"
+
+// =========================
+// Bit-sliced simulator: 64 independent copies of the circuit per pass
+// Every net is a uint64_t, lane i being copy i, so one AND/OR/XOR evaluates a gate for 64
+// input vectors. Zero-delay: step() settles the combinational logic, then clocks every
+// flip-flop / counter from the settled values at once (all modules sample before any of
+// them drives its new state, like the firmware's edge interrupts), and repeats while that
+// makes new edges (ripple counters, latches). Lanes that never settle are reported.
+// =========================
+
+namespace gatesim {
+
+class BitSim {
+public:
+  explicit BitSim(const Netlist& nl);
+
+  void reset();                                  // power-on: nets low, flip-flops and counts cleared
+  void set(NetId n, uint64_t lanes) { v_[n] = lanes; }
+  uint64_t get(NetId n) const { return v_[n]; }
+  const uint64_t* values() const { return v_.data(); }
+
+  // Apply the current inputs. Returns the lanes that did not settle (oscillating).
+  uint64_t step();
+
+private:
+  struct ModState {
+    uint64_t q[4];     // gate: q[0] = Q; counter: count bits
+    uint64_t prevClk;  // CLK (row 2 / CLK pin) at the last clocking
+  };
+
+  uint64_t row(const std::vector<NetId>& pins) const;
+  uint64_t evalOutputs(uint32_t m);   // returns lanes whose outputs changed
+  uint64_t clockModule(uint32_t m);   // returns lanes whose state changed
+  uint64_t settle();
+
+  const Netlist& nl_;
+  std::vector<uint64_t> v_;
+  std::vector<ModState> st_;
+  std::vector<uint32_t> seqMods_;
+  std::vector<uint8_t> nib_;          // per gate: 8 LUT2 selectors (Y quadrants, then /Y)
+  bool primed_ = false;
+};
+
+// ========================= Exhaustive / random check =========================
+
+struct CheckOptions {
+  unsigned threads = 0;         // 0 = all cores
+  uint64_t randomVectors = 0;   // 0 = exhaustive
+  uint64_t seed = 1;
+  size_t maxReports = 8;
+};
+
+struct CheckFailure {
+  uint64_t vector;     // bit i = inputs[i]
+  size_t expect;       // index into Netlist::expects, or SIZE_MAX = did not settle
+  bool got;
+};
+
+struct CheckResult {
+  uint64_t vectors = 0;
+  uint64_t failures = 0;   // vectors with any mismatch
+  uint64_t unstable = 0;   // vectors that did not settle
+  std::vector<CheckFailure> first;
+  double seconds = 0;
+  unsigned threads = 0;
+};
+
+// Every vector starts from power-on and gets one step().
+CheckResult checkVectors(const Netlist& nl, const CheckOptions& opt);
+
+} // namespace gatesim
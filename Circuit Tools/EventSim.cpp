@@ -0,0 +1,281 @@
+#include "EventSim.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace gatesim {
+
+EventSim::EventSim(const Netlist& nl)
+    : nl_(nl), val_(nl.netCount()), toggles_(nl.netCount()), last_(nl.netCount()), pend_(nl.netCount()),
+      seq_(nl.modules.size()), cnt_(nl.modules.size()), dirty_(nl.modules.size()) {
+  reset();
+}
+
+bool EventSim::reset(uint64_t maxEvents) {
+  queue_ = decltype(queue_)();
+  std::fill(val_.begin(), val_.end(), 0);
+  val_[NET_1] = 1;
+  std::fill(pend_.begin(), pend_.end(), Pending{});
+  pending_ = 0;
+  std::fill(seq_.begin(), seq_.end(), SeqState{});
+  std::fill(cnt_.begin(), cnt_.end(), CounterState{});
+  now_ = 0;
+  for (uint32_t m : nl_.order) evaluate(m);   // setup(): every module drives its outputs once
+  const bool ok = process(std::numeric_limits<uint64_t>::max(), maxEvents);
+  events_ = 0;
+  clearActivity();
+  return ok;
+}
+
+void EventSim::clearActivity() {
+  std::fill(toggles_.begin(), toggles_.end(), 0);
+  std::fill(last_.begin(), last_.end(), now_);
+}
+
+bool EventSim::pinsHigh(const std::vector<NetId>& pins) const {
+  for (NetId n : pins) if (val_[n]) return true;
+  return false;
+}
+
+// Inertial: at most one change pending per net. A new value equal to the net's current one
+// cancels the pending change (the pulse never makes it out).
+void EventSim::schedule(NetId n, bool v, uint64_t t) {
+  Pending& p = pend_[n];
+  const bool target = p.has ? p.v : val_[n];
+  if (v == target) return;
+  if (p.has) {
+    p.has = false;
+    pending_--;
+    return;
+  }
+  p = Pending{ true, v, ++seqNo_ };
+  pending_++;
+  queue_.push(Event{ t, p.seq, n, v });
+}
+
+void EventSim::set(NetId n, bool v) { schedule(n, v, now_); }
+
+void EventSim::evaluate(uint32_t m) {
+  const Module& mod = nl_.modules[m];
+  const uint64_t t = now_ + mod.delayNs;
+
+  if (mod.kind == MK_GATE) {
+    uint8_t rows = 0;
+    for (uint8_t r = 0; r < 4; r++) if (pinsHigh(mod.in[r])) rows |= 1 << r;
+    bool y, yb;
+    if (isSeqFamily(mod.family)) {
+      y = seqStep(mod.family, seq_[m], rows);
+      yb = !y;
+    } else {
+      y  = (mod.tt.y  >> rows) & 1;
+      yb = (mod.tt.yb >> rows) & 1;
+    }
+    schedule(mod.out[0], y, t);
+    schedule(mod.out[1], yb, t);
+    return;
+  }
+
+  uint16_t in = 0;
+  for (uint8_t p = 0; p < CI__COUNT; p++) if (pinsHigh(mod.in[p])) in |= 1 << p;
+  counterStep(mod.cascade, cnt_[m], in);
+  const uint16_t o = counterOutputs(mod.cascade, cnt_[m].count, in);
+  for (uint8_t k = 0; k < CO__COUNT; k++) schedule(mod.out[k], (o >> k) & 1, t);
+}
+
+// All changes due at one instant land first, then every module that reads them is
+// evaluated once, so simultaneous edges look simultaneous to a flip-flop.
+bool EventSim::process(uint64_t limitT, uint64_t maxEvents) {
+  uint64_t n = 0;
+  while (!queue_.empty() && queue_.top().t <= limitT) {
+    now_ = queue_.top().t;
+    while (!queue_.empty() && queue_.top().t == now_) {
+      const Event e = queue_.top();
+      queue_.pop();
+      Pending& p = pend_[e.net];
+      if (!p.has || p.seq != e.seq) continue;   // cancelled
+      p.has = false;
+      pending_--;
+      val_[e.net] = e.v;
+      toggles_[e.net]++;
+      last_[e.net] = now_;
+      events_++;
+      n++;
+      if (trace) trace(now_, e.net, e.v);
+      for (uint32_t m : nl_.fanout[e.net])
+        if (!dirty_[m]) { dirty_[m] = 1; dirtyList_.push_back(m); }
+    }
+    for (uint32_t m : dirtyList_) { dirty_[m] = 0; evaluate(m); }
+    dirtyList_.clear();
+    if (n > maxEvents) return false;
+  }
+  return true;
+}
+
+bool EventSim::run(uint64_t maxEvents) { return process(std::numeric_limits<uint64_t>::max(), maxEvents); }
+
+bool EventSim::runUntil(uint64_t t, uint64_t maxEvents) {
+  if (!process(t, maxEvents)) return false;
+  now_ = std::max(now_, t);
+  return true;
+}
+
+// ========================= Timing check =========================
+
+namespace {
+
+inline uint64_t splitmix64(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+} // namespace
+
+TimingResult checkTiming(const Netlist& nl, const TimingOptions& opt) {
+  const size_t n = nl.inputs.size();
+  const bool random = opt.randomVectors != 0;
+  if (n > 64) throw NetlistError("more than 64 circuit inputs");
+  if (!random && n > 20) throw NetlistError(std::to_string(n) + " inputs is too many for an exhaustive timing run, use random vectors");
+  if (!random && n == 0) throw NetlistError("no circuit inputs");
+
+  // Walk position k: exhaustive = (v, i) pair k, random = vector k.
+  const uint64_t inMask = n == 64 ? ~0ULL : (1ULL << n) - 1;
+  const uint64_t steps = random ? opt.randomVectors : (uint64_t)n << n;
+  auto randomVector = [&](uint64_t k) { return splitmix64(opt.seed ^ splitmix64(k)) & inMask; };
+
+  // Observed nets, by their output name where they have one.
+  std::vector<NetId> obs;
+  std::vector<std::string> obsName;
+  auto observe = [&](NetId id, const std::string& name) {
+    if (std::find(obs.begin(), obs.end(), id) != obs.end()) return;
+    obs.push_back(id);
+    obsName.push_back(name);
+  };
+  for (const auto& o : nl.outputs) observe(o.second, o.first);
+  for (const Expect& e : nl.expects) observe(e.net, nl.netName[e.net]);
+
+  const uint64_t BLOCK = 1024;
+  const uint64_t blocks = (steps + BLOCK - 1) / BLOCK;
+  unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+  threads = (unsigned)std::max<uint64_t>(1, std::min<uint64_t>(threads, blocks));
+
+  std::atomic<uint64_t> next{ 0 };
+  std::mutex lock;
+  TimingResult res;
+  res.exhaustive = !random;
+  res.threads = threads;
+  std::vector<uint64_t> worstNet(obs.size(), 0);
+  std::vector<std::pair<uint64_t, TimingReport>> reports;   // (walk position, report)
+
+  auto worker = [&]() {
+    EventSim sim(nl);
+    TimingResult r;
+    std::vector<uint64_t> worst(obs.size(), 0), vars, scratch;
+    std::vector<uint8_t> before(obs.size());
+    std::vector<std::pair<uint64_t, TimingReport>> mine;
+    uint64_t cur = 0;   // vector on the inputs
+
+    auto apply = [&](uint64_t vec) {
+      for (size_t i = 0; i < n; i++) {
+        const bool v = (vec >> i) & 1;
+        if (sim.get(nl.inputs[i]) != v) sim.set(nl.inputs[i], v);
+      }
+      cur = vec;
+    };
+
+    // Go from 'cur' to 'to' and measure it.
+    auto transition = [&](uint64_t k, uint64_t to) {
+      const uint64_t from = cur;
+      auto report = [&](const std::string& what) {
+        if (mine.size() < opt.maxReports) mine.push_back({ k, TimingReport{ from, to, what } });
+      };
+      for (size_t i = 0; i < obs.size(); i++) before[i] = sim.get(obs[i]);
+      sim.clearActivity();
+      const uint64_t t0 = sim.now(), e0 = sim.events();
+      apply(to);
+      const bool ok = sim.run(opt.maxEventsPerVector);
+      r.transitions++;
+      r.events += sim.events() - e0;
+      if (!ok) {
+        r.oscillating++;
+        report("does not settle");
+        sim.reset(opt.maxEventsPerVector);
+        apply(to);
+        sim.run(opt.maxEventsPerVector);
+        return;
+      }
+
+      uint64_t settle = 0;
+      std::string glitch;
+      for (size_t i = 0; i < obs.size(); i++) {
+        const uint32_t tg = sim.toggles(obs[i]);
+        if (!tg) continue;
+        const uint64_t s = sim.lastChange(obs[i]) - t0;
+        worst[i] = std::max(worst[i], s);
+        settle = std::max(settle, s);
+        if (tg > (uint32_t)(before[i] != sim.get(obs[i]))) glitch += (glitch.empty() ? "" : ", ") + obsName[i];
+      }
+      if (!glitch.empty()) { r.glitchy++; report("glitch on " + glitch); }
+      if (opt.periodNs && settle > opt.periodNs) r.late++;
+      if (settle > r.worstSettleNs) { r.worstSettleNs = settle; r.worstFrom = from; r.worstTo = to; }
+
+      for (const Expect& x : nl.expects) {
+        vars.resize(x.vars.size());
+        for (size_t j = 0; j < x.vars.size(); j++) vars[j] = sim.get(x.vars[j]) ? ~0ULL : 0;
+        const bool want = evalExpr(x.expr, vars.data(), scratch) & 1;
+        if (want != sim.get(x.net)) { r.mismatches++; report("expect " + x.text + " failed"); }
+      }
+    };
+
+    for (uint64_t b; (b = next.fetch_add(1)) < blocks;) {
+      const uint64_t a = b * BLOCK;
+      sim.reset(opt.maxEventsPerVector);
+      cur = 0;
+      if (random && a) { apply(randomVector(a - 1)); sim.run(opt.maxEventsPerVector); }
+
+      for (uint64_t k = a; k < std::min(steps, a + BLOCK); k++) {
+        if (random) { transition(k, randomVector(k)); continue; }
+        const uint64_t v = k / n, bit = 1ULL << (k % n);
+        if (v & bit) continue;
+        if (cur != v) { apply(v); sim.run(opt.maxEventsPerVector); }   // get there, unmeasured
+        transition(k, v | bit);
+        transition(k, v);
+      }
+    }
+
+    std::lock_guard<std::mutex> g(lock);
+    res.transitions += r.transitions;
+    res.events += r.events;
+    res.mismatches += r.mismatches;
+    res.glitchy += r.glitchy;
+    res.oscillating += r.oscillating;
+    res.late += r.late;
+    if (r.worstSettleNs > res.worstSettleNs ||
+        (r.worstSettleNs == res.worstSettleNs && r.worstTo < res.worstTo)) {
+      res.worstSettleNs = r.worstSettleNs;
+      res.worstFrom = r.worstFrom;
+      res.worstTo = r.worstTo;
+    }
+    for (size_t i = 0; i < obs.size(); i++) worstNet[i] = std::max(worstNet[i], worst[i]);
+    reports.insert(reports.end(), mine.begin(), mine.end());
+  };
+
+  const auto t0 = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads; t++) pool.emplace_back(worker);
+  worker();
+  for (std::thread& t : pool) t.join();
+  res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  std::stable_sort(reports.begin(), reports.end(), [](const auto& x, const auto& y) { return x.first < y.first; });
+  for (size_t i = 0; i < reports.size() && i < opt.maxReports; i++) res.first.push_back(reports[i].second);
+  for (size_t i = 0; i < obs.size(); i++) res.worstPerNet.push_back({ obsName[i], worstNet[i] });
+  return res;
+}
+
+} // namespace gatesim
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "Netlist.h"
+
+// =========================
+// Event-driven simulator: one copy of the circuit, real time in ns
+// A module re-evaluates when one of its inputs changes and drives its outputs
+// Module::delayNs later. Delays are inertial: a pulse shorter than the delay that
+// comes and goes before the output has moved is swallowed, which is what the
+// firmware does when the edge is gone again by the time its interrupt samples the rows.
+// Flip-flops and counters sample at evaluation time, so a shared clock sees the old
+// data everywhere.
+// =========================
+
+namespace gatesim {
+
+class EventSim {
+public:
+  explicit EventSim(const Netlist& nl);
+
+  // Power-on: every module evaluated once and the circuit left to settle.
+  // Returns false if it never settles. Counters restart from now().
+  bool reset(uint64_t maxEvents = 1000000);
+
+  void set(NetId n, bool v);                 // circuit input change at now()
+  bool run(uint64_t maxEvents);              // until quiet; false = event limit (oscillating)
+  bool runUntil(uint64_t t, uint64_t maxEvents);   // events up to t, then now() = t
+
+  bool get(NetId n) const { return val_[n]; }
+  bool busy() const { return pending_ != 0; }   // output changes still on their way
+  uint64_t now() const { return now_; }
+  uint64_t events() const { return events_; }
+
+  // Per-net activity since clearActivity().
+  void clearActivity();
+  uint32_t toggles(NetId n) const { return toggles_[n]; }
+  uint64_t lastChange(NetId n) const { return last_[n]; }
+
+  std::function<void(uint64_t t, NetId n, bool v)> trace;   // every net change, if set
+
+private:
+  struct Event {
+    uint64_t t, seq;
+    NetId net;
+    bool v;
+    bool operator>(const Event& o) const { return t != o.t ? t > o.t : seq > o.seq; }
+  };
+  struct Pending { bool has = false; bool v = false; uint64_t seq = 0; };
+
+  void schedule(NetId n, bool v, uint64_t t);
+  void evaluate(uint32_t m);
+  bool pinsHigh(const std::vector<NetId>& pins) const;
+  bool process(uint64_t limitT, uint64_t maxEvents);
+
+  const Netlist& nl_;
+  std::vector<uint8_t> val_;
+  std::vector<uint32_t> toggles_;
+  std::vector<uint64_t> last_;
+  std::vector<Pending> pend_;
+  std::vector<SeqState> seq_;
+  std::vector<CounterState> cnt_;
+  std::vector<uint8_t> dirty_;
+  std::vector<uint32_t> dirtyList_;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> queue_;
+  uint64_t now_ = 0, seqNo_ = 0, events_ = 0;
+  size_t pending_ = 0;
+};
+
+// ========================= Timing check =========================
+// Exhaustive: every single-input flip, both ways (v -> v with input i set -> v again, for
+// every v with input i clear), the transitions that expose static hazards.
+// Random: a walk through random vectors, several inputs changing at once.
+// Each transition's settle time and glitches are measured on the observed nets (outputs and
+// expect targets). The walk is cut into fixed blocks that each start from power-on, so the
+// result doesn't depend on the thread count.
+
+struct TimingOptions {
+  unsigned threads = 0;             // 0 = all cores
+  uint64_t randomVectors = 0;       // 0 = exhaustive
+  uint64_t seed = 1;
+  uint64_t periodNs = 0;            // transitions slower than this to settle count as late (0 = off)
+  uint64_t maxEventsPerVector = 100000;
+  size_t maxReports = 8;
+};
+
+struct TimingReport { uint64_t from, to; std::string what; };
+
+struct TimingResult {
+  uint64_t transitions = 0, events = 0;
+  uint64_t mismatches = 0;     // expect lines wrong once settled
+  uint64_t glitchy = 0;        // an observed net moved more often than its final value needed
+  uint64_t oscillating = 0;    // never settled
+  uint64_t late = 0;           // settled after periodNs
+  bool exhaustive = false;
+  uint64_t worstSettleNs = 0, worstFrom = 0, worstTo = 0;
+  std::vector<std::pair<std::string, uint64_t>> worstPerNet;   // observed net, worst settle ns
+  std::vector<TimingReport> first;
+  double seconds = 0;
+  unsigned threads = 0;
+};
+
+TimingResult checkTiming(const Netlist& nl, const TimingOptions& opt);
+
+} // namespace gatesim
@@ -0,0 +1,114 @@
+#include "Expr.h"
+
+#include <cctype>
+
+namespace gatesim {
+
+namespace {
+
+// Recursive descent, one function per precedence level.
+struct Parser {
+  const std::string& s;
+  size_t i = 0;
+  Expr e;
+
+  explicit Parser(const std::string& text) : s(text) {}
+
+  void skip() { while (i < s.size() && std::isspace((unsigned char)s[i])) i++; }
+  bool eat(char c) { skip(); if (i < s.size() && s[i] == c) { i++; return true; } return false; }
+  [[noreturn]] void fail(const std::string& what) { throw ExprError(what + " at column " + std::to_string(i + 1), i); }
+
+  uint32_t add(Expr::Op op, uint32_t a = 0, uint32_t b = 0) {
+    e.nodes.push_back(Expr::Node{ op, a, b });
+    return (uint32_t)e.nodes.size() - 1;
+  }
+
+  uint32_t var(const std::string& name) {
+    for (uint32_t k = 0; k < e.vars.size(); k++) if (e.vars[k] == name) return add(Expr::VAR, k);
+    e.vars.push_back(name);
+    return add(Expr::VAR, (uint32_t)e.vars.size() - 1);
+  }
+
+  uint32_t primary() {
+    skip();
+    if (i >= s.size()) fail("expression ends early");
+    char c = s[i];
+    uint32_t n;
+    if (c == '!' || c == '~') { i++; return add(Expr::NOT, primary()); }
+    if (c == '(') {
+      i++;
+      n = orExpr();
+      if (!eat(')')) fail("missing ')'");
+    } else if (std::isalnum((unsigned char)c) || c == '_') {
+      size_t j = i;
+      while (j < s.size() && (std::isalnum((unsigned char)s[j]) || s[j] == '_' || s[j] == '.')) j++;
+      std::string name = s.substr(i, j - i);
+      i = j;
+      if (name == "0")      n = add(Expr::CONST0);
+      else if (name == "1") n = add(Expr::CONST1);
+      else                  n = var(name);
+    } else {
+      fail(std::string("unexpected '") + c + "'");
+    }
+    while (eat('\'')) n = add(Expr::NOT, n);   // postfix complement
+    return n;
+  }
+
+  uint32_t andExpr() {
+    uint32_t n = primary();
+    while (eat('&') || eat('*')) n = add(Expr::AND, n, primary());
+    return n;
+  }
+
+  uint32_t xorExpr() {
+    uint32_t n = andExpr();
+    while (eat('^')) n = add(Expr::XOR, n, andExpr());
+    return n;
+  }
+
+  uint32_t orExpr() {
+    uint32_t n = xorExpr();
+    while (eat('|') || eat('+')) n = add(Expr::OR, n, xorExpr());
+    return n;
+  }
+};
+
+} // namespace
+
+Expr parseExpr(const std::string& text) {
+  Parser p(text);
+  p.orExpr();
+  p.skip();
+  if (p.i != text.size()) p.fail("unexpected text");
+  return std::move(p.e);
+}
+
+uint64_t evalExpr(const Expr& e, const uint64_t* vars, std::vector<uint64_t>& scratch) {
+  scratch.resize(e.nodes.size());
+  uint64_t* v = scratch.data();
+  for (size_t k = 0; k < e.nodes.size(); k++) {
+    const Expr::Node& n = e.nodes[k];
+    switch (n.op) {
+      case Expr::VAR:    v[k] = vars[n.a];        break;
+      case Expr::CONST0: v[k] = 0;                break;
+      case Expr::CONST1: v[k] = ~0ULL;            break;
+      case Expr::NOT:    v[k] = ~v[n.a];          break;
+      case Expr::AND:    v[k] = v[n.a] & v[n.b];  break;
+      case Expr::OR:     v[k] = v[n.a] | v[n.b];  break;
+      case Expr::XOR:    v[k] = v[n.a] ^ v[n.b];  break;
+    }
+  }
+  return e.nodes.empty() ? 0 : v[e.nodes.size() - 1];
+}
+
+uint64_t exprTruthTable(const Expr& e) {
+  static const uint64_t LANE_PATTERN[6] = {
+    0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL };
+  if (e.vars.size() > 6) throw ExprError("more than 6 variables", 0);
+  std::vector<uint64_t> scratch;
+  uint64_t t = evalExpr(e, LANE_PATTERN, scratch);
+  return e.vars.size() == 6 ? t : t & ((1ULL << (1u << e.vars.size())) - 1);
+}
+
+} // namespace gatesim
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// =========================
+// Boolean expressions, evaluated 64 input vectors at a time
+// Syntax (lowest to highest precedence):
+//   a | b   a + b      OR
+//   a ^ b              XOR
+//   a & b   a * b      AND
+//   !a  ~a  a'         NOT
+//   ( )  0  1  names   (names: letters, digits, '_' and '.', e.g. A, cin, x1.Y)
+// =========================
+
+namespace gatesim {
+
+struct ExprError : std::runtime_error {
+  size_t pos;
+  ExprError(const std::string& what, size_t p) : std::runtime_error(what), pos(p) {}
+};
+
+struct Expr {
+  enum Op : uint8_t { VAR, CONST0, CONST1, NOT, AND, OR, XOR };
+  struct Node { Op op; uint32_t a, b; };  // VAR: a = index into vars; NOT: a; AND/OR/XOR: a, b
+  std::vector<Node> nodes;                // operands always come before their users; root = last
+  std::vector<std::string> vars;          // in order of first use
+};
+
+Expr parseExpr(const std::string& text);
+
+// vars[i] = 64 lanes of variable i. 'scratch' is resized as needed.
+uint64_t evalExpr(const Expr& e, const uint64_t* vars, std::vector<uint64_t>& scratch);
+
+// Truth table over e.vars (bit i = value when var j == bit j of i), for up to 6 variables.
+uint64_t exprTruthTable(const Expr& e);
+
+} // namespace gatesim
@@ -0,0 +1,133 @@
+#pragma once
+#include <cstdint>
+
+// =========================
+// Module rules, host side
+// A copy of what the firmware runs, so a simulated circuit behaves like the wired one.
+// Keep in step with:
+//   Programmable Logic gates V2/Universal Logic Gate.cpp : GateFamily, gateOut(), seqEval()
+//   Programmable Logic gates V1/Binary Counter           : PORTA/PORTF interrupts, writeCountOutputs()
+// The CHECK_TT table is the firmware's own hand-written one, so a slip in either copy
+// fails a compile instead of a simulation.
+// =========================
+
+namespace gatesim {
+
+// ========================= Universal gate =========================
+// Same order and values as the firmware (they are also the EEPROM family byte).
+enum GateFamily : uint8_t { GF_ANDNAND=0, GF_ORNOR, GF_XORXNOR, GF_MAJMIN, GF_DUALNOT, GF_CUSTOM,
+                            GF_DLATCH, GF_DFF, GF_JKFF, GF_TFF, GF__COUNT };
+constexpr bool isSeqFamily(uint8_t gf) { return gf >= GF_DLATCH && gf < GF__COUNT; }
+
+constexpr const char* FAMILY_NAMES[GF__COUNT] = {
+  "ANDNAND", "ORNOR", "XORXNOR", "MAJMIN", "DUALNOT", "CUSTOM", "DLATCH", "DFF", "JKFF", "TFF" };
+
+// V2 PCB: pins per input row (the firmware ORs them) and per output bus (O1A..C = Y, O2A..C = /Y).
+// With an OLED fitted, row 4's pins are the MODE button and the I2C bus: 3-input mode.
+constexpr uint8_t ROW_PINS[4] = { 3, 2, 2, 3 };
+constexpr uint8_t BUS_PINS = 3;
+
+// Rule for one output of a built-in family. 'four' = 4-input mode (no OLED).
+constexpr bool gateOut(uint8_t gf, bool four, bool inv, uint8_t i) {
+  bool a = i & 1, b = i & 2, c = i & 4, d = four && (i & 8);
+  uint8_t n = a + b + c + d;
+  bool y = false;
+  switch (gf) {
+    case GF_ANDNAND: y = four ? (a & b & c & d) : (a & b & c); break;
+    case GF_ORNOR:   y = a | b | c | d;                        break;
+    case GF_XORXNOR: y = a ^ b ^ c ^ d;                        break;
+    case GF_MAJMIN:  y = n >= (four ? 3 : 2);                  break; // majority of 4 (>=3) / of 3
+    case GF_DUALNOT: return inv ? !c : !b;                            // two independent NOTs on rows 2 and 3
+  }
+  return inv ? !y : y;
+}
+
+constexpr uint16_t buildTT(uint8_t gf, bool four, bool inv) {
+  uint16_t t = 0;
+  for (uint8_t i = 0; i < 16; i++) if (gateOut(gf, four, inv, i)) t |= (uint16_t)1 << i;
+  return t;
+}
+
+// Truth tables: bit i = output when row bits == i (bit0 = row 1 ... bit3 = row 4).
+struct GateTT { uint16_t y, yb; };
+
+constexpr GateTT familyTT(uint8_t gf, bool four) { return GateTT{ buildTT(gf, four, false), buildTT(gf, four, true) }; }
+
+#define CHECK_TT(gf, four, y, yb) \
+  static_assert(buildTT(gf, four, false) == (y) && buildTT(gf, four, true) == (yb), #gf " truth table")
+CHECK_TT(GF_ANDNAND, false, 0x8080, 0x7F7F);  // a&b&c
+CHECK_TT(GF_ORNOR,   false, 0xFEFE, 0x0101);  // a|b|c
+CHECK_TT(GF_XORXNOR, false, 0x9696, 0x6969);  // a^b^c
+CHECK_TT(GF_MAJMIN,  false, 0xE8E8, 0x1717);  // >=2 of 3
+CHECK_TT(GF_DUALNOT, false, 0x3333, 0x0F0F);  // !row2, !row3
+CHECK_TT(GF_ANDNAND, true,  0x8000, 0x7FFF);  // a&b&c&d
+CHECK_TT(GF_ORNOR,   true,  0xFFFE, 0x0001);  // a|b|c|d
+CHECK_TT(GF_XORXNOR, true,  0x6996, 0x9669);  // a^b^c^d
+CHECK_TT(GF_MAJMIN,  true,  0xE880, 0x177F);  // >=3 of 4
+CHECK_TT(GF_DUALNOT, true,  0x3333, 0x0F0F);  // !row2, !row3 (row 4 unused)
+#undef CHECK_TT
+
+// Sequential families, as seqEval():
+//   row 1 = D / J / T, row 2 = CLK (latch: enable), row 3 = K, row 4 = clear (4-input mode).
+//   Y = Q, /Y = !Q. Q starts cleared, and the previous rows start at 0, so a CLK that is
+//   already high at power-on counts as a rising edge (the firmware's first updateOutputs()).
+struct SeqState { bool q = false; uint8_t prevRows = 0; };
+
+// 'rows' already masked to the mode (row 4 = 0 in 3-input mode). Returns Q.
+inline bool seqStep(uint8_t gf, SeqState& s, uint8_t rows) {
+  bool q = s.q;
+  const bool d = rows & 0x01, clk = rows & 0x02, k = rows & 0x04;
+  const bool rise = clk && !(s.prevRows & 0x02);
+  switch (gf) {
+    case GF_DLATCH: if (clk) q = d;                       break;
+    case GF_DFF:    if (rise) q = d;                      break;
+    case GF_JKFF:   if (rise) q = (d && !q) || (!k && q); break;
+    case GF_TFF:    if (rise && d) q = !q;                break;
+  }
+  if (rows & 0x08) q = false;   // row 4 = asynchronous clear
+  s.q = q;
+  s.prevRows = rows;
+  return q;
+}
+
+// ========================= Binary counter (LS161) =========================
+// CASCADE_MODE 0 (kit): ENT pin = active-low LOAD of BI1..BI4, ENP enables counting,
+//                       RCO = LOAD && ENP && count == 15.
+// CASCADE_MODE 1:       count when ENP && ENT, RCO = ENT && count == 15, no LOAD.
+// CLR is active low and asynchronous. No edge is seen at power-on (edges are interrupts).
+enum CounterIn  : uint8_t { CI_CLK=0, CI_CLR, CI_ENP, CI_ENT, CI_BI1, CI_BI2, CI_BI3, CI_BI4, CI__COUNT };
+enum CounterOut : uint8_t { CO_BO1=0, CO_BO2, CO_BO3, CO_BO4, CO_RCO, CO_D1, CO__COUNT = CO_D1 + 10 };
+
+constexpr const char* COUNTER_IN_NAMES[CI__COUNT] = { "CLK", "CLR", "ENP", "ENT", "BI1", "BI2", "BI3", "BI4" };
+
+struct CounterState { uint8_t count = 0; bool prevClk = false; bool primed = false; };
+
+// in = bit i = CounterIn i. Updates the count on a CLK rising edge / CLR low.
+inline void counterStep(bool cascade, CounterState& s, uint16_t in) {
+  const bool clk = in & (1 << CI_CLK), clr = in & (1 << CI_CLR);
+  const bool enp = in & (1 << CI_ENP), ent = in & (1 << CI_ENT);
+  if (!s.primed) { s.prevClk = clk; s.primed = true; }
+  if (clk && !s.prevClk && clr) {
+    if (cascade) {
+      if (enp && ent) s.count = (s.count + 1) & 0x0F;
+    } else if (!ent) {
+      s.count = (in >> CI_BI1) & 0x0F;   // LOAD active low
+    } else if (enp) {
+      s.count = (s.count + 1) & 0x0F;
+    }
+  }
+  s.prevClk = clk;
+  if (!clr) s.count = 0;
+}
+
+// Output pins for a count (bit i = CounterOut i): BO1..BO4 = binary, RCO, D1..D10 = one-hot 1..10.
+inline uint16_t counterOutputs(bool cascade, uint8_t count, uint16_t in) {
+  const bool enp = in & (1 << CI_ENP), ent = in & (1 << CI_ENT);
+  const bool rco = ent && (cascade || enp) && count == 15;
+  uint16_t o = count & 0x0F;
+  if (rco) o |= 1 << CO_RCO;
+  if (count >= 1 && count <= 10) o |= 1 << (CO_D1 + count - 1);
+  return o;
+}
+
+} // namespace gatesim
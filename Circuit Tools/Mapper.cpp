@@ -0,0 +1,1268 @@
+#include "Mapper.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace gatesim {
+
+namespace {
+
+// ========================= Truth tables =========================
+// Bit m of a table over n variables = value when variable j == bit j of m. Tables of fewer
+// than 6 variables keep the unused high bits of their one word clear.
+using Table = std::vector<uint64_t>;
+
+constexpr uint64_t VAR6[6] = { 0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+                               0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL };
+
+unsigned tableWords(unsigned n) { return n <= 6 ? 1 : 1u << (n - 6); }
+uint64_t tableMask(unsigned n) { return n >= 6 ? ~0ULL : (1ULL << (1u << n)) - 1; }
+
+Table varTable(unsigned i, unsigned n) {
+  Table t(tableWords(n));
+  for (size_t j = 0; j < t.size(); j++)
+    t[j] = i < 6 ? VAR6[i] & tableMask(n) : ((j >> (i - 6)) & 1) ? ~0ULL : 0;
+  return t;
+}
+
+Table constTable(bool v, unsigned n) { return Table(tableWords(n), v ? tableMask(n) : 0); }
+
+Table notTable(Table t, unsigned n) {
+  for (uint64_t& w : t) w = ~w & tableMask(n);
+  return t;
+}
+
+bool isConst(const Table& t, bool v, unsigned n) {
+  const uint64_t want = v ? tableMask(n) : 0;
+  for (uint64_t w : t) if (w != want) return false;
+  return true;
+}
+
+bool tableBit(const Table& t, uint32_t m) { return (t[m >> 6] >> (m & 63)) & 1; }
+
+// f with variable i fixed to v (the result no longer depends on i), into r.
+void cofactor(const Table& t, unsigned i, bool v, unsigned n, Table& r) {
+  r.resize(t.size());
+  if (i < 6) {
+    const unsigned s = 1u << i;
+    for (size_t j = 0; j < t.size(); j++) {
+      const uint64_t x = t[j] & (v ? VAR6[i] : ~VAR6[i]);
+      r[j] = (v ? x | (x >> s) : x | (x << s)) & tableMask(n);
+    }
+  } else {
+    const size_t step = (size_t)1 << (i - 6);
+    for (size_t j = 0; j < t.size(); j++) r[j] = t[v ? (j | step) : (j & ~step)];
+  }
+}
+
+Table cofactor(const Table& t, unsigned i, bool v, unsigned n) {
+  Table r;
+  cofactor(t, i, v, n, r);
+  return r;
+}
+
+// t over n variables, re-expressed over m: variable i of t is variable at[i] of the result
+// (UINT8_MAX where t does not depend on it).
+Table remap(const Table& t, unsigned n, const uint8_t* at, unsigned m) {
+  Table r = constTable(false, m);
+  for (uint32_t x = 0; x < (1u << m); x++) {
+    uint32_t y = 0;
+    for (unsigned i = 0; i < n; i++) if (at[i] != UINT8_MAX && ((x >> at[i]) & 1)) y |= 1u << i;
+    if (tableBit(t, y)) r[x >> 6] |= 1ULL << (x & 63);
+  }
+  return r;
+}
+
+bool dependsOn(const Table& t, unsigned i, unsigned n) {
+  if (i < 6) {
+    for (uint64_t w : t) if ((((w >> (1u << i)) ^ w) & ~VAR6[i] & tableMask(n)) != 0) return true;
+    return false;
+  }
+  const size_t step = (size_t)1 << (i - 6);
+  for (size_t j = 0; j < t.size(); j++) if (!(j & step) && t[j] != t[j | step]) return true;
+  return false;
+}
+
+template <class Op> Table combine(const Table& a, const Table& b, Op op) {
+  Table r(a.size());
+  for (size_t j = 0; j < a.size(); j++) r[j] = op(a[j], b[j]);
+  return r;
+}
+
+std::string tableKey(const Table& t, uint32_t extra) {
+  std::string k((const char*)t.data(), t.size() * sizeof(uint64_t));
+  k.append((const char*)&extra, sizeof extra);
+  return k;
+}
+
+// ========================= Sum of products (Minato-Morreale ISOP) =========================
+struct Cube { uint16_t care = 0, val = 0; };
+
+// A cover of some function between L and U, added to 'cubes'. Returns that function.
+// Gives up (returns garbage) once the cover has more than 'limit' cubes.
+Table isop(const Table& L, const Table& U, int top, unsigned n, std::vector<Cube>& cubes, size_t limit) {
+  if (cubes.size() > limit) return L;
+  if (isConst(L, false, n)) return constTable(false, n);
+  if (isConst(U, true, n)) { cubes.push_back(Cube{}); return constTable(true, n); }
+  int x = top - 1;
+  while (x >= 0 && !dependsOn(L, x, n) && !dependsOn(U, x, n)) x--;
+  const Table L0 = cofactor(L, x, false, n), L1 = cofactor(L, x, true, n);
+  const Table U0 = cofactor(U, x, false, n), U1 = cofactor(U, x, true, n);
+  auto andNot = [](uint64_t a, uint64_t b) { return a & ~b; };
+
+  const size_t s0 = cubes.size();
+  const Table f0 = isop(combine(L0, U1, andNot), U0, x, n, cubes, limit);
+  for (size_t c = s0; c < cubes.size(); c++) cubes[c].care |= 1 << x;
+  const size_t s1 = cubes.size();
+  const Table f1 = isop(combine(L1, U0, andNot), U1, x, n, cubes, limit);
+  for (size_t c = s1; c < cubes.size(); c++) { cubes[c].care |= 1 << x; cubes[c].val |= 1 << x; }
+  const Table Ls = combine(combine(L0, f0, andNot), combine(L1, f1, andNot), [](uint64_t a, uint64_t b) { return a | b; });
+  if (cubes.size() > limit) return L;
+  const Table fs = isop(Ls, combine(U0, U1, [](uint64_t a, uint64_t b) { return a & b; }), x, n, cubes, limit);
+
+  const Table X = varTable(x, n);
+  Table r(L.size());
+  for (size_t j = 0; j < r.size(); j++) r[j] = (f0[j] & ~X[j]) | (f1[j] & X[j]) | fs[j];
+  return r;
+}
+
+// More than 'limit' cubes: returns limit + 1 of them.
+std::vector<Cube> sop(const Table& f, unsigned n, size_t limit = SIZE_MAX) {
+  std::vector<Cube> cubes;
+  isop(f, f, (int)n, n, cubes, limit);
+  if (cubes.size() > limit) cubes.resize(limit + 1);
+  return cubes;
+}
+
+size_t literals(const std::vector<Cube>& cubes) {
+  size_t l = 0;
+  for (const Cube& c : cubes) l += __builtin_popcount(c.care);
+  return l;
+}
+
+// ========================= Matching one module =========================
+// A cut's function g over k leaves is one module if the leaves, each taken true or inverted,
+// fall into at most 4 groups (3 with an OLED) such that g only sees each group's OR (a row),
+// and the rows' function is a built-in family (some rows tied high or left low), a Dual NOT
+// half, or anything at all for USER. Module outputs come in both polarities, so inverting an
+// internal leaf is free; inverting a circuit input costs a Dual NOT half.
+constexpr unsigned K = 10;   // the most pins one module takes: 3 + 2 + 2 + 3
+
+struct Match {
+  enum Kind : uint8_t { NONE, CONST, WIRE, HALF, FULL };
+  Kind kind = NONE;
+  uint8_t family = GF_ORNOR;
+  bool onNY = false;               // built-in: the cut's function is on /Y (its complement on Y)
+  bool value = false;              // CONST: the value; WIRE: the output is the leaf inverted
+  uint8_t tie = 0;                 // rows tied high
+  uint8_t negPI = 0;               // circuit inputs taken inverted
+  std::array<uint8_t, K> pos{}, inv{};   // rows (bit r = row r + 1) taking each leaf true / inverted
+  uint16_t tt[2] = { 0, 0 };       // GF_CUSTOM tables for Y and /Y
+};
+
+struct MatchProblem {
+  unsigned k = 0;
+  uint32_t piMask = 0;
+  bool four = true, custom = true, builtins = true;
+  std::vector<Table> fns;          // 1, or 2 for a shared USER module (Y, /Y)
+  std::array<std::array<uint8_t, 2>, K> allow{};   // polarities each leaf may be taken in
+  bool compat[2 * K][2 * K];       // literal pair may share a row
+};
+
+// Two literals may share a row when g is the same whichever of them (or both) is true.
+void computeCompat(MatchProblem& P) {
+  for (unsigned a = 0; a < 2 * K; a++) for (unsigned b = 0; b < 2 * K; b++) P.compat[a][b] = true;
+  const unsigned k = P.k;
+  Table ci[2], d[2][2];
+  for (const Table& g : P.fns) {
+    for (unsigned i = 0; i < k; i++) {
+      for (int x = 0; x < 2; x++) cofactor(g, i, x, k, ci[x]);
+      for (unsigned j = i + 1; j < k; j++) {
+        for (int x = 0; x < 2; x++) for (int y = 0; y < 2; y++) cofactor(ci[x], j, y, k, d[x][y]);
+        for (int p = 0; p < 2; p++) for (int q = 0; q < 2; q++) {
+          const bool ok = d[1 ^ p][q] == d[p][1 ^ q] && d[p][1 ^ q] == d[1 ^ p][1 ^ q];
+          if (!ok) P.compat[2 * i + p][2 * j + q] = P.compat[2 * j + q][2 * i + p] = false;
+        }
+      }
+    }
+  }
+}
+
+// Leaves into rows, depth first: true before inverted, joining a row before opening one.
+// Score: inverted circuit inputs first, then Dual NOT half < built-in < USER.
+struct GroupSearch {
+  const MatchProblem& P;
+  std::array<int, K> members[4];
+  int size[4] = { 0, 0, 0, 0 }, nb = 0, negPI = 0;
+  std::array<uint8_t, K> neg{};
+  Match best;
+  int bestScore = INT_MAX, floor = 0;
+  long budget = 4096;
+
+  explicit GroupSearch(const MatchProblem& p) : P(p) {
+    floor = P.fns.size() > 1 ? 3 : (P.k <= 2 && P.builtins ? 0 : 2);
+  }
+
+  void run() { go(0); }
+
+  void go(unsigned i) {
+    if (bestScore <= floor || budget <= 0) return;
+    if (i == P.k) { budget--; fit(); return; }
+    const int maxRows = P.four ? 4 : 3;
+    for (uint8_t p = 0; p < 2; p++) {
+      if (!P.allow[i][p]) continue;
+      const bool inv = p && ((P.piMask >> i) & 1);
+      negPI += inv;
+      neg[i] = p;
+      for (int b = 0; b < nb; b++) {
+        if (size[b] == 3) continue;
+        bool ok = true;
+        for (int m = 0; m < size[b] && ok; m++) ok = P.compat[2 * members[b][m] + neg[members[b][m]]][2 * i + p];
+        if (!ok) continue;
+        members[b][size[b]++] = i;
+        go(i + 1);
+        size[b]--;
+      }
+      if (nb < maxRows) {
+        members[nb][0] = i;
+        size[nb++] = 1;
+        go(i + 1);
+        size[--nb] = 0;
+      }
+      negPI -= inv;
+    }
+  }
+
+  void fit() {
+    // Rows (groups) need their pins: groups of 3 go to rows 1 and 4.
+    int slot[4], used = 0, threes = 0;
+    for (int b = 0; b < nb; b++) threes += size[b] == 3;
+    if (threes > (P.four ? 2 : 1)) return;
+    const int bigRows[2] = { 0, 3 }, order[4] = { 1, 2, 0, 3 };
+    int nextBig = 0;
+    for (int b = 0; b < nb; b++) if (size[b] == 3) { slot[b] = bigRows[nextBig++]; used |= 1 << slot[b]; }
+    for (int b = 0; b < nb; b++) {
+      if (size[b] == 3) continue;
+      for (int r : order) if (!(used & (1 << r)) && (P.four || r < 3)) { slot[b] = r; used |= 1 << r; break; }
+    }
+
+    // Row function: g at one representative minterm per combination of true rows.
+    uint32_t base = 0;
+    for (unsigned i = 0; i < P.k; i++) if (neg[i]) base |= 1u << i;
+    const uint32_t combos = 1u << nb;
+    uint16_t h[2] = { 0, 0 };
+    for (uint32_t bv = 0; bv < combos; bv++) {
+      uint32_t m = base;
+      for (int b = 0; b < nb; b++) if ((bv >> b) & 1) m ^= 1u << members[b][0];
+      for (size_t f = 0; f < P.fns.size(); f++) if (tableBit(P.fns[f], m)) h[f] |= 1 << bv;
+    }
+    const uint16_t hMask = (uint16_t)((1u << combos) - 1);
+
+    auto take = [&](Match m, int score) {
+      if (score >= bestScore) return false;
+      for (int b = 0; b < nb; b++)
+        for (int j = 0; j < size[b]; j++) {
+          const int leaf = members[b][j];
+          (neg[leaf] ? m.inv : m.pos)[leaf] = (uint8_t)(1 << slot[b]);
+        }
+      m.negPI = (uint8_t)negPI;
+      best = m;
+      bestScore = score;
+      return true;
+    };
+    const int base4 = 4 * negPI;
+
+    if (P.fns.size() == 1 && P.builtins) {
+      // Dual NOT half: NOR of one row of up to 2 pins (slot[0] is row 2).
+      if (nb == 1 && size[0] <= 2 && h[0] == 0x1) {
+        Match m;
+        m.kind = Match::HALF;
+        m.family = GF_DUALNOT;
+        take(m, base4);
+        return;
+      }
+      const uint8_t families[4] = { GF_ANDNAND, GF_ORNOR, GF_XORXNOR, GF_MAJMIN };
+      int freeRows[4], nFree = 0;
+      for (int r = 0; r < (P.four ? 4 : 3); r++) if (!(used & (1 << r))) freeRows[nFree++] = r;
+      for (uint8_t gf : families) {
+        const GateTT t = familyTT(gf, P.four);
+        for (uint32_t ties = 0; ties < (1u << nFree); ties++) {
+          uint8_t tieRows = 0;
+          for (int f = 0; f < nFree; f++) if ((ties >> f) & 1) tieRows |= 1 << freeRows[f];
+          uint16_t y = 0;
+          for (uint32_t bv = 0; bv < combos; bv++) {
+            uint8_t rows = tieRows;
+            for (int b = 0; b < nb; b++) if ((bv >> b) & 1) rows |= 1 << slot[b];
+            if ((t.y >> rows) & 1) y |= 1 << bv;
+          }
+          if (y != h[0] && (uint16_t)(~y & hMask) != h[0]) continue;
+          Match m;
+          m.kind = Match::FULL;
+          m.family = gf;
+          m.onNY = y != h[0];
+          m.tie = tieRows;
+          take(m, base4 + 2);
+          return;
+        }
+      }
+    }
+    if (!P.custom) return;
+
+    // USER: the tables read the used rows only, so a stray wire on a free row changes nothing.
+    Match m;
+    m.kind = Match::FULL;
+    m.family = GF_CUSTOM;
+    for (uint32_t r = 0; r < 16; r++) {
+      uint32_t bv = 0;
+      for (int b = 0; b < nb; b++) if ((r >> slot[b]) & 1) bv |= 1u << b;
+      if ((h[0] >> bv) & 1) m.tt[0] |= 1 << r;
+      if (P.fns.size() > 1 ? (h[1] >> bv) & 1 : !((h[0] >> bv) & 1)) m.tt[1] |= 1 << r;
+    }
+    take(m, base4 + 3);
+  }
+};
+
+// AND/NAND on clauses: g (or !g) as an AND of up to 4 ORs, a signal wired to every row whose
+// clause needs it. The clauses are the complement's sum of products, one row each.
+int clauseMatch(const MatchProblem& P, Match& out) {
+  int bestScore = INT_MAX;
+  for (uint8_t onNY = 0; onNY < 2; onNY++) {
+    const std::vector<Cube> cubes = sop(onNY ? P.fns[0] : notTable(P.fns[0], P.k), P.k, 4);
+    int threes = 0;
+    bool fits = cubes.size() <= (P.four ? 4u : 3u);
+    for (const Cube& c : cubes) {
+      const int n = __builtin_popcount(c.care);
+      fits &= n >= 1 && n <= 3;
+      threes += n == 3;
+    }
+    if (!fits || threes > (P.four ? 2 : 1)) continue;
+    Match m;
+    m.kind = Match::FULL;
+    m.family = GF_ANDNAND;
+    m.onNY = onNY;
+    int used = 0, nextBig = 0;
+    const int bigRows[2] = { 0, 3 }, order[4] = { 1, 2, 0, 3 };
+    for (const Cube& c : cubes) {
+      int row = -1;
+      if (__builtin_popcount(c.care) == 3) row = bigRows[nextBig++];
+      else for (int r : order) if (!(used & (1 << r)) && !(r == 0 && threes > 0) && !(r == 3 && threes > 1) && (P.four || r < 3)) { row = r; break; }
+      used |= 1 << row;
+      for (unsigned x = 0; x < P.k; x++)
+        if ((c.care >> x) & 1) ((c.val >> x) & 1 ? m.inv : m.pos)[x] |= (uint8_t)(1 << row);   // clause = NOT cube
+    }
+    for (int r = 0; r < (P.four ? 4 : 3); r++) if (!(used & (1 << r))) m.tie |= 1 << r;
+    for (unsigned x = 0; x < P.k; x++) m.negPI += m.inv[x] && ((P.piMask >> x) & 1);
+    const int score = 4 * m.negPI + 2;
+    if (score < bestScore) { bestScore = score; out = m; }
+  }
+  return bestScore;
+}
+
+Match solve(MatchProblem& P) {
+  computeCompat(P);
+  GroupSearch s(P);
+  s.run();
+  if (P.fns.size() == 1 && P.builtins && s.bestScore > 2) {
+    Match m;
+    if (clauseMatch(P, m) < s.bestScore) return m;
+  }
+  return s.best;
+}
+
+// One function, memoised by (k, circuit-input leaves, table). The mode and the family set are
+// fixed for a run, so they are not part of the key.
+class MatchCache {
+public:
+  MatchCache(bool four, bool custom) : four_(four), custom_(custom) {}
+
+  const Match* get(const Table& g, unsigned k, uint32_t piMask) {
+    const std::string key = tableKey(g, k | piMask << 8);
+    {
+      std::lock_guard<std::mutex> l(lock_);
+      auto it = map_.find(key);
+      if (it != map_.end()) { hits++; return &it->second; }
+    }
+    Match m;
+    if (k == 0) {
+      m.kind = Match::CONST;
+      m.value = g[0] & 1;
+    } else if (k == 1) {
+      m.kind = Match::WIRE;                          // g depends on its leaf: it is the leaf or !leaf
+      m.value = (g[0] & 1) != 0;
+    } else {
+      MatchProblem P;
+      P.k = k;
+      P.piMask = piMask;
+      P.four = four_;
+      P.custom = custom_;
+      P.fns.push_back(g);
+      for (unsigned i = 0; i < k; i++) P.allow[i] = { 1, 1 };
+      m = solve(P);
+    }
+    misses++;
+    std::lock_guard<std::mutex> l(lock_);
+    return &map_.emplace(key, m).first->second;     // node-based: the pointer stays valid
+  }
+
+  bool four() const { return four_; }
+  bool custom() const { return custom_; }
+
+  std::atomic<uint64_t> hits{ 0 }, misses{ 0 };
+
+private:
+  bool four_, custom_;
+  std::mutex lock_;
+  std::unordered_map<std::string, Match> map_;
+};
+
+// ========================= Subject graph =========================
+// 2-input AND and XOR nodes, structurally hashed. A literal is node * 2 + inverted;
+// node 0 is constant 0, nodes 1..n are the circuit inputs.
+struct Graph {
+  enum Type : uint8_t { CONST, PI, AND, XOR };
+  struct Node { Type type; uint32_t a, b; };
+
+  std::vector<Node> nodes;
+  std::unordered_map<uint64_t, uint32_t> hash;
+  std::vector<uint32_t> outs;
+
+  explicit Graph(unsigned inputs) {
+    nodes.push_back(Node{ CONST, 0, 0 });
+    for (unsigned i = 0; i < inputs; i++) nodes.push_back(Node{ PI, i, 0 });
+  }
+
+  static uint32_t pi(unsigned i) { return (i + 1) * 2; }
+
+  uint32_t node(Type t, uint32_t a, uint32_t b) {
+    if (a > b) std::swap(a, b);
+    const uint64_t key = (uint64_t)t << 62 | (uint64_t)a << 31 | b;
+    auto it = hash.find(key);
+    if (it != hash.end()) return it->second * 2;
+    nodes.push_back(Node{ t, a, b });
+    hash.emplace(key, (uint32_t)nodes.size() - 1);
+    return ((uint32_t)nodes.size() - 1) * 2;
+  }
+
+  uint32_t And(uint32_t a, uint32_t b) {
+    if (a == 0 || b == 0 || (a ^ b) == 1) return 0;
+    if (a == 1) return b;
+    if (b == 1 || a == b) return a;
+    return node(AND, a, b);
+  }
+  uint32_t Or(uint32_t a, uint32_t b) { return And(a ^ 1, b ^ 1) ^ 1; }
+  uint32_t Xor(uint32_t a, uint32_t b) {
+    const uint32_t c = (a ^ b) & 1;
+    a &= ~1u;
+    b &= ~1u;
+    if (a == 0) return b ^ c;
+    if (b == 0) return a ^ c;
+    if (a == b) return c;
+    return node(XOR, a, b) ^ c;
+  }
+  uint32_t Mux(uint32_t s, uint32_t t, uint32_t e) { return Or(And(s, t), And(s ^ 1, e)); }
+
+  // Balanced trees: fewer levels for the mapper to collapse.
+  template <class Op> uint32_t tree(std::vector<uint32_t> v, uint32_t empty, Op op) {
+    if (v.empty()) return empty;
+    while (v.size() > 1) {
+      std::vector<uint32_t> next;
+      for (size_t i = 0; i + 1 < v.size(); i += 2) next.push_back(op(v[i], v[i + 1]));
+      if (v.size() & 1) next.push_back(v.back());
+      v.swap(next);
+    }
+    return v[0];
+  }
+};
+
+constexpr size_t MAX_SOP_CUBES = 64;
+
+// Chains of one operator ((A^B)^C)^D are rebuilt as balanced trees: same function, fewer stages.
+uint32_t buildExpr(Graph& g, const Expr& e, const std::vector<unsigned>& varInput) {
+  std::vector<uint32_t> lit(e.nodes.size());
+  std::vector<uint32_t> stack, operands;
+  std::vector<bool> inChain(e.nodes.size());   // operand of the same operator: built by its user
+  for (const Expr::Node& n : e.nodes)
+    if (n.op == Expr::AND || n.op == Expr::OR || n.op == Expr::XOR) {
+      inChain[n.a] = e.nodes[n.a].op == n.op;
+      inChain[n.b] = e.nodes[n.b].op == n.op;
+    }
+  for (size_t i = 0; i < e.nodes.size(); i++) {
+    const Expr::Node& n = e.nodes[i];
+    if (inChain[i]) continue;
+    switch (n.op) {
+      case Expr::VAR:    lit[i] = Graph::pi(varInput[n.a]); continue;
+      case Expr::CONST0: lit[i] = 0;                        continue;
+      case Expr::CONST1: lit[i] = 1;                        continue;
+      case Expr::NOT:    lit[i] = lit[n.a] ^ 1;             continue;
+      default: break;
+    }
+    operands.clear();
+    stack.assign({ n.b, n.a });
+    while (!stack.empty()) {
+      const uint32_t j = stack.back();
+      stack.pop_back();
+      if (e.nodes[j].op == n.op) { stack.push_back(e.nodes[j].b); stack.push_back(e.nodes[j].a); }
+      else operands.push_back(lit[j]);
+    }
+    if (n.op == Expr::AND)     lit[i] = g.tree(operands, 1, [&](uint32_t a, uint32_t b) { return g.And(a, b); });
+    else if (n.op == Expr::OR) lit[i] = g.tree(operands, 0, [&](uint32_t a, uint32_t b) { return g.Or(a, b); });
+    else                       lit[i] = g.tree(operands, 0, [&](uint32_t a, uint32_t b) { return g.Xor(a, b); });
+  }
+  return lit.back();
+}
+
+// Returns UINT32_MAX when both covers are too big to be worth mapping (parity-like functions).
+uint32_t buildSop(Graph& g, const Table& f, unsigned n) {
+  const std::vector<Cube> on = sop(f, n, MAX_SOP_CUBES), off = sop(notTable(f, n), n, MAX_SOP_CUBES);
+  if (on.size() > MAX_SOP_CUBES && off.size() > MAX_SOP_CUBES) return UINT32_MAX;
+  const bool inv = off.size() <= MAX_SOP_CUBES && (on.size() > MAX_SOP_CUBES || literals(off) < literals(on));
+  std::vector<uint32_t> terms;
+  for (const Cube& c : inv ? off : on) {
+    std::vector<uint32_t> lits;
+    for (unsigned x = 0; x < n; x++) if ((c.care >> x) & 1) lits.push_back(Graph::pi(x) ^ (((c.val >> x) & 1) ? 0 : 1));
+    terms.push_back(g.tree(lits, 1, [&](uint32_t a, uint32_t b) { return g.And(a, b); }));
+  }
+  return g.tree(terms, 0, [&](uint32_t a, uint32_t b) { return g.Or(a, b); }) ^ (inv ? 1 : 0);
+}
+
+// Recursive decomposition with functional hashing: pull out single variables that AND, OR
+// or XOR onto the rest, otherwise split on a variable (Shannon). 'order' = variable
+// preference; an empty order picks the split whose cofactors have the smallest supports.
+class Decomposer {
+public:
+  Decomposer(Graph& g, unsigned n, std::vector<unsigned> order) : g_(g), n_(n), order_(std::move(order)) {
+    if (order_.empty()) { greedy_ = true; for (unsigned i = 0; i < n; i++) order_.push_back(i); }
+  }
+
+  uint32_t build(const Table& f) {
+    if (isConst(f, false, n_)) return 0;
+    if (isConst(f, true, n_)) return 1;
+    const std::string key = tableKey(f, 0);
+    auto it = memo_.find(key);
+    if (it != memo_.end()) return it->second;
+    const Table nf = notTable(f, n_);
+    it = memo_.find(tableKey(nf, 0));
+    if (it != memo_.end()) return it->second ^ 1;
+
+    std::vector<unsigned> supp;
+    for (unsigned x : order_) if (dependsOn(f, x, n_)) supp.push_back(x);
+    uint32_t r = UINT32_MAX;
+    for (unsigned x : supp) {
+      const Table f0 = cofactor(f, x, false, n_), f1 = cofactor(f, x, true, n_);
+      const uint32_t X = Graph::pi(x);
+      if (isConst(f0, false, n_))      r = g_.And(X, build(f1));
+      else if (isConst(f1, false, n_)) r = g_.And(X ^ 1, build(f0));
+      else if (isConst(f0, true, n_))  r = g_.Or(X ^ 1, build(f1));
+      else if (isConst(f1, true, n_))  r = g_.Or(X, build(f0));
+      else if (f0 == notTable(f1, n_)) r = g_.Xor(X, build(f0));
+      if (r != UINT32_MAX) break;
+    }
+    if (r == UINT32_MAX) {
+      unsigned split = supp[0];
+      if (greedy_) {
+        size_t bestCost = SIZE_MAX;
+        for (unsigned x : supp) {
+          size_t cost = 0;
+          for (bool v : { false, true }) {
+            const Table c = cofactor(f, x, v, n_);
+            for (unsigned y : supp) cost += y != x && dependsOn(c, y, n_);
+          }
+          if (cost < bestCost) { bestCost = cost; split = x; }
+        }
+      }
+      r = g_.Mux(Graph::pi(split), build(cofactor(f, split, true, n_)), build(cofactor(f, split, false, n_)));
+    }
+    memo_.emplace(key, r);
+    return r;
+  }
+
+private:
+  Graph& g_;
+  unsigned n_;
+  std::vector<unsigned> order_;
+  bool greedy_ = false;
+  std::unordered_map<std::string, uint32_t> memo_;
+};
+
+inline uint64_t splitmix64(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+// ========================= Cut mapping =========================
+constexpr unsigned CUTS_PER_NODE = 10;
+constexpr float NOT_SLOT = 0.5f;   // one Dual NOT half
+
+struct Cut {
+  uint8_t k = 0;
+  std::array<uint32_t, K> leaf{};
+  Table table;                     // the node over the leaves
+  const Match* match = nullptr;
+  float area = 0;
+  uint16_t depth = 0;
+};
+
+bool invertedLeaf(const Match& m, unsigned i) {
+  return m.kind == Match::WIRE ? m.value : m.kind != Match::CONST && m.inv[i];
+}
+
+float moduleCost(const Match& m) { return m.kind == Match::FULL ? 1.0f : m.kind == Match::HALF ? 0.5f : 0.0f; }
+
+class Mapper {
+public:
+  Mapper(const Graph& g, MatchCache& cache)
+      : g_(g), cache_(cache), cuts_(g.nodes.size()), best_(g.nodes.size(), 0), fanout_(g.nodes.size(), 0),
+        refs_(g.nodes.size(), 0), depth_(g.nodes.size(), 0), area_(g.nodes.size(), 0.0f),
+        stamp_(g.nodes.size(), 0), val_(g.nodes.size()) {}
+
+  uint64_t cutsSeen = 0;
+
+  void map() {
+    for (const Graph::Node& nd : g_.nodes)
+      if (nd.type == Graph::AND || nd.type == Graph::XOR) { fanout_[nd.a >> 1]++; fanout_[nd.b >> 1]++; }
+    for (uint32_t o : g_.outs) fanout_[o >> 1]++;
+
+    for (uint32_t v = 0; v < g_.nodes.size(); v++) {
+      Cut trivial;
+      trivial.k = 1;
+      trivial.leaf[0] = v;
+      cuts_[v].push_back(trivial);
+      if (g_.nodes[v].type == Graph::AND || g_.nodes[v].type == Graph::XOR) enumerate(v);
+    }
+
+    // Exact area: re-pick each used node's cut by what it would really add, twice.
+    for (uint32_t o : g_.outs) refNode(o >> 1);
+    for (int pass = 0; pass < 2; pass++) {
+      for (uint32_t v = 0; v < g_.nodes.size(); v++) {
+        if (!internal(v)) continue;
+        if (!refs_[v]) { depth_[v] = cutDepth(cuts_[v][best_[v]]); continue; }
+        deref(cuts_[v][best_[v]]);
+        float bestArea = 1e30f;
+        uint16_t bestDepth = UINT16_MAX;
+        for (size_t c = 1; c < cuts_[v].size(); c++) {
+          const Cut& cut = cuts_[v][c];
+          if (cut.match->kind == Match::NONE) continue;
+          const float a = ref(cut);
+          deref(cut);
+          const uint16_t d = cutDepth(cut);
+          if (a < bestArea - 1e-6f || (a < bestArea + 1e-6f && d < bestDepth)) { bestArea = a; bestDepth = d; best_[v] = (uint32_t)c; }
+        }
+        ref(cuts_[v][best_[v]]);
+        depth_[v] = bestDepth;
+      }
+    }
+  }
+
+  bool internal(uint32_t v) const { return g_.nodes[v].type == Graph::AND || g_.nodes[v].type == Graph::XOR; }
+  const Cut& bestCut(uint32_t v) const { return cuts_[v][best_[v]]; }
+
+  // The function of v over some leaves that cut it from the inputs. Cuts are shrunk to their
+  // support, so a cut merged from shrunk fanin cuts may not cut the cone: open() says so.
+  bool open() const { return open_; }
+  Table coneTable(uint32_t v, const uint32_t* leaves, unsigned k) {
+    stampNo_++;
+    open_ = false;
+    for (unsigned i = 0; i < k; i++) { stamp_[leaves[i]] = stampNo_; val_[leaves[i]] = varTable(i, k); }
+    return eval(v, k);
+  }
+
+private:
+  const Table& eval(uint32_t v, unsigned k) {
+    if (stamp_[v] == stampNo_) return val_[v];
+    const Graph::Node& nd = g_.nodes[v];
+    Table t = constTable(false, k);
+    if (nd.type == Graph::PI) open_ = true;
+    else if (nd.type != Graph::CONST) {
+      const Table& a = eval(nd.a >> 1, k);
+      const Table& b = eval(nd.b >> 1, k);
+      const uint64_t ia = (nd.a & 1) ? tableMask(k) : 0, ib = (nd.b & 1) ? tableMask(k) : 0;
+      for (size_t j = 0; j < t.size(); j++)
+        t[j] = nd.type == Graph::AND ? (a[j] ^ ia) & (b[j] ^ ib) : (a[j] ^ ia) ^ (b[j] ^ ib);
+    }
+    stamp_[v] = stampNo_;
+    val_[v] = std::move(t);
+    return val_[v];
+  }
+
+  uint16_t cutDepth(const Cut& c) const {
+    uint16_t d = 0;
+    for (unsigned i = 0; i < c.k; i++) {
+      const uint32_t l = c.leaf[i];
+      const bool inv = invertedLeaf(*c.match, i) && g_.nodes[l].type == Graph::PI;
+      d = std::max<uint16_t>(d, (uint16_t)(depth_[l] + inv));
+    }
+    return (uint16_t)(d + (moduleCost(*c.match) > 0));
+  }
+
+  void enumerate(uint32_t v) {
+    const Graph::Node& nd = g_.nodes[v];
+    std::vector<Cut> found;
+    for (const Cut& ca : cuts_[nd.a >> 1]) {
+      for (const Cut& cb : cuts_[nd.b >> 1]) {
+        Cut c;
+        unsigned i = 0, j = 0;
+        bool fits = true;
+        while (i < ca.k || j < cb.k) {
+          uint32_t l;
+          if (j == cb.k || (i < ca.k && ca.leaf[i] < cb.leaf[j])) l = ca.leaf[i++];
+          else if (i == ca.k || cb.leaf[j] < ca.leaf[i]) l = cb.leaf[j++];
+          else { l = ca.leaf[i++]; j++; }
+          if (c.k == K) { fits = false; break; }
+          c.leaf[c.k++] = l;
+        }
+        if (fits) addCut(v, c, found);
+      }
+    }
+    std::sort(found.begin(), found.end(), [](const Cut& x, const Cut& y) {
+      const bool mx = x.match->kind != Match::NONE, my = y.match->kind != Match::NONE;
+      if (mx != my) return mx;
+      if (x.area != y.area) return x.area < y.area;
+      if (x.depth != y.depth) return x.depth < y.depth;
+      return x.k < y.k;
+    });
+    if (found.size() > CUTS_PER_NODE) found.resize(CUTS_PER_NODE);
+    if (found.empty() || found[0].match->kind == Match::NONE) throw std::logic_error("node without a module match");
+    cuts_[v].insert(cuts_[v].end(), found.begin(), found.end());
+    best_[v] = 1;
+    area_[v] = found[0].area;
+    depth_[v] = found[0].depth;
+  }
+
+  void addCut(uint32_t v, Cut c, std::vector<Cut>& found) {
+    auto same = [&](const Cut& o) { return o.k == c.k && std::equal(o.leaf.begin(), o.leaf.begin() + c.k, c.leaf.begin()); };
+    if (std::any_of(found.begin(), found.end(), same)) return;
+    Table t = coneTable(v, c.leaf.data(), c.k);
+    if (open()) return;
+
+    // Drop leaves the function does not depend on.
+    Cut s;
+    std::array<uint8_t, K> at;
+    for (unsigned i = 0; i < c.k; i++) {
+      at[i] = dependsOn(t, i, c.k) ? s.k : UINT8_MAX;
+      if (at[i] != UINT8_MAX) s.leaf[s.k++] = c.leaf[i];
+    }
+    if (s.k != c.k) {
+      t = remap(t, c.k, at.data(), s.k);
+      c = s;
+      if (std::any_of(found.begin(), found.end(), same)) return;
+    }
+    cutsSeen++;
+    uint32_t piMask = 0;
+    for (unsigned i = 0; i < c.k; i++) if (g_.nodes[c.leaf[i]].type == Graph::PI) piMask |= 1u << i;
+    c.match = cache_.get(t, c.k, piMask);
+    c.table = std::move(t);
+    if (c.match->kind != Match::NONE) {
+      // Area flow: a leaf's area is shared by everything it fans out to.
+      float a = moduleCost(*c.match) + NOT_SLOT * 0.5f * c.match->negPI;
+      for (unsigned i = 0; i < c.k; i++) a += area_[c.leaf[i]] / std::max<uint32_t>(1, fanout_[c.leaf[i]]);
+      c.area = a;
+      c.depth = cutDepth(c);
+    }
+    found.push_back(c);
+  }
+
+  // Reference counting for exact area. Inverted circuit inputs are counted once each.
+  float ref(const Cut& c) {
+    float a = moduleCost(*c.match);
+    if (c.match->kind == Match::CONST) return a;
+    for (unsigned i = 0; i < c.k; i++) {
+      const uint32_t l = c.leaf[i];
+      if (g_.nodes[l].type == Graph::PI) { if (invertedLeaf(*c.match, i) && notRefs_[l]++ == 0) a += NOT_SLOT; }
+      else if (internal(l) && refs_[l]++ == 0) a += ref(cuts_[l][best_[l]]);
+    }
+    return a;
+  }
+
+  float deref(const Cut& c) {
+    float a = moduleCost(*c.match);
+    if (c.match->kind == Match::CONST) return a;
+    for (unsigned i = 0; i < c.k; i++) {
+      const uint32_t l = c.leaf[i];
+      if (g_.nodes[l].type == Graph::PI) { if (invertedLeaf(*c.match, i) && --notRefs_[l] == 0) a += NOT_SLOT; }
+      else if (internal(l) && --refs_[l] == 0) a += deref(cuts_[l][best_[l]]);
+    }
+    return a;
+  }
+
+  void refNode(uint32_t v) { if (internal(v) && refs_[v]++ == 0) ref(cuts_[v][best_[v]]); }
+
+  const Graph& g_;
+  MatchCache& cache_;
+  std::vector<std::vector<Cut>> cuts_;   // [0] = the trivial cut {v}
+  std::vector<uint32_t> best_, fanout_, refs_;
+  std::unordered_map<uint32_t, uint32_t> notRefs_;
+  std::vector<uint16_t> depth_;
+  std::vector<float> area_;
+  std::vector<uint32_t> stamp_;
+  std::vector<Table> val_;
+  uint32_t stampNo_ = 0;
+  bool open_ = false;
+};
+
+// ========================= From a cover to modules =========================
+// Each used node becomes a module output. Then:
+//   - a Dual NOT half whose complement is wanted becomes an OR/NOR module;
+//   - circuit inputs wanted inverted get a Dual NOT half each;
+//   - two nodes wanted in one polarity only, whose leaves fit one set of rows, share a USER
+//     module (Y = one, /Y = the other);
+//   - Dual NOT halves pair up.
+// Modules only pair when neither feeds the other, so the circuit stays free of feedback.
+struct Item {
+  enum Kind : uint8_t { FULL, HALF, INVERT } kind = FULL;
+  uint32_t node = 0;            // graph node (NOT slot: the circuit input)
+  Cut cut;                      // leaves and the match in use
+  Match m;                      // may be upgraded / replaced by a shared USER match
+  uint8_t pol = 0;              // 'node' ^ pol is on Y (shared items: on this item's pin)
+  bool shared = false;          // one of the two functions of a USER module
+  int group = -1;               // module
+  int pin = 0;                  // 0 = Y, 1 = /Y (HALF: which Dual NOT half)
+  std::vector<int> deps;        // items feeding it
+  unsigned stage = 0;
+};
+
+class Builder {
+public:
+  Builder(const Graph& g, const MapSpec& spec, Mapper& mp, MatchCache& cache)
+      : g_(g), spec_(spec), mp_(mp), cache_(cache), need_(g.nodes.size(), 0), item_(g.nodes.size(), -1), notItem_(g.nodes.size(), -1) {}
+
+  MapResult build() {
+    for (uint32_t o : g_.outs) request(o >> 1, o & 1);
+
+    for (uint32_t v = 0; v < g_.nodes.size(); v++) {
+      if (!need_[v]) continue;
+      if (g_.nodes[v].type == Graph::PI && (need_[v] & 2)) {
+        Item it;
+        it.kind = Item::INVERT;
+        it.node = v;
+        notItem_[v] = (int)items_.size();
+        items_.push_back(it);
+      }
+      if (!mp_.internal(v)) continue;
+      const Cut& c = mp_.bestCut(v);
+      if (c.match->kind != Match::FULL && c.match->kind != Match::HALF) continue;
+      Item it;
+      it.node = v;
+      it.cut = c;
+      it.m = *c.match;
+      it.kind = it.m.kind == Match::HALF ? Item::HALF : Item::FULL;
+      if (it.kind == Item::HALF && (need_[v] & 2)) {
+        // NOR wanted both ways: the same row on an OR/NOR module (Y = OR, /Y = NOR).
+        it.kind = Item::FULL;
+        it.m.kind = Match::FULL;
+        it.m.family = GF_ORNOR;
+        it.m.onNY = true;
+        for (unsigned i = 0; i < c.k; i++) { it.m.pos[i] = it.m.pos[i] ? 1 : 0; it.m.inv[i] = it.m.inv[i] ? 1 : 0; }
+      }
+      it.pol = it.kind == Item::FULL && it.m.onNY ? 1 : 0;
+      item_[v] = (int)items_.size();
+      items_.push_back(it);
+    }
+    for (Item& it : items_) it.deps = inputsOf(it);
+    for (size_t i = 0; i < items_.size(); i++) items_[i].group = (int)i;
+    for (size_t i = 0; i < items_.size(); i++) for (int d : items_[i].deps) users_[d].push_back((int)i);
+
+    if (cache_.custom()) shareUser();
+    pairHalves();
+    return emit();
+  }
+
+private:
+  void request(uint32_t v, uint8_t p) {
+    if (need_[v] & (1 << p)) return;
+    const bool first = !need_[v];
+    need_[v] |= 1 << p;
+    if (!mp_.internal(v)) return;
+    const Cut& c = mp_.bestCut(v);
+    if (c.match->kind == Match::WIRE) { request(c.leaf[0], p ^ c.match->value); return; }
+    if (c.match->kind == Match::CONST || !first) return;
+    for (unsigned i = 0; i < c.k; i++) {
+      if (c.match->pos[i]) request(c.leaf[i], 0);
+      if (c.match->inv[i]) request(c.leaf[i], 1);
+    }
+  }
+
+  // The item carrying node v in polarity p, through wires; -1 for inputs and constants.
+  int source(uint32_t v, uint8_t p) const {
+    if (g_.nodes[v].type == Graph::PI) return p ? notItem_[v] : -1;
+    if (!mp_.internal(v)) return -1;
+    const Cut& c = mp_.bestCut(v);
+    if (c.match->kind == Match::WIRE) return source(c.leaf[0], p ^ c.match->value);
+    if (c.match->kind == Match::CONST) return -1;
+    return item_[v];
+  }
+
+  std::vector<int> inputsOf(const Item& it) const {
+    std::vector<int> d;
+    if (it.kind == Item::INVERT) return d;
+    for (unsigned i = 0; i < it.cut.k; i++) {
+      for (uint8_t p = 0; p < 2; p++) {
+        if (!(p ? it.m.inv[i] : it.m.pos[i])) continue;
+        const int s = source(it.cut.leaf[i], p);
+        if (s >= 0 && std::find(d.begin(), d.end(), s) == d.end()) d.push_back(s);
+      }
+    }
+    return d;
+  }
+
+  // Does module (group) a feed module b, directly or through others?
+  bool reaches(int a, int b) const {
+    std::vector<uint8_t> seen(items_.size(), 0);
+    std::vector<int> stack;
+    for (size_t i = 0; i < items_.size(); i++) if (items_[i].group == a) stack.push_back((int)i);
+    while (!stack.empty()) {
+      const int i = stack.back();
+      stack.pop_back();
+      auto u = users_.find(i);
+      if (u == users_.end()) continue;
+      for (int j : u->second) {
+        const int gj = items_[j].group;
+        if (gj == b) return true;
+        if (seen[gj]) continue;
+        seen[gj] = 1;
+        for (size_t k = 0; k < items_.size(); k++) if (items_[k].group == gj) stack.push_back((int)k);
+      }
+    }
+    return false;
+  }
+
+  bool independent(int a, int b) const { return !reaches(items_[a].group, items_[b].group) && !reaches(items_[b].group, items_[a].group); }
+
+  void shareUser() {
+    std::vector<int> cand;
+    for (size_t i = 0; i < items_.size(); i++) {
+      const Item& it = items_[i];
+      if (it.kind == Item::FULL && (need_[it.node] == 1 || need_[it.node] == 2)) cand.push_back((int)i);
+    }
+    // Most shared leaves first: those are the pairs most likely to fit one set of rows.
+    std::vector<std::pair<int, std::pair<int, int>>> pairs;
+    for (size_t x = 0; x < cand.size(); x++) {
+      for (size_t y = x + 1; y < cand.size(); y++) {
+        const Cut& a = items_[cand[x]].cut;
+        const Cut& b = items_[cand[y]].cut;
+        int shared = 0, total = a.k + b.k;
+        for (unsigned i = 0; i < a.k; i++) shared += std::count(b.leaf.begin(), b.leaf.begin() + b.k, a.leaf[i]) != 0;
+        if (total - shared <= (int)K) pairs.push_back({ -shared * 16 + (total - shared), { cand[x], cand[y] } });
+      }
+    }
+    std::stable_sort(pairs.begin(), pairs.end(), [](const auto& p, const auto& q) { return p.first < q.first; });
+    std::vector<uint8_t> taken(items_.size(), 0);
+    for (const auto& p : pairs) {
+      const int a = p.second.first, b = p.second.second;
+      if (taken[a] || taken[b] || !independent(a, b)) continue;
+      if (!sharePair(a, b)) continue;
+      taken[a] = taken[b] = 1;
+    }
+  }
+
+  bool sharePair(int ia, int ib) {
+    Item& A = items_[ia];
+    Item& B = items_[ib];
+    Cut u;
+    for (const Cut* c : { &A.cut, &B.cut })
+      for (unsigned i = 0; i < c->k; i++)
+        if (std::find(u.leaf.begin(), u.leaf.begin() + u.k, c->leaf[i]) == u.leaf.begin() + u.k) u.leaf[u.k++] = c->leaf[i];
+    MatchProblem P;
+    P.k = u.k;
+    P.four = cache_.four();
+    P.builtins = false;
+    const uint8_t pa = need_[A.node] == 2, pb = need_[B.node] == 2;
+    auto over = [&](const Cut& c) {
+      std::array<uint8_t, K> at;
+      for (unsigned i = 0; i < c.k; i++) at[i] = (uint8_t)(std::find(u.leaf.begin(), u.leaf.begin() + u.k, c.leaf[i]) - u.leaf.begin());
+      return remap(c.table, c.k, at.data(), u.k);
+    };
+    Table fa = over(A.cut), fb = over(B.cut);
+    if (pa) fa = notTable(fa, u.k);
+    if (pb) fb = notTable(fb, u.k);
+    P.fns = { fa, fb };
+    for (unsigned i = 0; i < u.k; i++) {
+      const uint32_t l = u.leaf[i];
+      // Only polarities something already provides: no new NOTs, no new outputs.
+      P.allow[i] = { (uint8_t)((need_[l] & 1) || g_.nodes[l].type == Graph::PI), (uint8_t)((need_[l] & 2) != 0) };
+      if (g_.nodes[l].type == Graph::PI) P.piMask |= 1u << i;
+    }
+    const Match m = solve(P);
+    if (m.kind != Match::FULL) return false;
+    A.cut = u;
+    A.cut.match = nullptr;
+    A.m = m;
+    A.pol = pa;
+    A.pin = 0;
+    B.kind = Item::FULL;
+    B.pol = pb;
+    B.pin = 1;
+    B.group = A.group;
+    A.shared = B.shared = true;
+    // Both items now read the shared rows.
+    const std::vector<int> before = A.deps;
+    A.deps = inputsOf(A);
+    for (int d : A.deps) if (std::find(before.begin(), before.end(), d) == before.end()) users_[d].push_back(ia);
+    return true;
+  }
+
+  void pairHalves() {
+    std::vector<int> halves;
+    for (size_t i = 0; i < items_.size(); i++) if (items_[i].kind != Item::FULL) halves.push_back((int)i);
+    std::vector<uint8_t> taken(items_.size(), 0);
+    for (size_t x = 0; x < halves.size(); x++) {
+      if (taken[halves[x]]) continue;
+      for (size_t y = x + 1; y < halves.size(); y++) {
+        const int a = halves[x], b = halves[y];
+        if (taken[b] || !independent(a, b)) continue;
+        items_[b].group = items_[a].group;
+        items_[b].pin = 1;
+        taken[a] = taken[b] = 1;
+        break;
+      }
+    }
+  }
+
+  std::string pinName(int item) const {
+    const Item& it = items_[item];
+    return names_.at(it.group) + (it.pin ? ".nY" : ".Y");
+  }
+
+  // Net carrying node v in polarity p.
+  std::string net(uint32_t v, uint8_t p) const {
+    const Graph::Node& nd = g_.nodes[v];
+    if (nd.type == Graph::CONST) return p ? "1" : "0";
+    if (nd.type == Graph::PI) return p ? pinName(notItem_[v]) : spec_.inputs[nd.a];
+    const Cut& c = mp_.bestCut(v);
+    if (c.match->kind == Match::CONST) return (c.match->value ^ p) ? "1" : "0";
+    if (c.match->kind == Match::WIRE) return net(c.leaf[0], p ^ c.match->value);
+    const Item& it = items_[item_[v]];
+    if (it.shared || it.kind != Item::FULL) return pinName(item_[v]);
+    return names_.at(it.group) + ((p == it.pol) ? ".Y" : ".nY");
+  }
+
+  MapResult emit() {
+    // Stages, then modules named in stage order.
+    std::vector<unsigned> stage(items_.size(), 0);
+    std::function<unsigned(int)> stageOf = [&](int i) -> unsigned {
+      if (stage[i]) return stage[i];
+      unsigned s = 0;
+      for (int d : items_[i].deps) s = std::max(s, stageOf(d));
+      return stage[i] = s + 1;
+    };
+    std::vector<int> groups;
+    std::unordered_map<int, unsigned> groupStage;
+    for (size_t i = 0; i < items_.size(); i++) {
+      const int gi = items_[i].group;
+      if (!groupStage.count(gi)) groups.push_back(gi);
+      groupStage[gi] = std::max(groupStage[gi], stageOf((int)i));
+    }
+    std::stable_sort(groups.begin(), groups.end(), [&](int a, int b) { return groupStage[a] < groupStage[b]; });
+    for (size_t k = 0; k < groups.size(); k++) names_[groups[k]] = "g" + std::to_string(k + 1);
+
+    MapResult r;
+    const bool four = cache_.four();
+    for (int gi : groups) {
+      MappedModule mm;
+      mm.name = names_[gi];
+      mm.four = four;
+      mm.stage = groupStage[gi];
+      for (size_t i = 0; i < items_.size(); i++) {
+        const Item& it = items_[i];
+        if (it.group != gi) continue;
+        if (it.kind == Item::INVERT) {
+          mm.family = GF_DUALNOT;
+          mm.rows[1 + it.pin].push_back(spec_.inputs[g_.nodes[it.node].a]);
+          continue;
+        }
+        if (it.shared && it.pin == 1) continue;   // rows and tables are on its partner
+        mm.family = it.kind == Item::HALF ? (uint8_t)GF_DUALNOT : it.m.family;
+        for (unsigned l = 0; l < it.cut.k; l++) {
+          for (int row = 0; row < 4; row++)
+            for (uint8_t p = 0; p < 2; p++)
+              if (((p ? it.m.inv[l] : it.m.pos[l]) >> row) & 1)
+                mm.rows[it.kind == Item::HALF ? 1 + it.pin : row].push_back(net(it.cut.leaf[l], p));
+        }
+        if (it.kind == Item::FULL) {
+          for (int row = 0; row < 4; row++) if ((it.m.tie >> row) & 1) mm.rows[row].push_back("1");
+          if (it.m.family == GF_CUSTOM) mm.tt = GateTT{ it.m.tt[0], it.m.tt[1] };
+        }
+      }
+      r.custom += mm.family == GF_CUSTOM;
+      r.modules.push_back(mm);
+    }
+
+    for (size_t o = 0; o < g_.outs.size(); o++) {
+      const uint32_t lit = g_.outs[o];
+      r.outputs.push_back({ spec_.outputs[o].name, net(lit >> 1, lit & 1) });
+      const int s = source(lit >> 1, lit & 1);
+      if (s >= 0) r.stages = std::max(r.stages, stage[s]);
+    }
+
+    // Where each output pin goes, for the plan.
+    std::unordered_map<std::string, std::string> to;
+    auto note = [&](const std::string& pin, const std::string& where) {
+      std::string& s = to[pin];
+      if (s.find(where) == std::string::npos) s += (s.empty() ? "" : ",") + where;
+    };
+    for (const MappedModule& mm : r.modules)
+      for (int row = 0; row < 4; row++) for (const std::string& n : mm.rows[row]) note(n, mm.name);
+    for (const auto& o : r.outputs) note(o.second, o.first);
+    for (MappedModule& mm : r.modules) { mm.y = to[mm.name + ".Y"]; mm.yb = to[mm.name + ".nY"]; }
+    return r;
+  }
+
+  const Graph& g_;
+  const MapSpec& spec_;
+  Mapper& mp_;
+  MatchCache& cache_;
+  std::vector<uint8_t> need_;          // polarities wanted per node: bit 0 = true, bit 1 = inverted
+  std::vector<int> item_, notItem_;
+  std::vector<Item> items_;
+  std::unordered_map<int, std::vector<int>> users_;
+  std::unordered_map<int, std::string> names_;
+};
+
+// ========================= Strategies =========================
+// 0: the expressions as written, 1: sum of products, 2: decomposition with greedy splits,
+// 3+: decomposition under random variable orders.
+std::string strategyName(unsigned s) {
+  if (s == 0) return "as written";
+  if (s == 1) return "sum of products";
+  if (s == 2) return "decomposition";
+  return "decomposition, order " + std::to_string(s - 2);
+}
+
+// Outputs whose covers are too big fall back from sum of products to decomposition;
+// the name then says so.
+Graph buildGraph(const MapSpec& spec, unsigned s, uint64_t seed, std::string& name) {
+  const unsigned n = (unsigned)spec.inputs.size();
+  Graph g(n);
+  std::vector<unsigned> order;
+  if (s >= 3) {
+    for (unsigned i = 0; i < n; i++) order.push_back(i);
+    uint64_t x = splitmix64(seed ^ s);
+    for (unsigned i = n; i > 1; i--) { x = splitmix64(x); std::swap(order[i - 1], order[x % i]); }
+  }
+  Decomposer dec(g, n, order);
+  bool fellBack = false;
+  for (const MapSpec::Output& o : spec.outputs) {
+    if (s == 0 && !o.expr.nodes.empty()) {
+      std::vector<unsigned> varInput;
+      for (const std::string& v : o.expr.vars)
+        varInput.push_back((unsigned)(std::find(spec.inputs.begin(), spec.inputs.end(), v) - spec.inputs.begin()));
+      g.outs.push_back(buildExpr(g, o.expr, varInput));
+    } else {
+      const uint32_t lit = s <= 1 ? buildSop(g, o.table, n) : UINT32_MAX;
+      fellBack |= s <= 1 && lit == UINT32_MAX;
+      g.outs.push_back(lit != UINT32_MAX ? lit : dec.build(o.table));
+    }
+  }
+  name = strategyName(s) + (fellBack ? " (decomposition where too big)" : "");
+  return g;
+}
+
+bool better(const MapResult& a, const MapResult& b) {
+  if (a.modules.size() != b.modules.size()) return a.modules.size() < b.modules.size();
+  if (a.stages != b.stages) return a.stages < b.stages;
+  return a.custom < b.custom;
+}
+
+} // namespace
+
+// ========================= API =========================
+
+MapResult mapCircuit(const MapSpec& spec, const MapOptions& opt) {
+  const unsigned n = (unsigned)spec.inputs.size();
+  if (n > MAP_MAX_INPUTS) throw std::runtime_error(std::to_string(n) + " inputs, the mapper takes up to " + std::to_string(MAP_MAX_INPUTS));
+  if (spec.outputs.empty()) throw std::runtime_error("nothing to map");
+  bool haveExpr = false;
+  for (const MapSpec::Output& o : spec.outputs) haveExpr |= !o.expr.nodes.empty();
+
+  const unsigned strategies = std::max(1u, opt.effort) + (haveExpr ? 1 : 0);
+  unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min(threads, strategies);
+
+  MatchCache cache(!opt.oled, !opt.presets);
+  std::atomic<unsigned> next{ 0 };
+  std::atomic<uint64_t> cuts{ 0 };
+  std::mutex lock;
+  MapResult best;
+  bool have = false;
+  unsigned bestIndex = 0;
+
+  auto worker = [&]() {
+    for (unsigned i; (i = next.fetch_add(1)) < strategies;) {
+      const unsigned s = haveExpr ? i : i + 1;   // no expression: start at sum of products
+      std::string name;
+      const Graph g = buildGraph(spec, s, opt.seed, name);
+      Mapper mp(g, cache);
+      mp.map();
+      MapResult r = Builder(g, spec, mp, cache).build();
+      r.strategy = name;
+      cuts += mp.cutsSeen;
+      std::lock_guard<std::mutex> l(lock);
+      // Ties go to the lower strategy number, so the result doesn't depend on the threads.
+      if (!have || better(r, best) || (!better(best, r) && i < bestIndex)) { best = std::move(r); bestIndex = i; have = true; }
+    }
+  };
+
+  const auto t0 = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads; t++) pool.emplace_back(worker);
+  worker();
+  for (std::thread& t : pool) t.join();
+  best.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  best.tried = strategies;
+  best.threads = threads;
+  best.cuts = cuts;
+  best.matches = cache.misses;
+  best.memoHits = cache.hits;
+  return best;
+}
+
+std::string sopText(const std::vector<uint64_t>& table, const std::vector<std::string>& inputs) {
+  const unsigned n = (unsigned)inputs.size();
+  const std::vector<Cube> cubes = sop(table, n);
+  if (cubes.empty()) return "0";
+  std::string s;
+  for (const Cube& c : cubes) {
+    std::string term;
+    for (unsigned x = 0; x < n; x++)
+      if ((c.care >> x) & 1) term += (term.empty() ? "" : "&") + std::string(((c.val >> x) & 1) ? "" : "!") + inputs[x];
+    s += (s.empty() ? "" : " | ") + (term.empty() ? std::string("1") : term);
+  }
+  return s;
+}
+
+std::string mapNetlistText(const MapSpec& spec, const MapResult& r) {
+  std::string s = "# gatemap: " + std::to_string(r.modules.size()) + " modules, " + std::to_string(r.stages) + " stages\n";
+  s += "input";
+  for (const std::string& in : spec.inputs) s += " " + in;
+  s += "\n";
+  for (const MappedModule& m : r.modules) {
+    s += "gate " + m.name + " " + FAMILY_NAMES[m.family] + (m.four ? "" : " oled");
+    if (m.family == GF_CUSTOM) {
+      char tt[32];
+      std::snprintf(tt, sizeof tt, " tt=0x%04X,0x%04X", m.tt.y, m.tt.yb);
+      s += tt;
+    }
+    for (int row = 0; row < 4; row++) {
+      if (m.rows[row].empty()) continue;
+      s += " row" + std::to_string(row + 1) + "=";
+      for (size_t k = 0; k < m.rows[row].size(); k++) s += (k ? "," : "") + m.rows[row][k];
+    }
+    s += "\n";
+  }
+  s += "output";
+  for (const auto& o : r.outputs) s += " " + o.first + "=" + o.second;
+  s += "\n";
+  for (size_t o = 0; o < spec.outputs.size(); o++) s += "expect " + spec.outputs[o].name + " = " + spec.outputs[o].text + "\n";
+  return s;
+}
+
+} // namespace gatesim
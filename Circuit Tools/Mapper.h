@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Expr.h"
+#include "GateModel.h"
+
+// =========================
+// Technology mapper: boolean functions -> the fewest Universal gate modules
+// What one module can do, as the firmware and the V2 PCB allow it:
+//   - rows 1..4 are each the OR of up to 3, 2, 2 and 3 signals, or tied high, or left low;
+//   - a built-in family on the rows (AND, OR, XOR, MAJ; 3-input mode with an OLED), Y and /Y;
+//   - Dual NOT: two NORs, one per row 2 / row 3 (each row 2 pins), packed two to a module;
+//   - USER (GF_CUSTOM): any two tables of the rows, so two functions of shared inputs can
+//     share a module.
+// Search: a subject graph of 2-input AND/XOR nodes is built several ways (the expression as
+// written, sum-of-products, Shannon/bi-decomposition under different variable orders). Each
+// graph is mapped by cut enumeration: every node keeps its best few cuts of up to 10 leaves,
+// each cut's function is matched against one module (matches are memoised by truth table and
+// shared by every graph), and the cover is chosen by area flow then exact area. The graphs
+// are mapped in parallel and the smallest result wins.
+// =========================
+
+namespace gatesim {
+
+constexpr unsigned MAP_MAX_INPUTS = 12;
+
+struct MapSpec {
+  std::vector<std::string> inputs;
+  struct Output {
+    std::string name;
+    std::vector<uint64_t> table;   // bit i = output when input j == bit j of i
+    Expr expr;                     // how it was written (no nodes = from a truth table)
+    std::string text;              // for the expect line
+  };
+  std::vector<Output> outputs;
+};
+
+struct MapOptions {
+  bool oled = false;       // every module has its OLED: 3-input mode
+  bool presets = false;    // built-in families only (preset images, no USER tables)
+  unsigned effort = 12;    // restructured subject graphs, besides the expressions as written
+  unsigned threads = 0;    // 0 = all cores
+  uint64_t seed = 1;
+};
+
+struct MappedModule {
+  std::string name;
+  uint8_t family = GF_ORNOR;
+  bool four = true;
+  GateTT tt{};                         // GF_CUSTOM only
+  std::vector<std::string> rows[4];    // nets on each row ("1" = tied high)
+  unsigned stage = 0;                  // 1 = fed by circuit inputs only
+  std::string y, yb;                   // what each output carries (for the plan)
+};
+
+struct MapResult {
+  std::vector<MappedModule> modules;
+  std::vector<std::pair<std::string, std::string>> outputs;   // output name, net
+  unsigned stages = 0;                 // modules on the longest input-to-output path
+  unsigned custom = 0;                 // modules that need USER tables
+  std::string strategy;                // subject graph that won
+  unsigned tried = 0;
+  uint64_t cuts = 0, matches = 0, memoHits = 0;
+  double seconds = 0;
+  unsigned threads = 0;
+};
+
+// Throws std::runtime_error for specs it cannot take (too many inputs, no outputs).
+MapResult mapCircuit(const MapSpec& spec, const MapOptions& opt);
+
+// The mapped circuit as a gatesim netlist, with an expect line per output.
+std::string mapNetlistText(const MapSpec& spec, const MapResult& r);
+
+// Sum of products for a table over spec inputs, as expression text ("A&!B | C").
+std::string sopText(const std::vector<uint64_t>& table, const std::vector<std::string>& inputs);
+
+} // namespace gatesim
@@ -0,0 +1,297 @@
+#include "Netlist.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace gatesim {
+
+NetId Netlist::find(const std::string& name) const {
+  auto it = netByName.find(name);
+  if (it == netByName.end()) throw NetlistError("unknown net '" + name + "'");
+  return it->second;
+}
+
+namespace {
+
+std::vector<std::string> split(const std::string& s, const char* seps) {
+  std::vector<std::string> out;
+  size_t i = 0;
+  while (i < s.size()) {
+    size_t j = s.find_first_of(seps, i);
+    if (j == std::string::npos) j = s.size();
+    if (j > i) out.push_back(s.substr(i, j - i));
+    i = j + 1;
+  }
+  return out;
+}
+
+std::string trim(const std::string& s) {
+  size_t a = s.find_first_not_of(" \t\r"), b = s.find_last_not_of(" \t\r");
+  return a == std::string::npos ? "" : s.substr(a, b - a + 1);
+}
+
+std::string upper(std::string s) {
+  for (char& c : s) c = (char)std::toupper((unsigned char)c);
+  return s;
+}
+
+struct Builder {
+  // Connections are resolved at the end, so modules can be listed in any order.
+  struct PendingPin    { uint32_t mod; uint8_t slot; std::string net; int line; };
+  struct PendingOutput { std::string name, net; int line; };
+  struct PendingExpect { std::string net, expr; int line; };
+
+  Netlist nl;
+  int line = 0;
+  std::vector<PendingPin> pins;
+  std::vector<PendingOutput> outputs;
+  std::vector<PendingExpect> expects;
+  std::vector<bool> explicitDelay;
+  uint32_t defaultDelay[2] = { 1000, 2000 };   // MK_GATE, MK_COUNTER
+  std::vector<int> driver;                     // net -> module, -1 = circuit input / constant
+
+  [[noreturn]] void fail(const std::string& what) const {
+    throw NetlistError(nl.source + ":" + std::to_string(line) + ": " + what);
+  }
+
+  NetId newNet(const std::string& name, int drivenBy) {
+    if (nl.netByName.count(name)) fail("'" + name + "' is already defined");
+    nl.netName.push_back(name);
+    nl.netByName[name] = (NetId)nl.netName.size() - 1;
+    driver.push_back(drivenBy);
+    return (NetId)nl.netName.size() - 1;
+  }
+
+  void alias(const std::string& name, NetId id) {
+    if (nl.netByName.count(name)) fail("'" + name + "' is already defined");
+    nl.netByName[name] = id;
+  }
+
+  uint32_t number(const std::string& v) const {
+    char* end = nullptr;
+    unsigned long n = std::strtoul(v.c_str(), &end, 0);
+    if (v.empty() || *end) fail("'" + v + "' is not a number");
+    return (uint32_t)n;
+  }
+
+  Builder(const std::string& source) {
+    nl.source = source;
+    newNet("0", -1);
+    newNet("1", -1);
+  }
+
+  // key=value options shared by gates and counters. Returns false if 'key' isn't one of them.
+  bool moduleOption(Module& m, const std::string& key, const std::string& value) {
+    if (key == "delay") {
+      m.delayNs = number(value);
+      explicitDelay.back() = true;
+      return true;
+    }
+    return false;
+  }
+
+  Module& addModule(ModuleKind kind, const std::string& name) {
+    if (name.empty() || name.find('.') != std::string::npos) fail("bad module name '" + name + "'");
+    for (const Module& m : nl.modules) if (m.name == name) fail("module '" + name + "' is already defined");
+    nl.modules.emplace_back();
+    explicitDelay.push_back(false);
+    Module& m = nl.modules.back();
+    m.kind = kind;
+    m.name = name;
+    m.line = line;
+    m.delayNs = defaultDelay[kind];
+    return m;
+  }
+
+  void connect(const std::string& what, const std::string& list, uint8_t slot, size_t maxPins) {
+    std::vector<std::string> nets = split(list, ",");
+    if (nets.size() > maxPins) fail(what + " has " + std::to_string(maxPins) + (maxPins == 1 ? " pin" : " pins"));
+    for (const std::string& n : nets) pins.push_back({ (uint32_t)nl.modules.size() - 1, slot, n, line });
+  }
+
+  void gate(const std::vector<std::string>& w) {
+    if (w.size() < 3) fail("gate <name> <family> [options]");
+    Module& m = addModule(MK_GATE, w[1]);
+    const std::string fam = upper(w[2]);
+    auto f = std::find_if(std::begin(FAMILY_NAMES), std::end(FAMILY_NAMES), [&](const char* n) { return fam == n; });
+    if (f == std::end(FAMILY_NAMES)) fail("unknown family '" + w[2] + "'");
+    m.family = (uint8_t)(f - std::begin(FAMILY_NAMES));
+    m.in.resize(4);
+    m.tt = GateTT{ 0x0000, 0xFFFF };   // firmware default for an unset GF_CUSTOM
+    bool rowFour = false;
+    for (size_t k = 3; k < w.size(); k++) {
+      const std::string& t = w[k];
+      if (t == "oled" || t == "3in") { m.four = false; continue; }
+      size_t eq = t.find('=');
+      if (eq == std::string::npos) fail("unknown gate option '" + t + "'");
+      const std::string key = t.substr(0, eq), value = t.substr(eq + 1);
+      if (moduleOption(m, key, value)) continue;
+      if (key.size() == 4 && key.compare(0, 3, "row") == 0 && key[3] >= '1' && key[3] <= '4') {
+        uint8_t r = key[3] - '1';
+        connect(key, value, r, ROW_PINS[r]);
+        rowFour |= r == 3;
+      } else if (key == "tt") {
+        std::vector<std::string> v = split(value, ",");
+        if (m.family != GF_CUSTOM || v.size() != 2) fail("tt=<Y>,</Y> is for CUSTOM gates");
+        m.tt = GateTT{ (uint16_t)number(v[0]), (uint16_t)number(v[1]) };
+      } else {
+        fail("unknown gate option '" + key + "'");
+      }
+    }
+    if (rowFour && !m.four) fail("row 4 is the OLED's I2C bus in 3-input mode");
+    if (m.family != GF_CUSTOM && !isSeqFamily(m.family)) m.tt = familyTT(m.family, m.four);
+    const std::string& n = m.name;
+    const int id = (int)nl.modules.size() - 1;
+    m.out = { newNet(n + ".Y", id), newNet(n + ".nY", id) };
+    alias(n + ".O1", m.out[0]);
+    alias(n + ".O2", m.out[1]);
+  }
+
+  void counter(const std::vector<std::string>& w) {
+    if (w.size() < 2) fail("counter <name> [options]");
+    Module& m = addModule(MK_COUNTER, w[1]);
+    m.in.resize(CI__COUNT);
+    std::vector<std::pair<std::string, std::string>> wires;
+    for (size_t k = 2; k < w.size(); k++) {
+      const std::string& t = w[k];
+      if (t == "cascade") { m.cascade = true; continue; }
+      size_t eq = t.find('=');
+      if (eq == std::string::npos) fail("unknown counter option '" + t + "'");
+      const std::string key = t.substr(0, eq), value = t.substr(eq + 1);
+      if (!moduleOption(m, key, value)) wires.push_back({ upper(key), value });
+    }
+    for (auto& kv : wires) {
+      std::string pin = kv.first;
+      if (pin == "LOAD" && !m.cascade) pin = "ENT";   // kit firmware: the ENT pin is LOAD
+      auto p = std::find_if(std::begin(COUNTER_IN_NAMES), std::end(COUNTER_IN_NAMES), [&](const char* n) { return pin == n; });
+      if (p == std::end(COUNTER_IN_NAMES)) fail("unknown counter pin '" + kv.first + "'");
+      connect(pin, kv.second, (uint8_t)(p - std::begin(COUNTER_IN_NAMES)), 1);
+    }
+    const std::string& n = m.name;
+    const int id = (int)nl.modules.size() - 1;
+    for (int b = 0; b < 4; b++) m.out.push_back(newNet(n + ".BO" + std::to_string(b + 1), id));
+    m.out.push_back(newNet(n + ".RCO", id));
+    for (int d = 1; d <= 10; d++) m.out.push_back(newNet(n + ".D" + std::to_string(d), id));
+  }
+
+  void statement(const std::string& text) {
+    std::vector<std::string> w = split(text, " \t\r");
+    if (w.empty()) return;
+    const std::string& kw = w[0];
+    if (kw == "input") {
+      for (size_t k = 1; k < w.size(); k++) nl.inputs.push_back(newNet(w[k], -1));
+    } else if (kw == "gate") {
+      gate(w);
+    } else if (kw == "counter") {
+      counter(w);
+    } else if (kw == "output") {
+      for (size_t k = 1; k < w.size(); k++) {
+        size_t eq = w[k].find('=');
+        if (eq == std::string::npos) outputs.push_back({ w[k], w[k], line });
+        else outputs.push_back({ w[k].substr(0, eq), w[k].substr(eq + 1), line });
+      }
+    } else if (kw == "expect") {
+      std::string rest = trim(text.substr(text.find("expect") + 6));
+      size_t eq = rest.find('=');
+      if (eq == std::string::npos) fail("expect <net> = <expression>");
+      expects.push_back({ trim(rest.substr(0, eq)), trim(rest.substr(eq + 1)), line });
+    } else if (kw == "delay") {
+      for (size_t k = 1; k < w.size(); k++) {
+        size_t eq = w[k].find('=');
+        std::string key = eq == std::string::npos ? w[k] : w[k].substr(0, eq);
+        if (key == "gate" && eq != std::string::npos)         defaultDelay[MK_GATE] = number(w[k].substr(eq + 1));
+        else if (key == "counter" && eq != std::string::npos) defaultDelay[MK_COUNTER] = number(w[k].substr(eq + 1));
+        else fail("delay gate=<ns> counter=<ns>");
+      }
+    } else {
+      fail("unknown statement '" + kw + "'");
+    }
+  }
+
+  NetId resolve(const std::string& name, int at) {
+    auto it = nl.netByName.find(name);
+    if (it == nl.netByName.end()) { line = at; fail("unknown net '" + name + "'"); }
+    return it->second;
+  }
+
+  Netlist finish() {
+    for (size_t k = 0; k < nl.modules.size(); k++)
+      if (!explicitDelay[k]) nl.modules[k].delayNs = defaultDelay[nl.modules[k].kind];
+
+    for (const PendingPin& p : pins) nl.modules[p.mod].in[p.slot].push_back(resolve(p.net, p.line));
+    for (const PendingOutput& o : outputs) {
+      NetId id = resolve(o.net, o.line);
+      line = o.line;
+      if (o.name != o.net) alias(o.name, id);
+      nl.outputs.push_back({ o.name, id });
+    }
+    for (const PendingExpect& x : expects) {
+      line = x.line;
+      Expect e{ resolve(x.net, x.line), Expr{}, {}, x.net + " = " + x.expr, x.line };
+      try {
+        e.expr = parseExpr(x.expr);
+      } catch (const ExprError& err) {
+        fail(err.what());
+      }
+      for (const std::string& v : e.expr.vars) e.vars.push_back(resolve(v, x.line));
+      nl.expects.push_back(std::move(e));
+    }
+
+    // Fan-out, and a source-first order (Kahn). Whatever is left sits on a feedback loop
+    // and is appended in file order; the simulators iterate those to a fixed point.
+    const size_t nm = nl.modules.size();
+    nl.fanout.assign(nl.netCount(), {});
+    std::vector<uint32_t> indeg(nm, 0);
+    for (uint32_t m = 0; m < nm; m++) {
+      const Module& mod = nl.modules[m];
+      nl.sequential |= mod.kind == MK_COUNTER || isSeqFamily(mod.family);
+      for (const auto& slot : mod.in)
+        for (NetId n : slot) {
+          auto& f = nl.fanout[n];
+          if (!f.empty() && f.back() == m) continue;
+          f.push_back(m);
+          if (driver[n] >= 0) indeg[m]++;
+        }
+    }
+    std::vector<uint32_t> ready;
+    for (uint32_t m = 0; m < nm; m++) if (!indeg[m]) ready.push_back(m);
+    std::vector<bool> placed(nm, false);
+    while (!ready.empty()) {
+      uint32_t m = ready.front();
+      ready.erase(ready.begin());
+      nl.order.push_back(m);
+      placed[m] = true;
+      for (NetId n : nl.modules[m].out)
+        for (uint32_t r : nl.fanout[n])
+          if (--indeg[r] == 0) ready.push_back(r);
+    }
+    nl.cyclic = nl.order.size() != nm;
+    for (uint32_t m = 0; m < nm; m++) if (!placed[m]) nl.order.push_back(m);
+    return std::move(nl);
+  }
+};
+
+} // namespace
+
+Netlist parseNetlist(std::istream& in, const std::string& source) {
+  Builder b(source);
+  std::string text;
+  while (std::getline(in, text)) {
+    b.line++;
+    size_t hash = text.find('#');
+    if (hash != std::string::npos) text.resize(hash);
+    b.statement(text);
+  }
+  if (b.nl.modules.empty()) throw NetlistError(source + ": no modules");
+  return b.finish();
+}
+
+Netlist loadNetlist(const std::string& path) {
+  std::ifstream f(path);
+  if (!f) throw NetlistError("cannot open " + path);
+  return parseNetlist(f, path);
+}
+
+} // namespace gatesim
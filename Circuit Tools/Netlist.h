@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Expr.h"
+#include "GateModel.h"
+
+// =========================
+// Netlist of kit modules
+// One statement per line, '#' starts a comment:
+//
+//   input A B CIN                          circuit inputs (switches, a clock, ...)
+//   gate  x1 XORXNOR row1=A row2=B         Universal gate: family, rows (pins of one row are ORed)
+//   gate  m1 MAJMIN oled row1=A row2=B row3=CIN       'oled' = 3-input mode (row 4 is the I2C bus)
+//   gate  u1 CUSTOM tt=0x6996,0x9669 row1=A ...        GF_CUSTOM tables (bit i = rows i)
+//   counter c1 CLK=clk CLR=1 ENP=1 ENT=1   LS161 module ('cascade' = CASCADE_MODE 1; LOAD = ENT)
+//   output SUM=x2.Y COUT=m1.Y              names for nets (and what --run prints)
+//   expect SUM = A ^ B ^ CIN               checked for every input vector
+//   delay gate=1500 counter=3000           default propagation delays in ns (event mode)
+//
+// Every module option also takes delay=NS. Nets: the inputs, 0 and 1, and the module
+// outputs <gate>.Y / <gate>.nY (aliases .O1 / .O2), <counter>.BO1..BO4 / .RCO / .D1..D10.
+// Unconnected module inputs read low, like the pull-downs on the gate rows.
+// =========================
+
+namespace gatesim {
+
+using NetId = uint32_t;
+constexpr NetId NET_0 = 0, NET_1 = 1;
+
+struct NetlistError : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+enum ModuleKind : uint8_t { MK_GATE, MK_COUNTER };
+
+struct Module {
+  ModuleKind kind = MK_GATE;
+  std::string name;
+  int line = 0;
+  uint8_t family = GF_ORNOR;           // gate
+  bool four = true;                    // gate: false = OLED fitted, 3-input mode
+  GateTT tt{};                         // gate: combinational tables for this mode
+  bool cascade = false;                // counter: CASCADE_MODE 1 firmware
+  uint32_t delayNs = 0;
+  std::vector<std::vector<NetId>> in;  // gate: rows 1..4; counter: CounterIn (0 or 1 net each)
+  std::vector<NetId> out;              // gate: Y, /Y; counter: CounterOut
+};
+
+struct Expect {
+  NetId net;
+  Expr expr;
+  std::vector<NetId> vars;   // net of each expr.vars[i]
+  std::string text;
+  int line;
+};
+
+struct Netlist {
+  std::string source;
+  std::vector<std::string> netName;                   // canonical name of each net
+  std::unordered_map<std::string, NetId> netByName;   // every name, aliases included
+  std::vector<NetId> inputs;
+  std::vector<std::pair<std::string, NetId>> outputs;
+  std::vector<Module> modules;
+  std::vector<Expect> expects;
+
+  // Derived by finish()
+  std::vector<uint32_t> order;                 // modules, sources first
+  std::vector<std::vector<uint32_t>> fanout;   // net -> modules reading it
+  bool cyclic = false;                         // feedback between modules (latches, oscillators)
+  bool sequential = false;                     // any flip-flop, latch or counter
+
+  size_t netCount() const { return netName.size(); }
+  NetId find(const std::string& name) const;   // throws NetlistError if unknown
+};
+
+Netlist parseNetlist(std::istream& in, const std::string& source);
+Netlist loadNetlist(const std::string& path);
+
+} // namespace gatesim
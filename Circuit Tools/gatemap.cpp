@@ -0,0 +1,230 @@
+// BreadboarD GeniuS technology mapper
+// Turns boolean functions into the fewest kit modules and prints the wiring plan and
+// each module's configuration. The plan is checked with the gatesim checker before it is shown.
+//
+//   gatemap "F = A&B | C&D"                         one output from an expression
+//   gatemap "S = A^B^CIN" "COUT = A&B | CIN&(A^B)"  several outputs share modules
+//   gatemap --inputs A,B,C --tt F=0xE8              from a truth table
+//   gatemap "F = ..." --presets --net plan.net      built-in families only, write the netlist
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "BitSim.h"
+#include "Mapper.h"
+#include "Netlist.h"
+
+using namespace gatesim;
+
+namespace {
+
+// --- Options ---
+struct Options {
+  std::vector<std::string> exprs, tts, inputs;
+  std::string net;
+  MapOptions map;
+};
+
+void usage() {
+  std::fprintf(stderr,
+    "usage: gatemap [options] \"F = expression\" [\"G = expression\" ...]\n"
+    "       gatemap [options] --inputs A,B,C --tt F=0xE8 [--tt G=...]\n"
+    "  --inputs A,B,..  input order (and the names for --tt); default: order of first use\n"
+    "  --tt NAME=HEX    an output from its truth table: bit i = output when input j = bit j of i\n"
+    "  --oled           every module has its OLED fitted (3-input mode)\n"
+    "  --presets        built-in families only (preset images, no USER tables)\n"
+    "  --net FILE       write the circuit as a gatesim netlist\n"
+    "  --effort N       restructured graphs to try besides the expressions as written (default 12)\n"
+    "  --seed S         variable-order seed (default 1)\n"
+    "  --threads N      worker threads (default: all cores)\n");
+}
+
+std::vector<std::string> split(const std::string& s, char sep) {
+  std::vector<std::string> v;
+  std::stringstream ss(s);
+  for (std::string t; std::getline(ss, t, sep);) if (!t.empty()) v.push_back(t);
+  return v;
+}
+
+std::string trim(const std::string& s) {
+  const size_t a = s.find_first_not_of(" \t"), b = s.find_last_not_of(" \t");
+  return a == std::string::npos ? "" : s.substr(a, b - a + 1);
+}
+
+bool parseArgs(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; i++) {
+    const std::string a = argv[i];
+    auto value = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+    const char* v = nullptr;
+    if (a == "--oled")         o.map.oled = true;
+    else if (a == "--presets") o.map.presets = true;
+    else if (a == "--inputs")  { if (!(v = value())) return false; o.inputs = split(v, ','); }
+    else if (a == "--tt")      { if (!(v = value())) return false; o.tts.push_back(v); }
+    else if (a == "--net")     { if (!(v = value())) return false; o.net = v; }
+    else if (a == "--effort")  { if (!(v = value())) return false; o.map.effort = (unsigned)std::strtoul(v, nullptr, 0); }
+    else if (a == "--seed")    { if (!(v = value())) return false; o.map.seed = std::strtoull(v, nullptr, 0); }
+    else if (a == "--threads") { if (!(v = value())) return false; o.map.threads = (unsigned)std::strtoul(v, nullptr, 0); }
+    else if (a[0] == '-') return false;
+    else o.exprs.push_back(a);
+  }
+  return !o.exprs.empty() || !o.tts.empty();
+}
+
+// --- Spec ---
+void addInput(MapSpec& spec, const std::string& name) {
+  if (std::find(spec.inputs.begin(), spec.inputs.end(), name) == spec.inputs.end()) spec.inputs.push_back(name);
+}
+
+MapSpec buildSpec(const Options& o) {
+  MapSpec spec;
+  spec.inputs = o.inputs;
+  for (size_t k = 0; k < o.exprs.size(); k++) {
+    MapSpec::Output out;
+    const size_t eq = o.exprs[k].find('=');
+    out.name = eq == std::string::npos ? (o.exprs.size() == 1 ? "F" : "F" + std::to_string(k + 1)) : trim(o.exprs[k].substr(0, eq));
+    out.text = trim(eq == std::string::npos ? o.exprs[k] : o.exprs[k].substr(eq + 1));
+    try {
+      out.expr = parseExpr(out.text);
+    } catch (const ExprError& e) {
+      throw std::runtime_error(out.name + ": " + e.what());
+    }
+    for (const std::string& v : out.expr.vars) {
+      if (!o.inputs.empty() && std::find(o.inputs.begin(), o.inputs.end(), v) == o.inputs.end())
+        throw std::runtime_error(out.name + ": '" + v + "' is not in --inputs");
+      addInput(spec, v);
+    }
+    spec.outputs.push_back(out);
+  }
+  if (!o.tts.empty() && o.inputs.empty()) throw std::runtime_error("--tt needs --inputs");
+  const size_t n = spec.inputs.size();
+  if (n > MAP_MAX_INPUTS) throw std::runtime_error(std::to_string(n) + " inputs, the mapper takes up to " + std::to_string(MAP_MAX_INPUTS));
+  const size_t bits = (size_t)1 << n, words = n <= 6 ? 1 : bits / 64;
+  const uint64_t mask = n >= 6 ? ~0ULL : (1ULL << bits) - 1;
+
+  // Expression tables: 64 input vectors per evaluation.
+  for (MapSpec::Output& out : spec.outputs) {
+    std::vector<uint64_t> vars(out.expr.vars.size()), scratch;
+    for (size_t w = 0; w < words; w++) {
+      for (size_t j = 0; j < vars.size(); j++) {
+        const size_t i = std::find(spec.inputs.begin(), spec.inputs.end(), out.expr.vars[j]) - spec.inputs.begin();
+        uint64_t lanes = 0;
+        for (unsigned b = 0; b < 64; b++) if ((((w * 64 + b) >> i) & 1)) lanes |= 1ULL << b;
+        vars[j] = lanes;
+      }
+      out.table.push_back(evalExpr(out.expr, vars.data(), scratch) & mask);
+    }
+  }
+
+  // Truth tables: hex digits, most significant first.
+  for (const std::string& t : o.tts) {
+    const size_t eq = t.find('=');
+    if (eq == std::string::npos) throw std::runtime_error("--tt NAME=HEX, got '" + t + "'");
+    MapSpec::Output out;
+    out.name = trim(t.substr(0, eq));
+    std::string hex = trim(t.substr(eq + 1));
+    if (hex.compare(0, 2, "0x") == 0 || hex.compare(0, 2, "0X") == 0) hex = hex.substr(2);
+    if (hex.empty() || hex.size() * 4 > std::max<size_t>(bits, 4) || hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+      throw std::runtime_error(out.name + ": " + std::to_string(bits) + "-bit table expected, got '" + t.substr(eq + 1) + "'");
+    out.table.assign(words, 0);
+    for (size_t d = 0; d < hex.size(); d++) {
+      const uint64_t digit = std::strtoul(hex.substr(hex.size() - 1 - d, 1).c_str(), nullptr, 16);
+      out.table[d / 16] |= digit << (4 * (d % 16));
+    }
+    if (out.table[0] & ~mask) throw std::runtime_error(out.name + ": table wider than " + std::to_string(bits) + " bits");
+    out.text = sopText(out.table, spec.inputs);
+    spec.outputs.push_back(out);
+  }
+  for (const MapSpec::Output& out : spec.outputs)
+    if (std::find(spec.inputs.begin(), spec.inputs.end(), out.name) != spec.inputs.end())
+      throw std::runtime_error("output " + out.name + " has the name of an input");
+  return spec;
+}
+
+// --- Plan ---
+const char* presetHex(uint8_t gf) {
+  switch (gf) {
+    case GF_ANDNAND: return "V2-And-Nand.hex";
+    case GF_ORNOR:   return "V2-Or-Nor.hex";
+    case GF_XORXNOR: return "V2-Xor-Xnor.hex";
+    case GF_MAJMIN:  return "V2-Majority-Minority.hex";
+    case GF_DUALNOT: return "V2-Dual-Not.hex";
+  }
+  return nullptr;
+}
+
+// GATE_FAMILIES in the programmer (the EEPROM family byte is the index).
+const char* programmerFamily(uint8_t gf) {
+  static const char* names[] = { "AND/NAND", "OR/NOR", "XOR/XNOR", "MAJ/MIN", "Dual NOT", "USER" };
+  return gf < sizeof names / sizeof names[0] ? names[gf] : "?";
+}
+
+std::string configText(const MappedModule& m) {
+  char s[160];
+  if (m.family == GF_CUSTOM)
+    std::snprintf(s, sizeof s, "Universal, family %d: --set-function USER --tt-y 0x%04X --tt-yb 0x%04X",
+                  m.family, m.tt.y, m.tt.yb);
+  else if (m.four)
+    std::snprintf(s, sizeof s, "%s, or Universal family %d: --set-function \"%s\"", presetHex(m.family), m.family, programmerFamily(m.family));
+  else
+    std::snprintf(s, sizeof s, "Universal + OLED, family %d: --set-function \"%s\"", m.family, programmerFamily(m.family));
+  return s;
+}
+
+void printPlan(const MapSpec& spec, const MapResult& r) {
+  std::printf("%zu inputs, %zu outputs: %zu modules, %u stages (%u USER)  [%s of %u graphs, %.3f s, %u thread(s)]\n",
+              spec.inputs.size(), spec.outputs.size(), r.modules.size(), r.stages, r.custom, r.strategy.c_str(),
+              r.tried, r.seconds, r.threads);
+  std::printf("  cuts %llu, module matches %llu (+%llu memoised)\n", (unsigned long long)r.cuts,
+              (unsigned long long)r.matches, (unsigned long long)r.memoHits);
+  for (const MappedModule& m : r.modules) {
+    std::printf("\n%s  stage %u  %s%s\n", m.name.c_str(), m.stage, FAMILY_NAMES[m.family], m.four ? "" : " (3-input, OLED)");
+    for (int row = 0; row < 4; row++) {
+      if (m.rows[row].empty()) continue;
+      std::string pins;
+      for (const std::string& p : m.rows[row]) pins += (pins.empty() ? "" : ", ") + p;
+      std::printf("  row%d <- %s\n", row + 1, pins.c_str());
+    }
+    if (!m.y.empty())  std::printf("  Y    -> %s\n", m.y.c_str());
+    if (!m.yb.empty()) std::printf("  /Y   -> %s\n", m.yb.c_str());
+    std::printf("  config: %s\n", configText(m).c_str());
+  }
+  std::printf("\n");
+  for (const auto& o : r.outputs) std::printf("%s = %s\n", o.first.c_str(), o.second.c_str());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options o;
+  if (!parseArgs(argc, argv, o)) { usage(); return 2; }
+  try {
+    const MapSpec spec = buildSpec(o);
+    const MapResult r = mapCircuit(spec, o.map);
+    printPlan(spec, r);
+    if (r.modules.empty()) {
+      std::printf("(no modules needed: the outputs are inputs or constants)\n");
+      return 0;
+    }
+
+    // Same checker as gatesim, on the netlist it would be given.
+    const std::string text = mapNetlistText(spec, r);
+    std::istringstream in(text);
+    const Netlist nl = parseNetlist(in, "gatemap");
+    const CheckResult c = checkVectors(nl, CheckOptions{});
+    std::printf("check: %llu vectors, %llu failing\n", (unsigned long long)c.vectors, (unsigned long long)c.failures);
+    if (!o.net.empty()) {
+      std::ofstream f(o.net);
+      if (!(f << text)) throw std::runtime_error("cannot write " + o.net);
+      std::printf("netlist: %s\n", o.net.c_str());
+    }
+    return c.failures ? 1 : 0;
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 2;
+  }
+}
@@ -0,0 +1,298 @@
+// BreadboarD GeniuS circuit simulator
+// Checks a netlist of kit modules before it is wired up. See README.md for the netlist format.
+//
+//   gatesim adder.net                       every expect line, every input vector (bit-sliced)
+//   gatesim adder.net --timing              same vectors, event-driven: settle times and glitches
+//   gatesim counter.net --run count.stim    step through a stimulus file, print the outputs
+//   gatesim counter.net --run count.stim --event --vcd count.vcd
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "BitSim.h"
+#include "EventSim.h"
+#include "Netlist.h"
+
+using namespace gatesim;
+
+namespace {
+
+// --- Options ---
+struct Options {
+  std::string netlist, stimulus, vcd;
+  bool timing = false, event = false, bench = false;
+  unsigned threads = 0;
+  uint64_t random = 0, seed = 1, periodNs = 0;
+};
+
+void usage() {
+  std::fprintf(stderr,
+    "usage: gatesim CIRCUIT.net [options]\n"
+    "  (default)      check every 'expect' line on every input vector (zero delay)\n"
+    "  --timing       event-driven run over the same vectors: settle times, glitches\n"
+    "  --run STIM     step through a stimulus file and print the outputs after each step\n"
+    "  --event        with --run: event-driven, one step every --period ns (default 10000)\n"
+    "  --vcd FILE     with --run --event: write the trace as a VCD file\n"
+    "  --period NS    --timing: count vectors that settle slower than this\n"
+    "  --random N     N random vectors instead of all 2^inputs\n"
+    "  --seed S       random vector seed (default 1)\n"
+    "  --threads N    worker threads (default: all cores)\n"
+    "  --bench        repeat the check for about a second and report vectors/s\n");
+}
+
+bool parseArgs(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; i++) {
+    const std::string a = argv[i];
+    auto value = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+    const char* v = nullptr;
+    if (a == "--timing")       o.timing = true;
+    else if (a == "--event")   o.event = true;
+    else if (a == "--bench")   o.bench = true;
+    else if (a == "--run")     { if (!(v = value())) return false; o.stimulus = v; }
+    else if (a == "--vcd")     { if (!(v = value())) return false; o.vcd = v; }
+    else if (a == "--period")  { if (!(v = value())) return false; o.periodNs = std::strtoull(v, nullptr, 0); }
+    else if (a == "--random")  { if (!(v = value())) return false; o.random = std::strtoull(v, nullptr, 0); }
+    else if (a == "--seed")    { if (!(v = value())) return false; o.seed = std::strtoull(v, nullptr, 0); }
+    else if (a == "--threads") { if (!(v = value())) return false; o.threads = (unsigned)std::strtoul(v, nullptr, 0); }
+    else if (a[0] == '-' || !o.netlist.empty()) return false;
+    else o.netlist = a;
+  }
+  return !o.netlist.empty() && (o.vcd.empty() || o.event) && (!o.event || !o.stimulus.empty());
+}
+
+std::string vectorText(const Netlist& nl, uint64_t vec) {
+  std::string s;
+  for (size_t i = 0; i < nl.inputs.size(); i++)
+    s += (i ? " " : "") + nl.netName[nl.inputs[i]] + "=" + (((vec >> i) & 1) ? "1" : "0");
+  return s;
+}
+
+// "A=1 B=0 C=1, B rose"
+std::string transitionText(const Netlist& nl, uint64_t from, uint64_t to) {
+  std::string s = vectorText(nl, to), moved;
+  for (size_t i = 0; i < nl.inputs.size(); i++)
+    if (((from ^ to) >> i) & 1) moved += (moved.empty() ? "" : " ") + nl.netName[nl.inputs[i]] + (((to >> i) & 1) ? "+" : "-");
+  return moved.empty() ? s : s + " after " + moved;
+}
+
+// --- Check modes ---
+int runCheck(const Netlist& nl, const Options& o) {
+  if (nl.expects.empty()) { std::fprintf(stderr, "%s: no expect lines to check\n", nl.source.c_str()); return 2; }
+  CheckOptions co;
+  co.threads = o.threads;
+  co.randomVectors = o.random;
+  co.seed = o.seed;
+  CheckResult r = checkVectors(nl, co);
+  if (o.bench) {
+    uint64_t vectors = r.vectors;
+    double seconds = r.seconds;
+    while (seconds < 1.0) {
+      CheckResult again = checkVectors(nl, co);
+      vectors += again.vectors;
+      seconds += again.seconds;
+    }
+    std::printf("bench: %.3g vectors/s on %u thread(s)\n", vectors / seconds, r.threads);
+  }
+
+  std::printf("%s vectors: %llu, failing: %llu", o.random ? "random" : "exhaustive",
+              (unsigned long long)r.vectors, (unsigned long long)r.failures);
+  if (r.unstable) std::printf(" (%llu never settle)", (unsigned long long)r.unstable);
+  std::printf("  [%.3f s, %u thread(s)]\n", r.seconds, r.threads);
+  for (const CheckFailure& f : r.first) {
+    if (f.expect == SIZE_MAX) std::printf("  %s: does not settle\n", vectorText(nl, f.vector).c_str());
+    else std::printf("  %s: expect %s, got %d (line %d)\n", vectorText(nl, f.vector).c_str(),
+                     nl.expects[f.expect].text.c_str(), (int)f.got, nl.expects[f.expect].line);
+  }
+  return r.failures ? 1 : 0;
+}
+
+int runTiming(const Netlist& nl, const Options& o) {
+  TimingOptions to;
+  to.threads = o.threads;
+  to.randomVectors = o.random;
+  to.seed = o.seed;
+  to.periodNs = o.periodNs;
+  TimingResult r = checkTiming(nl, to);
+
+  std::printf("%s: %llu transitions, %llu events  [%.3f s, %u thread(s)]\n",
+              r.exhaustive ? "every single-input flip, both ways" : "random walk",
+              (unsigned long long)r.transitions, (unsigned long long)r.events, r.seconds, r.threads);
+  std::printf("worst settle: %llu ns, %s\n", (unsigned long long)r.worstSettleNs,
+              transitionText(nl, r.worstFrom, r.worstTo).c_str());
+  for (const auto& w : r.worstPerNet) std::printf("  %-12s %8llu ns\n", w.first.c_str(), (unsigned long long)w.second);
+  std::printf("glitching transitions: %llu, expect failures: %llu, never settle: %llu",
+              (unsigned long long)r.glitchy, (unsigned long long)r.mismatches, (unsigned long long)r.oscillating);
+  if (o.periodNs) std::printf(", slower than %llu ns: %llu", (unsigned long long)o.periodNs, (unsigned long long)r.late);
+  std::printf("\n");
+  for (const TimingReport& t : r.first) std::printf("  %s: %s\n", transitionText(nl, t.from, t.to).c_str(), t.what.c_str());
+  return (r.mismatches || r.oscillating || r.late) ? 1 : 0;
+}
+
+// --- Stimulus run ---
+// One step per line: NAME=0/1 ... (inputs not named keep their value).
+// 'pulse NAME [N]' expands to N steps of NAME=1 followed by NAME=0.
+struct Step { std::vector<std::pair<NetId, bool>> set; int line; };
+
+std::vector<Step> loadStimulus(const Netlist& nl, const std::string& path) {
+  std::ifstream f(path);
+  if (!f) throw NetlistError("cannot open " + path);
+  std::vector<Step> steps;
+  std::string text;
+  for (int line = 1; std::getline(f, text); line++) {
+    size_t hash = text.find('#');
+    if (hash != std::string::npos) text.resize(hash);
+    std::istringstream ws(text);
+    std::vector<std::string> w;
+    for (std::string t; ws >> t;) w.push_back(t);
+    if (w.empty()) continue;
+    auto input = [&](const std::string& name) {
+      try {
+        NetId id = nl.find(name);
+        for (NetId in : nl.inputs) if (in == id) return id;
+      } catch (const NetlistError&) {}
+      throw NetlistError(path + ":" + std::to_string(line) + ": '" + name + "' is not a circuit input");
+    };
+    if (w[0] == "pulse") {
+      if (w.size() < 2) throw NetlistError(path + ":" + std::to_string(line) + ": pulse NAME [N]");
+      const NetId id = input(w[1]);
+      const long count = w.size() > 2 ? std::strtol(w[2].c_str(), nullptr, 0) : 1;
+      for (long k = 0; k < count; k++) {
+        steps.push_back({ { { id, true } }, line });
+        steps.push_back({ { { id, false } }, line });
+      }
+      continue;
+    }
+    Step s{ {}, line };
+    for (const std::string& t : w) {
+      size_t eq = t.find('=');
+      if (eq == std::string::npos || (t.substr(eq + 1) != "0" && t.substr(eq + 1) != "1"))
+        throw NetlistError(path + ":" + std::to_string(line) + ": expected NAME=0 or NAME=1, got '" + t + "'");
+      s.set.push_back({ input(t.substr(0, eq)), t[eq + 1] == '1' });
+    }
+    steps.push_back(s);
+  }
+  return steps;
+}
+
+// What --run prints: the declared outputs, or every gate's Y and every counter's count.
+std::vector<std::pair<std::string, NetId>> shownNets(const Netlist& nl) {
+  if (!nl.outputs.empty()) return nl.outputs;
+  std::vector<std::pair<std::string, NetId>> shown;
+  for (const Module& m : nl.modules) {
+    if (m.kind == MK_GATE) shown.push_back({ m.name + ".Y", m.out[0] });
+    else for (int b = 3; b >= 0; b--) shown.push_back({ m.name + ".BO" + std::to_string(b + 1), m.out[CO_BO1 + b] });
+  }
+  return shown;
+}
+
+void printHeader(const Netlist& nl, const std::vector<std::pair<std::string, NetId>>& shown) {
+  std::printf("step ");
+  for (NetId in : nl.inputs) std::printf(" %s", nl.netName[in].c_str());
+  std::printf("  |");
+  for (const auto& s : shown) std::printf(" %s", s.first.c_str());
+  std::printf("\n");
+}
+
+template <class Get>
+void printRow(size_t k, const Netlist& nl, const std::vector<std::pair<std::string, NetId>>& shown, Get get) {
+  std::printf("%4zu ", k);
+  for (NetId in : nl.inputs) std::printf(" %*d", (int)nl.netName[in].size(), (int)get(in));
+  std::printf("  |");
+  for (const auto& s : shown) std::printf(" %*d", (int)s.first.size(), (int)get(s.second));
+  std::printf("\n");
+}
+
+// VCD: every net but the constants, in ns.
+struct VcdWriter {
+  std::ofstream f;
+  std::vector<std::string> id;
+
+  static std::string code(size_t n) {
+    std::string s;
+    do { s += (char)('!' + n % 94); n /= 94; } while (n);
+    return s;
+  }
+
+  VcdWriter(const std::string& path, const Netlist& nl, const EventSim& sim) : f(path) {
+    if (!f) throw NetlistError("cannot write " + path);
+    f << "$version BreadboarD GeniuS gatesim $end\n$timescale 1ns $end\n$scope module circuit $end\n";
+    for (size_t n = 0; n < nl.netCount(); n++) {
+      id.push_back(code(n));
+      if (n <= NET_1) continue;
+      std::string name = nl.netName[n];
+      for (char& c : name) if (c == '.') c = '_';
+      f << "$var wire 1 " << id[n] << " " << name << " $end\n";
+    }
+    f << "$upscope $end\n$enddefinitions $end\n#0\n";
+    for (size_t n = NET_1 + 1; n < nl.netCount(); n++) f << (sim.get((NetId)n) ? '1' : '0') << id[n] << "\n";
+  }
+
+  void change(uint64_t t, NetId n, bool v) { f << "#" << t << "\n" << (v ? '1' : '0') << id[n] << "\n"; }
+};
+
+int runStimulus(const Netlist& nl, const Options& o) {
+  const std::vector<Step> steps = loadStimulus(nl, o.stimulus);
+  const auto shown = shownNets(nl);
+  printHeader(nl, shown);
+
+  if (!o.event) {
+    BitSim sim(nl);   // lane 0 only
+    int bad = 0;
+    for (size_t k = 0; k < steps.size(); k++) {
+      for (const auto& s : steps[k].set) sim.set(s.first, s.second ? ~0ULL : 0);
+      if (sim.step() & 1) { std::printf("step %zu (line %d) does not settle\n", k, steps[k].line); bad = 1; }
+      printRow(k, nl, shown, [&](NetId n) { return sim.get(n) & 1; });
+    }
+    return bad;
+  }
+
+  const uint64_t period = o.periodNs ? o.periodNs : 10000;
+  const uint64_t maxEvents = 100000;
+  EventSim sim(nl);
+  std::unique_ptr<VcdWriter> vcd;
+  if (!o.vcd.empty()) {
+    vcd.reset(new VcdWriter(o.vcd, nl, sim));
+    const uint64_t base = sim.now();
+    sim.trace = [&](uint64_t t, NetId n, bool v) { vcd->change(t - base, n, v); };
+  }
+  int bad = 0;
+  for (size_t k = 0; k < steps.size(); k++) {
+    for (const auto& s : steps[k].set) sim.set(s.first, s.second);
+    if (!sim.runUntil(sim.now() + period, maxEvents)) {
+      std::printf("step %zu (line %d) does not settle\n", k, steps[k].line);
+      bad = 1;
+      break;
+    }
+    if (sim.busy()) { std::printf("step %zu (line %d) still switching after %llu ns\n", k, steps[k].line, (unsigned long long)period); bad = 1; }
+    printRow(k, nl, shown, [&](NetId n) { return sim.get(n); });
+  }
+  if (vcd) std::printf("trace: %s\n", o.vcd.c_str());
+  return bad;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options o;
+  if (!parseArgs(argc, argv, o)) { usage(); return 2; }
+  try {
+    Netlist nl = loadNetlist(o.netlist);
+    size_t gates = 0;
+    for (const Module& m : nl.modules) gates += m.kind == MK_GATE;
+    std::printf("%s: %zu inputs, %zu gates, %zu counters, %zu expects%s%s\n", nl.source.c_str(), nl.inputs.size(),
+                gates, nl.modules.size() - gates, nl.expects.size(), nl.sequential ? ", sequential" : "",
+                nl.cyclic ? ", feedback" : "");
+    if (!o.stimulus.empty()) return runStimulus(nl, o);
+    if (o.timing) return runTiming(nl, o);
+    return runCheck(nl, o);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 2;
+  }
+}
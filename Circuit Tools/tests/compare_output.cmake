@@ -0,0 +1,10 @@
+# cmake -DCMD=<program;args...> -DEXPECTED=<file> -P compare_output.cmake
+# Runs CMD in the current directory; fails unless it exits 0 and prints exactly EXPECTED.
+execute_process(COMMAND ${CMD} RESULT_VARIABLE rc OUTPUT_VARIABLE out)
+if(NOT rc EQUAL 0)
+  message(FATAL_ERROR "${CMD} exited with ${rc}:\n${out}")
+endif()
+file(READ "${EXPECTED}" expected)
+if(NOT out STREQUAL expected)
+  message(FATAL_ERROR "output differs from ${EXPECTED}:\n${out}")
+endif()
@@ -0,0 +1,101 @@
+#pragma once
+#include "HostMcu.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <util/crc16.h>
+
+// =========================
+// Helpers shared by the host test programs
+// Each program boots one sketch once (its globals can't be reset), so one ctest case is one
+// process: the arguments pick the family / mode, and main() returns ht::result().
+// =========================
+
+namespace ht {
+
+inline unsigned& failures() { static unsigned n = 0; return n; }
+
+// Count a failed check; the first 20 are printed with their context.
+inline bool check(bool ok, const char* fmt, ...) {
+  if (ok) return true;
+  if (++failures() <= 20) {
+    std::va_list ap;
+    va_start(ap, fmt);
+    std::fputs("FAIL: ", stderr);
+    std::vfprintf(stderr, fmt, ap);
+    std::fputc('\n', stderr);
+    va_end(ap);
+  }
+  return false;
+}
+
+inline int result(const char* what) {
+  if (failures()) { std::fprintf(stderr, "%s: %u failed checks\n", what, failures()); return 1; }
+  std::printf("%s: ok\n", what);
+  return 0;
+}
+
+// Universal gate config record (ConfigRecord in the sketch, build_config_record() in the
+// programmer tool), written straight into the EEPROM model before host::boot().
+struct GateConfig {
+  uint8_t family = 1;                          // GF_ORNOR, the factory default
+  uint8_t filter[4] = { 0x53, 0x53, 0x53, 0x53 };  // FILT_NOFM(2, 3)
+  uint8_t brightness = 255;
+  uint16_t ttY = 0x0000, ttYb = 0xFFFF;
+};
+
+#define HT_EE_CONFIG 16
+
+inline void writeGateConfig(const GateConfig& c) {
+  uint8_t r[16] = { 0x47, 1, c.family, c.filter[0], c.filter[1], c.filter[2], c.filter[3], c.brightness,
+                    (uint8_t)c.ttY, (uint8_t)(c.ttY >> 8), (uint8_t)c.ttYb, (uint8_t)(c.ttYb >> 8),
+                    0xFF, 0xFF, 0, 0 };
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < 14; i++) crc = _crc16_update(crc, r[i]);
+  r[14] = (uint8_t)crc;
+  r[15] = (uint8_t)(crc >> 8);
+  for (uint8_t i = 0; i < 16; i++) host::eeprom()[HT_EE_CONFIG + i] = r[i];
+}
+
+// V2 board: pin map of the Universal gate (IN_* / O1* / O2* in the sketch) and its families.
+namespace v2 {
+
+const uint8_t ROW_PINS[4][3] = {
+  { PIN_PA1, PIN_PA2, PIN_PA3 },
+  { PIN_PA5, PIN_PA6, 0xFF },
+  { PIN_PA7, PIN_PB5, 0xFF },
+  { PIN_PB4, PIN_PB1, PIN_PB0 },   // IN_4A = MODE button, IN_4B/4C = I2C with an OLED
+};
+const uint8_t O1_PINS[3] = { PIN_PB2, PIN_PC2, PIN_PC3 };
+const uint8_t O2_PINS[3] = { PIN_PB3, PIN_PC0, PIN_PC1 };
+
+const char* const FAMILIES[] = { "ANDNAND", "ORNOR", "XORXNOR", "MAJMIN", "DUALNOT", "CUSTOM",
+                                 "DLATCH", "DFF", "JKFF", "TFF" };
+enum { F_AND, F_OR, F_XOR, F_MAJ, F_NOT, F_CUSTOM, F_DLATCH, F_DFF, F_JK, F_T, F_COUNT };
+
+// "FAMILY" "oled"|"no-oled" from the command line.
+inline bool parseFamilyMode(const char* fam, const char* mode, uint8_t& f, bool& oled) {
+  f = F_COUNT;
+  for (uint8_t i = 0; i < F_COUNT; i++) if (!std::strcmp(fam, FAMILIES[i])) f = i;
+  oled = !std::strcmp(mode, "oled");
+  return f != F_COUNT && (oled || !std::strcmp(mode, "no-oled"));
+}
+
+struct Pin { uint8_t pin, row; };
+
+// Every input pin of the mode: 7 with the OLED (rows 1..3), 10 without.
+inline std::vector<Pin> inputPins(bool oled) {
+  std::vector<Pin> pins;
+  for (uint8_t r = 0; r < (oled ? 3 : 4); r++)
+    for (uint8_t k = 0; k < 3; k++) if (ROW_PINS[r][k] != 0xFF) pins.push_back({ ROW_PINS[r][k], r });
+  return pins;
+}
+
+}  // namespace v2
+
+// Index of the bit that changes between Gray codes k-1 and k (k >= 1).
+inline unsigned grayStep(unsigned k) { return __builtin_ctz(k); }
+
+}  // namespace ht
@@ -0,0 +1,227 @@
+// Universal Logic Gate (V2) built with HW_GATE 1: the CCL / event system setup per family.
+//
+//   ccl_test FAMILY oled|no-oled [Y /Y]     (Y, /Y: USER tables, CUSTOM only)
+//
+// The host model only stores the CCL, EVSYS and PORTMUX registers, so this test reads them
+// back after boot and evaluates them the way the silicon would: each LUT input from its
+// INSEL (IO pin, event channel and its generator, LINK, MASK), the LUT from TRUTHn, the
+// sequencer from SEQSEL, clocked by LUT0's IN2 when CLKSRC is set.
+//   3-input (OLED) mode, combinational: O1A/O1B (EVOUT1/EVOUT2) must be Y and O2C (LUT1
+//     output) /Y for every row vector, seen on the A pin of each row only. A USER /Y that
+//     is not a function of (Y, row 2, row 3) must leave the CCL off (CPU path).
+//   3-input mode, sequential: SEQSEL, CLKSRC = IN2 (not for the latch), LUT0 IN0 and LUT1 IN2
+//     masked, and the sequencer's Q on O1A/O1B must follow GateModel.h's seqStep() over a
+//     random walk.
+//   3-input mode, combinational: the B / C pins of each row are ignored, also by the
+//     CPU-driven outputs.
+//   4-input (no OLED) mode: the CCL is off and no event output is taken.
+
+#include "HostTest.h"
+
+#include <cstdlib>
+
+#include "GateModel.h"
+
+using namespace ht::v2;
+
+namespace {
+
+uint32_t g_lcg = 0xCC1;
+unsigned rnd(unsigned n) { g_lcg = g_lcg * 1103515245u + 12345u; return (g_lcg >> 16) % n; }
+
+// ATtiny1614/16/17 event users of the two LUTs and the event outputs (ASYNCUSERn)
+enum { U_LUT0EV0 = 2, U_LUT1EV0 = 3, U_LUT0EV1 = 4, U_LUT1EV1 = 5, U_EVOUT1 = 9, U_EVOUT2 = 10 };
+
+struct Levels {
+  uint8_t rows;   // bit0 = row 1 (on its A pin), bit1 = row 2, bit2 = row 3
+  bool lut[2];    // LUT outputs (LUT0: the sequencer output when SEQSEL is set)
+};
+
+const uint8_t* asyncUser() { return (const uint8_t*)&EVSYS.ASYNCUSER0; }
+const uint8_t* asyncCh() { return (const uint8_t*)&EVSYS.ASYNCCH0; }
+
+// Level of async channel ch, from its generator
+bool channel(uint8_t ch, const Levels& l) {
+  const uint8_t gen = asyncCh()[ch];
+  switch (ch) {
+    case 0: if (gen == EVSYS_ASYNCCH0_PORTA_PIN5_gc) return l.rows & 2; break;
+    case 1: if (gen == EVSYS_ASYNCCH1_CCL_LUT0_gc) return l.lut[0]; break;
+    case 3:
+      if (gen == EVSYS_ASYNCCH3_PORTA_PIN7_gc) return l.rows & 4;
+      if (gen == EVSYS_ASYNCCH3_PORTA_PIN1_gc) return l.rows & 1;
+      break;
+  }
+  ht::check(false, "ASYNCCH%u generator 0x%02X not expected", ch, gen);
+  return false;
+}
+
+// Level of an event user: the channel it takes (ASYNCUSER = ASYNCCHn + 3)
+bool user(uint8_t u, const Levels& l) {
+  const uint8_t v = asyncUser()[u];
+  if (v < EVSYS_ASYNCUSER_ASYNCCH0_gc || v > EVSYS_ASYNCUSER_ASYNCCH3_gc) {
+    ht::check(false, "ASYNCUSER%u = 0x%02X, no channel", u, v);
+    return false;
+  }
+  return channel(v - EVSYS_ASYNCUSER_ASYNCCH0_gc, l);
+}
+
+// Input k of LUT n. IO pins: LUT0 IN0..2 = PA0..PA2, of which only PA1 (IN_1A) is a row.
+bool lutInput(uint8_t n, uint8_t k, const Levels& l) {
+  const uint8_t ctrlb = n ? CCL.LUT1CTRLB : CCL.LUT0CTRLB, ctrlc = n ? CCL.LUT1CTRLC : CCL.LUT0CTRLC;
+  const uint8_t sel = k == 0 ? ctrlb & 0x0F : k == 1 ? ctrlb >> 4 : ctrlc & 0x0F;
+  switch (sel) {
+    case CCL_INSEL0_MASK_gc:   return false;
+    case CCL_INSEL0_LINK_gc:   return l.lut[n ^ 1];
+    case CCL_INSEL0_EVENT0_gc: return user(n ? U_LUT1EV0 : U_LUT0EV0, l);
+    case CCL_INSEL0_EVENT1_gc: return user(n ? U_LUT1EV1 : U_LUT0EV1, l);
+    case CCL_INSEL0_IO_gc:
+      if (n == 0 && k == 1) return l.rows & 1;
+      break;
+  }
+  ht::check(false, "LUT%u IN%u: INSEL 0x%X not expected", n, k, sel);
+  return false;
+}
+
+bool lut(uint8_t n, const Levels& l) {
+  const uint8_t i = lutInput(n, 0, l) | lutInput(n, 1, l) << 1 | lutInput(n, 2, l) << 2;
+  return ((n ? CCL.TRUTH1 : CCL.TRUTH0) >> i) & 1;
+}
+
+bool lutEnabled(uint8_t n) { return (n ? CCL.LUT1CTRLA : CCL.LUT0CTRLA) & CCL_ENABLE_bm; }
+
+void checkOff(const char* why) {
+  ht::check(!(CCL.CTRLA & CCL_ENABLE_bm) && !lutEnabled(0) && !lutEnabled(1), "%s: CCL still enabled", why);
+  ht::check(EVSYS.ASYNCUSER9 == EVSYS_ASYNCUSER_OFF_gc && EVSYS.ASYNCUSER10 == EVSYS_ASYNCUSER_OFF_gc &&
+                !(PORTMUX.CTRLA & (PORTMUX_EVOUT1_bm | PORTMUX_EVOUT2_bm | PORTMUX_LUT1_bm)),
+            "%s: an event or LUT output still drives a pin", why);
+}
+
+// O1A (EVOUT1 = PB2) and O1B (EVOUT2 = PC2) both carry LUT0's output event
+void checkEventOutputs(const Levels& l, bool want, const char* when) {
+  ht::check((PORTMUX.CTRLA & (PORTMUX_EVOUT1_bm | PORTMUX_EVOUT2_bm)) == (PORTMUX_EVOUT1_bm | PORTMUX_EVOUT2_bm),
+            "EVOUT1/EVOUT2 not on their pins");
+  ht::check(user(U_EVOUT1, l) == want && user(U_EVOUT2, l) == want, "%s: O1A/O1B %d/%d, expected %d", when,
+            user(U_EVOUT1, l), user(U_EVOUT2, l), want);
+}
+
+// /Y of a USER table as a function of (Y, row 2, row 3), as LUT1 sees it
+bool lut1CanBuild(gatesim::GateTT tt) {
+  int seen[8] = { -1, -1, -1, -1, -1, -1, -1, -1 };
+  for (uint8_t i = 0; i < 8; i++) {
+    const uint8_t j = ((i >> 2) & 1) | ((i >> 1) & 1) << 1 | ((tt.y >> i) & 1) << 2;
+    const int yb = (tt.yb >> i) & 1;
+    if (seen[j] >= 0 && seen[j] != yb) return false;
+    seen[j] = yb;
+  }
+  return true;
+}
+
+void combinational(uint8_t f, gatesim::GateTT tt) {
+  if (f == F_CUSTOM && !lut1CanBuild(tt)) {
+    checkOff("USER /Y not a function of (Y, row 2, row 3)");
+    return;
+  }
+  ht::check(CCL.CTRLA & CCL_ENABLE_bm && lutEnabled(0) && lutEnabled(1), "CCL not enabled");
+  ht::check(CCL.SEQCTRL0 == CCL_SEQSEL_DISABLE_gc, "SEQSEL 0x%02X on a combinational family", CCL.SEQCTRL0);
+  ht::check(!(CCL.LUT0CTRLA & CCL_OUTEN_bm) && (CCL.LUT1CTRLA & CCL_OUTEN_bm) && (PORTMUX.CTRLA & PORTMUX_LUT1_bm),
+            "LUT0 must not drive PA4 (WS2812), LUT1 must drive its alternate pin PC1 (O2C)");
+  for (uint8_t rows = 0; rows < 8; rows++) {
+    Levels l = { rows, { false, false } };
+    l.lut[0] = lut(0, l);
+    l.lut[1] = lut(1, l);
+    char when[24];
+    std::snprintf(when, sizeof(when), "rows %X", rows);
+    checkEventOutputs(l, (tt.y >> rows) & 1, when);
+    ht::check(l.lut[1] == ((tt.yb >> rows) & 1), "rows %X: O2C (LUT1) %d, expected /Y %d", rows, l.lut[1],
+              (tt.yb >> rows) & 1);
+  }
+}
+
+void sequential(uint8_t f) {
+  static const uint8_t SEQSEL[] = { CCL_SEQSEL_LATCH_gc, CCL_SEQSEL_DFF_gc, CCL_SEQSEL_JK_gc, CCL_SEQSEL_JK_gc };
+  const bool clocked = f != F_DLATCH;
+  ht::check(CCL.CTRLA & CCL_ENABLE_bm && lutEnabled(0) && lutEnabled(1), "CCL not enabled");
+  ht::check(CCL.SEQCTRL0 == SEQSEL[f - F_DLATCH], "SEQSEL 0x%02X, expected 0x%02X", CCL.SEQCTRL0, SEQSEL[f - F_DLATCH]);
+  ht::check(!!(CCL.LUT0CTRLA & CCL_CLKSRC_bm) == clocked, "LUT0 CLKSRC %d, expected %d (IN2 = row 2 as the clock)",
+            !!(CCL.LUT0CTRLA & CCL_CLKSRC_bm), clocked);
+  ht::check((CCL.LUT0CTRLB & 0x0F) == CCL_INSEL0_MASK_gc && (CCL.LUT1CTRLC & 0x0F) == CCL_INSEL2_MASK_gc,
+            "LUT0 IN0 / LUT1 IN2 not masked");
+  ht::check(!(CCL.LUT0CTRLA & CCL_OUTEN_bm) && !(CCL.LUT1CTRLA & CCL_OUTEN_bm) && !(PORTMUX.CTRLA & PORTMUX_LUT1_bm),
+            "a LUT output pin is enabled (PA4 is the WS2812, /Q goes through the CPU)");
+  ht::check((PORTB.PIN2CTRL & PORT_ISC_gm) == PORT_ISC_BOTHEDGES_gc, "no PB2 (O1A) interrupt to mirror /Q");
+
+  // Sequencer: D / J = LUT0, G / K = LUT1. DFF: Q = D on a clock edge while G; JK: set,
+  // reset or toggle on a clock edge; latch: Q = D while G. The clock is LUT0's IN2.
+  gatesim::SeqState s;
+  uint8_t rows = 0;
+  bool q = false, prevClk = false;
+  for (unsigned k = 0; k <= 3000; k++) {
+    if (k) rows ^= 1 << rnd(3);
+    Levels l = { rows, { q, false } };
+    const bool a = lut(0, l), b = lut(1, l), clk = lutInput(0, 2, l);
+    const bool edge = clocked && clk && !prevClk;
+    prevClk = clk;
+    switch (CCL.SEQCTRL0) {
+      case CCL_SEQSEL_DFF_gc:   if (edge && b) q = a; break;
+      case CCL_SEQSEL_JK_gc:    if (edge) q = (a && !q) || (!b && q); break;
+      case CCL_SEQSEL_LATCH_gc: if (b) q = a; break;
+    }
+    l.lut[0] = q;
+    const bool want = gatesim::seqStep(f, s, rows);
+    char when[40];
+    std::snprintf(when, sizeof(when), "step %u, rows %X", k, rows);
+    checkEventOutputs(l, want, when);
+  }
+}
+
+// Only the A pin of each row reaches the CCL, so in 3-input mode the B / C pins are not OR'd
+// in at all: the CPU-driven outputs (O1C, O2A) must agree with the CCL and ignore them too.
+void rowOrDropped(gatesim::GateTT tt) {
+  for (uint8_t r = 0; r < 3; r++)
+    for (uint8_t k = 0; k < 3; k++) {
+      if (ROW_PINS[r][k] == 0xFF) continue;
+      host::drive(ROW_PINS[r][k], true);
+      host::runFor(20000);
+      const uint8_t rows = k == 0 ? 1 << r : 0;
+      ht::check(host::level(O1_PINS[2]) == ((tt.y >> rows) & 1) && host::level(O2_PINS[0]) == ((tt.yb >> rows) & 1),
+                "row %u pin %c high: O1C %d O2A %d, expected %d %d", r + 1, 'A' + k, host::level(O1_PINS[2]),
+                host::level(O2_PINS[0]), (tt.y >> rows) & 1, (tt.yb >> rows) & 1);
+      host::drive(ROW_PINS[r][k], false);
+      host::runFor(20000);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint8_t f = F_COUNT;
+  bool oled = false;
+  if ((argc != 3 && argc != 5) || !parseFamilyMode(argv[1], argv[2], f, oled) || (argc == 5 && f != F_CUSTOM)) {
+    std::fprintf(stderr, "usage: ccl_test ANDNAND|ORNOR|...|TFF oled|no-oled [Y /Y]\n");
+    return 2;
+  }
+  ht::GateConfig cfg;
+  cfg.family = f;
+  if (argc == 5) {
+    cfg.ttY = (uint16_t)std::strtoul(argv[3], nullptr, 0);
+    cfg.ttYb = (uint16_t)std::strtoul(argv[4], nullptr, 0);
+  }
+  ht::writeGateConfig(cfg);
+  if (oled) host::attachOled(PIN_PB1, PIN_PB0);
+  host::boot();
+  host::runFor(100000);
+
+  if (!oled)
+    checkOff("4-input mode");
+  else if (gatesim::isSeqFamily(f))
+    sequential(f);
+  else {
+    const gatesim::GateTT tt = f == F_CUSTOM ? gatesim::GateTT{ cfg.ttY, cfg.ttYb } : gatesim::familyTT(f, false);
+    combinational(f, tt);
+    rowOrDropped(tt);
+  }
+
+  char what[64];
+  std::snprintf(what, sizeof(what), "CCL %s %s%s%s", FAMILIES[f], argv[2], argc == 5 ? " " : "", argc == 5 ? argv[3] : "");
+  return ht::result(what);
+}
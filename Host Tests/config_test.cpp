@@ -0,0 +1,61 @@
+// Universal Logic Gate (V2): booting from a config record the programmer tool wrote.
+//
+//   config_test RECORD FAMILY FILTER1..4 BRIGHTNESS TTY TTYB
+//
+// RECORD is the 16 bytes at EE_CONFIG of a device after "--set-function" (hex, from the fake
+// device in programmer/test_programmer.py). FAMILY is a gate_test family name, the filters are
+// the FILT_* bytes, TTY/TTYB the USER tables. The record must equal ht::writeGateConfig() of
+// the same settings, and the firmware must take it: no EEPROM write at boot, and the outputs
+// follow the family (USER: TTY/TTYB) for every input without the OLED.
+
+#include "HostTest.h"
+
+#include <cstdlib>
+
+#include "GateModel.h"
+
+using namespace ht::v2;
+
+int main(int argc, char** argv) {
+  uint8_t record[16];
+  uint8_t f = F_COUNT;
+  bool oled = false;
+  if (argc != 10 || std::strlen(argv[1]) != 32 || !parseFamilyMode(argv[2], "no-oled", f, oled) ||
+      gatesim::isSeqFamily(f)) {
+    std::fprintf(stderr, "usage: config_test RECORD(32 hex digits) ANDNAND|...|CUSTOM F1 F2 F3 F4 BRIGHTNESS TTY TTYB\n");
+    return 2;
+  }
+  for (uint8_t i = 0; i < 16; i++) {
+    const char byte[3] = { argv[1][2 * i], argv[1][2 * i + 1], 0 };
+    record[i] = (uint8_t)std::strtoul(byte, nullptr, 16);
+  }
+  ht::GateConfig cfg;
+  cfg.family = f;
+  for (uint8_t r = 0; r < 4; r++) cfg.filter[r] = (uint8_t)std::strtoul(argv[3 + r], nullptr, 0);
+  cfg.brightness = (uint8_t)std::strtoul(argv[7], nullptr, 0);
+  cfg.ttY = (uint16_t)std::strtoul(argv[8], nullptr, 0);
+  cfg.ttYb = (uint16_t)std::strtoul(argv[9], nullptr, 0);
+
+  ht::writeGateConfig(cfg);
+  for (uint8_t i = 0; i < 16; i++)
+    ht::check(host::eeprom()[HT_EE_CONFIG + i] == record[i], "record byte %u: programmer %02X, writeGateConfig %02X", i,
+              record[i], host::eeprom()[HT_EE_CONFIG + i]);
+  memcpy(&host::eeprom()[HT_EE_CONFIG], record, sizeof(record));
+
+  host::boot();
+  host::runFor(100000);
+  ht::check(host::eepromWrites() == 0, "boot wrote %u EEPROM bytes: record not taken", host::eepromWrites());
+
+  const gatesim::GateTT tt = f == F_CUSTOM ? gatesim::GateTT{ cfg.ttY, cfg.ttYb } : gatesim::familyTT(f, true);
+  for (uint8_t rows = 0; rows < 16; rows++) {
+    for (uint8_t r = 0; r < 4; r++) host::drive(ROW_PINS[r][0], rows & (1 << r));
+    host::runFor(20000);   // longer than the slowest filter
+    const bool y = (tt.y >> rows) & 1, yb = (tt.yb >> rows) & 1;
+    ht::check(host::level(O1_PINS[0]) == y && host::level(O2_PINS[0]) == yb, "%s, rows %X: O1A %d O2A %d, expected %d %d",
+              argv[2], rows, host::level(O1_PINS[0]), host::level(O2_PINS[0]), y, yb);
+  }
+
+  char what[40];
+  std::snprintf(what, sizeof(what), "config record %s", argv[2]);
+  return ht::result(what);
+}
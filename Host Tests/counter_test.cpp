@@ -0,0 +1,244 @@
+// V1 Binary Counter (LS161 module), run unmodified on the host MCU model (ATmega4809).
+// Built twice: counter_test (kit behaviour) and counter_cascade_test (CASCADE_MODE 1).
+//
+// Kit behaviour (CASCADE_MODE 0): on a rising CLK edge, CLR low clears, else the ENT pin low
+// loads BI1..BI4, else ENP high counts. CLR falling clears at once, without a clock.
+// RCO = ENT && ENP && count == 15, and follows ENP/ENT between clocks.
+// CASCADE_MODE 1: on a rising CLK edge, CLR low clears, else ENP && ENT count; BI1..BI4 are
+// never loaded. RCO = ENT && count == 15 (ENP does not gate it). CLR is asynchronous as above.
+// A second module rippled from this one's RCO must step on the same CLK edge.
+// Every clocked transition is checked exhaustively: each of the 16 counts against every
+// combination of CLR, ENP, ENT and BI1..BI4 on the edge.
+
+#include "HostTest.h"
+
+#include <cstring>
+
+#ifndef CASCADE_MODE
+#define CASCADE_MODE 0   // as the sketch defaults it
+#endif
+
+namespace {
+
+// Arduino pin numbers of the counter (Binary Counter / V1 README)
+enum : uint8_t {
+  BI4 = 0, D3 = 2, D4 = 3, CLK = 4, ENP = 5, ENT = 6, RCO = 7,
+  D10 = 14, D9 = 15, D8 = 16, D7 = 17, BI3 = 18, BI2 = 19, BI1 = 29,
+  BO1 = 30, BO2 = 31, BO3 = 32, BO4 = 33, D2 = 34, D1 = 35, D5 = 36, D6 = 37, CLR = 40,
+};
+const uint8_t BO[4] = { BO1, BO2, BO3, BO4 };
+const uint8_t BI[4] = { BI1, BI2, BI3, BI4 };
+const uint8_t D[10] = { D1, D2, D3, D4, D5, D6, D7, D8, D9, D10 };
+
+struct Inputs { bool clr, enp, ent; uint8_t bi; };
+
+void apply(const Inputs& in) {
+  host::drive(CLR, in.clr);
+  host::drive(ENP, in.enp);
+  host::drive(ENT, in.ent);
+  for (uint8_t i = 0; i < 4; i++) host::drive(BI[i], (in.bi >> i) & 1);
+}
+
+void pulse() {
+  host::drive(CLK, HIGH);
+  host::advanceUs(5);
+  host::drive(CLK, LOW);
+  host::advanceUs(5);
+}
+
+// Model of one rising edge.
+uint8_t next(uint8_t q, const Inputs& in) {
+  if (!in.clr) return 0;
+#if CASCADE_MODE
+  if (in.enp && in.ent) return (q + 1) & 15;
+#else
+  if (!in.ent) return in.bi;
+  if (in.enp) return (q + 1) & 15;
+#endif
+  return q;
+}
+
+#if CASCADE_MODE
+bool rco(uint8_t q, const Inputs& in) { return in.ent && q == 15; }
+#else
+bool rco(uint8_t q, const Inputs& in) { return in.ent && in.enp && q == 15; }
+#endif
+
+// BO1..BO4 = q, exactly one of D1..D10 for 1..10, RCO.
+void expectOutputs(const char* when, uint8_t q, bool r) {
+  uint8_t bo = 0;
+  for (uint8_t i = 0; i < 4; i++) bo |= host::level(BO[i]) << i;
+  uint16_t d = 0, dWant = (q >= 1 && q <= 10) ? 1 << (q - 1) : 0;
+  for (uint8_t i = 0; i < 10; i++) d |= host::level(D[i]) << i;
+  ht::check(bo == q && d == dWant && host::level(RCO) == r,
+            "%s: BO=%u D=%03X RCO=%d, expected %u / %03X / %d", when, bo, d, host::level(RCO), q, dWant, r);
+}
+
+#if CASCADE_MODE
+// No LOAD in this mode: clear, then count up to q.
+void loadCount(uint8_t q) {
+  apply({ false, true, true, 0 });
+  apply({ true, true, true, 0 });
+  for (uint8_t k = 0; k < q; k++) pulse();
+}
+#else
+// Load q through the LOAD (ENT) pin.
+void loadCount(uint8_t q) {
+  apply({ true, false, false, q });
+  pulse();
+}
+#endif
+
+void exhaustive() {
+  // Every count x every input combination on one rising edge.
+  for (uint8_t q0 = 0; q0 < 16; q0++) {
+    for (unsigned combo = 0; combo < 128; combo++) {
+      const Inputs in = { (bool)(combo & 1), (bool)(combo & 2), (bool)(combo & 4), (uint8_t)(combo >> 3) };
+      loadCount(q0);
+      apply(in);
+      char when[64];
+      // A falling CLR edge from apply() already cleared the count.
+      const uint8_t before = in.clr ? q0 : 0;
+      std::snprintf(when, sizeof(when), "count %u, CLR %d ENP %d ENT %d BI %u", q0, in.clr, in.enp, in.ent, in.bi);
+      expectOutputs(when, before, rco(before, in));
+      pulse();
+      std::strcat(when, ", CLK");
+      expectOutputs(when, next(before, in), rco(next(before, in), in));
+    }
+  }
+}
+
+#if CASCADE_MODE
+
+void cascadeTests() {
+  // ---- Count up through the wrap; RCO only at 15.
+  apply({ true, true, true, 0 });
+  uint8_t q = 0;
+  for (unsigned k = 0; k < 40; k++) {
+    pulse();
+    q = (q + 1) & 15;
+    expectOutputs("counting", q, q == 15);
+    if (k % 5 == 0) host::runFor(3000);
+  }
+
+  // ---- RCO = ENT && count == 15: ENP does not gate it, ENT does, no clock needed.
+  loadCount(15);
+  expectOutputs("terminal count", 15, true);
+  host::drive(ENP, LOW);
+  expectOutputs("ENP low at 15", 15, true);
+  pulse();
+  expectOutputs("clock with ENP low", 15, true);
+  host::drive(ENP, HIGH);
+  host::drive(ENT, LOW);
+  expectOutputs("ENT low at 15", 15, false);
+  pulse();
+  expectOutputs("clock with ENT low", 15, false);
+  host::drive(ENT, HIGH);
+  expectOutputs("ENT high again", 15, true);
+  pulse();
+  expectOutputs("wrap", 0, false);
+
+  // ---- BI1..BI4 are shown, never loaded.
+  apply({ true, true, false, 9 });
+  pulse();
+  expectOutputs("BI 9 with ENT low", 0, false);
+
+  // ---- Asynchronous clear: CLR falling clears without a clock, then holds it at 0.
+  loadCount(9);
+  host::drive(CLR, LOW);
+  expectOutputs("CLR falling", 0, false);
+  for (unsigned k = 0; k < 3; k++) pulse();
+  expectOutputs("clocks while CLR low", 0, false);
+  host::drive(CLR, HIGH);
+  pulse();
+  expectOutputs("CLR released", 1, false);
+
+  // ---- Two-module ripple chain (8 bits): common CLK and ENP, stage 1 ENT high, this
+  // module as stage 2 with ENT = stage 1's RCO. Stage 1 is modelled: its RCO moves 1 us
+  // after the edge (its own CLK interrupt; the model runs interrupts in zero time). Stage 2
+  // has sampled ENT by then, so both stages step on the same edge and the carry only shows
+  // up on the next one.
+  apply({ false, true, false, 0 });   // clear both stages
+  apply({ true, true, false, 0 });
+  uint8_t q1 = 0;
+  for (unsigned k = 1; k <= 300; k++) {
+    host::drive(CLK, HIGH);
+    q1 = (q1 + 1) & 15;
+    if (q1 == 15 || q1 == 0) host::driveAt(1, ENT, q1 == 15);   // stage 1's RCO
+    host::advanceUs(5);
+    host::drive(CLK, LOW);
+    host::advanceUs(5);
+    char when[48];
+    std::snprintf(when, sizeof(when), "chain, clock %u (value %02X)", k, k & 0xFF);
+    expectOutputs(when, (k >> 4) & 15, (k & 0xFF) == 0xFF);
+    if (k % 50 == 0) host::runFor(3000);
+  }
+  host::drive(ENT, HIGH);
+
+  exhaustive();
+}
+
+#else
+
+void kitTests() {
+  // ---- Count up through the wrap; RCO only at 15.
+  apply({ true, true, true, 0 });
+  uint8_t q = 0;
+  for (unsigned k = 0; k < 40; k++) {
+    pulse();
+    q = (q + 1) & 15;
+    expectOutputs("counting", q, q == 15);
+    if (k % 5 == 0) host::runFor(3000);   // loop() (display) between clocks changes nothing
+  }
+
+  // ---- RCO follows ENP/ENT at terminal count, no clock needed.
+  loadCount(15);
+  apply({ true, true, true, 0 });
+  expectOutputs("terminal count", 15, true);
+  host::drive(ENP, LOW);
+  expectOutputs("ENP low at 15", 15, false);
+  host::drive(ENP, HIGH);
+  host::drive(ENT, LOW);
+  expectOutputs("LOAD low at 15", 15, false);
+  host::drive(ENT, HIGH);
+  expectOutputs("ENP/ENT high again", 15, true);
+
+  // ---- Only rising CLK edges count.
+  loadCount(3);
+  apply({ true, true, true, 0 });
+  host::drive(CLK, HIGH);
+  expectOutputs("CLK rise", 4, false);
+  host::runFor(2000);
+  host::drive(CLK, LOW);
+  expectOutputs("CLK fall", 4, false);
+
+  // ---- Asynchronous clear: CLR falling clears without a clock, then holds it at 0.
+  loadCount(9);
+  apply({ true, true, true, 0 });
+  host::drive(CLR, LOW);
+  expectOutputs("CLR falling", 0, false);
+  for (unsigned k = 0; k < 3; k++) pulse();
+  expectOutputs("clocks while CLR low", 0, false);
+  host::drive(CLR, HIGH);
+  pulse();
+  expectOutputs("CLR released", 1, false);
+
+  exhaustive();
+}
+
+#endif
+
+}  // namespace
+
+int main() {
+  host::boot();
+  host::runFor(10000);
+  expectOutputs("after boot (CLR idles low)", 0, false);
+#if CASCADE_MODE
+  cascadeTests();
+#else
+  kitTests();
+#endif
+  host::runFor(10000);
+  return ht::result(CASCADE_MODE ? "counter (cascade)" : "counter");
+}
@@ -0,0 +1,246 @@
+// Loop-timing benchmark of the Universal Logic Gate (V2) on the host MCU model.
+//
+//   gate_bench FAMILY oled|no-oled [--baseline FILE] [--update FILE]
+//
+// The sketch is built with PHASE_TRACE 1, so every PHASE() mark is a GPIOR0 write that the
+// model reports with its cycle time. After boot the bench scripts a few thousand input edges
+// at pseudo-random times (so they land anywhere in the loop()/sleep/LED/OLED schedule) and
+// reports, in CPU cycles at F_CPU:
+//   - loop() pass length (PH_LOOP .. PH_IDLE, interrupts included)
+//   - input edge -> O1A / O2A edge
+//   - each phase, per entry: rowOR (PH_SAMPLE), eval (PH_EVAL), setBus (PH_DRIVE),
+//     ledsShowSafe (PH_LEDS), renderOLED (PH_OLED_RENDER), oled_flush (PH_OLED_FLUSH);
+//     output-path phases interrupting another phase are not counted in it.
+// as n / min / mean / p99 / max.
+//
+// Time is the model's: waits (delay, delayMicroseconds, sleep), millis()/micros() calls, the
+// WS2812 wire time with interrupts off and TWI0 bytes. Plain CPU work between them takes no
+// time, so PH_EVAL and PH_DRIVE read 0; for instruction-level cycles, run a PHASE_TRACE
+// build in an AVR simulator (developer note 8 in the sketch).
+//
+// --baseline FILE: exit 1 if mean, p99 or max of any metric is above its line in FILE by more
+// than 10 % (and 40 cycles). --update FILE: write this run's line(s) into FILE instead.
+
+#include "HostTest.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace ht::v2;
+
+namespace {
+
+// PHASE() numbers in the sketch
+enum { PH_IDLE = 0, PH_SAMPLE, PH_EVAL, PH_DRIVE, PH_LEDS, PH_OLED_RENDER, PH_OLED_FLUSH, PH_LOOP, PH_COUNT };
+
+const unsigned EDGES = 2000;
+const uint32_t GAP_MIN_US = 100, GAP_SPAN_US = 20000;   // between scripted edges
+const uint32_t SETTLE_US = 600;                          // after an edge, before the next one
+
+struct Stat {
+  std::vector<uint32_t> v;
+  void add(uint64_t x) { v.push_back((uint32_t)x); }
+};
+
+struct Summary { size_t n; uint32_t min, mean, p99, max; };
+
+Summary summarize(Stat& s) {
+  if (s.v.empty()) return { 0, 0, 0, 0, 0 };
+  std::sort(s.v.begin(), s.v.end());
+  uint64_t sum = 0;
+  for (uint32_t x : s.v) sum += x;
+  const size_t n = s.v.size();
+  const size_t i99 = (n * 99 + 99) / 100 - 1;
+  return { n, s.v.front(), (uint32_t)(sum / n), s.v[i99 < n ? i99 : n - 1], s.v.back() };
+}
+
+// ---- Phase tracking from the GPIOR0 writes
+bool g_record = false;
+Stat g_loop, g_phase[PH_COUNT];
+
+bool isPathPhase(uint8_t p) { return p == PH_SAMPLE || p == PH_EVAL || p == PH_DRIVE; }
+
+struct Tracker {
+  uint8_t cur = PH_IDLE;
+  uint64_t since = 0;
+  uint64_t acc = 0;           // time already spent in 'cur' before an output-path interruption
+  uint8_t outer = PH_IDLE;    // phase the output path interrupted
+  bool inPass = false;
+  uint64_t passStart = 0;
+} g_tr;
+
+void closeSpan(uint8_t p, uint64_t len) { if (g_record && p != PH_IDLE && p != PH_LOOP) g_phase[p].add(len); }
+
+void onPhase(uint8_t v, uint64_t t) {
+  Tracker& s = g_tr;
+  if (v == s.cur) return;
+  if (isPathPhase(v)) {
+    if (!isPathPhase(s.cur)) { s.outer = s.cur; s.acc += t - s.since; }   // pause the outer phase
+    else closeSpan(s.cur, t - s.since);
+    s.cur = v;
+    s.since = t;
+    return;
+  }
+  if (isPathPhase(s.cur)) {
+    closeSpan(s.cur, t - s.since);
+    if (v == s.outer) { s.cur = v; s.since = t; return; }               // resume it
+    closeSpan(s.outer, s.acc);
+  } else {
+    closeSpan(s.cur, s.acc + t - s.since);
+  }
+  s.acc = 0;
+  if (v == PH_LOOP && (s.cur == PH_IDLE || (isPathPhase(s.cur) && s.outer == PH_IDLE)) && !s.inPass) {
+    s.inPass = true;
+    s.passStart = t;
+  } else if (v == PH_IDLE && s.inPass) {
+    s.inPass = false;
+    if (g_record) g_loop.add(t - s.passStart);
+  }
+  s.cur = v;
+  s.since = t;
+}
+
+// ---- Baseline file: "FAMILY MODE METRIC MEAN P99 MAX" per line, '#' comments
+struct Metric { const char* key; const char* label; Stat* stat; };
+
+std::string lineKey(const std::string& line) {
+  std::istringstream in(line);
+  std::string a, b, c;
+  in >> a >> b >> c;
+  return a + " " + b + " " + c;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint8_t f;
+  bool oled;
+  const char* baseline = nullptr;
+  const char* update = nullptr;
+  bool ok = argc >= 3 && parseFamilyMode(argv[1], argv[2], f, oled);
+  for (int i = 3; ok && i < argc; i++) {
+    if (!std::strcmp(argv[i], "--baseline") && i + 1 < argc)    baseline = argv[++i];
+    else if (!std::strcmp(argv[i], "--update") && i + 1 < argc) update = argv[++i];
+    else ok = false;
+  }
+  if (!ok) {
+    std::fprintf(stderr, "usage: gate_bench ANDNAND|ORNOR|...|TFF oled|no-oled [--baseline FILE] [--update FILE]\n");
+    return 2;
+  }
+
+  ht::GateConfig cfg;
+  cfg.family = f;
+  cfg.ttY = 0x6996;                 // CUSTOM = 4-input parity: every edge moves Y and /Y
+  cfg.ttYb = 0x9669;
+  ht::writeGateConfig(cfg);
+  if (oled) host::attachOled(PIN_PB1, PIN_PB0);
+  host::traceGpior0(onPhase);
+  host::boot();
+  host::runFor(200000);             // past the first OLED frame and LED push
+
+  const std::vector<Pin> pins = inputPins(oled);
+  Stat lat[2];
+  const uint8_t OUT_PINS[2] = { O1_PINS[0], O2_PINS[0] };
+  const uint64_t cycPerUs = F_CPU / 1000000UL;
+  uint32_t levels = 0, lcg = 0x5EED;
+  g_record = true;
+  for (unsigned k = 0; k < EDGES; k++) {
+    lcg = lcg * 1103515245u + 12345u;
+    const uint32_t gap = GAP_MIN_US + (lcg >> 8) % GAP_SPAN_US;
+    lcg = lcg * 1103515245u + 12345u;
+    const unsigned bit = (lcg >> 16) % pins.size();
+    levels ^= 1u << bit;
+    const uint64_t te = host::cycles() + gap * cycPerUs;
+    host::driveAt(gap, pins[bit].pin, levels & (1u << bit));
+    host::runFor(gap + SETTLE_US);
+    for (uint8_t o = 0; o < 2; o++) {
+      const uint64_t e = host::lastEdge(OUT_PINS[o]);
+      if (e >= te) lat[o].add(e - te);
+    }
+  }
+  g_record = false;
+
+  Metric metrics[] = {
+    { "loop",    "loop() pass",          &g_loop },
+    { "lat_o1a", "edge -> O1A",          &lat[0] },
+    { "lat_o2a", "edge -> O2A",          &lat[1] },
+    { "sample",  "rowOR    PH_SAMPLE",   &g_phase[PH_SAMPLE] },
+    { "eval",    "eval     PH_EVAL",     &g_phase[PH_EVAL] },
+    { "drive",   "setBus   PH_DRIVE",    &g_phase[PH_DRIVE] },
+    { "leds",    "ledsShowSafe",         &g_phase[PH_LEDS] },
+    { "render",  "renderOLED",           &g_phase[PH_OLED_RENDER] },
+    { "flush",   "oled_flush",           &g_phase[PH_OLED_FLUSH] },
+  };
+  const char* const mode = oled ? "oled" : "no-oled";
+
+  std::printf("gate_bench %s %s: %u edges, CPU cycles at %lu MHz (host MCU model)\n",
+              FAMILIES[f], mode, EDGES, (unsigned long)cycPerUs);
+  std::printf("  %-20s %7s %8s %8s %8s %8s\n", "", "n", "min", "mean", "p99", "max");
+  Summary sum[sizeof(metrics) / sizeof(metrics[0])];
+  for (size_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++) {
+    const Summary s = sum[i] = summarize(*metrics[i].stat);
+    std::printf("  %-20s %7zu %8u %8u %8u %8u\n", metrics[i].label, s.n, s.min, s.mean, s.p99, s.max);
+  }
+
+  // Lines of this run, keyed "FAMILY MODE METRIC"
+  std::vector<std::string> mine;
+  for (size_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++) {
+    char line[96];
+    std::snprintf(line, sizeof(line), "%s %s %s %u %u %u", FAMILIES[f], mode, metrics[i].key,
+                  sum[i].mean, sum[i].p99, sum[i].max);
+    mine.push_back(line);
+  }
+
+  if (update) {
+    std::vector<std::string> lines;
+    std::ifstream in(update);
+    for (std::string l; std::getline(in, l);) lines.push_back(l);
+    in.close();
+    for (const std::string& m : mine) {
+      bool found = false;
+      for (std::string& l : lines) if (!l.empty() && l[0] != '#' && lineKey(l) == lineKey(m)) { l = m; found = true; }
+      if (!found) lines.push_back(m);
+    }
+    std::ofstream out(update);
+    for (const std::string& l : lines) out << l << "\n";
+    std::printf("baseline %s updated\n", update);
+    return 0;
+  }
+
+  if (baseline) {
+    std::ifstream in(baseline);
+    if (!in) { std::fprintf(stderr, "cannot read baseline %s\n", baseline); return 2; }
+    unsigned regressions = 0, compared = 0;
+    for (std::string l; std::getline(in, l);) {
+      if (l.empty() || l[0] == '#') continue;
+      for (size_t i = 0; i < mine.size(); i++) {
+        if (lineKey(l) != lineKey(mine[i])) continue;
+        compared++;
+        std::istringstream b(l);
+        std::string skip;
+        uint32_t base[3];
+        b >> skip >> skip >> skip >> base[0] >> base[1] >> base[2];
+        const uint32_t now[3] = { sum[i].mean, sum[i].p99, sum[i].max };
+        const char* const what[3] = { "mean", "p99", "max" };
+        for (uint8_t k = 0; k < 3; k++) {
+          const uint32_t limit = base[k] + std::max<uint32_t>(base[k] / 10, 40);
+          if (now[k] > limit) {
+            std::fprintf(stderr, "REGRESSION %s %s %s %s: %u cycles, baseline %u (limit %u)\n",
+                         FAMILIES[f], mode, metrics[i].key, what[k], now[k], base[k], limit);
+            regressions++;
+          }
+        }
+      }
+    }
+    if (compared != mine.size()) {
+      std::fprintf(stderr, "baseline %s has %u of %zu metrics for %s %s (run the bench_baseline target)\n",
+                   baseline, compared, mine.size(), FAMILIES[f], mode);
+      return 1;
+    }
+    if (regressions) return 1;
+    std::printf("within baseline\n");
+  }
+  return 0;
+}
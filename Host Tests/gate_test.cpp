@@ -0,0 +1,145 @@
+// Universal Logic Gate (V2), run unmodified on the host MCU model.
+//
+//   gate_test FAMILY oled|no-oled
+//
+// Boots the sketch with FAMILY in its config record and walks every combination of the row
+// pins (Gray code, one pin per step). After each pin change the O1/O2 buses must already
+// hold the expected Y and /Y (pin-change ISR path); after the following loop() passes the
+// LEDs must show the rows and outputs. The expected values are written out below from the
+// kit's documented behaviour, not taken from the sketch's own tables.
+
+#include "HostTest.h"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+using namespace ht::v2;
+
+enum { LED_IN1 = 0, LED_IN4 = 3, LED_Y = 5, LED_YBAR = 6 };
+const uint32_t GREEN_IN = 0x003000, GREEN = 0x004000, RED = 0x400000;
+
+const uint16_t CUSTOM_Y = 0xC3A5, CUSTOM_YB = 0x1E69;   // arbitrary, Y and /Y unrelated
+
+struct Expect { bool y, yb; };
+
+// Combinational families: rows -> (Y, /Y). 'four' = 4-input mode (no OLED).
+Expect combinational(uint8_t f, bool four, uint8_t rows) {
+  const bool a = rows & 1, b = rows & 2, c = rows & 4, d = four && (rows & 8);
+  const unsigned n = a + b + c + d;
+  bool y = false;
+  switch (f) {
+    case F_AND:    y = a && b && c && (d || !four); break;
+    case F_OR:     y = a || b || c || d;            break;
+    case F_XOR:    y = (n & 1);                     break;
+    case F_MAJ:    y = four ? n >= 3 : n >= 2;      break;
+    case F_NOT:    return { !b, !c };
+    case F_CUSTOM: {
+      const uint8_t i = four ? rows : (rows & 7);
+      return { (bool)((CUSTOM_Y >> i) & 1), (bool)((CUSTOM_YB >> i) & 1) };
+    }
+  }
+  return { y, !y };
+}
+
+// Sequential families, stepped once per row change: row 1 = D/J/T, row 2 = CLK (latch
+// enable), row 3 = K, row 4 = asynchronous clear (4-input mode only).
+struct SeqModel {
+  uint8_t f;
+  bool q = false, clk = false;
+  Expect step(uint8_t rows, bool four) {
+    const bool d = rows & 1, c = rows & 2, k = rows & 4;
+    const bool rise = c && !clk;
+    clk = c;
+    switch (f) {
+      case F_DLATCH: if (c) q = d;                        break;
+      case F_DFF:    if (rise) q = d;                     break;
+      case F_JK:     if (rise) q = (d && !q) || (!k && q); break;
+      case F_T:      if (rise && d) q = !q;               break;
+    }
+    if (four && (rows & 8)) q = false;
+    return { q, !q };
+  }
+};
+
+bool busIs(const uint8_t* pins, bool v) {
+  for (uint8_t i = 0; i < 3; i++) if (host::level(pins[i]) != v) return false;
+  return true;
+}
+
+void checkOutputs(const char* when, unsigned step, uint8_t rows, Expect e) {
+  ht::check(busIs(O1_PINS, e.y) && busIs(O2_PINS, e.yb),
+            "%s, step %u, rows %X: O1 %d%d%d O2 %d%d%d, expected Y=%d /Y=%d", when, step, rows,
+            host::level(O1_PINS[0]), host::level(O1_PINS[1]), host::level(O1_PINS[2]),
+            host::level(O2_PINS[0]), host::level(O2_PINS[1]), host::level(O2_PINS[2]), e.y, e.yb);
+}
+
+void checkLeds(unsigned step, uint8_t rows, Expect e, uint8_t f, bool four) {
+  for (uint8_t r = 0; r < 4; r++) {
+    const bool on = (rows & (1 << r)) && (r < 3 || four);
+    ht::check(host::pixel(LED_IN1 + r) == (on ? GREEN_IN : 0), "step %u: LED of row %u", step, r + 1);
+  }
+  const uint32_t yOn = (f == F_NOT) ? RED : GREEN;
+  ht::check(host::pixel(LED_Y) == (e.y ? yOn : 0) && host::pixel(LED_YBAR) == (e.yb ? RED : 0),
+            "step %u: output LEDs %06X %06X for Y=%d /Y=%d", step, host::pixel(LED_Y),
+            host::pixel(LED_YBAR), e.y, e.yb);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint8_t f = F_COUNT;
+  bool oled = false;
+  if (argc != 3 || !parseFamilyMode(argv[1], argv[2], f, oled)) {
+    std::fprintf(stderr, "usage: gate_test ANDNAND|ORNOR|...|TFF oled|no-oled\n");
+    return 2;
+  }
+  const bool four = !oled;
+
+  ht::GateConfig cfg;
+  cfg.family = f;
+  cfg.ttY = CUSTOM_Y;
+  cfg.ttYb = CUSTOM_YB;
+  ht::writeGateConfig(cfg);
+  if (oled) host::attachOled(PIN_PB1, PIN_PB0);
+  host::boot();
+  host::runFor(100000);
+  ht::check(!oled || host::oledBytes() > 0, "OLED attached but never written");
+
+  const std::vector<Pin> pins = inputPins(oled);
+
+  const bool seq = f >= F_DLATCH;
+  SeqModel model{ f };
+  Expect e = seq ? model.step(0, four) : combinational(f, four, 0);
+  checkOutputs("after boot", 0, 0, e);
+
+  // Sequential families depend on the path taken, so they walk the code three times
+  // (different Q at each point), then a pseudo-random walk.
+  const unsigned n = 1u << pins.size();
+  const unsigned steps = seq ? 3 * n + 4000 : n;
+  uint32_t levels = 0, lcg = 12345;
+  for (unsigned k = 1; k <= steps; k++) {
+    unsigned bit;
+    if (k <= 3 * n || !seq) bit = (k % n) ? ht::grayStep(k % n) : pins.size() - 1;   // last step: back to 0
+    else { lcg = lcg * 1103515245u + 12345u; bit = (lcg >> 16) % pins.size(); }
+    levels ^= 1u << bit;
+    host::drive(pins[bit].pin, levels & (1u << bit));
+
+    uint8_t rows = 0;
+    for (size_t i = 0; i < pins.size(); i++) if (levels & (1u << i)) rows |= 1 << pins[i].row;
+    e = seq ? model.step(rows, four) : combinational(f, four, rows);
+    checkOutputs("pin change", k, rows, e);
+
+    // Let loop() run now and then: it must agree, and the LEDs must catch up.
+    if (k % 7 == 0 || k == steps) {
+      host::runFor(20000);
+      checkOutputs("after loop()", k, rows, e);
+      checkLeds(k, rows, e, f, four);
+    }
+  }
+
+  char what[48];
+  std::snprintf(what, sizeof(what), "gate %s %s", FAMILIES[f], oled ? "oled" : "no-oled");
+  return ht::result(what);
+}
@@ -0,0 +1,146 @@
+// Circuit Tools/GateModel.h (the module rules gatesim and gatemap use) against the firmware
+// on the host MCU model.
+//
+//   gatemodel_gate FAMILY oled|no-oled     Universal Logic Gate (V2), ATtiny1616
+//   gatemodel_counter                      Binary Counter (V1), ATmega4809, CASCADE_MODE 0
+//   gatemodel_counter_cascade              the same with CASCADE_MODE 1
+//
+// Gates: combinational families take every row vector of the mode and must match
+// familyTT() (CUSTOM: the tables in the config record); sequential families take a
+// pseudo-random walk of single row changes and must match seqStep() after each one.
+// Counter: a pseudo-random walk of single input changes, matched against counterStep() and
+// counterOutputs() after each one.
+
+#include "HostTest.h"
+
+#include "GateModel.h"
+
+#ifndef CASCADE_MODE
+#define CASCADE_MODE 0   // as the sketch defaults it
+#endif
+
+namespace {
+
+uint32_t g_lcg = 0x6A7E;
+unsigned rnd(unsigned n) { g_lcg = g_lcg * 1103515245u + 12345u; return (g_lcg >> 16) % n; }
+
+#ifndef HOST_MCU_4809
+
+using namespace ht::v2;
+
+const uint16_t CUSTOM_Y = 0x5AC3, CUSTOM_YB = 0x0FF1;
+
+bool busIs(const uint8_t* pins, bool v) {
+  for (uint8_t i = 0; i < 3; i++) if (host::level(pins[i]) != v) return false;
+  return true;
+}
+
+void checkOutputs(unsigned step, uint8_t rows, bool y, bool yb) {
+  ht::check(busIs(O1_PINS, y) && busIs(O2_PINS, yb), "step %u, rows %X: O1A %d O2A %d, GateModel.h says Y=%d /Y=%d",
+            step, rows, host::level(O1_PINS[0]), host::level(O2_PINS[0]), y, yb);
+}
+
+// Drive row r to v on its first pin (the others stay low, the row is their OR).
+void driveRow(uint8_t r, bool v) { host::drive(ROW_PINS[r][0], v); }
+
+int runGate(int argc, char** argv) {
+  uint8_t f = F_COUNT;
+  bool oled = false;
+  if (argc != 3 || !parseFamilyMode(argv[1], argv[2], f, oled)) {
+    std::fprintf(stderr, "usage: gatemodel_gate ANDNAND|ORNOR|...|TFF oled|no-oled\n");
+    return 2;
+  }
+  static_assert((int)gatesim::GF_TFF == F_T && (int)gatesim::GF_CUSTOM == F_CUSTOM, "family numbering");
+  const bool four = !oled;
+  const uint8_t nRows = four ? 4 : 3;
+
+  ht::GateConfig cfg;
+  cfg.family = f;
+  cfg.ttY = CUSTOM_Y;
+  cfg.ttYb = CUSTOM_YB;
+  ht::writeGateConfig(cfg);
+  if (oled) host::attachOled(PIN_PB1, PIN_PB0);
+  host::boot();
+  host::runFor(100000);
+
+  if (!gatesim::isSeqFamily(f)) {
+    const gatesim::GateTT tt = f == F_CUSTOM ? gatesim::GateTT{ CUSTOM_Y, CUSTOM_YB } : gatesim::familyTT(f, four);
+    const unsigned n = 1u << nRows;
+    uint8_t rows = 0;
+    for (unsigned k = 0; k <= n; k++) {
+      if (k) {
+        const unsigned bit = (k % n) ? ht::grayStep(k % n) : nRows - 1;
+        rows ^= 1 << bit;
+        driveRow(bit, rows & (1 << bit));
+        host::runFor(200);
+      }
+      checkOutputs(k, rows, (tt.y >> rows) & 1, (tt.yb >> rows) & 1);
+    }
+  } else {
+    gatesim::SeqState s;
+    uint8_t rows = 0;
+    bool q = gatesim::seqStep(f, s, rows);
+    checkOutputs(0, rows, q, !q);
+    for (unsigned k = 1; k <= 4000; k++) {
+      // Row 4 (clear) moves less often, so the flip-flops get somewhere between clears.
+      const uint8_t bit = (four && rnd(8) == 0) ? 3 : rnd(3);
+      rows ^= 1 << bit;
+      driveRow(bit, rows & (1 << bit));
+      host::runFor(200);
+      q = gatesim::seqStep(f, s, rows);
+      checkOutputs(k, rows, q, !q);
+    }
+  }
+
+  char what[48];
+  std::snprintf(what, sizeof(what), "GateModel.h %s %s", FAMILIES[f], oled ? "oled" : "no-oled");
+  return ht::result(what);
+}
+
+#else
+
+// Arduino pin numbers of the counter (Binary Counter / V1 README), in CounterIn order
+const uint8_t IN_PINS[gatesim::CI__COUNT] = { 4, 40, 5, 6, 29, 19, 18, 0 };   // CLK CLR ENP ENT BI1..BI4
+const uint8_t OUT_PINS[gatesim::CO__COUNT] = { 30, 31, 32, 33, 7,             // BO1..BO4, RCO
+                                              35, 34, 2, 3, 36, 37, 17, 16, 15, 14 };   // D1..D10
+
+int runCounter() {
+  host::boot();
+  host::runFor(10000);
+
+  gatesim::CounterState s;
+  uint16_t in = 0;   // every input low after boot, as the model's power-on
+  for (unsigned k = 0; k <= 6000; k++) {
+    if (k) {
+      // CLK half the time, CLR seldom (it clears), the rest evenly
+      const unsigned r = rnd(16);
+      const uint8_t bit = r < 8 ? (unsigned)gatesim::CI_CLK
+                        : r == 8 ? (unsigned)gatesim::CI_CLR : 2 + rnd(gatesim::CI__COUNT - 2);
+      in ^= 1 << bit;
+      host::drive(IN_PINS[bit], in & (1 << bit));
+      host::advanceUs(5);
+      if (k % 64 == 0) host::runFor(3000);
+    }
+    gatesim::counterStep(CASCADE_MODE, s, in);
+    const uint16_t want = gatesim::counterOutputs(CASCADE_MODE, s.count, in);
+    uint16_t got = 0;
+    for (uint8_t o = 0; o < gatesim::CO__COUNT; o++) got |= host::level(OUT_PINS[o]) << o;
+    ht::check(got == want, "step %u, inputs %02X: outputs %04X, GateModel.h says %04X (count %u)", k, in, got, want,
+              s.count);
+  }
+  return ht::result(CASCADE_MODE ? "GateModel.h counter (cascade)" : "GateModel.h counter");
+}
+
+#endif
+
+}  // namespace
+
+int main(int argc, char** argv) {
+#ifndef HOST_MCU_4809
+  return runGate(argc, argv);
+#else
+  (void)argc;
+  (void)argv;
+  return runCounter();
+#endif
+}
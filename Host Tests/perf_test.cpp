@@ -0,0 +1,59 @@
+// Universal Logic Gate (V2) built with PERF_STATS 1: the worst cases saved in EEPROM.
+//
+//   perf_test oled|no-oled
+//
+// Row 1 toggles for a little over PERF_SAVE_MS, then the PerfRecord at EE_PERF must be
+// valid (magic, version, CRC as the config record) and hold plausible worst cases: the
+// WS2812 push (7 pixels, ~210 µs) at least, the loop() pass at least as long as that, and
+// the input->output latency, in tenths of a µs, near the 4 µs gate_bench measures.
+
+#include "HostTest.h"
+
+using namespace ht::v2;
+
+namespace {
+
+const uint16_t EE_PERF = 32;
+const uint32_t PERF_SAVE_MS = 60000;
+
+uint16_t eeWord(uint16_t at) { return host::eeprom()[at] | host::eeprom()[at + 1] << 8; }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint8_t f;
+  bool oled;
+  if (argc != 2 || !parseFamilyMode("ORNOR", argv[1], f, oled)) {
+    std::fprintf(stderr, "usage: perf_test oled|no-oled\n");
+    return 2;
+  }
+  ht::GateConfig cfg;
+  cfg.family = f;
+  ht::writeGateConfig(cfg);
+  if (oled) host::attachOled(PIN_PB1, PIN_PB0);
+  host::boot();
+  host::runFor(100000);
+  ht::check(host::eeprom()[EE_PERF] == 0xFF, "PerfRecord written at boot");
+
+  bool in = false;
+  for (uint32_t ms = 0; ms < PERF_SAVE_MS + 2000; ms += 10) {
+    in = !in;
+    host::drive(ROW_PINS[0][0], in);
+    host::runFor(10000);
+  }
+
+  const uint8_t* r = &host::eeprom()[EE_PERF];
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < 10; i++) crc = _crc16_update(crc, r[i]);
+  ht::check(r[0] == 0x50 && r[1] == 1 && eeWord(EE_PERF + 10) == crc, "no valid PerfRecord after %u ms",
+            PERF_SAVE_MS + 2000);
+  const uint16_t loopMax = eeWord(EE_PERF + 2), ledsMax = eeWord(EE_PERF + 4), latMax = eeWord(EE_PERF + 8);
+  ht::check(ledsMax >= 200 && ledsMax < 1000, "LED worst case %u µs, a 7-pixel push is ~210 µs", ledsMax);
+  ht::check(loopMax >= ledsMax, "loop() worst case %u µs shorter than the LED push %u µs", loopMax, ledsMax);
+  ht::check(latMax >= 30 && latMax <= 60, "latency worst case %u.%u µs, gate_bench sees 4 µs (80 cycles)",
+            latMax / 10, latMax % 10);
+
+  char what[32];
+  std::snprintf(what, sizeof(what), "perf %s", argv[1]);
+  return ht::result(what);
+}
@@ -0,0 +1,135 @@
+// Preset gate images (Preset Firmware/PresetGate), one build per board and family, run on the
+// host MCU model.
+//
+//   preset_test V1|V2 ANDNAND|ORNOR|XORXNOR|MAJMIN|DUALNOT
+//
+// The expected pins and values are those of the per-gate sketches the presets replaced, which
+// are built against this test too (legacy_* targets):
+//   V1  "Programmable Logic gates V1/AND-NAND" etc.: Arduino pins 15/16/0 = inputs 1..3,
+//       9/8 = Y and /Y, 1/2/3 = input LEDs, 7/6 = Y and /Y LEDs, 5 = gate LED (on after a
+//       three-pass LED chase). Dual NOT: Y = !input 1, /Y = !input 3, input 2 and its LED unused.
+//   V2  "Programmable Logic gates V2/AND-NAND.cpp": rows = OR of their pins, Y on
+//       PB2/PC2/PC3, /Y on PB3/PC0/PC1, WS2812 inputs 0..3 green, Y green, /Y red, centre
+//       heartbeat. The other V2 families follow the Universal sketch without OLED
+//       (majority = 3 of 4, Dual NOT = !row 2 / !row 3).
+// Every combination of the input pins is applied, in Gray code.
+
+#include "HostTest.h"
+
+using namespace ht::v2;
+
+namespace {
+
+enum { AND, OR, XOR, MAJ, NOT };
+const char* const NAMES[] = { "ANDNAND", "ORNOR", "XORXNOR", "MAJMIN", "DUALNOT" };
+
+struct Out { bool y, yb; };
+
+Out expected(uint8_t f, bool v1, uint8_t rows) {
+  const bool a = rows & 1, b = rows & 2, c = rows & 4, d = !v1 && (rows & 8);
+  const unsigned n = a + b + c + d;
+  bool y = false;
+  switch (f) {
+    case AND: y = a && b && c && (d || v1);  break;
+    case OR:  y = a || b || c || d;          break;
+    case XOR: y = n & 1;                     break;
+    case MAJ: y = n >= (v1 ? 2u : 3u);       break;
+    case NOT: return v1 ? Out{ !a, !c } : Out{ !b, !c };
+  }
+  return { y, !y };
+}
+
+// ---- V1 pins (Arduino numbers of the old sketches)
+const uint8_t V1_IN[3] = { 15, 16, 0 };
+const uint8_t V1_IN_LED[3] = { 1, 2, 3 };
+const uint8_t V1_Y = 9, V1_YB = 8, V1_Y_LED = 7, V1_YB_LED = 6, V1_GATE_LED = 5;
+
+const uint32_t GREEN_IN = 0x003000, GREEN = 0x004000, RED = 0x400000;
+enum { LED_CENTER = 4, LED_Y = 5, LED_YBAR = 6 };
+
+void checkV1(uint8_t f, unsigned step, uint8_t rows) {
+  const Out e = expected(f, true, rows);
+  ht::check(host::level(V1_Y) == e.y && host::level(V1_YB) == e.yb && host::level(V1_Y_LED) == e.y &&
+            host::level(V1_YB_LED) == e.yb,
+            "step %u, inputs %X: Y %d /Y %d, LEDs %d %d, expected %d %d", step, rows,
+            host::level(V1_Y), host::level(V1_YB), host::level(V1_Y_LED), host::level(V1_YB_LED), e.y, e.yb);
+  for (uint8_t i = 0; i < 3; i++) {
+    const bool on = (rows & (1 << i)) && !(f == NOT && i == 1);
+    ht::check(host::level(V1_IN_LED[i]) == on, "step %u, inputs %X: input LED %u is %d", step, rows, i + 1,
+              host::level(V1_IN_LED[i]));
+  }
+  ht::check(host::level(V1_GATE_LED), "step %u: gate LED off", step);
+}
+
+bool busIs(const uint8_t* pins, bool v) {
+  for (uint8_t i = 0; i < 3; i++) if (host::level(pins[i]) != v) return false;
+  return true;
+}
+
+void checkV2(uint8_t f, unsigned step, uint8_t rows) {
+  const Out e = expected(f, false, rows);
+  ht::check(busIs(O1_PINS, e.y) && busIs(O2_PINS, e.yb), "step %u, rows %X: buses %d%d%d %d%d%d, expected %d %d",
+            step, rows, host::level(O1_PINS[0]), host::level(O1_PINS[1]), host::level(O1_PINS[2]),
+            host::level(O2_PINS[0]), host::level(O2_PINS[1]), host::level(O2_PINS[2]), e.y, e.yb);
+  for (uint8_t r = 0; r < 4; r++) {
+    const bool used = f != NOT || r == 1 || r == 2;
+    const bool on = used && (rows & (1 << r));
+    ht::check(host::pixel(r) == (on ? GREEN_IN : 0), "step %u, rows %X: LED of row %u is %06X", step, rows, r + 1,
+              host::pixel(r));
+  }
+  ht::check(host::pixel(LED_Y) == (e.y ? GREEN : 0) && host::pixel(LED_YBAR) == (e.yb ? RED : 0),
+            "step %u, rows %X: output LEDs %06X %06X", step, rows, host::pixel(LED_Y), host::pixel(LED_YBAR));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint8_t f = 5;
+  for (uint8_t i = 0; argc == 3 && i < 5; i++) if (!std::strcmp(argv[2], NAMES[i])) f = i;
+  const bool v1 = argc == 3 && !std::strcmp(argv[1], "V1");
+  if (f == 5 || (!v1 && std::strcmp(argv[1], "V2"))) {
+    std::fprintf(stderr, "usage: preset_test V1|V2 ANDNAND|ORNOR|XORXNOR|MAJMIN|DUALNOT\n");
+    return 2;
+  }
+
+  host::boot();
+  host::runFor(100000);
+
+  std::vector<Pin> pins;
+  if (v1) {
+    // The old sketches chased every LED three times, then left the gate LED on.
+    const uint8_t leds[6] = { V1_IN_LED[0], V1_IN_LED[1], V1_IN_LED[2], V1_GATE_LED, V1_Y_LED, V1_YB_LED };
+    for (uint8_t i = 0; i < 6; i++)
+      ht::check(host::edges(leds[i]) >= 6, "boot: LED pin %u changed %u times in the chase", leds[i], host::edges(leds[i]));
+    for (uint8_t i = 0; i < 3; i++) pins.push_back({ V1_IN[i], i });
+  } else {
+    pins = inputPins(false);
+  }
+  if (v1) checkV1(f, 0, 0); else checkV2(f, 0, 0);
+
+  const unsigned n = 1u << pins.size();
+  uint32_t levels = 0;
+  for (unsigned k = 1; k <= n; k++) {
+    const unsigned bit = (k % n) ? ht::grayStep(k % n) : pins.size() - 1;
+    levels ^= 1u << bit;
+    host::drive(pins[bit].pin, levels & (1u << bit));
+    host::runFor(1000);
+    uint8_t rows = 0;
+    for (size_t i = 0; i < pins.size(); i++) if (levels & (1u << i)) rows |= 1 << pins[i].row;
+    if (v1) checkV1(f, k, rows); else checkV2(f, k, rows);
+  }
+
+  if (!v1) {
+    // Heartbeat on the centre pixel (8 steps/s) while the inputs are quiet.
+    uint32_t changes = 0, last = host::pixel(LED_CENTER);
+    for (unsigned t = 0; t < 20; t++) {
+      host::runFor(100000);
+      if (host::pixel(LED_CENTER) != last) { changes++; last = host::pixel(LED_CENTER); }
+    }
+    ht::check(changes >= 10, "heartbeat: centre pixel changed %u times in 2 s", changes);
+  }
+
+  char what[40];
+  std::snprintf(what, sizeof(what), "preset %s %s", argv[1], argv[2]);
+  return ht::result(what);
+}
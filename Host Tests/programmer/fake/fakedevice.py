@@ -0,0 +1,111 @@
+# Simulated UPDI targets for the programmer tests, shared by the fake prog.py and the fake
+# pymcuprog. One JSON file per port in $FAKE_UPDI_STATE holds the chip, its memories and
+# counters. Ports named DEAD* never answer UPDI.
+#
+# NVM rules of the real parts: a chip erase sets flash and EEPROM to 0xFF, a flash write without
+# erase can only clear bits (old AND new), a page erase-write sets one page, EEPROM and fuse
+# writes replace the byte.
+#
+# Faults a test can put in the state: "no_nvm" (the pymcuprog build has no NVM page access),
+# "page_write_damages_next" (a page erase-write also clears the first byte of the next page),
+# "max_baud" (UPDI does not come up above that rate), "eeprom_write_fails" (EEPROM writes are
+# lost). Every connection attempt appends its baud to "bauds".
+
+import json
+import os
+
+CHIPS = {
+    "attiny1616": {"devid": "1E9421", "family": "tinyAVR", "flash": 16 * 1024, "eeprom": 256, "sram": 2048,
+                   "flash_base": 0x8000, "page": 64},
+    "atmega4809": {"devid": "1E9651", "family": "megaAVR", "flash": 48 * 1024, "eeprom": 256, "sram": 6144,
+                   "flash_base": 0x4000, "page": 128},
+}
+FUSES = 11
+
+class NoUpdi(Exception):
+    pass
+
+def path(port):
+    return os.path.join(os.environ["FAKE_UPDI_STATE"], port.replace("/", "_") + ".json")
+
+def create(port, chip="attiny1616", flash=b"", eeprom=b"", fuses=b"", **faults):
+    info = CHIPS[chip]
+    state = {
+        "chip": chip,
+        "serial": "%020X" % (sum(map(ord, port)) * 7919),
+        "flash": (bytes(flash) + b"\xFF" * info["flash"])[:info["flash"]].hex(),
+        "eeprom": (bytes(eeprom) + b"\xFF" * info["eeprom"])[:info["eeprom"]].hex(),
+        "fuses": (bytes(fuses) + b"\x00" * FUSES)[:FUSES].hex(),
+        "prog_runs": 0,
+        "sessions": 0,
+        "chip_erases": 0,
+        "page_erases": 0,
+        "eeprom_writes": 0,
+        "bauds": [],
+        **faults,
+    }
+    save(port, state)
+    return state
+
+def load(port):
+    if port.startswith("DEAD"):
+        raise NoUpdi(f"no UPDI response on {port}")
+    if not os.path.exists(path(port)):
+        return create(port)
+    with open(path(port)) as f:
+        return json.load(f)
+
+def connect(port, baud):
+    # load() for a connection at baud, which fails above the port's max_baud
+    state = load(port)
+    state["bauds"].append(int(baud))
+    save(port, state)
+    if int(baud) > state.get("max_baud", int(baud)):
+        raise NoUpdi(f"no UPDI response on {port} at {baud} baud")
+    return state
+
+def save(port, state):
+    with open(path(port), "w") as f:
+        json.dump(state, f)
+
+def memory(state, name):
+    return bytearray.fromhex(state[name])
+
+def store(state, name, data):
+    state[name] = bytes(data).hex()
+
+def chip_erase(state):
+    info = CHIPS[state["chip"]]
+    store(state, "flash", b"\xFF" * info["flash"])
+    store(state, "eeprom", b"\xFF" * info["eeprom"])
+    state["chip_erases"] += 1
+
+def write(state, name, offset, data):
+    mem = memory(state, name)
+    if offset + len(data) > len(mem):
+        raise ValueError(f"{name} write past the end")
+    if name == "eeprom":
+        state["eeprom_writes"] += 1
+        if state.get("eeprom_write_fails"):
+            return
+    for i, b in enumerate(data):
+        mem[offset + i] = mem[offset + i] & b if name == "flash" else b
+    store(state, name, mem)
+
+def erase_write_page(state, offset, data):
+    info = CHIPS[state["chip"]]
+    if offset % info["page"] or len(data) > info["page"]:
+        raise ValueError(f"page erase-write at 0x{offset:X}, {len(data)} bytes")
+    mem = memory(state, "flash")
+    mem[offset:offset + info["page"]] = b"\xFF" * info["page"]
+    mem[offset:offset + len(data)] = data
+    if state.get("page_write_damages_next") and offset + info["page"] < len(mem):
+        mem[offset + info["page"]] = 0x00
+    store(state, "flash", mem)
+    state["page_erases"] += 1
+
+def device_lines(state):
+    # What pymcuprog logs (and prog.py prints) when a session starts
+    info = CHIPS[state["chip"]]
+    return [f"Device family ID: '{info['family']}'", f"Device ID: '{info['devid']}'", "Device revision: '0.1'",
+            f"Device serial number: 'b'{state['serial'].lower()}''"]
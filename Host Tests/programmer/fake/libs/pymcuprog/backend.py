@@ -0,0 +1,103 @@
+# The part of pymcuprog's Backend the programmer uses, on the simulated device in fakedevice.py.
+# As with Serial UPDI in pymcuprog: erase() is always a chip erase, whatever memory or address
+# is passed, and a flash write_memory() writes pages without erasing them. Page erase-write is
+# reached as in pymcuprog: programmer.device_model.avr.nvm.write_nvm(..., nvmcommand=...).
+
+import logging
+
+import fakedevice
+from pymcuprog.serialupdi import constants
+
+class SessionConfig:
+    def __init__(self, device):
+        self.device = device
+
+class MemoryRead:
+    def __init__(self, data):
+        self.data = data
+
+class DeviceMemoryInfo:
+    def __init__(self, chip):
+        self.chip = chip
+
+    def memory_info_by_name(self, name):
+        if name != "flash":
+            raise ValueError(name)
+        info = fakedevice.CHIPS[self.chip]
+        return {"name": "flash", "address": info["flash_base"], "size": info["flash"], "page_size": info["page"]}
+
+class NvmUpdi:
+    def __init__(self, backend):
+        self.backend = backend
+
+    def write_nvm(self, address, data, use_word_access, nvmcommand=constants.UPDI_V0_NVMCTRL_CTRLA_WRITE_PAGE):
+        state, port = self.backend.state, self.backend.port
+        offset = address - fakedevice.CHIPS[state["chip"]]["flash_base"]
+        if nvmcommand == constants.UPDI_V0_NVMCTRL_CTRLA_ERASE_WRITE_PAGE:
+            fakedevice.erase_write_page(state, offset, data)
+        elif nvmcommand == constants.UPDI_V0_NVMCTRL_CTRLA_WRITE_PAGE:
+            fakedevice.write(state, "flash", offset, data)
+        else:
+            raise ValueError(f"NVM command 0x{nvmcommand:02X}")
+        fakedevice.save(port, state)
+
+class Holder:
+    pass
+
+class Backend:
+    def __init__(self):
+        self.logger = logging.getLogger("pymcuprog.serialupdi.application")
+        self.port = None
+        self.baud = None
+        self.state = None
+        self.device_memory_info = None
+        self.programmer = None
+
+    def connect_to_tool(self, toolconnection):
+        self.port = toolconnection.serialport
+        self.baud = toolconnection.baudrate
+
+    def disconnect_from_tool(self):
+        self.port = None
+
+    def start_session(self, sessionconfig):
+        try:
+            state = fakedevice.connect(self.port, self.baud)
+        except fakedevice.NoUpdi as e:
+            raise Exception(f"UPDI initialisation failed ({e})")
+        for line in fakedevice.device_lines(state):
+            self.logger.info(line.replace("%", "%%"))
+        if state["chip"] != sessionconfig.device:
+            raise Exception(f"Device ID mismatch: {fakedevice.CHIPS[state['chip']]['devid']}, expected {sessionconfig.device}")
+        state["sessions"] += 1
+        fakedevice.save(self.port, state)
+        self.state = state
+        self.device_memory_info = DeviceMemoryInfo(state["chip"])
+        if not state.get("no_nvm"):
+            self.programmer = Holder()
+            self.programmer.device_model = Holder()
+            self.programmer.device_model.avr = Holder()
+            self.programmer.device_model.avr.nvm = NvmUpdi(self)
+
+    def end_session(self):
+        self.state = None
+
+    def read_device_id(self):
+        return bytearray.fromhex(fakedevice.CHIPS[self.state["chip"]]["devid"])
+
+    def read_memory(self, memory_name=None, offset_byte=0, numbytes=0):
+        name = "sram" if memory_name == "internal_sram" else memory_name
+        if name == "sram":
+            mem = bytearray(fakedevice.CHIPS[self.state["chip"]]["sram"])
+        else:
+            mem = fakedevice.memory(self.state, name)
+        numbytes = numbytes or len(mem) - offset_byte
+        return [MemoryRead(mem[offset_byte:offset_byte + numbytes])]
+
+    def write_memory(self, data, memory_name="flash", offset_byte=0):
+        fakedevice.write(self.state, memory_name, offset_byte, data)
+        fakedevice.save(self.port, self.state)
+
+    def erase(self, memory_name=None, address=None):
+        fakedevice.chip_erase(self.state)
+        fakedevice.save(self.port, self.state)
@@ -0,0 +1,9 @@
+# NVMCTRL CTRLA commands of the UPDI v0 NVM (tinyAVR 0/1/2, megaAVR 0), as in pymcuprog
+UPDI_V0_NVMCTRL_CTRLA_NOP = 0x00
+UPDI_V0_NVMCTRL_CTRLA_WRITE_PAGE = 0x01
+UPDI_V0_NVMCTRL_CTRLA_ERASE_PAGE = 0x02
+UPDI_V0_NVMCTRL_CTRLA_ERASE_WRITE_PAGE = 0x03
+UPDI_V0_NVMCTRL_CTRLA_PAGE_BUFFER_CLR = 0x04
+UPDI_V0_NVMCTRL_CTRLA_CHIP_ERASE = 0x05
+UPDI_V0_NVMCTRL_CTRLA_ERASE_EEPROM = 0x06
+UPDI_V0_NVMCTRL_CTRLA_WRITE_FUSE = 0x07
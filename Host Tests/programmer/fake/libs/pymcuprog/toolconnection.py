@@ -0,0 +1,3 @@
+class ToolSerialConnection:
+    def __init__(self, serialport="COM1", baudrate=115200, timeout=None):
+        self.serialport, self.baudrate = serialport, baudrate
@@ -0,0 +1,67 @@
+# Stand-in for megaTinyCore's prog.py with the arguments the programmer passes:
+#   prog.py -t uart -u PORT -b BAUD -d MCU --fuses OFS:VAL ... [-f HEX] -a write -v
+# Prints the device lines prog.py prints, then chip erase + flash write (with -f) and fuses,
+# on the simulated device in fakedevice.py.
+
+import argparse
+import sys
+
+import fakedevice
+
+def parse_hex(path):
+    data = bytearray()
+    base = 0
+    with open(path) as f:
+        for line in f:
+            rec = bytes.fromhex(line.strip()[1:])
+            if not rec:
+                continue
+            count, addr, rtype, payload = rec[0], (rec[1] << 8) | rec[2], rec[3], rec[4:4 + rec[0]]
+            if rtype == 0x00:
+                end = base + addr + count
+                data.extend(b"\xFF" * max(0, end - len(data)))
+                data[base + addr:end] = payload
+            elif rtype == 0x01:
+                break
+            elif rtype in (0x02, 0x04):
+                base = ((payload[0] << 8) | payload[1]) << (4 if rtype == 0x02 else 16)
+    return data
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-t")
+    parser.add_argument("-u", required=True)
+    parser.add_argument("-b")
+    parser.add_argument("-d", required=True)
+    parser.add_argument("--fuses", nargs="*", default=[])
+    parser.add_argument("-f")
+    parser.add_argument("-a")
+    parser.add_argument("-v", action="store_true")
+    args = parser.parse_args()
+
+    print(f"Connecting to SerialUPDI on {args.u} at {args.b} baud")
+    try:
+        state = fakedevice.connect(args.u, args.b)
+    except fakedevice.NoUpdi:
+        print("UPDI init failed")
+        return 1
+    state["prog_runs"] += 1
+    for line in fakedevice.device_lines(state):
+        print(line)
+    if state["chip"] != args.d:
+        print(f"Device ID mismatch: {fakedevice.CHIPS[state['chip']]['devid']}, expected {args.d}")
+        fakedevice.save(args.u, state)
+        return 1
+    if args.f:
+        fakedevice.chip_erase(state)
+        fakedevice.write(state, "flash", 0, parse_hex(args.f))
+        print(f"Wrote {args.f}")
+    for fuse in args.fuses:
+        offset, value = fuse.split(":")
+        fakedevice.write(state, "fuses", int(offset), [int(value, 0)])
+    fakedevice.save(args.u, state)
+    print("Done.")
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
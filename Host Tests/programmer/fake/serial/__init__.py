@@ -0,0 +1 @@
+# Just enough pyserial for the programmer to import; the tests pass --ports.
@@ -0,0 +1,2 @@
+def comports():
+    return []
@@ -0,0 +1,332 @@
+# BreadboarDGeniuSLogicGateProgrammer.py --batch on simulated UPDI ports (fake/): the fake
+# prog.py and pymcuprog keep each port's flash, EEPROM and fuses in a JSON file, so a run can
+# be checked device by device and against the consolidated packdataN.txt log.
+#
+#   python test_programmer.py [-v]
+
+import importlib.util
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import unittest
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FAKE = os.path.join(HERE, "fake")
+PROGRAMMER = os.path.join(HERE, "..", "..", "BreadboarDGeniuSLogicGateProgrammer.py")
+
+sys.path.insert(0, FAKE)
+import fakedevice  # noqa: E402
+
+FLASH = 16 * 1024
+TARGET_FUSES = {0: 0x00, 2: 0x01, 6: 0x04, 7: 0x00, 8: 0x00}   # as in the programmer
+
+def write_hex(path, data, origin=0):
+    with open(path, "w") as f:
+        for a in range(0, len(data), 16):
+            chunk = data[a:a + 16]
+            rec = bytes([len(chunk), (origin + a) >> 8 & 0xFF, (origin + a) & 0xFF, 0]) + chunk
+            f.write(":" + (rec + bytes([-sum(rec) & 0xFF])).hex().upper() + "\n")
+        f.write(":00000001FF\n")
+
+def image(n, seed):
+    x = seed
+    out = bytearray()
+    for _ in range(n):
+        x = (x * 1103515245 + 12345) & 0xFFFFFFFF
+        out.append(x >> 16 & 0xFF)
+    return bytes(out)
+
+try:
+    import tkinter  # noqa: F401  (the programmer imports it at load)
+    HAVE_TK = True
+except ImportError:
+    HAVE_TK = False
+
+@unittest.skipUnless(HAVE_TK, "tkinter not available")
+class ProgrammerTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp(prefix="programmer_test_")
+        self.state = os.path.join(self.dir, "state")
+        os.mkdir(self.state)
+        os.environ["FAKE_UPDI_STATE"] = self.state
+        self.data = image(3000, 1)
+        self.hex = os.path.join(self.dir, "gate.hex")
+        write_hex(self.hex, self.data)
+
+    def tearDown(self):
+        shutil.rmtree(self.dir)
+
+    def prog_only(self):
+        # prog.py without megaTinyCore's libs next to it: pymcuprog cannot be imported
+        os.mkdir(os.path.join(self.dir, "bare"))
+        return shutil.copy(os.path.join(FAKE, "prog.py"), os.path.join(self.dir, "bare", "prog.py"))
+
+    def run_programmer(self, *args, prog=None):
+        env = dict(os.environ, PYTHONPATH=FAKE, PYTHONDONTWRITEBYTECODE="1")
+        proc = subprocess.run([sys.executable, PROGRAMMER, "--prog", prog or os.path.join(FAKE, "prog.py"), *args],
+                              cwd=self.dir, env=env, capture_output=True, text=True, timeout=120)
+        return proc.returncode, proc.stdout + proc.stderr
+
+    def log(self):
+        # The newest packdataN.txt: every run starts the next one
+        n = max(int(m.group(1)) for m in map(re.compile(r"packdata(\d+)\.txt$").match, os.listdir(self.dir)) if m)
+        with open(os.path.join(self.dir, f"packdata{n}.txt")) as f:
+            return f.read().splitlines()
+
+    def device(self, port):
+        with open(fakedevice.path(port)) as f:
+            return json.load(f)
+
+    def check_programmed(self, port):
+        state = self.device(port)
+        flash = fakedevice.memory(state, "flash")
+        self.assertEqual(flash[:len(self.data)], self.data, port)
+        self.assertEqual(flash[len(self.data):], b"\xFF" * (FLASH - len(self.data)), port)
+        fuses = fakedevice.memory(state, "fuses")
+        self.assertEqual({o: fuses[o] for o in TARGET_FUSES}, TARGET_FUSES, port)
+        return state
+
+    def check_log(self, ports, failed):
+        lines = self.log()
+        crc = "%08X" % (zlib.crc32(self.data) & 0xFFFFFFFF)
+        self.assertEqual(len(lines), 1 + len(ports), lines)
+        self.assertRegex(lines[0], rf"^--- Batch .*, gate\.hex \(CRC32 {crc}, {len(self.data)} bytes\), "
+                                   rf"{len(ports) - len(failed)}/{len(ports)} OK$")
+        for port, line in zip(ports, lines[1:]):
+            self.assertTrue(line.startswith(port + ", "), line)
+            if port in failed:
+                self.assertIn("Device ID: Not found", line)
+                self.assertRegex(line, r", FAIL: UPDI Failed\. Reseat the device\., [0-9.]+s$")
+                continue
+            state = self.device(port)
+            self.assertIn(f"Device family ID: tinyAVR, Device ID: 1E9421, Device serial number: 'b'{state['serial'].lower()}'', "
+                          f"Device revision: 0.1, gate.hex, Programming successful, ", line)
+
+class BatchTest(ProgrammerTest):
+    def test_batch_with_prog_py_only(self):
+        ports = ["FAKE1", "FAKE2", "DEAD3"]
+        rc, out = self.run_programmer("--batch", self.hex, "--ports", *ports, prog=self.prog_only())
+        self.assertEqual(rc, 1, out)
+        self.check_log(ports, {"DEAD3"})
+        for port in ports[:2]:
+            self.assertEqual(self.check_programmed(port)["prog_runs"], 1)
+
+    def test_batch_through_session(self):
+        # pymcuprog next to prog.py: the parsed image goes through the session, prog.py is not run
+        ports = ["FAKE1", "FAKE2", "FAKE3", "DEAD4"]
+        fakedevice.create("FAKE2", eeprom=b"\x47\x01\x02")
+        rc, out = self.run_programmer("--batch", self.hex, "--ports", *ports)
+        self.assertEqual(rc, 1, out)
+        self.check_log(ports, {"DEAD4"})
+        for port in ports[:3]:
+            state = self.check_programmed(port)
+            self.assertEqual(state["prog_runs"], 0, port)
+            self.assertEqual(state["chip_erases"], 1, port)
+        self.assertEqual(fakedevice.memory(self.device("FAKE2"), "eeprom"), b"\xFF" * 256)   # as prog.py -a write
+        self.assertRegex(out, r"\[FAKE1\] Flash CRC32 [0-9A-F]{8}, 3000 bytes written, verified")
+
+    def test_wrong_chip(self):
+        # An ATmega4809 on an ATtiny1616 batch: reported as a mismatch, no other baud, no write
+        for args in ((), ("--smart",), ("--fast",)):
+            fakedevice.create("FAKE2", chip="atmega4809")
+            rc, out = self.run_programmer("--batch", self.hex, "--mcu", "attiny1616", "--ports", "FAKE1", "FAKE2", *args)
+            self.assertEqual(rc, 1, out)
+            line = self.log()[-1]
+            self.assertTrue(line.startswith("FAKE2, "), line)
+            self.assertIn("Device ID: 1E9651", line)
+            self.assertRegex(line, r", FAIL: Device ID mismatch\. Expected device for MCU attiny1616\., [0-9.]+s$")
+            self.assertEqual(out.count("[FAKE2] Device ID mismatch"), 1, out)
+            self.assertNotIn("full write", out)
+            state = self.device("FAKE2")
+            self.assertEqual((state["chip_erases"], state["page_erases"], state["prog_runs"]), (0, 0, 0), args)
+            self.assertEqual(fakedevice.memory(state, "flash"), b"\xFF" * 48 * 1024)
+            self.check_programmed("FAKE1")
+
+    def test_all_ok_exit_code(self):
+        rc, out = self.run_programmer("--batch", self.hex, "--ports", "FAKE1")
+        self.assertEqual(rc, 0, out)
+        self.assertTrue(re.search(r"1/1 OK$", self.log()[0]))
+
+class SmartTest(ProgrammerTest):
+    # --smart: read back, then rewrite only the pages that differ, with EEPROM left alone
+    EEPROM = b"\x47\x01\x02\x88\x88\x88\x88\xFF"
+
+    def fuses(self):
+        out = bytearray(fakedevice.FUSES)
+        for o, v in TARGET_FUSES.items():
+            out[o] = v
+        return out
+
+    def installed(self, port, data, fuses=None, **faults):
+        fakedevice.create(port, flash=data, eeprom=self.EEPROM, fuses=self.fuses() if fuses is None else fuses, **faults)
+
+    def old_image(self):
+        # self.data with page 10 changed, including bits a write without erase could not set
+        old = bytearray(self.data)
+        old[10 * 64 + 5] ^= 0xFF
+        old[10 * 64 + 6] = 0x00
+        return bytes(old)
+
+    def smart(self, *ports):
+        rc, out = self.run_programmer("--batch", self.hex, "--smart", "--ports", *ports)
+        return rc, out, self.log()[1:]
+
+    def test_changed_page_keeps_eeprom(self):
+        self.installed("FAKE1", self.old_image())
+        rc, out, lines = self.smart("FAKE1")
+        self.assertEqual(rc, 0, out)
+        self.assertIn("Changed pages programmed", lines[0])
+        self.assertIn("1 page(s) differ", out)
+        state = self.check_programmed("FAKE1")
+        self.assertEqual((state["chip_erases"], state["page_erases"], state["prog_runs"]), (0, 1, 0))
+        self.assertEqual(fakedevice.memory(state, "eeprom")[:len(self.EEPROM)], self.EEPROM)
+
+    def test_identical_device_skipped(self):
+        self.installed("FAKE1", self.data)
+        rc, out, lines = self.smart("FAKE1")
+        self.assertEqual(rc, 0, out)
+        self.assertIn("Already up to date", lines[0])
+        state = self.check_programmed("FAKE1")
+        self.assertEqual((state["chip_erases"], state["page_erases"], state["prog_runs"]), (0, 0, 0))
+
+    def test_fuses_only_through_session(self):
+        self.installed("FAKE1", self.data, fuses=b"\x00" * fakedevice.FUSES)
+        rc, out, lines = self.smart("FAKE1")
+        self.assertEqual(rc, 0, out)
+        self.assertIn("Fuses programmed", lines[0])
+        state = self.check_programmed("FAKE1")
+        self.assertEqual((state["chip_erases"], state["page_erases"], state["prog_runs"]), (0, 0, 0))
+        self.assertEqual(fakedevice.memory(state, "eeprom")[:len(self.EEPROM)], self.EEPROM)
+
+    def test_no_nvm_access_full_write(self):
+        self.installed("FAKE1", self.old_image(), no_nvm=True)
+        rc, out, lines = self.smart("FAKE1")
+        self.assertEqual(rc, 0, out)
+        self.assertIn("Programming successful", lines[0])
+        self.assertIn("Differential write failed", out)
+        state = self.check_programmed("FAKE1")
+        self.assertEqual((state["chip_erases"], state["page_erases"]), (1, 0))
+
+    def test_whole_flash_verify(self):
+        # The page written reads back fine, the page after it does not: only a whole-flash
+        # read-back sees it, and the device then gets a full write.
+        self.installed("FAKE1", self.old_image(), page_write_damages_next=True)
+        rc, out, lines = self.smart("FAKE1")
+        self.assertEqual(rc, 0, out)
+        self.assertIn("1 page(s) failed verify, full write", out)
+        self.assertIn("Programming successful", lines[0])
+        state = self.check_programmed("FAKE1")
+        self.assertEqual((state["chip_erases"], state["page_erases"]), (1, 1))
+
+class FastTest(ProgrammerTest):
+    # --fast: start at the highest UPDI baud and step down; the rate that worked is kept per port
+    # for the rest of the batch. The adapters here manage 230400.
+    BAUDS = [460800, 345600, 230400]
+
+    def test_step_down_through_session(self):
+        fakedevice.create("FAKE1", max_baud=230400)
+        rc, out = self.run_programmer("--batch", self.hex, "--fast", "--ports", "FAKE1")
+        self.assertEqual(rc, 0, out)
+        self.assertIn("[FAKE1] UPDI session at 230400 baud", out)
+        self.assertEqual(self.check_programmed("FAKE1")["bauds"], self.BAUDS)
+
+    def test_step_down_with_prog_py_only(self):
+        fakedevice.create("FAKE1", max_baud=230400)
+        rc, out = self.run_programmer("--batch", self.hex, "--fast", "--ports", "FAKE1", prog=self.prog_only())
+        self.assertEqual(rc, 0, out)
+        state = self.check_programmed("FAKE1")
+        self.assertEqual((state["bauds"], state["prog_runs"]), (self.BAUDS, 1))
+
+    def test_full_write_starts_at_known_baud(self):
+        # --smart without NVM page access: the full write's session starts where the read-back's ended
+        old = bytearray(self.data)
+        old[100] ^= 0xFF
+        fakedevice.create("FAKE1", flash=old, max_baud=230400, no_nvm=True)
+        rc, out = self.run_programmer("--batch", self.hex, "--smart", "--fast", "--ports", "FAKE1")
+        self.assertEqual(rc, 0, out)
+        self.assertIn("Differential write failed", out)
+        self.assertEqual(self.check_programmed("FAKE1")["bauds"], self.BAUDS + [230400])
+
+    def test_known_baud_reset_per_batch(self):
+        # Two batches in one process (the GUI): after the adapter is swapped for a faster one,
+        # the next batch tries the highest rate again.
+        spec = importlib.util.spec_from_file_location("programmer", PROGRAMMER)
+        programmer = importlib.util.module_from_spec(spec)
+        spec.loader.exec_module(programmer)
+        programmer.PROG_PY_PATH = os.path.join(FAKE, "prog.py")
+        programmer.FAST_UPDI = True
+        programmer.LOG_DIR = self.dir
+        fakedevice.create("FAKE1", max_baud=230400)
+        results = programmer.run_batch(self.hex, "attiny1616", ["FAKE1"], lambda line: None)
+        self.assertTrue(results[0]["ok"], results)
+        state = self.device("FAKE1")
+        del state["max_baud"]
+        fakedevice.save("FAKE1", state)
+        results = programmer.run_batch(self.hex, "attiny1616", ["FAKE1"], lambda line: None)
+        self.assertTrue(results[0]["ok"], results)
+        self.assertEqual(self.check_programmed("FAKE1")["bauds"], self.BAUDS + [460800])
+
+class SetFunctionTest(ProgrammerTest):
+    # --set-function: the config record alone, into EEPROM at 16, flash and fuses untouched.
+    # Filter bytes are the firmware's FILT_* values.
+    FILTERS = {"RAW": 0x00, "2/3": 0x53, "INT 2ms": 0x88, "TMR 5ms": 0xD4}
+
+    def set_function(self, family, *ports, filters=("2/3",) * 4, brightness=255, tt_y=0x0000, tt_yb=0xFFFF):
+        return self.run_programmer("--set-function", family, "--filters", *filters, "--brightness", str(brightness),
+                                   "--tt-y", hex(tt_y), "--tt-yb", hex(tt_yb), "--ports", *ports)
+
+    def record(self, port):
+        return fakedevice.memory(self.device(port), "eeprom")[16:32]
+
+    def check_boots(self, port, family, filters, brightness, tt_y, tt_yb):
+        # config_test (built with the host tests): the bytes against ht::writeGateConfig(), then
+        # booted by the Universal firmware
+        config_test = os.environ.get("CONFIG_TEST")
+        if not config_test:
+            return
+        proc = subprocess.run([config_test, self.record(port).hex(), family, *(hex(self.FILTERS[f]) for f in filters),
+                               str(brightness), hex(tt_y), hex(tt_yb)], capture_output=True, text=True, timeout=120)
+        self.assertEqual(proc.returncode, 0, proc.stdout + proc.stderr)
+
+    def test_record_boots(self):
+        old = image(2000, 7)
+        # programmer family, GateFamily value and gate_test name, settings
+        for family, value, name, filters, brightness, tt_y, tt_yb in (
+                ("USER", 5, "CUSTOM", ("RAW", "2/3", "INT 2ms", "TMR 5ms"), 128, 0x5AC3, 0x0FF1),
+                ("XOR/XNOR", 2, "XORXNOR", ("2/3",) * 4, 255, 0x0000, 0xFFFF)):
+            for port in ("FAKE1", "FAKE2"):
+                fakedevice.create(port, flash=old)
+            rc, out = self.set_function(family, "FAKE1", "FAKE2", filters=filters, brightness=brightness,
+                                        tt_y=tt_y, tt_yb=tt_yb)
+            self.assertEqual(rc, 0, out)
+            for port, line in zip(("FAKE1", "FAKE2"), self.log()[1:]):
+                self.assertRegex(line, rf"^{port}, .*Set function, Function set, ")
+                state = self.device(port)
+                self.assertEqual(fakedevice.memory(state, "flash")[:len(old)], old)
+                self.assertEqual((state["chip_erases"], state["page_erases"], state["prog_runs"]), (0, 0, 0))
+                self.assertEqual(self.record(port)[:3], bytes([0x47, 1, value]))
+                self.check_boots(port, name, filters, brightness, tt_y, tt_yb)
+
+    def test_identical_record_skipped(self):
+        self.set_function("OR/NOR", "FAKE1")
+        writes = self.device("FAKE1")["eeprom_writes"]
+        rc, out = self.set_function("OR/NOR", "FAKE1")
+        self.assertEqual(rc, 0, out)
+        self.assertIn("Function already set", out)
+        self.assertRegex(self.log()[1], r", Already up to date, ")
+        self.assertEqual(self.device("FAKE1")["eeprom_writes"], writes)
+
+    def test_eeprom_verify_failure(self):
+        fakedevice.create("FAKE1", eeprom_write_fails=True)
+        rc, out = self.set_function("OR/NOR", "FAKE1")
+        self.assertEqual(rc, 1, out)
+        self.assertIn("EEPROM verify failed", out)
+        self.assertRegex(self.log()[1], r", FAIL: Programming failed, ")
+
+if __name__ == "__main__":
+    unittest.main()
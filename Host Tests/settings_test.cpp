@@ -0,0 +1,54 @@
+// Universal Logic Gate (V2): settings at boot when EEPROM holds no valid config record.
+//
+//   settings_test erased|legacy|legacy-custom
+//
+// erased         all 0xFF: factory family (OR/NOR), custom tables Y = 0, /Y = 1
+// legacy         a module from before the record: only the family byte at address 0
+//                (XOR/XNOR here) is kept; the bytes after it are not settings
+// legacy-custom  legacy family byte = CUSTOM over erased bytes: Y low and /Y high for
+//                every input, never both high
+// In each case boot writes nothing to EEPROM. Inputs run without the OLED (4 rows).
+
+#include "HostTest.h"
+
+using namespace ht::v2;
+
+int main(int argc, char** argv) {
+  const char* const c = argc == 2 ? argv[1] : "";
+  uint8_t family;
+  if (!std::strcmp(c, "erased")) {
+    family = F_OR;
+  } else if (!std::strcmp(c, "legacy")) {
+    host::eeprom()[0] = F_XOR;
+    for (uint8_t i = 1; i < 16; i++) host::eeprom()[i] = 0x00;   // not settings: must be ignored
+    family = F_XOR;
+  } else if (!std::strcmp(c, "legacy-custom")) {
+    host::eeprom()[0] = F_CUSTOM;
+    family = F_CUSTOM;
+  } else {
+    std::fprintf(stderr, "usage: settings_test erased|legacy|legacy-custom\n");
+    return 2;
+  }
+
+  host::boot();
+  host::runFor(100000);
+  ht::check(host::eepromWrites() == 0, "%s: boot wrote %u EEPROM bytes", c, host::eepromWrites());
+
+  for (uint8_t rows = 0; rows < 16; rows++) {
+    for (uint8_t r = 0; r < 4; r++) host::drive(ROW_PINS[r][0], rows & (1 << r));
+    host::runFor(2000);
+    bool y;
+    switch (family) {
+      case F_OR:  y = rows != 0;                       break;
+      case F_XOR: y = __builtin_parity(rows);          break;
+      default:    y = false;                           break;   // custom default table
+    }
+    ht::check(host::level(O1_PINS[0]) == y && host::level(O2_PINS[0]) == !y,
+              "%s, rows %X: O1A %d O2A %d, expected Y=%d /Y=%d", c, rows,
+              host::level(O1_PINS[0]), host::level(O2_PINS[0]), y, !y);
+  }
+
+  char what[40];
+  std::snprintf(what, sizeof(what), "settings %s", c);
+  return ht::result(what);
+}
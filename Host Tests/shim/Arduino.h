@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+// =========================
+// Host Arduino core (megaTinyCore / MegaCoreX subset)
+// Same pin numbers as the real cores, so sketches compile unchanged. Time only moves when
+// the sketch waits (delay, delayMicroseconds, sleep, a WS2812 push) or asks for it
+// (millis()/micros() cost HOST_CALL_US each); see HostMcu.h for the test side.
+// =========================
+
+#define LOW  0
+#define HIGH 1
+#define INPUT        0
+#define OUTPUT       1
+#define INPUT_PULLUP 2
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+#define PA 0
+#define PB 1
+#define PC 2
+#define PD 3
+#define PE 4
+#define PF 5
+#define NOT_A_PIN  255
+#define NOT_A_PORT 255
+
+#ifdef HOST_MCU_4809
+// MegaCoreX, ATmega4809 48-pin: digital pin n runs PA0..PF6 in port order (no PB6/PB7/PE4..7).
+enum {
+  PIN_PA0 = 0, PIN_PA1, PIN_PA2, PIN_PA3, PIN_PA4, PIN_PA5, PIN_PA6, PIN_PA7,
+  PIN_PB0, PIN_PB1, PIN_PB2, PIN_PB3, PIN_PB4, PIN_PB5,
+  PIN_PC0, PIN_PC1, PIN_PC2, PIN_PC3, PIN_PC4, PIN_PC5, PIN_PC6, PIN_PC7,
+  PIN_PD0, PIN_PD1, PIN_PD2, PIN_PD3, PIN_PD4, PIN_PD5, PIN_PD6, PIN_PD7,
+  PIN_PE0, PIN_PE1, PIN_PE2, PIN_PE3,
+  PIN_PF0, PIN_PF1, PIN_PF2, PIN_PF3, PIN_PF4, PIN_PF5, PIN_PF6,
+  NUM_DIGITAL_PINS
+};
+#else
+// megaTinyCore, ATtiny1616 (20-pin)
+enum {
+  PIN_PA4 = 0, PIN_PA5, PIN_PA6, PIN_PA7, PIN_PB5, PIN_PB4, PIN_PB3, PIN_PB2, PIN_PB1, PIN_PB0,
+  PIN_PC0, PIN_PC1, PIN_PC2, PIN_PC3, PIN_PA1, PIN_PA2, PIN_PA3, PIN_PA0,
+  NUM_DIGITAL_PINS
+};
+#endif
+
+uint8_t digitalPinToPort(uint8_t pin);
+uint8_t digitalPinToBitMask(uint8_t pin);
+uint8_t digitalPinToBitPosition(uint8_t pin);
+PORT_t* digitalPinToPortStruct(uint8_t pin);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(unsigned int us);
+
+#define interrupts()   host_sei()
+#define noInterrupts() host_cli()
+
+void setup(void);
+void loop(void);
+
+struct HardwareSerial {
+  void begin(unsigned long) {}
+  void end() {}
+  int available() { return 0; }
+  int read() { return -1; }
+  void flush() {}
+  size_t write(uint8_t) { return 1; }
+  size_t print(const char*) { return 0; }
+  size_t print(long) { return 0; }
+  size_t println(const char* = "") { return 0; }
+  size_t println(long) { return 0; }
+  explicit operator bool() const { return true; }
+};
+extern HardwareSerial Serial;
@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+
+// EEPROM library: byte array in HostMcu.cpp, erased (0xFF) at reset unless a test preloads it.
+// put() updates byte-wise, like the real library, so the write count tracks actual wear.
+uint8_t host_eeprom_read(int idx);
+void    host_eeprom_write(int idx, uint8_t val);
+uint16_t host_eeprom_length(void);
+
+struct EEPROMClass {
+  uint8_t read(int idx) { return host_eeprom_read(idx); }
+  void write(int idx, uint8_t val) { host_eeprom_write(idx, val); }
+  void update(int idx, uint8_t val) { if (read(idx) != val) write(idx, val); }
+  uint16_t length() { return host_eeprom_length(); }
+
+  template <class T> T& get(int idx, T& t) {
+    uint8_t* p = (uint8_t*)&t;
+    for (unsigned i = 0; i < sizeof(T); i++) p[i] = read(idx + i);
+    return t;
+  }
+  template <class T> const T& put(int idx, const T& t) {
+    const uint8_t* p = (const uint8_t*)&t;
+    for (unsigned i = 0; i < sizeof(T); i++) update(idx + i, p[i]);
+    return t;
+  }
+};
+extern EEPROMClass EEPROM;   // defined in HostMcu.cpp
@@ -0,0 +1,780 @@
+// Host model of the MCU behind the Arduino shims: pins, time, timers, TWI0 + SSD1306,
+// EEPROM, WS2812 and interrupt dispatch. See HostMcu.h for what a test can do with it.
+
+#include "HostMcu.h"
+#include <EEPROM.h>
+#include <tinyNeoPixel.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <ucontext.h>
+
+#define CYC_PER_US   (F_CPU / 1000000UL)
+#define HOST_CALL_US 1          // cost of one millis()/micros() call
+#define NEO_PIXEL_US 30         // WS2812 wire time per pixel (24 bits at 800 kHz)
+#define NO_EVENT     UINT64_MAX
+
+[[noreturn]] static void fatal(const char* msg, const char* what = "") {
+  std::fprintf(stderr, "host MCU: %s%s\n", msg, what);
+  std::abort();
+}
+
+// ========================= Pin table =========================
+struct PinDef { uint8_t port, bit; };
+
+#ifdef HOST_MCU_4809
+#define HOST_PORTS  6
+#define HOST_EEPROM 256
+static PinDef PINS[NUM_DIGITAL_PINS];
+static void initPinTable() {
+  const uint8_t width[HOST_PORTS] = { 8, 6, 8, 8, 4, 7 };   // PA..PF as bonded out
+  uint8_t n = 0;
+  for (uint8_t p = 0; p < HOST_PORTS; p++)
+    for (uint8_t b = 0; b < width[p]; b++) PINS[n++] = { p, b };
+}
+#else
+#define HOST_PORTS  3
+#define HOST_EEPROM 256
+static PinDef PINS[NUM_DIGITAL_PINS] = {
+  {PA,4}, {PA,5}, {PA,6}, {PA,7}, {PB,5}, {PB,4}, {PB,3}, {PB,2}, {PB,1}, {PB,0},
+  {PC,0}, {PC,1}, {PC,2}, {PC,3}, {PA,1}, {PA,2}, {PA,3}, {PA,0} };
+static void initPinTable() {}
+#endif
+
+static const PinDef& pinDef(uint8_t pin) {
+  if (pin >= NUM_DIGITAL_PINS) fatal("no such pin");
+  return PINS[pin];
+}
+
+// ========================= Registers =========================
+VPORT_t VPORTA, VPORTB, VPORTC, VPORTD, VPORTE, VPORTF;
+PORT_t  PORTA, PORTB, PORTC, PORTD, PORTE, PORTF;
+CPUINT_t CPUINT;
+HostReg8 GPIOR0;
+register8_t GPIOR1, GPIOR2, GPIOR3;
+CLKCTRL_t CLKCTRL;
+SLPCTRL_t SLPCTRL;
+TCB_t TCB0, TCB1, TCB2, TCB3;
+RTC_t RTC;
+TWI_t TWI0;
+CCL_t CCL;
+EVSYS_t EVSYS;
+PORTMUX_t PORTMUX;
+HardwareSerial Serial;
+
+static PORT_t*  const PORTS[6]  = { &PORTA, &PORTB, &PORTC, &PORTD, &PORTE, &PORTF };
+static VPORT_t* const VPORTS[6] = { &VPORTA, &VPORTB, &VPORTC, &VPORTD, &VPORTE, &VPORTF };
+static TCB_t*   const TCBS[4]   = { &TCB0, &TCB1, &TCB2, &TCB3 };
+
+// ========================= Time =========================
+static uint64_t g_now = 0;                 // CPU cycles
+static uint64_t g_deadline = NO_EVENT;     // end of the current runFor(): sleep stops here
+
+// loop() runs on its own stack, so a sleep that reaches the end of runFor() can be suspended
+// there and resumed by the next runFor(), as the CPU would simply sleep on.
+static ucontext_t g_hostCtx, g_sketchCtx;
+static bool g_inSketch = false;
+static bool g_sketchStarted = false;
+static bool g_isrRan = false;              // see host_sleep_enable()
+
+static void advanceTo(uint64_t t);
+static void service();
+
+// ========================= Ports and pins =========================
+struct PortState {
+  uint8_t dir, out, flags;
+  uint8_t extOn, extLevel;   // external driver (drive()/release())
+  uint8_t floatHi;           // idle level of an undriven input
+  uint8_t slaveLow;          // held low by the I2C device
+  uint8_t line;              // current level of each pin
+  uint32_t edges[8];
+  uint64_t lastEdge[8];      // cycle of the latest change
+};
+static PortState g_port[6];
+
+static inline volatile uint8_t& pinCtrl(uint8_t p, uint8_t bit) { return (&PORTS[p]->PIN0CTRL)[bit]; }
+
+static uint8_t computeLine(uint8_t p) {
+  const PortState& s = g_port[p];
+  uint8_t pullup = 0;
+  for (uint8_t b = 0; b < 8; b++) if (pinCtrl(p, b) & PORT_PULLUPEN_bm) pullup |= 1 << b;
+  uint8_t in = (s.extOn & s.extLevel) | (~s.extOn & (pullup | s.floatHi));
+  return ((s.dir & s.out) | (~s.dir & in)) & ~s.slaveLow;
+}
+
+static void i2cLinesChanged();
+
+// Recompute every pin level; record edges and raise pin-change flags per ISC.
+static void updateLines() {
+  for (uint8_t iter = 0; iter < 8; iter++) {
+    bool changed = false;
+    for (uint8_t p = 0; p < HOST_PORTS; p++) {
+      PortState& s = g_port[p];
+      uint8_t nv = computeLine(p), diff = nv ^ s.line;
+      if (!diff) continue;
+      changed = true;
+      s.line = nv;
+      for (uint8_t b = 0; b < 8; b++) {
+        if (!(diff & (1 << b))) continue;
+        s.edges[b]++;
+        s.lastEdge[b] = g_now;
+        const bool rise = nv & (1 << b);
+        switch (pinCtrl(p, b) & PORT_ISC_gm) {
+          case PORT_ISC_BOTHEDGES_gc: s.flags |= 1 << b; break;
+          case PORT_ISC_RISING_gc:    if (rise) s.flags |= 1 << b; break;
+          case PORT_ISC_FALLING_gc:   if (!rise) s.flags |= 1 << b; break;
+        }
+      }
+    }
+    if (!changed) break;
+    i2cLinesChanged();          // may pull SDA, hence another pass
+  }
+  for (uint8_t p = 0; p < HOST_PORTS; p++)
+    for (uint8_t b = 0; b < 8; b++)
+      if ((pinCtrl(p, b) & PORT_ISC_gm) == PORT_ISC_LEVEL_gc && !(g_port[p].line & (1 << b)))
+        g_port[p].flags |= 1 << b;
+}
+
+static uint8_t portIn(uint8_t p) {
+  updateLines();
+  uint8_t v = g_port[p].line;
+  for (uint8_t b = 0; b < 8; b++) {
+    const uint8_t c = pinCtrl(p, b);
+    if ((c & PORT_ISC_gm) == PORT_ISC_INPUT_DISABLE_gc) v &= ~(1 << b);
+    if (c & PORT_INVEN_bm) v ^= 1 << b;
+  }
+  return v;
+}
+
+static void pinsChanged() { updateLines(); service(); }
+
+static uint8_t rdDir(uint8_t p)            { return g_port[p].dir; }
+static void    wrDir(uint8_t p, uint8_t v) { g_port[p].dir = v; pinsChanged(); }
+static void    wrDirSet(uint8_t p, uint8_t v) { wrDir(p, g_port[p].dir | v); }
+static void    wrDirClr(uint8_t p, uint8_t v) { wrDir(p, g_port[p].dir & ~v); }
+static void    wrDirTgl(uint8_t p, uint8_t v) { wrDir(p, g_port[p].dir ^ v); }
+static uint8_t rdOut(uint8_t p)            { return g_port[p].out; }
+static void    wrOut(uint8_t p, uint8_t v) { g_port[p].out = v; pinsChanged(); }
+static void    wrOutSet(uint8_t p, uint8_t v) { wrOut(p, g_port[p].out | v); }
+static void    wrOutClr(uint8_t p, uint8_t v) { wrOut(p, g_port[p].out & ~v); }
+static void    wrOutTgl(uint8_t p, uint8_t v) { wrOut(p, g_port[p].out ^ v); }
+static uint8_t rdIn(uint8_t p)             { return portIn(p); }
+static void    wrIn(uint8_t p, uint8_t v)  { wrOutTgl(p, v); }   // writing 1 to IN toggles OUT
+static uint8_t rdFlags(uint8_t p)          { return g_port[p].flags; }
+static void    wrFlags(uint8_t p, uint8_t v) { g_port[p].flags &= ~v; }
+
+static void hook(HostReg8& r, uint8_t arg, uint8_t (*rd)(uint8_t), void (*wr)(uint8_t, uint8_t)) {
+  r.arg = arg; r.rd = rd; r.wr = wr;
+}
+static void hook16(HostReg16& r, uint8_t arg, uint16_t (*rd)(uint8_t), void (*wr)(uint8_t, uint16_t)) {
+  r.arg = arg; r.rd = rd; r.wr = wr;
+}
+
+// ========================= TCB (periodic interrupt mode) =========================
+struct TcbState {
+  uint8_t ctrla, intctrl, flags;
+  uint16_t ccmp, cnt0;       // CNT was cnt0 at cycle 'base'
+  uint64_t base, nextWrap;
+};
+static TcbState g_tcb[4];
+
+static uint32_t tcbDiv(const TcbState& t) { return (t.ctrla & TCB_CLKSEL_gm) == TCB_CLKSEL_CLKDIV1_gc ? 1 : 2; }
+
+static uint16_t tcbCount(uint8_t i) {
+  const TcbState& t = g_tcb[i];
+  if (!(t.ctrla & TCB_ENABLE_bm)) return t.cnt0;
+  const uint64_t ticks = (g_now - t.base) / tcbDiv(t);
+  const uint64_t period = (uint64_t)t.ccmp + 1;
+  uint64_t c = t.cnt0 + ticks;
+  if (t.cnt0 > t.ccmp) {                    // above TOP: runs to 0xFFFF first
+    if (c <= 0xFFFF) return (uint16_t)c;
+    c -= 0x10000;
+  }
+  return (uint16_t)(c % period);
+}
+
+static void tcbRebase(uint8_t i) {
+  TcbState& t = g_tcb[i];
+  t.cnt0 = tcbCount(i);
+  t.base = g_now;
+  if (!(t.ctrla & TCB_ENABLE_bm)) { t.nextWrap = NO_EVENT; return; }
+  const uint64_t toWrap = (t.cnt0 <= t.ccmp) ? (uint64_t)t.ccmp + 1 - t.cnt0 : 0x10000 - t.cnt0;
+  t.nextWrap = t.base + toWrap * tcbDiv(t);
+}
+
+static void tcbWrap(uint8_t i) {
+  TcbState& t = g_tcb[i];
+  t.flags |= TCB_CAPT_bm;
+  t.base = t.nextWrap;
+  t.cnt0 = 0;
+  t.nextWrap = t.base + ((uint64_t)t.ccmp + 1) * tcbDiv(t);
+}
+
+static uint8_t  rdTcbCtrlA(uint8_t i)              { return g_tcb[i].ctrla; }
+static void     wrTcbCtrlA(uint8_t i, uint8_t v)   { g_tcb[i].cnt0 = tcbCount(i); g_tcb[i].base = g_now; g_tcb[i].ctrla = v; tcbRebase(i); }
+static uint8_t  rdTcbIntCtrl(uint8_t i)            { return g_tcb[i].intctrl; }
+static void     wrTcbIntCtrl(uint8_t i, uint8_t v) { g_tcb[i].intctrl = v; service(); }
+static uint8_t  rdTcbFlags(uint8_t i)              { return g_tcb[i].flags; }
+static void     wrTcbFlags(uint8_t i, uint8_t v)   { g_tcb[i].flags &= ~v; }
+static uint16_t rdTcbCnt(uint8_t i)                { return tcbCount(i); }
+static void     wrTcbCnt(uint8_t i, uint16_t v)    { g_tcb[i].cnt0 = v; g_tcb[i].base = g_now; tcbRebase(i); }
+static uint16_t rdTcbCcmp(uint8_t i)               { return g_tcb[i].ccmp; }
+static void     wrTcbCcmp(uint8_t i, uint16_t v)   { g_tcb[i].cnt0 = tcbCount(i); g_tcb[i].base = g_now; g_tcb[i].ccmp = v; tcbRebase(i); }
+
+// ========================= RTC PIT =========================
+static uint8_t  g_pitCtrl, g_pitIntCtrl, g_pitFlags;
+static uint64_t g_pitNext = NO_EVENT;
+
+static uint64_t pitPeriod() {
+  const uint8_t sel = (g_pitCtrl & RTC_PERIOD_gm) >> 3;
+  const uint32_t clk = (RTC.CLKSEL & RTC_CLKSEL_gm) == RTC_CLKSEL_INT1K_gc ? 1024 : 32768;
+  return ((uint64_t)4 << (sel - 1)) * F_CPU / clk;
+}
+
+static uint8_t rdPitCtrl(uint8_t)            { return g_pitCtrl; }
+static void    wrPitCtrl(uint8_t, uint8_t v) {
+  g_pitCtrl = v;
+  g_pitNext = ((v & RTC_PITEN_bm) && (v & RTC_PERIOD_gm)) ? g_now + pitPeriod() : NO_EVENT;
+}
+static uint8_t rdPitIntCtrl(uint8_t)            { return g_pitIntCtrl; }
+static void    wrPitIntCtrl(uint8_t, uint8_t v) { g_pitIntCtrl = v; service(); }
+static uint8_t rdPitFlags(uint8_t)              { return g_pitFlags; }
+static void    wrPitFlags(uint8_t, uint8_t v)   { g_pitFlags &= ~v; }
+
+// ========================= GPIOR0 =========================
+// Plain storage, but every write can be reported with its time (the firmware's PHASE() marks).
+static uint8_t g_gpior0;
+static void (*g_gpior0Trace)(uint8_t, uint64_t);
+
+static uint8_t rdGpior0(uint8_t)            { return g_gpior0; }
+static void    wrGpior0(uint8_t, uint8_t v) { g_gpior0 = v; if (g_gpior0Trace) g_gpior0Trace(v, g_now); }
+
+// ========================= SSD1306 =========================
+// Command parser for what the firmware sends: 0x21/0x22 windows, horizontal addressing,
+// one-argument setup commands. Data bytes land in ram[] at the window cursor.
+struct Ssd1306 {
+  bool attached = false;
+  uint8_t addr = 0x3C, sdaPin = 0, sclPin = 0;
+  uint8_t ram[1024];
+  uint8_t colLo = 0, colHi = 127, pageLo = 0, pageHi = 7, col = 0, page = 0;
+  bool ctrlNext = false, dataMode = false, single = false;
+  uint8_t arg[2], argLen = 0, argNeed = 0, argCmd = 0;
+  uint32_t dataBytes = 0;
+
+  void start() { ctrlNext = true; argNeed = 0; }
+  void stop()  { ctrlNext = false; }
+  void byte(uint8_t b) {
+    if (ctrlNext) { dataMode = b & 0x40; single = b & 0x80; ctrlNext = false; return; }
+    if (dataMode) {
+      ram[page * 128 + col] = b;
+      dataBytes++;
+      if (++col > colHi) { col = colLo; if (++page > pageHi) page = pageLo; }
+    } else {
+      command(b);
+    }
+    if (single) ctrlNext = true;
+  }
+  void command(uint8_t b) {
+    if (argNeed) {
+      arg[argLen++] = b;
+      if (argLen < argNeed) return;
+      argNeed = 0;
+      if (argCmd == 0x21) { colLo = arg[0] & 127; colHi = arg[1] & 127; col = colLo; }
+      if (argCmd == 0x22) { pageLo = arg[0] & 7; pageHi = arg[1] & 7; page = pageLo; }
+      return;
+    }
+    argLen = 0;
+    argCmd = b;
+    switch (b) {
+      case 0x21: case 0x22: argNeed = 2; break;
+      case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        argNeed = 1; break;
+      default: break;   // single-byte commands (display on/off, remap, ...)
+    }
+  }
+};
+static Ssd1306 g_oled;
+
+// ---- Bit-banged side (the boot probe). Decodes START/STOP, 8 data bits and drives the ACK.
+struct I2cSlave {
+  bool lastSda = true, lastScl = true;
+  enum { IDLE, ADDR, DATA } st = IDLE;
+  uint8_t bits = 0, shift = 0;
+  bool ack = false, selected = false;
+};
+static I2cSlave g_i2c;
+
+static void slaveSda(bool low) {
+  const PinDef& d = pinDef(g_oled.sdaPin);
+  if (low) g_port[d.port].slaveLow |= 1 << d.bit; else g_port[d.port].slaveLow &= ~(1 << d.bit);
+}
+
+static void i2cLinesChanged() {
+  if (!g_oled.attached || (TWI0.MCTRLA & TWI_ENABLE_bm)) return;
+  const PinDef& a = pinDef(g_oled.sdaPin);
+  const PinDef& c = pinDef(g_oled.sclPin);
+  const bool sda = g_port[a.port].line & (1 << a.bit);
+  const bool scl = g_port[c.port].line & (1 << c.bit);
+  I2cSlave& s = g_i2c;
+  if (scl && s.lastScl && sda != s.lastSda) {
+    if (!sda) { s.st = I2cSlave::ADDR; s.bits = 0; s.shift = 0; s.ack = false; }              // START
+    else      { s.st = I2cSlave::IDLE; if (s.selected) g_oled.stop(); s.selected = false; }   // STOP
+  } else if (scl && !s.lastScl) {
+    if (s.st != I2cSlave::IDLE && !s.ack) { s.shift = (s.shift << 1) | sda; s.bits++; }
+  } else if (!scl && s.lastScl) {
+    if (s.ack) {
+      s.ack = false;
+      slaveSda(false);
+      if (!s.selected) s.st = I2cSlave::IDLE;
+    } else if (s.st != I2cSlave::IDLE && s.bits == 8) {
+      s.bits = 0;
+      if (s.st == I2cSlave::ADDR) {
+        s.selected = (s.shift >> 1) == g_oled.addr && !(s.shift & 1);
+        if (s.selected) { g_oled.start(); s.st = I2cSlave::DATA; }
+      } else {
+        g_oled.byte(s.shift);
+      }
+      s.shift = 0;
+      s.ack = true;
+      if (s.selected) slaveSda(true);
+    }
+  }
+  s.lastSda = sda;
+  s.lastScl = scl;
+}
+
+// ========================= TWI0 master =========================
+struct TwiState {
+  uint8_t mctrla, flags, busstate;
+  uint8_t pending;           // byte on the wire
+  bool addrPhase, selected;
+  uint64_t doneAt = NO_EVENT;
+};
+static TwiState g_twi;
+
+static void twiSend(uint8_t b, bool addr) {
+  g_twi.flags &= ~(TWI_WIF_bm | TWI_RIF_bm | TWI_CLKHOLD_bm);
+  g_twi.pending = b;
+  g_twi.addrPhase = addr;
+  g_twi.busstate = TWI_BUSSTATE_OWNER_gc;
+  g_twi.doneAt = g_now + 9 * (10 + 2 * (uint64_t)TWI0.MBAUD);
+}
+
+static void twiDone() {
+  bool ack;
+  if (g_twi.addrPhase) {
+    if (g_twi.selected) g_oled.stop();      // repeated START
+    ack = g_oled.attached && (g_twi.pending >> 1) == g_oled.addr && !(g_twi.pending & 1);
+    g_twi.selected = ack;
+    if (ack) g_oled.start();
+  } else {
+    ack = g_twi.selected;
+    if (ack) g_oled.byte(g_twi.pending);
+  }
+  g_twi.flags |= TWI_WIF_bm | TWI_CLKHOLD_bm;
+  if (ack) g_twi.flags &= ~TWI_RXACK_bm; else g_twi.flags |= TWI_RXACK_bm;
+  g_twi.doneAt = NO_EVENT;
+}
+
+static uint8_t rdTwiCtrlA(uint8_t)            { return g_twi.mctrla; }
+static void    wrTwiCtrlA(uint8_t, uint8_t v) { g_twi.mctrla = v; service(); }
+static uint8_t rdTwiCtrlB(uint8_t)            { return 0; }
+static void    wrTwiCtrlB(uint8_t, uint8_t v) {
+  if ((v & TWI_MCMD_gm) == TWI_MCMD_STOP_gc) {
+    g_twi.flags &= ~(TWI_WIF_bm | TWI_RIF_bm | TWI_CLKHOLD_bm);
+    g_twi.busstate = TWI_BUSSTATE_IDLE_gc;
+    g_twi.doneAt = NO_EVENT;
+    if (g_twi.selected) g_oled.stop();
+    g_twi.selected = false;
+  }
+}
+static uint8_t rdTwiStatus(uint8_t)            { return g_twi.flags | g_twi.busstate; }
+static void    wrTwiStatus(uint8_t, uint8_t v) {
+  g_twi.flags &= ~(v & (TWI_RIF_bm | TWI_WIF_bm | TWI_ARBLOST_bm | TWI_BUSERR_bm));
+  if ((v & TWI_BUSSTATE_gm) == TWI_BUSSTATE_IDLE_gc) g_twi.busstate = TWI_BUSSTATE_IDLE_gc;
+}
+static uint8_t rdTwiAddr(uint8_t)            { return g_twi.pending; }
+static void    wrTwiAddr(uint8_t, uint8_t v) { if (g_twi.mctrla & TWI_ENABLE_bm) twiSend(v, true); }
+static uint8_t rdTwiData(uint8_t)            { return g_twi.pending; }
+static void    wrTwiData(uint8_t, uint8_t v) { if (g_twi.mctrla & TWI_ENABLE_bm) twiSend(v, false); }
+
+// ========================= Stimuli =========================
+struct Stim { uint8_t pin; bool level; };
+static std::multimap<uint64_t, Stim> g_stims;   // equal times keep insertion order
+
+static void applyDrive(uint8_t pin, bool level) {
+  const PinDef& d = pinDef(pin);
+  PortState& s = g_port[d.port];
+  s.extOn |= 1 << d.bit;
+  if (level) s.extLevel |= 1 << d.bit; else s.extLevel &= ~(1 << d.bit);
+}
+
+// ========================= Events =========================
+static uint64_t nextEvent() {
+  uint64_t t = g_stims.empty() ? NO_EVENT : g_stims.begin()->first;
+  for (const TcbState& s : g_tcb) if ((s.ctrla & TCB_ENABLE_bm) && s.nextWrap < t) t = s.nextWrap;
+  if (g_pitNext < t) t = g_pitNext;
+  if (g_twi.doneAt < t) t = g_twi.doneAt;
+  return t;
+}
+
+// Everything due at or before now.
+static void fireDue() {
+  while (!g_stims.empty() && g_stims.begin()->first <= g_now) {
+    applyDrive(g_stims.begin()->second.pin, g_stims.begin()->second.level);
+    g_stims.erase(g_stims.begin());
+  }
+  for (uint8_t i = 0; i < 4; i++)
+    while ((g_tcb[i].ctrla & TCB_ENABLE_bm) && g_tcb[i].nextWrap <= g_now) tcbWrap(i);
+  while (g_pitNext <= g_now) { g_pitFlags |= RTC_PI_bm; g_pitNext += pitPeriod(); }
+  if (g_twi.doneAt <= g_now) twiDone();
+  updateLines();
+}
+
+static void advanceTo(uint64_t t) {
+  for (;;) {
+    const uint64_t ne = nextEvent();
+    if (ne > t) break;
+    if (ne > g_now) g_now = ne;
+    fireDue();
+    service();
+  }
+  if (t > g_now) g_now = t;
+  service();
+}
+
+// ========================= Interrupts =========================
+extern "C" {
+void host_vect_PORTA_PORT(void) __attribute__((weak));
+void host_vect_PORTB_PORT(void) __attribute__((weak));
+void host_vect_PORTC_PORT(void) __attribute__((weak));
+void host_vect_PORTD_PORT(void) __attribute__((weak));
+void host_vect_PORTE_PORT(void) __attribute__((weak));
+void host_vect_PORTF_PORT(void) __attribute__((weak));
+void host_vect_RTC_PIT(void) __attribute__((weak));
+void host_vect_TCB0_INT(void) __attribute__((weak));
+void host_vect_TCB1_INT(void) __attribute__((weak));
+void host_vect_TCB2_INT(void) __attribute__((weak));
+void host_vect_TCB3_INT(void) __attribute__((weak));
+void host_vect_TWI0_TWIM(void) __attribute__((weak));
+}
+
+static bool pendPort(uint8_t p) { return p < HOST_PORTS && g_port[p].flags; }
+static bool pendTcb(uint8_t i)  { return g_tcb[i].flags & g_tcb[i].intctrl & TCB_CAPT_bm; }
+static bool pendPit(uint8_t)    { return g_pitFlags & g_pitIntCtrl & RTC_PI_bm; }
+static bool pendTwi(uint8_t)    {
+  return ((g_twi.flags & TWI_WIF_bm) && (g_twi.mctrla & TWI_WIEN_bm)) ||
+         ((g_twi.flags & TWI_RIF_bm) && (g_twi.mctrla & TWI_RIEN_bm));
+}
+
+struct Vector { uint8_t num; void (*fn)(void); bool (*pending)(uint8_t); uint8_t arg; const char* name; };
+static Vector VECTORS[] = {
+  { PORTA_PORT_vect_num, host_vect_PORTA_PORT, pendPort, 0, "PORTA_PORT_vect" },
+  { PORTB_PORT_vect_num, host_vect_PORTB_PORT, pendPort, 1, "PORTB_PORT_vect" },
+  { PORTC_PORT_vect_num, host_vect_PORTC_PORT, pendPort, 2, "PORTC_PORT_vect" },
+  { PORTD_PORT_vect_num, host_vect_PORTD_PORT, pendPort, 3, "PORTD_PORT_vect" },
+  { PORTE_PORT_vect_num, host_vect_PORTE_PORT, pendPort, 4, "PORTE_PORT_vect" },
+  { PORTF_PORT_vect_num, host_vect_PORTF_PORT, pendPort, 5, "PORTF_PORT_vect" },
+  { RTC_PIT_vect_num,    host_vect_RTC_PIT,    pendPit,  0, "RTC_PIT_vect" },
+  { TCB0_INT_vect_num,   host_vect_TCB0_INT,   pendTcb,  0, "TCB0_INT_vect" },
+  { TCB1_INT_vect_num,   host_vect_TCB1_INT,   pendTcb,  1, "TCB1_INT_vect" },
+  { TCB2_INT_vect_num,   host_vect_TCB2_INT,   pendTcb,  2, "TCB2_INT_vect" },
+  { TCB3_INT_vect_num,   host_vect_TCB3_INT,   pendTcb,  3, "TCB3_INT_vect" },
+  { TWI0_TWIM_vect_num,  host_vect_TWI0_TWIM,  pendTwi,  0, "TWI0_TWIM_vect" },
+};
+
+static bool g_sei = false;          // SREG.I
+static uint8_t g_inLvl0 = 0, g_inLvl1 = 0;
+static uint32_t g_isrCount[256];
+
+// Run pending interrupts the CPU would take now: level 1 (CPUINT.LVL1VEC) first and even
+// inside a level-0 handler, else the lowest vector number, never inside its own level.
+// AVR-0/1 cores don't clear SREG.I on entry; the level bits do the masking.
+static void service() {
+  uint32_t guard = 0;
+  while (g_sei && !g_inLvl1) {
+    const Vector* run = nullptr;
+    for (const Vector& v : VECTORS) {
+      if (!v.pending(v.arg)) continue;
+      const bool lvl1 = CPUINT.LVL1VEC && v.num == CPUINT.LVL1VEC;
+      if (lvl1) { run = &v; break; }
+      if (!g_inLvl0 && (!run || v.num < run->num)) run = &v;
+    }
+    if (!run) return;
+    if (!run->fn) fatal("interrupt with no handler (BADISR): ", run->name);
+    if (++guard > 100000) fatal("interrupt flag never cleared: ", run->name);
+    const bool lvl1 = CPUINT.LVL1VEC && run->num == CPUINT.LVL1VEC;
+    uint8_t& level = lvl1 ? g_inLvl1 : g_inLvl0;
+    level++;
+    g_isrCount[run->num]++;
+    run->fn();
+    level--;
+    g_isrRan = true;
+  }
+}
+
+static bool anyPending() {
+  for (const Vector& v : VECTORS) if (v.pending(v.arg)) return true;
+  return false;
+}
+
+extern "C" void host_sei(void) { g_sei = true; service(); }
+extern "C" void host_cli(void) { g_sei = false; }
+
+static void yieldToHost() {
+  g_inSketch = false;
+  swapcontext(&g_sketchCtx, &g_hostCtx);
+  g_inSketch = true;
+}
+
+// Interrupts serviced since sleep_enable(): on the chip, one that runs at 'sei; sleep' or
+// while loop() is suspended in sleep wakes the CPU as it returns.
+extern "C" void host_sleep_enable(void) {
+  SLPCTRL.CTRLA |= SLPCTRL_SEN_bm;
+  g_isrRan = false;
+}
+
+// Let time run to the next event that raises an interrupt. At the end of runFor() the
+// sleeping loop() is suspended until the next runFor() (outside loop(): sleep returns).
+extern "C" void host_sleep_cpu(void) {
+  if (!(SLPCTRL.CTRLA & SLPCTRL_SEN_bm)) return;
+  while (!g_isrRan && !anyPending()) {
+    const uint64_t ne = nextEvent();
+    if (ne > g_deadline) {
+      if (g_deadline == NO_EVENT) fatal("sleep with no wake-up source");
+      if (g_now < g_deadline) g_now = g_deadline;
+      if (!g_inSketch) return;
+      yieldToHost();
+      continue;
+    }
+    if (ne > g_now) g_now = ne;
+    fireDue();
+  }
+  service();
+}
+
+// ========================= Arduino core =========================
+uint8_t digitalPinToPort(uint8_t pin)        { return pin < NUM_DIGITAL_PINS ? PINS[pin].port : NOT_A_PORT; }
+uint8_t digitalPinToBitPosition(uint8_t pin) { return pin < NUM_DIGITAL_PINS ? PINS[pin].bit : NOT_A_PIN; }
+uint8_t digitalPinToBitMask(uint8_t pin)     { return pin < NUM_DIGITAL_PINS ? 1 << PINS[pin].bit : 0; }
+PORT_t* digitalPinToPortStruct(uint8_t pin)  { return pin < NUM_DIGITAL_PINS ? PORTS[PINS[pin].port] : nullptr; }
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  const PinDef& d = pinDef(pin);
+  volatile uint8_t& ctrl = pinCtrl(d.port, d.bit);
+  if (mode == OUTPUT) {
+    g_port[d.port].dir |= 1 << d.bit;
+  } else {
+    g_port[d.port].dir &= ~(1 << d.bit);
+    ctrl = (mode == INPUT_PULLUP) ? (ctrl | PORT_PULLUPEN_bm) : (ctrl & ~PORT_PULLUPEN_bm);
+  }
+  pinsChanged();
+}
+
+// As megaTinyCore: writing an input pin sets its pull-up.
+void digitalWrite(uint8_t pin, uint8_t val) {
+  const PinDef& d = pinDef(pin);
+  PortState& s = g_port[d.port];
+  if (val) s.out |= 1 << d.bit; else s.out &= ~(1 << d.bit);
+  if (!(s.dir & (1 << d.bit))) {
+    volatile uint8_t& ctrl = pinCtrl(d.port, d.bit);
+    ctrl = val ? (ctrl | PORT_PULLUPEN_bm) : (ctrl & ~PORT_PULLUPEN_bm);
+  }
+  pinsChanged();
+}
+
+int digitalRead(uint8_t pin) {
+  const PinDef& d = pinDef(pin);
+  return (portIn(d.port) >> d.bit) & 1;
+}
+
+uint32_t micros(void) {
+  const uint64_t t = g_now;
+  advanceTo(g_now + HOST_CALL_US * CYC_PER_US);
+  return (uint32_t)(t / CYC_PER_US);
+}
+uint32_t millis(void) {
+  const uint64_t t = g_now;
+  advanceTo(g_now + HOST_CALL_US * CYC_PER_US);
+  return (uint32_t)(t / (F_CPU / 1000UL));
+}
+void delay(uint32_t ms)                { advanceTo(g_now + (uint64_t)ms * (F_CPU / 1000UL)); }
+void delayMicroseconds(unsigned int us) { advanceTo(g_now + (uint64_t)us * CYC_PER_US); }
+
+// ========================= EEPROM =========================
+EEPROMClass EEPROM;
+static uint8_t g_ee[HOST_EEPROM];
+static uint32_t g_eeWrites;
+
+uint8_t host_eeprom_read(int idx) { return (idx >= 0 && idx < HOST_EEPROM) ? g_ee[idx] : 0xFF; }
+void host_eeprom_write(int idx, uint8_t val) {
+  if (idx < 0 || idx >= HOST_EEPROM) fatal("EEPROM write out of range");
+  g_ee[idx] = val;
+  g_eeWrites++;
+}
+uint16_t host_eeprom_length(void) { return HOST_EEPROM; }
+
+// ========================= WS2812 =========================
+static uint32_t g_pixels[64];
+static uint32_t g_pixelShows;
+
+void host_neopixel_show(uint8_t /*pin*/, const uint8_t* grb, uint16_t count) {
+  for (uint16_t i = 0; i < count && i < 64; i++)
+    g_pixels[i] = ((uint32_t)grb[3 * i + 1] << 16) | ((uint32_t)grb[3 * i] << 8) | grb[3 * i + 2];
+  g_pixelShows++;
+  const bool sei = g_sei;
+  g_sei = false;                            // the bit stream runs with interrupts off
+  advanceTo(g_now + (uint64_t)count * NEO_PIXEL_US * CYC_PER_US);
+  g_sei = sei;
+  service();
+}
+
+// ========================= Reset state =========================
+static struct HostInit {
+  HostInit() {
+    initPinTable();
+    std::memset(g_ee, 0xFF, sizeof(g_ee));   // erased
+    for (uint8_t p = 0; p < 6; p++) {
+      VPORT_t& v = *VPORTS[p];
+      PORT_t& r = *PORTS[p];
+      hook(v.DIR, p, rdDir, wrDir);       hook(r.DIR, p, rdDir, wrDir);
+      hook(v.OUT, p, rdOut, wrOut);       hook(r.OUT, p, rdOut, wrOut);
+      hook(v.IN, p, rdIn, wrIn);          hook(r.IN, p, rdIn, wrIn);
+      hook(v.INTFLAGS, p, rdFlags, wrFlags); hook(r.INTFLAGS, p, rdFlags, wrFlags);
+      hook(r.DIRSET, p, rdDir, wrDirSet); hook(r.DIRCLR, p, rdDir, wrDirClr); hook(r.DIRTGL, p, rdDir, wrDirTgl);
+      hook(r.OUTSET, p, rdOut, wrOutSet); hook(r.OUTCLR, p, rdOut, wrOutClr); hook(r.OUTTGL, p, rdOut, wrOutTgl);
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+      TCB_t& t = *TCBS[i];
+      hook(t.CTRLA, i, rdTcbCtrlA, wrTcbCtrlA);
+      hook(t.INTCTRL, i, rdTcbIntCtrl, wrTcbIntCtrl);
+      hook(t.INTFLAGS, i, rdTcbFlags, wrTcbFlags);
+      hook16(t.CNT, i, rdTcbCnt, wrTcbCnt);
+      hook16(t.CCMP, i, rdTcbCcmp, wrTcbCcmp);
+      g_tcb[i].nextWrap = NO_EVENT;
+    }
+    hook(RTC.PITCTRLA, 0, rdPitCtrl, wrPitCtrl);
+    hook(RTC.PITINTCTRL, 0, rdPitIntCtrl, wrPitIntCtrl);
+    hook(RTC.PITINTFLAGS, 0, rdPitFlags, wrPitFlags);
+    hook(GPIOR0, 0, rdGpior0, wrGpior0);
+    hook(TWI0.MCTRLA, 0, rdTwiCtrlA, wrTwiCtrlA);
+    hook(TWI0.MCTRLB, 0, rdTwiCtrlB, wrTwiCtrlB);
+    hook(TWI0.MSTATUS, 0, rdTwiStatus, wrTwiStatus);
+    hook(TWI0.MADDR, 0, rdTwiAddr, wrTwiAddr);
+    hook(TWI0.MDATA, 0, rdTwiData, wrTwiData);
+    memset(g_ee, 0xFF, sizeof(g_ee));
+    memset(g_oled.ram, 0, sizeof(g_oled.ram));
+  }
+} s_hostInit;
+
+// ========================= Test API =========================
+namespace host {
+
+uint64_t cycles() { return g_now; }
+uint32_t nowUs()  { return (uint32_t)(g_now / CYC_PER_US); }
+void advanceUs(uint32_t us) { advanceTo(g_now + (uint64_t)us * CYC_PER_US); }
+
+void boot() {
+  g_sei = true;                             // the core's init() enables interrupts before setup()
+  setup();
+}
+
+static void sketchMain() {
+  for (;;) {
+    const uint64_t t = g_now;
+    loop();
+    if (g_now == t) advanceTo(g_now + CYC_PER_US);   // a pass that never waits still takes time
+    if (g_now >= g_deadline) yieldToHost();
+  }
+}
+
+void runFor(uint32_t us) {
+  static char stack[1 << 20];
+  if (!g_sketchStarted) {
+    g_sketchStarted = true;
+    getcontext(&g_sketchCtx);
+    g_sketchCtx.uc_stack.ss_sp = stack;
+    g_sketchCtx.uc_stack.ss_size = sizeof(stack);
+    g_sketchCtx.uc_link = nullptr;
+    makecontext(&g_sketchCtx, sketchMain, 0);
+  }
+  const uint64_t end = g_now + (uint64_t)us * CYC_PER_US;
+  g_deadline = end;
+  if (g_now < end) {
+    g_inSketch = true;
+    swapcontext(&g_hostCtx, &g_sketchCtx);
+  }
+  g_deadline = NO_EVENT;
+}
+
+void drive(uint8_t pin, bool level) { applyDrive(pin, level); pinsChanged(); }
+
+void release(uint8_t pin) {
+  const PinDef& d = pinDef(pin);
+  g_port[d.port].extOn &= ~(1 << d.bit);
+  pinsChanged();
+}
+
+void driveAt(uint32_t usFromNow, uint8_t pin, bool level) {
+  pinDef(pin);
+  g_stims.insert({ g_now + (uint64_t)usFromNow * CYC_PER_US, Stim{ pin, level } });
+}
+
+void floatLevel(uint8_t pin, bool level) {
+  const PinDef& d = pinDef(pin);
+  if (level) g_port[d.port].floatHi |= 1 << d.bit; else g_port[d.port].floatHi &= ~(1 << d.bit);
+  pinsChanged();
+}
+
+bool level(uint8_t pin) {
+  const PinDef& d = pinDef(pin);
+  updateLines();
+  return (g_port[d.port].line >> d.bit) & 1;
+}
+
+bool isOutput(uint8_t pin) {
+  const PinDef& d = pinDef(pin);
+  return (g_port[d.port].dir >> d.bit) & 1;
+}
+
+uint32_t edges(uint8_t pin) {
+  const PinDef& d = pinDef(pin);
+  return g_port[d.port].edges[d.bit];
+}
+
+uint64_t lastEdge(uint8_t pin) {
+  const PinDef& d = pinDef(pin);
+  updateLines();
+  return g_port[d.port].lastEdge[d.bit];
+}
+
+void clearEdges() { for (PortState& s : g_port) memset(s.edges, 0, sizeof(s.edges)); }
+
+void attachOled(uint8_t sdaPin, uint8_t sclPin, uint8_t addr) {
+  g_oled.attached = true;
+  g_oled.addr = addr;
+  g_oled.sdaPin = sdaPin;
+  g_oled.sclPin = sclPin;
+  floatLevel(sdaPin, true);                 // the module's own pull-ups
+  floatLevel(sclPin, true);
+  g_i2c.lastSda = level(sdaPin);
+  g_i2c.lastScl = level(sclPin);
+}
+
+const uint8_t* oledRam() { return g_oled.ram; }
+uint32_t oledBytes()     { return g_oled.dataBytes; }
+
+uint8_t* eeprom()       { return g_ee; }
+uint32_t eepromWrites() { return g_eeWrites; }
+
+uint32_t pixel(uint8_t i) { return i < 64 ? g_pixels[i] : 0; }
+uint32_t pixelShows()     { return g_pixelShows; }
+
+uint32_t isrCount(uint8_t vectorNum) { return g_isrCount[vectorNum]; }
+bool interruptsEnabled() { return g_sei; }
+
+void traceGpior0(void (*fn)(uint8_t value, uint64_t cycle)) { g_gpior0Trace = fn; }
+
+}  // namespace host
@@ -0,0 +1,58 @@
+#pragma once
+#include <Arduino.h>
+
+// =========================
+// Test side of the host MCU model
+// A test program #includes one sketch unchanged, then drives it through this API:
+// boot() runs setup(), runFor() runs loop() for a span of simulated time, and the pin
+// functions act as the breadboard around the chip.
+//
+// Pins are the Arduino pin numbers (PIN_Pxx). An input pin reads, in order of precedence:
+// the chip driving it (OUTPUT), an external driver from drive(), its internal pull-up, then
+// the board's idle level (floatLevel(), LOW by default = the kit's 100 kΩ pulldowns).
+// A pin change interrupt fires as soon as interrupts are enabled, so with the gate's
+// FAST_OUTPUT_ISR the outputs are valid right after drive() returns.
+// =========================
+
+namespace host {
+
+// ---- Clock
+uint64_t cycles();                 // CPU cycles since reset (F_CPU)
+uint32_t nowUs();
+void advanceUs(uint32_t us);       // let time pass (interrupts run, loop() does not)
+void boot();                       // setup(), from reset state with interrupts enabled
+void runFor(uint32_t us);          // loop() until 'us' of simulated time have passed (a sleeping
+                                   // loop() is suspended there and sleeps on in the next runFor())
+
+// ---- Pins
+void drive(uint8_t pin, bool level);
+void release(uint8_t pin);                             // stop driving: pin floats
+void driveAt(uint32_t usFromNow, uint8_t pin, bool level);
+void floatLevel(uint8_t pin, bool level);              // idle level of an undriven input
+bool level(uint8_t pin);                               // line level right now
+bool isOutput(uint8_t pin);
+uint32_t edges(uint8_t pin);                           // line changes since reset / clearEdges()
+uint64_t lastEdge(uint8_t pin);                        // cycles() at the latest line change (0 = never)
+void clearEdges();
+
+// ---- SSD1306 on the I2C pins (answers the bit-banged probe and TWI0 traffic)
+void attachOled(uint8_t sdaPin, uint8_t sclPin, uint8_t addr = 0x3C);
+const uint8_t* oledRam();                              // 8 pages x 128 columns, as the panel holds it
+uint32_t oledBytes();                                  // data bytes received
+
+// ---- EEPROM
+uint8_t* eeprom();                                     // erased (0xFF); preload before boot(), inspect after
+uint32_t eepromWrites();                               // bytes actually written
+
+// ---- WS2812 chain
+uint32_t pixel(uint8_t i);                             // last frame pushed, 0xRRGGBB
+uint32_t pixelShows();                                 // frames pushed
+
+// ---- Interrupts
+uint32_t isrCount(uint8_t vectorNum);                  // times a vector ran (XXX_vect_num)
+bool interruptsEnabled();
+
+// ---- GPIOR0 (the firmware's PHASE() marks): fn gets every write and its cycles() time
+void traceGpior0(void (*fn)(uint8_t value, uint64_t cycle));
+
+}  // namespace host
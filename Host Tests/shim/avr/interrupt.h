@@ -0,0 +1,10 @@
+#pragma once
+#include <avr/io.h>
+
+// ISRs are plain C functions on the host; HostMcu.cpp finds them by their vector symbol.
+#define ISR(vector, ...) extern "C" void vector(void)
+
+extern "C" void host_sei(void);
+extern "C" void host_cli(void);
+#define sei() host_sei()
+#define cli() host_cli()
@@ -0,0 +1,274 @@
+#pragma once
+#include <stdint.h>
+
+// =========================
+// Host model of the AVR register file (tinyAVR 1-series / megaAVR 0-series subset)
+// Only what the sketches in this repo touch. Registers with side effects (PORT OUTSET/OUTCLR,
+// write-1-to-clear flags, timer counts, TWI0 commands) are HostReg8/HostReg16 objects whose
+// reads and writes go through HostMcu.cpp; everything else is plain storage.
+// PORTx and VPORTx share their DIR/OUT/IN/INTFLAGS state, as on the chip.
+// Target: HOST_MCU_4809 = ATmega4809 (binary counter), otherwise ATtiny1616 (gates).
+// =========================
+
+#ifndef F_CPU
+#define F_CPU 20000000UL
+#endif
+
+struct HostReg8 {
+  volatile uint8_t v;
+  uint8_t (*rd)(uint8_t arg);
+  void (*wr)(uint8_t arg, uint8_t val);
+  uint8_t arg;
+
+  operator uint8_t() const { return rd ? rd(arg) : v; }
+  HostReg8& operator=(uint8_t x) { if (wr) wr(arg, x); else v = x; return *this; }
+  HostReg8& operator=(const HostReg8& o) { return *this = (uint8_t)o; }
+  // int operands, as for a plain register: 'reg &= ~MASK' promotes and truncates silently
+  HostReg8& operator|=(int x) { return *this = (uint8_t)(*this | x); }
+  HostReg8& operator&=(int x) { return *this = (uint8_t)(*this & x); }
+  HostReg8& operator^=(int x) { return *this = (uint8_t)(*this ^ x); }
+};
+
+struct HostReg16 {
+  volatile uint16_t v;
+  uint16_t (*rd)(uint8_t arg);
+  void (*wr)(uint8_t arg, uint16_t val);
+  uint8_t arg;
+
+  operator uint16_t() const { return rd ? rd(arg) : v; }
+  HostReg16& operator=(uint16_t x) { if (wr) wr(arg, x); else v = x; return *this; }
+  HostReg16& operator=(const HostReg16& o) { return *this = (uint16_t)o; }
+};
+
+typedef volatile uint8_t register8_t;
+
+// ========================= Ports =========================
+struct VPORT_t { HostReg8 DIR, OUT, IN, INTFLAGS; };
+struct PORT_t {
+  HostReg8 DIR, DIRSET, DIRCLR, DIRTGL, OUT, OUTSET, OUTCLR, OUTTGL, IN, INTFLAGS;
+  register8_t PORTCTRL;
+  register8_t PIN0CTRL, PIN1CTRL, PIN2CTRL, PIN3CTRL, PIN4CTRL, PIN5CTRL, PIN6CTRL, PIN7CTRL;
+};
+extern VPORT_t VPORTA, VPORTB, VPORTC, VPORTD, VPORTE, VPORTF;
+extern PORT_t  PORTA, PORTB, PORTC, PORTD, PORTE, PORTF;
+
+#define PIN0_bm 0x01
+#define PIN1_bm 0x02
+#define PIN2_bm 0x04
+#define PIN3_bm 0x08
+#define PIN4_bm 0x10
+#define PIN5_bm 0x20
+#define PIN6_bm 0x40
+#define PIN7_bm 0x80
+// avr/portpins.h bit numbers (the old V1 gate sketches count their LED chase to PIN3)
+#define PIN0 0
+#define PIN1 1
+#define PIN2 2
+#define PIN3 3
+#define PIN4 4
+#define PIN5 5
+#define PIN6 6
+#define PIN7 7
+
+#define PORT_ISC_gm                0x07
+#define PORT_ISC_INTDISABLE_gc     0x00
+#define PORT_ISC_BOTHEDGES_gc      0x01
+#define PORT_ISC_RISING_gc         0x02
+#define PORT_ISC_FALLING_gc        0x03
+#define PORT_ISC_INPUT_DISABLE_gc  0x04
+#define PORT_ISC_LEVEL_gc          0x05
+#define PORT_PULLUPEN_bm           0x08
+#define PORT_INVEN_bm              0x80
+
+// ========================= CPU =========================
+struct CPUINT_t { register8_t CTRLA, STATUS, LVL0PRI, LVL1VEC; };
+extern CPUINT_t CPUINT;
+
+extern HostReg8 GPIOR0;                       // writes can be traced (host::traceGpior0)
+extern register8_t GPIOR1, GPIOR2, GPIOR3;
+
+struct CLKCTRL_t { register8_t MCLKCTRLA, MCLKCTRLB, MCLKLOCK, MCLKSTATUS, OSC20MCTRLA, OSC20MCALIBA, OSC20MCALIBB, OSC32KCTRLA; };
+extern CLKCTRL_t CLKCTRL;
+#define CLKCTRL_RUNSTDBY_bm 0x02
+#define _PROTECTED_WRITE(reg, value) ((reg) = (value))
+
+struct SLPCTRL_t { register8_t CTRLA; };
+extern SLPCTRL_t SLPCTRL;
+#define SLPCTRL_SEN_bm       0x01
+#define SLPCTRL_SMODE_gm     0x06
+#define SLPCTRL_SMODE_IDLE_gc  0x00
+#define SLPCTRL_SMODE_STDBY_gc 0x02
+#define SLPCTRL_SMODE_PDOWN_gc 0x04
+
+// ========================= TCB =========================
+struct TCB_t { HostReg8 CTRLA; register8_t CTRLB, EVCTRL; HostReg8 INTCTRL, INTFLAGS; register8_t STATUS, DBGCTRL, TEMP; HostReg16 CNT, CCMP; };
+extern TCB_t TCB0, TCB1, TCB2, TCB3;
+#define TCB_ENABLE_bm         0x01
+#define TCB_CLKSEL_gm         0x06
+#define TCB_CLKSEL_CLKDIV1_gc 0x00
+#define TCB_CLKSEL_CLKDIV2_gc 0x02
+#define TCB_CLKSEL_CLKTCA_gc  0x04
+#define TCB_RUNSTDBY_bm       0x40
+#define TCB_CNTMODE_gm        0x07
+#define TCB_CNTMODE_INT_gc    0x00
+#define TCB_CAPT_bm           0x01
+
+// ========================= RTC =========================
+struct RTC_t {
+  register8_t CTRLA, STATUS, INTCTRL, INTFLAGS, TEMP, DBGCTRL, CALIB, CLKSEL;
+  register8_t CNTL, CNTH, PERL, PERH, CMPL, CMPH;
+  HostReg8 PITCTRLA; register8_t PITSTATUS; HostReg8 PITINTCTRL, PITINTFLAGS; register8_t PITDBGCTRL;
+};
+extern RTC_t RTC;
+#define RTC_CLKSEL_gm           0x03
+#define RTC_CLKSEL_INT32K_gc    0x00
+#define RTC_CLKSEL_INT1K_gc     0x01
+#define RTC_PI_bm               0x01
+#define RTC_PITEN_bm            0x01
+#define RTC_PERIOD_gm           0x78
+#define RTC_PERIOD_CYC4_gc      (0x01 << 3)
+#define RTC_PERIOD_CYC8_gc      (0x02 << 3)
+#define RTC_PERIOD_CYC16_gc     (0x03 << 3)
+#define RTC_PERIOD_CYC32_gc     (0x04 << 3)
+#define RTC_PERIOD_CYC64_gc     (0x05 << 3)
+#define RTC_PERIOD_CYC128_gc    (0x06 << 3)
+#define RTC_PERIOD_CYC256_gc    (0x07 << 3)
+#define RTC_PERIOD_CYC512_gc    (0x08 << 3)
+#define RTC_PERIOD_CYC1024_gc   (0x09 << 3)
+#define RTC_PERIOD_CYC2048_gc   (0x0A << 3)
+#define RTC_PERIOD_CYC4096_gc   (0x0B << 3)
+#define RTC_PERIOD_CYC8192_gc   (0x0C << 3)
+#define RTC_PERIOD_CYC16384_gc  (0x0D << 3)
+#define RTC_PERIOD_CYC32768_gc  (0x0E << 3)
+
+// ========================= TWI0 (master only) =========================
+struct TWI_t {
+  register8_t CTRLA, DUALCTRL, DBGCTRL;
+  HostReg8 MCTRLA, MCTRLB, MSTATUS; register8_t MBAUD; HostReg8 MADDR, MDATA;
+  register8_t SCTRLA, SCTRLB, SSTATUS, SADDR, SDATA, SADDRMASK;
+};
+extern TWI_t TWI0;
+#define TWI_SDAHOLD_50NS_gc   0x04
+#define TWI_FMPEN_bm          0x02
+#define TWI_ENABLE_bm         0x01
+#define TWI_SMEN_bm           0x02
+#define TWI_WIEN_bm           0x40
+#define TWI_RIEN_bm           0x80
+#define TWI_MCMD_gm           0x03
+#define TWI_MCMD_NOACT_gc     0x00
+#define TWI_MCMD_REPSTART_gc  0x01
+#define TWI_MCMD_RECVTRANS_gc 0x02
+#define TWI_MCMD_STOP_gc      0x03
+#define TWI_RIF_bm            0x80
+#define TWI_WIF_bm            0x40
+#define TWI_CLKHOLD_bm        0x20
+#define TWI_RXACK_bm          0x10
+#define TWI_ARBLOST_bm        0x08
+#define TWI_BUSERR_bm         0x04
+#define TWI_BUSSTATE_gm       0x03
+#define TWI_BUSSTATE_UNKNOWN_gc 0x00
+#define TWI_BUSSTATE_IDLE_gc  0x01
+#define TWI_BUSSTATE_OWNER_gc 0x02
+#define TWI_BUSSTATE_BUSY_gc  0x03
+
+// ========================= CCL / EVSYS / PORTMUX (storage only) =========================
+// The HW_GATE routing is configured but not simulated: its pins keep their PORT values.
+struct CCL_t {
+  register8_t CTRLA, SEQCTRL0, SEQCTRL1, r0, INTCTRL0, r1, INTFLAGS, r2;
+  register8_t LUT0CTRLA, LUT0CTRLB, LUT0CTRLC, TRUTH0, LUT1CTRLA, LUT1CTRLB, LUT1CTRLC, TRUTH1;
+};
+extern CCL_t CCL;
+#define CCL_ENABLE_bm          0x01
+#define CCL_OUTEN_bm           0x08
+#define CCL_CLKSRC_bm          0x40
+#define CCL_INSEL0_MASK_gc     0x00
+#define CCL_INSEL0_FEEDBACK_gc 0x01
+#define CCL_INSEL0_LINK_gc     0x02
+#define CCL_INSEL0_EVENT0_gc   0x03
+#define CCL_INSEL0_EVENT1_gc   0x04
+#define CCL_INSEL0_IO_gc       0x05
+#define CCL_INSEL1_MASK_gc     0x00
+#define CCL_INSEL1_LINK_gc     0x20
+#define CCL_INSEL1_EVENT0_gc   0x30
+#define CCL_INSEL1_EVENT1_gc   0x40
+#define CCL_INSEL1_IO_gc       0x50
+#define CCL_INSEL2_MASK_gc     0x00
+#define CCL_INSEL2_LINK_gc     0x02
+#define CCL_INSEL2_EVENT0_gc   0x03
+#define CCL_INSEL2_EVENT1_gc   0x04
+#define CCL_INSEL2_IO_gc       0x05
+#define CCL_SEQSEL_DISABLE_gc  0x00
+#define CCL_SEQSEL_DFF_gc      0x01
+#define CCL_SEQSEL_JK_gc       0x02
+#define CCL_SEQSEL_LATCH_gc    0x03
+#define CCL_SEQSEL_RS_gc       0x04
+
+struct EVSYS_t {
+  register8_t ASYNCSTROBE, SYNCSTROBE, ASYNCCH0, ASYNCCH1, ASYNCCH2, ASYNCCH3, SYNCCH0, SYNCCH1;
+  register8_t ASYNCUSER0, ASYNCUSER1, ASYNCUSER2, ASYNCUSER3, ASYNCUSER4, ASYNCUSER5, ASYNCUSER6,
+              ASYNCUSER7, ASYNCUSER8, ASYNCUSER9, ASYNCUSER10, ASYNCUSER11, ASYNCUSER12;
+};
+extern EVSYS_t EVSYS;
+#define EVSYS_ASYNCCH0_PORTA_PIN5_gc 0x0F
+#define EVSYS_ASYNCCH1_CCL_LUT0_gc   0x03
+#define EVSYS_ASYNCCH3_PORTA_PIN1_gc 0x0B
+#define EVSYS_ASYNCCH3_PORTA_PIN7_gc 0x11
+#define EVSYS_ASYNCUSER_OFF_gc       0x00
+#define EVSYS_ASYNCUSER_ASYNCCH0_gc  0x03
+#define EVSYS_ASYNCUSER_ASYNCCH1_gc  0x04
+#define EVSYS_ASYNCUSER_ASYNCCH2_gc  0x05
+#define EVSYS_ASYNCUSER_ASYNCCH3_gc  0x06
+
+struct PORTMUX_t { register8_t CTRLA, CTRLB, CTRLC, CTRLD; };
+extern PORTMUX_t PORTMUX;
+#define PORTMUX_EVOUT0_bm 0x01
+#define PORTMUX_EVOUT1_bm 0x02
+#define PORTMUX_EVOUT2_bm 0x04
+#define PORTMUX_LUT0_bm   0x10
+#define PORTMUX_LUT1_bm   0x20
+
+// ========================= Interrupt vectors =========================
+// Host symbols for the vectors the sketches use; HostMcu.cpp calls them in priority order
+// (lower number first). Numbers follow the chip's vector table.
+#define PORTA_PORT_vect  host_vect_PORTA_PORT
+#define PORTB_PORT_vect  host_vect_PORTB_PORT
+#define PORTC_PORT_vect  host_vect_PORTC_PORT
+#define PORTD_PORT_vect  host_vect_PORTD_PORT
+#define PORTE_PORT_vect  host_vect_PORTE_PORT
+#define PORTF_PORT_vect  host_vect_PORTF_PORT
+#define RTC_PIT_vect     host_vect_RTC_PIT
+#define TCB0_INT_vect    host_vect_TCB0_INT
+#define TCB1_INT_vect    host_vect_TCB1_INT
+#define TCB2_INT_vect    host_vect_TCB2_INT
+#define TCB3_INT_vect    host_vect_TCB3_INT
+#define TWI0_TWIM_vect   host_vect_TWI0_TWIM
+
+#ifdef HOST_MCU_4809
+#define RTC_PIT_vect_num     4
+#define PORTA_PORT_vect_num  6
+#define TCB0_INT_vect_num    12
+#define TCB1_INT_vect_num    13
+#define TWI0_TWIM_vect_num   15
+#define PORTD_PORT_vect_num  19
+#define PORTC_PORT_vect_num  22
+#define TCB2_INT_vect_num    25
+#define PORTF_PORT_vect_num  28
+#define PORTB_PORT_vect_num  31
+#define PORTE_PORT_vect_num  34
+#define TCB3_INT_vect_num    37
+#else
+#define PORTA_PORT_vect_num  3
+#define PORTB_PORT_vect_num  4
+#define PORTC_PORT_vect_num  5
+#define RTC_PIT_vect_num     7
+#define TCB0_INT_vect_num    13
+#define TCB1_INT_vect_num    14
+#define TWI0_TWIM_vect_num   25
+#define PORTD_PORT_vect_num  0xF0   // not on this chip
+#define PORTE_PORT_vect_num  0xF1
+#define PORTF_PORT_vect_num  0xF2
+#define TCB2_INT_vect_num    0xF3
+#define TCB3_INT_vect_num    0xF4
+#endif
+
+#define _BV(bit) (1 << (bit))
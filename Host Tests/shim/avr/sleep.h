@@ -0,0 +1,17 @@
+#pragma once
+#include <avr/io.h>
+
+// sleep_cpu() lets simulated time run to the next wake-up source (see HostMcu.cpp). An
+// interrupt that ran after sleep_enable() (e.g. one pending at 'sei; sleep') also wakes it.
+#define SLEEP_MODE_IDLE       SLPCTRL_SMODE_IDLE_gc
+#define SLEEP_MODE_STANDBY    SLPCTRL_SMODE_STDBY_gc
+#define SLEEP_MODE_PWR_DOWN   SLPCTRL_SMODE_PDOWN_gc
+
+#define set_sleep_mode(mode) (SLPCTRL.CTRLA = (SLPCTRL.CTRLA & ~SLPCTRL_SMODE_gm) | (mode))
+#define sleep_enable()       host_sleep_enable()
+#define sleep_disable()      (SLPCTRL.CTRLA &= ~SLPCTRL_SEN_bm)
+
+extern "C" void host_sleep_enable(void);
+extern "C" void host_sleep_cpu(void);
+#define sleep_cpu() host_sleep_cpu()
+#define sleep_mode() do { sleep_enable(); sleep_cpu(); sleep_disable(); } while (0)
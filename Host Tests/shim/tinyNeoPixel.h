@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+
+// tinyNeoPixel subset. Pixels are stored GRB and scaled by the brightness on write, like the
+// real library; show() hands the frame to HostMcu.cpp and costs the chain's wire time with
+// interrupts off (30 µs per pixel).
+#define NEO_GRB    0x52
+#define NEO_RGB    0x06
+#define NEO_KHZ800 0x0000
+
+void host_neopixel_show(uint8_t pin, const uint8_t* grb, uint16_t count);
+
+class tinyNeoPixel {
+ public:
+  tinyNeoPixel(uint16_t n, uint8_t p, uint8_t /*type*/ = NEO_GRB + NEO_KHZ800) : numLEDs(n), pin(p) {
+    pixels = new uint8_t[n * 3]();
+  }
+  ~tinyNeoPixel() { delete[] pixels; }
+
+  void begin() { pinMode(pin, OUTPUT); digitalWrite(pin, LOW); }
+  void show() { host_neopixel_show(pin, pixels, numLEDs); }
+  void clear() { memset(pixels, 0, numLEDs * 3); }
+  void setBrightness(uint8_t b) { brightness = b + 1; }
+  uint8_t getBrightness() const { return brightness - 1; }
+  uint16_t numPixels() const { return numLEDs; }
+  uint8_t* getPixels() const { return pixels; }
+
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+    if (n >= numLEDs) return;
+    if (brightness) { r = (r * brightness) >> 8; g = (g * brightness) >> 8; b = (b * brightness) >> 8; }
+    uint8_t* p = &pixels[n * 3];
+    p[0] = g; p[1] = r; p[2] = b;
+  }
+  void setPixelColor(uint16_t n, uint32_t c) { setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c); }
+  uint32_t getPixelColor(uint16_t n) const {
+    if (n >= numLEDs) return 0;
+    const uint8_t* p = &pixels[n * 3];
+    return ((uint32_t)p[1] << 16) | ((uint32_t)p[0] << 8) | p[2];
+  }
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) { return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b; }
+
+ private:
+  uint16_t numLEDs;
+  uint8_t pin;
+  uint8_t brightness = 0;   // 0 = full scale, as in the real library
+  uint8_t* pixels;
+};
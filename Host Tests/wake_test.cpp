@@ -0,0 +1,97 @@
+// Universal Logic Gate (V2) with LOW_POWER and tick-filtered rows: how often loop() runs.
+//
+//   wake_test oled|no-oled
+//
+// Rows 1..3 (and 4 without the OLED) use the INT 2 ms filter, so TCB1 interrupts every
+// FILTER_TICK_US and the CPU sleeps in IDLE. Those ticks, and the row changes they pass
+// on, must drive the outputs from the ISR without a loop() pass each: loop() may only run
+// on the 64 Hz PIT tick (plus once per millis() tick with the OLED, for the button and
+// display). The sketch is the PHASE_TRACE build; a PH_IDLE -> PH_LOOP write is one pass.
+// Capture must not be armed at boot; with the OLED, the CAP page arms it.
+
+#include "HostTest.h"
+
+using namespace ht::v2;
+
+namespace {
+
+const uint8_t PH_IDLE = 0, PH_LOOP = 7;   // PHASE() numbers in the sketch
+const uint8_t FILT_INT_2MS = 0x80 | 8;    // FILT_INTEG, 8 x 250 µs
+
+uint32_t g_passes = 0;
+uint8_t g_last = PH_IDLE;
+
+void onPhase(uint8_t v, uint64_t) {
+  if (v == PH_LOOP && g_last == PH_IDLE) g_passes++;
+  g_last = v;
+}
+
+// Passes allowed per simulated second: the PIT, with the OLED also millis(), plus slack.
+uint32_t maxPasses(bool oled) { return 64 + (oled ? 1000 : 0) + 8; }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint8_t f;
+  bool oled;
+  if (argc != 2 || !parseFamilyMode("ORNOR", argv[1], f, oled)) {
+    std::fprintf(stderr, "usage: wake_test oled|no-oled\n");
+    return 2;
+  }
+
+  ht::GateConfig cfg;
+  cfg.family = F_OR;
+  for (uint8_t r = 0; r < 4; r++) cfg.filter[r] = FILT_INT_2MS;
+  ht::writeGateConfig(cfg);
+  if (oled) host::attachOled(PIN_PB1, PIN_PB0);
+  host::traceGpior0(onPhase);
+  host::boot();
+  host::runFor(200000);
+
+  // ---- Quiet inputs for 1 s: the filter ticks on, loop() stays at the PIT rate.
+  uint32_t passes0 = g_passes, ticks0 = host::isrCount(TCB1_INT_vect_num);
+  host::runFor(1000000);
+  uint32_t passes = g_passes - passes0, ticks = host::isrCount(TCB1_INT_vect_num) - ticks0;
+  ht::check(ticks >= 3900, "quiet: %u filter ticks in 1 s, expected ~4000", ticks);
+  ht::check(passes <= maxPasses(oled), "quiet: %u loop() passes in 1 s, at most %u expected", passes, maxPasses(oled));
+
+  // ---- Row 1 toggling every 5 ms: outputs follow through the filter, still no extra passes.
+  passes0 = g_passes;
+  bool in = false;
+  for (unsigned k = 0; k < 200; k++) {
+    in = !in;
+    host::drive(ROW_PINS[0][0], in);
+    host::runFor(1000);
+    ht::check(host::level(O1_PINS[0]) == !in, "toggle %u: O1A followed row 1 within 1 ms (filter is 2 ms)", k);
+    host::runFor(2000);
+    ht::check(host::level(O1_PINS[0]) == in && host::level(O2_PINS[0]) == !in,
+              "toggle %u: O1A/O2A = %d/%d 3 ms after row 1 went %d", k,
+              host::level(O1_PINS[0]), host::level(O2_PINS[0]), in);
+    host::runFor(2000);
+  }
+  passes = g_passes - passes0;
+  ht::check(passes <= maxPasses(oled), "toggling: %u loop() passes in 1 s, at most %u expected", passes, maxPasses(oled));
+  ht::check(passes >= 60, "toggling: only %u loop() passes in 1 s, LEDs need the 64 Hz PIT pass", passes);
+
+  // The LEDs still catch up at the PIT pass.
+  host::runFor(40000);
+  ht::check(host::pixel(0) == (in ? 0x003000u : 0), "LED of row 1 is %06X with row 1 %d", host::pixel(0), in);
+
+  // ---- Capture is not armed at boot (TCB0 would wrap-interrupt every 6.5 ms and keep the
+  // MCU out of STANDBY); with the OLED, long-pressing through to the CAP page arms it.
+  ht::check(host::isrCount(TCB0_INT_vect_num) == 0, "capture armed at boot: %u TCB0 interrupts",
+            host::isrCount(TCB0_INT_vect_num));
+  if (oled) {
+    for (uint8_t page = 1; page <= 4; page++) {   // gate -> filters of rows 1..3 -> CAP
+      host::drive(ROW_PINS[3][0], true);
+      host::runFor(900000);
+      host::drive(ROW_PINS[3][0], false);
+      host::runFor(100000);
+    }
+    ht::check(host::isrCount(TCB0_INT_vect_num) > 0, "CAP page did not arm the capture");
+  }
+
+  char what[32];
+  std::snprintf(what, sizeof(what), "wake %s", argv[1]);
+  return ht::result(what);
+}
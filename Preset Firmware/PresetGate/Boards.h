@@ -0,0 +1,69 @@
+#pragma once
+#include <Arduino.h>
+
+// =========================
+// Board descriptions for the preset gate images (ATtiny1616)
+// Everything here is constexpr, so a preset build folds the pin map into
+// immediate port masks and the unused ports/LED code never reach the image.
+//
+// Port masks are per port, index 0/1/2 = PORTA/B/C.
+// Input rows use the PA|PB<<8 snapshot layout of the Universal sketch:
+// PA in the low byte, PB in the high byte. A row is true if any of its pins is high.
+// =========================
+
+// ---- V1 (demo kit): 3 inputs, discrete LEDs
+//   PORTA: 2/3/4 = Input 1/2/3, 5/6/7 = Input LED 1/2/3
+//   PORTB: 0 = Output 1 (Y), 1 = Output 2 (/Y), 2/3 = Output LED 1/2, 4 = Gate LED
+struct BoardV1 {
+  static constexpr const char* name = "V1";
+  static constexpr uint8_t  rows = 3;
+  static constexpr uint16_t rowMask[4] = { PIN2_bm, PIN3_bm, PIN4_bm, 0 };
+
+  static constexpr uint8_t  yMask[3]  = { 0, PIN0_bm, 0 };
+  static constexpr uint8_t  ybMask[3] = { 0, PIN1_bm, 0 };
+
+  // The two inverters of the Dual NOT preset sit on inputs 1 and 3.
+  static constexpr uint8_t  notRowY = 0, notRowYb = 2;
+
+  static constexpr bool     ws2812 = false;
+  static constexpr uint8_t  inLedMask[3] = { PIN5_bm, PIN6_bm, PIN7_bm };  // PORTA
+  static constexpr uint8_t  yLedMask  = PIN2_bm;                           // PORTB
+  static constexpr uint8_t  ybLedMask = PIN3_bm;                           // PORTB
+  static constexpr uint8_t  gateLedMask = PIN4_bm;                         // PORTB
+};
+
+// ---- V2: 4 input rows, output buses of 3 pins, WS2812 chain
+//   Row 1 = PA1/PA2/PA3, Row 2 = PA5/PA6, Row 3 = PA7/PB5, Row 4 = PB4/PB1/PB0
+//   Y = PB2/PC2/PC3, /Y = PB3/PC0/PC1, WS2812 (7 pixels) on PA4
+// No OLED in the preset images, so row 4 is always an input.
+struct BoardV2 {
+  static constexpr const char* name = "V2";
+  static constexpr uint8_t  rows = 4;
+  static constexpr uint16_t rowMask[4] = {
+    PIN1_bm | PIN2_bm | PIN3_bm,
+    PIN5_bm | PIN6_bm,
+    PIN7_bm | (uint16_t)PIN5_bm << 8,
+    (uint16_t)(PIN4_bm | PIN1_bm | PIN0_bm) << 8,
+  };
+
+  static constexpr uint8_t  yMask[3]  = { 0, PIN2_bm, PIN2_bm | PIN3_bm };
+  static constexpr uint8_t  ybMask[3] = { 0, PIN3_bm, PIN0_bm | PIN1_bm };
+
+  // Same rows as GF_DUALNOT in the Universal sketch.
+  static constexpr uint8_t  notRowY = 1, notRowYb = 2;
+
+  static constexpr bool     ws2812 = true;
+  static constexpr uint8_t  ledPin = PIN_PA4;
+  static constexpr uint8_t  ledCount = 7;
+};
+
+// Pins shared by the row masks and the outputs would make a preset fight itself.
+template <class B>
+constexpr bool boardIsSane() {
+  uint16_t rowsAll = 0;
+  for (uint8_t r = 0; r < 4; r++) rowsAll |= B::rowMask[r];
+  uint16_t outAB = (B::yMask[0] | B::ybMask[0]) | (uint16_t)(B::yMask[1] | B::ybMask[1]) << 8;
+  return (rowsAll & outAB) == 0 && B::rows >= 3 && B::rows <= 4 && (B::rows == 4 || B::rowMask[3] == 0);
+}
+static_assert(boardIsSane<BoardV1>(), "BoardV1 pin map");
+static_assert(boardIsSane<BoardV2>(), "BoardV2 pin map");
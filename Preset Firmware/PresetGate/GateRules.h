@@ -0,0 +1,71 @@
+#pragma once
+#include "Boards.h"
+
+// ========================= Gate families =========================
+// Same families and rules as the combinational half of the Universal sketch
+// (gateOut() there). Only the selected family is evaluated, at compile time:
+// the image carries one 16-byte table and nothing else.
+enum GateFamily : uint8_t { GF_ANDNAND=0, GF_ORNOR, GF_XORXNOR, GF_MAJMIN, GF_DUALNOT, GF__PRESETS };
+
+// One output of family 'gf' on board B for row bits i (bit0 = row 1 ... bit3 = row 4).
+template <class B>
+constexpr bool presetOut(uint8_t gf, bool inv, uint8_t i) {
+  bool four = B::rows == 4;
+  bool a = i & 1, b = i & 2, c = i & 4, d = four && (i & 8);
+  uint8_t n = a + b + c + d;
+  bool y = false;
+  switch (gf) {
+    case GF_ANDNAND: y = four ? (a & b & c & d) : (a & b & c); break;
+    case GF_ORNOR:   y = a | b | c | d;                        break;
+    case GF_XORXNOR: y = a ^ b ^ c ^ d;                        break;
+    case GF_MAJMIN:  y = n >= (four ? 3 : 2);                  break; // majority of 4 (>=3) / of 3
+    case GF_DUALNOT: return !(i & (1 << (inv ? B::notRowYb : B::notRowY)));
+  }
+  return inv ? !y : y;
+}
+
+// Lookup: lut[rows] = bit0 Y, bit1 /Y.
+struct PresetLUT { uint8_t v[16]; };
+
+template <class B>
+constexpr PresetLUT buildPresetLUT(uint8_t gf) {
+  PresetLUT t{};
+  for (uint8_t i = 0; i < 16; i++)
+    t.v[i] = (presetOut<B>(gf, false, i) ? 1 : 0) | (presetOut<B>(gf, true, i) ? 2 : 0);
+  return t;
+}
+
+// Rows the family actually looks at (bit r = row r+1). Unused rows get no input LED.
+template <class B>
+constexpr uint8_t usedRows(uint8_t gf) {
+  PresetLUT t = buildPresetLUT<B>(gf);
+  uint8_t used = 0;
+  for (uint8_t i = 0; i < 16; i++)
+    for (uint8_t r = 0; r < B::rows; r++)
+      if (t.v[i] != t.v[i ^ (1 << r)]) used |= 1 << r;
+  return used;
+}
+
+// Build-time safety net, same hand-written tables as the Universal sketch
+// (bit i = output when row bits == i).
+template <class B>
+constexpr uint16_t presetTT(uint8_t gf, bool inv) {
+  uint16_t t = 0;
+  for (uint8_t i = 0; i < 16; i++) if (presetOut<B>(gf, inv, i)) t |= (uint16_t)1 << i;
+  return t;
+}
+#define CHECK_TT(B, gf, y, yb) \
+  static_assert(presetTT<B>(gf, false) == (y) && presetTT<B>(gf, true) == (yb), #B " " #gf " truth table")
+CHECK_TT(BoardV1, GF_ANDNAND, 0x8080, 0x7F7F);  // a&b&c
+CHECK_TT(BoardV1, GF_ORNOR,   0xFEFE, 0x0101);  // a|b|c
+CHECK_TT(BoardV1, GF_XORXNOR, 0x9696, 0x6969);  // a^b^c
+CHECK_TT(BoardV1, GF_MAJMIN,  0xE8E8, 0x1717);  // >=2 of 3
+CHECK_TT(BoardV1, GF_DUALNOT, 0x5555, 0x0F0F);  // !in1, !in3
+CHECK_TT(BoardV2, GF_ANDNAND, 0x8000, 0x7FFF);  // a&b&c&d
+CHECK_TT(BoardV2, GF_ORNOR,   0xFFFE, 0x0001);  // a|b|c|d
+CHECK_TT(BoardV2, GF_XORXNOR, 0x6996, 0x9669);  // a^b^c^d
+CHECK_TT(BoardV2, GF_MAJMIN,  0xE880, 0x177F);  // >=3 of 4
+CHECK_TT(BoardV2, GF_DUALNOT, 0x3333, 0x0F0F);  // !row2, !row3
+#undef CHECK_TT
+static_assert(usedRows<BoardV1>(GF_DUALNOT) == 0x05 && usedRows<BoardV2>(GF_DUALNOT) == 0x06,
+              "Dual NOT uses two rows");
@@ -0,0 +1,291 @@
+/*
+  =========================
+  ATtiny1616 Logic Gate — Preset Firmware (single source for every fixed-function image)
+  =========================
+
+  One sketch, built once per preset. The board (V1 demo kit or V2 PCB) and the gate
+  family are picked at compile time, so each image only contains:
+    • one 16-entry lookup table for its family (no family switch, no EEPROM, no OLED),
+    • the port writes its board actually has (folded from the constexpr pin map in Boards.h),
+    • the WS2812 driver on V2 only.
+
+  Build selection (normally passed by build_presets.py, defaults below for the IDE):
+    PRESET_BOARD  = 1 (V1, discrete LEDs, 3 inputs) or 2 (V2, WS2812, 4 rows)
+    PRESET_FAMILY = GF_ANDNAND, GF_ORNOR, GF_XORXNOR, GF_MAJMIN or GF_DUALNOT
+
+  The programmable (MODE button / OLED / custom table / flip-flop) firmware stays in
+  "Programmable Logic gates V2/Universal Logic Gate.cpp"; the family rules here are
+  the same as its combinational families and are checked against the same tables.
+
+  -------------------------
+  Developer Notes
+  -------------------------
+  1) Inputs are sampled as whole ports (VPORTA/VPORTB) and 2-of-3 voted, like the
+     Universal sketch; only the rows the family uses are read or wake the MCU.
+  2) Output and discrete LED pins are written from per-port tables indexed by the row
+     bits (FRAME below): one load and one read-modify-write per port that is used.
+     loop() is the only writer of these ports.
+  3) LOW_POWER: standby between input edges (both-edge sensing on the used row pins).
+     On V2 the RTC PIT also wakes the MCU for the center heartbeat.
+  4) Adding a board: describe it in Boards.h and add a PRESET_BOARD branch below.
+*/
+
+#ifndef PRESET_BOARD
+#define PRESET_BOARD  2
+#endif
+#ifndef PRESET_FAMILY
+#define PRESET_FAMILY GF_ANDNAND
+#endif
+
+// Spacing between the three input snapshots that are voted.
+#define IN_GLITCH_US 2
+
+// Low power: 1 = sleep (standby) between input edges instead of spinning.
+#define LOW_POWER     1
+#define HEARTBEAT_PIT RTC_PERIOD_CYC4096_gc   // V2: 32768 / 4096 = 8 heartbeat steps/s
+
+#include <avr/sleep.h>
+#include "GateRules.h"
+
+#if PRESET_BOARD == 1
+using Board = BoardV1;
+#elif PRESET_BOARD == 2
+#include <tinyNeoPixel.h>
+#include <string.h>
+using Board = BoardV2;
+#else
+#error "PRESET_BOARD must be 1 (V1) or 2 (V2)"
+#endif
+
+static_assert(PRESET_FAMILY < GF__PRESETS, "PRESET_FAMILY must be one of the combinational GF_* families");
+
+// ========================= Compile-time image =========================
+static constexpr PresetLUT LUT  = buildPresetLUT<Board>(PRESET_FAMILY);
+static constexpr uint8_t   USED = usedRows<Board>(PRESET_FAMILY);
+
+// Snapshot bits that matter for this family (rows it ignores are never read).
+constexpr uint16_t usedRowMask(uint8_t r) { return (USED & (1 << r)) ? Board::rowMask[r] : 0; }
+static constexpr uint16_t IN_MASK = usedRowMask(0) | usedRowMask(1) | usedRowMask(2) | usedRowMask(3);
+
+// Per-port output values for every row combination (index 0/1/2 = PORTA/B/C).
+struct PortFrame { uint8_t mask[3]; uint8_t v[3][16]; };
+
+constexpr PortFrame buildFrame() {
+  PortFrame f{};
+  for (uint8_t p = 0; p < 3; p++) f.mask[p] = Board::yMask[p] | Board::ybMask[p];
+#if PRESET_BOARD == 1
+  for (uint8_t r = 0; r < Board::rows; r++)
+    if (USED & (1 << r)) f.mask[0] |= Board::inLedMask[r];
+  f.mask[1] |= Board::yLedMask | Board::ybLedMask | Board::gateLedMask;
+#endif
+  for (uint8_t i = 0; i < 16; i++) {
+    bool y = LUT.v[i] & 1, yb = LUT.v[i] & 2;
+    for (uint8_t p = 0; p < 3; p++)
+      f.v[p][i] = (y ? Board::yMask[p] : 0) | (yb ? Board::ybMask[p] : 0);
+#if PRESET_BOARD == 1
+    for (uint8_t r = 0; r < Board::rows; r++)
+      if ((USED & (1 << r)) && (i & (1 << r))) f.v[0][i] |= Board::inLedMask[r];
+    f.v[1][i] |= (y ? Board::yLedMask : 0) | (yb ? Board::ybLedMask : 0) | Board::gateLedMask;
+#endif
+  }
+  return f;
+}
+static constexpr PortFrame FRAME = buildFrame();
+
+// ========================= Inputs =========================
+static inline uint16_t readPortsSnapshot() {
+  uint16_t s = 0;
+  if (IN_MASK & 0x00FF) s |= VPORTA.IN;
+  if (IN_MASK & 0xFF00) s |= (uint16_t)VPORTB.IN << 8;
+  return s;
+}
+
+// Three snapshots, every bit majority-voted at once (2-of-3).
+static inline uint16_t readPortsStable() {
+  uint16_t a = readPortsSnapshot();
+  delayMicroseconds(IN_GLITCH_US);
+  uint16_t b = readPortsSnapshot();
+  delayMicroseconds(IN_GLITCH_US);
+  uint16_t c = readPortsSnapshot();
+  return (a & b) | (a & c) | (b & c);
+}
+
+// Row bits (bit0 = row 1 ... bit3 = row 4); rows the family ignores stay 0.
+static inline uint8_t rowsFromSnapshot(uint16_t s) {
+  uint8_t r = 0;
+  if (s & usedRowMask(0)) r |= 0x01;
+  if (s & usedRowMask(1)) r |= 0x02;
+  if (s & usedRowMask(2)) r |= 0x04;
+  if (s & usedRowMask(3)) r |= 0x08;
+  return r;
+}
+
+// ========================= Outputs =========================
+// Ports without any output/LED pin compile to nothing.
+static inline void writePort(VPORT_t& vp, uint8_t p, uint8_t rows) {
+  if (!FRAME.mask[p]) return;
+  vp.OUT = (vp.OUT & ~FRAME.mask[p]) | FRAME.v[p][rows];
+}
+
+static inline void writeOutputs(uint8_t rows) {
+  writePort(VPORTA, 0, rows);
+  writePort(VPORTB, 1, rows);
+  writePort(VPORTC, 2, rows);
+}
+
+static void initOutputs() {
+  VPORTA.DIR |= FRAME.mask[0];
+  VPORTB.DIR |= FRAME.mask[1];
+  VPORTC.DIR |= FRAME.mask[2];
+}
+
+#if PRESET_BOARD == 1
+// ========================= V1 LED test =========================
+// Boot chase: input LEDs, gate LED, output LEDs, three passes, then the gate LED stays on.
+static void ledTest() {
+  struct Step { VPORT_t* port; uint8_t mask; };
+  const Step steps[] = {
+    { &VPORTA, Board::inLedMask[0] }, { &VPORTA, Board::inLedMask[1] }, { &VPORTA, Board::inLedMask[2] },
+    { &VPORTB, Board::gateLedMask },  { &VPORTB, Board::yLedMask },     { &VPORTB, Board::ybLedMask },
+  };
+  VPORTA.DIR |= Board::inLedMask[0] | Board::inLedMask[1] | Board::inLedMask[2];
+  VPORTB.DIR |= Board::gateLedMask | Board::yLedMask | Board::ybLedMask;
+  for (uint8_t pass = 0; pass < 3; pass++) {
+    for (uint8_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+      steps[i].port->OUT |= steps[i].mask;
+      delay(50);
+      steps[i].port->OUT &= ~steps[i].mask;
+    }
+  }
+  VPORTA.OUT &= ~(Board::inLedMask[0] | Board::inLedMask[1] | Board::inLedMask[2]);
+}
+#endif
+
+#if PRESET_BOARD == 2
+// ========================= V2 WS2812 LEDs =========================
+// 7 pixels: 0..3 inputs, 4 center heartbeat, 5 = Y, 6 = /Y
+#define HB_STEP 8
+tinyNeoPixel leds(Board::ledCount, Board::ledPin, NEO_GRB + NEO_KHZ800);
+
+enum { LED_IN1=0, LED_IN2=1, LED_IN3=2, LED_IN4=3, LED_CENTER=4, LED_Y=5, LED_YBAR=6 };
+
+// Frames identical to the last one pushed are skipped: no latch wait, no interrupts-off time.
+static inline void ledsShowSafe() {
+  static uint8_t shown[Board::ledCount * 3];
+  static bool shownValid = false;
+  const uint8_t* px = leds.getPixels();
+  if (shownValid && memcmp(px, shown, sizeof(shown)) == 0) return;
+  memcpy(shown, px, sizeof(shown));
+  shownValid = true;
+
+  static uint32_t last = 0;
+  uint32_t now = micros();
+  if ((uint32_t)(now - last) < 300) {
+    delayMicroseconds(300 - (now - last));
+  }
+  leds.show();
+  last = micros();
+}
+#endif
+
+#if LOW_POWER
+// ========================= Low power =========================
+static volatile bool    g_inputEvent = false;  // an input pin changed since the pass started
+static volatile uint8_t g_pitTicks   = 0;      // V2 heartbeat time base
+
+ISR(PORTA_PORT_vect) { PORTA.INTFLAGS = PORTA.INTFLAGS; g_inputEvent = true; }
+ISR(PORTB_PORT_vect) { PORTB.INTFLAGS = PORTB.INTFLAGS; g_inputEvent = true; }
+#if PRESET_BOARD == 2
+ISR(RTC_PIT_vect)    { RTC.PITINTFLAGS = RTC_PI_bm; g_pitTicks++; }
+#endif
+
+// Both-edge sensing on every used row pin (not attachInterrupt(): it would claim the port vectors).
+static void wakeOnChange(PORT_t& port, uint8_t mask) {
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    if (!(mask & (1 << bit))) continue;
+    volatile uint8_t* ctrl = &port.PIN0CTRL + bit;
+    *ctrl = (*ctrl & ~PORT_ISC_gm) | PORT_ISC_BOTHEDGES_gc;
+  }
+  port.INTFLAGS = 0xFF;
+}
+
+static void initLowPower() {
+  wakeOnChange(PORTA, IN_MASK & 0xFF);
+  wakeOnChange(PORTB, IN_MASK >> 8);
+
+#if PRESET_BOARD == 2
+  while (RTC.STATUS) {}
+  RTC.CLKSEL = RTC_CLKSEL_INT32K_gc;
+  while (RTC.PITSTATUS) {}
+  RTC.PITCTRLA   = HEARTBEAT_PIT | RTC_PITEN_bm;
+  RTC.PITINTCTRL = RTC_PI_bm;
+#endif
+
+  // Main oscillator keeps running in standby: wake-up adds nothing to input-to-output latency.
+  _PROTECTED_WRITE(CLKCTRL.OSC20MCTRLA, CLKCTRL_RUNSTDBY_bm);
+  set_sleep_mode(SLEEP_MODE_STANDBY);
+}
+#endif
+
+void setup() {
+  // Inputs stay plain INPUT (external pulldowns), which is the reset state.
+#if PRESET_BOARD == 1
+  ledTest();
+#endif
+  initOutputs();
+  writeOutputs(0);
+
+#if PRESET_BOARD == 2
+  leds.begin();
+  leds.clear();
+  ledsShowSafe();
+#endif
+
+#if LOW_POWER
+  initLowPower();
+#endif
+}
+
+void loop() {
+#if LOW_POWER
+  g_inputEvent = false;  // cleared before sampling: an edge during this pass runs another
+#endif
+
+  uint8_t rows = rowsFromSnapshot(readPortsStable());
+  writeOutputs(rows);
+
+#if PRESET_BOARD == 2
+  uint8_t outs = LUT.v[rows];
+  for (uint8_t r = 0; r < Board::rows; r++) {
+    bool on = (USED & (1 << r)) && (rows & (1 << r));
+    leds.setPixelColor(LED_IN1 + r, on ? leds.Color(0, 48, 0) : 0);
+  }
+  leds.setPixelColor(LED_Y,    (outs & 1) ? leds.Color(0, 64, 0) : 0);
+  leds.setPixelColor(LED_YBAR, (outs & 2) ? leds.Color(64, 0, 0) : 0);
+
+  // Center heartbeat (slow fade), quantised so it only changes the frame every HB_STEP
+#if LOW_POWER
+  uint8_t hb = (uint8_t)(g_pitTicks * HB_STEP) & 0x3F;  // one quantum per PIT step (~1 s ramp)
+#else
+  static uint16_t t = 0; t++;
+  uint8_t hb = ((t >> 4) & 0x3F);
+#endif
+  hb &= ~(HB_STEP - 1);
+  leds.setPixelColor(LED_CENTER, leds.Color(0, hb, hb));
+
+  ledsShowSafe();
+#endif
+
+#if LOW_POWER
+  // Sleep until an input edge (or, on V2, the next heartbeat step).
+  // sei; sleep is atomic on AVR, so an edge can't slip in between check and sleep.
+  noInterrupts();
+  if (!g_inputEvent) {
+    sleep_enable();
+    interrupts();
+    sleep_cpu();
+    sleep_disable();
+  }
+  interrupts();
+#endif
+}
@@ -0,0 +1,76 @@
+# BreadboarD GeniuS Preset Firmware Builder
+# Builds every fixed-function gate image from the single PresetGate sketch
+# and writes the .hex files where the programmer expects them.
+#
+# Needs arduino-cli with megaTinyCore installed:
+#   arduino-cli core install megaTinyCore:megaavr
+#
+# Usage:
+#   python build_presets.py            build every preset
+#   python build_presets.py and-nand   build only presets whose hex name contains "and-nand"
+
+import os
+import sys
+import shutil
+import subprocess
+import tempfile
+
+# --- Globals ---
+HERE = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.dirname(HERE)
+SKETCH = os.path.join(HERE, "PresetGate")
+ARDUINO_CLI = os.environ.get("ARDUINO_CLI", "arduino-cli")
+
+# ATtiny1616, 20 MHz internal, same as the hand-built images
+FQBN = "megaTinyCore:megaavr:atxy6:chip=1616,clock=20internal,millis=enabled"
+
+V1_DIR = os.path.join(REPO, "Programmable Logic gates V1")
+V2_DIR = os.path.join(REPO, "Programmable Logic gates V2")
+
+# (board, family, output hex)
+PRESETS = [
+    (1, "GF_ANDNAND", os.path.join(V1_DIR, "and-nand.hex")),
+    (1, "GF_ORNOR",   os.path.join(V1_DIR, "or-nor.hex")),
+    (1, "GF_XORXNOR", os.path.join(V1_DIR, "xor-xnor.hex")),
+    (1, "GF_MAJMIN",  os.path.join(V1_DIR, "majority-minority.hex")),
+    (1, "GF_DUALNOT", os.path.join(V1_DIR, "dual-not.hex")),
+    (2, "GF_ANDNAND", os.path.join(V2_DIR, "V2-And-Nand.hex")),
+    (2, "GF_ORNOR",   os.path.join(V2_DIR, "V2-Or-Nor.hex")),
+    (2, "GF_XORXNOR", os.path.join(V2_DIR, "V2-Xor-Xnor.hex")),
+    (2, "GF_MAJMIN",  os.path.join(V2_DIR, "V2-Majority-Minority.hex")),
+    (2, "GF_DUALNOT", os.path.join(V2_DIR, "V2-Dual-Not.hex")),
+]
+
+# --- Build ---
+def build_preset(board, family, hex_path):
+    flags = f"-DPRESET_BOARD={board} -DPRESET_FAMILY={family}"
+    with tempfile.TemporaryDirectory() as out_dir:
+        command = [
+            ARDUINO_CLI, "compile",
+            "--fqbn", FQBN,
+            "--build-property", f"compiler.cpp.extra_flags={flags}",
+            "--output-dir", out_dir,
+            SKETCH,
+        ]
+        print(f"[V{board} {family}] -> {os.path.relpath(hex_path, REPO)}")
+        result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+        if result.returncode != 0:
+            print(result.stdout)
+            return False
+        built = os.path.join(out_dir, os.path.basename(SKETCH) + ".ino.hex")
+        shutil.copyfile(built, hex_path)
+    return True
+
+def main(argv):
+    selected = [p for p in PRESETS if not argv or any(a.lower() in os.path.basename(p[2]).lower() for a in argv)]
+    if not selected:
+        print("No preset matches " + " ".join(argv))
+        return 1
+    failed = [p for p in selected if not build_preset(*p)]
+    for board, family, hex_path in failed:
+        print(f"FAILED: V{board} {family} ({os.path.basename(hex_path)})")
+    print(f"{len(selected) - len(failed)}/{len(selected)} presets built")
+    return 1 if failed else 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
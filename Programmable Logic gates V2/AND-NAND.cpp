@@ -1,4 +1,6 @@
 #include <tinyNeoPixel.h>
+#include <avr/sleep.h>
+#include <string.h>
 
 // =========================
 // ATtiny1616 Programmable Logic Gate — Shipping Preset: 4-Input AND
@@ -35,6 +37,16 @@
 #define LED_PIN   PIN_PA4
 #define LED_COUNT 7
 
+// Heartbeat brightness moves in steps of HB_STEP, so it only changes the LED frame
+// (and costs a WS2812 push) a few times per ramp instead of on every pass.
+#define HB_STEP 8
+
+// Low power: 1 = sleep (standby) between input edges instead of spinning.
+// Any input edge wakes the MCU straight into a new evaluation pass; the RTC PIT
+// (32 kHz ULP, runs in standby) wakes it for the heartbeat steps.
+#define LOW_POWER     1
+#define HEARTBEAT_PIT RTC_PERIOD_CYC4096_gc   // 32768 / 4096 = 8 heartbeat steps/s
+
 tinyNeoPixel leds(LED_COUNT, LED_PIN, NEO_GRB + NEO_KHZ800);
 
 enum { LED_IN1=0, LED_IN2=1, LED_IN3=2, LED_IN4=3, LED_CENTER=4, LED_AND=5, LED_NAND=6 };
@@ -72,7 +84,15 @@ static inline void showInputLed(uint8_t idx, bool on) {
 }
 
 // Guard WS2812 latch time (some batches ~250-300us)
+// Frames identical to the last one pushed are skipped: no latch wait, no interrupts-off time.
 static inline void ledsShowSafe() {
+  static uint8_t shown[LED_COUNT * 3];
+  static bool shownValid = false;
+  const uint8_t* px = leds.getPixels();
+  if (shownValid && memcmp(px, shown, sizeof(shown)) == 0) return;
+  memcpy(shown, px, sizeof(shown));
+  shownValid = true;
+
   static uint32_t last = 0;
   uint32_t now = micros();
   if ((uint32_t)(now - last) < 300) {
@@ -82,6 +102,41 @@ static inline void ledsShowSafe() {
   last = micros();
 }
 
+#if LOW_POWER
+static volatile bool    g_inputEvent = false;  // an input pin changed since the pass started
+static volatile uint8_t g_pitTicks   = 0;      // heartbeat time base
+
+ISR(PORTA_PORT_vect) { PORTA.INTFLAGS = PORTA.INTFLAGS; g_inputEvent = true; }
+ISR(PORTB_PORT_vect) { PORTB.INTFLAGS = PORTB.INTFLAGS; g_inputEvent = true; }
+ISR(RTC_PIT_vect)    { RTC.PITINTFLAGS = RTC_PI_bm; g_pitTicks++; }
+
+// Both-edge sensing: wakes from standby on every pin, not just the async ones.
+// (Not attachInterrupt(): it would claim the port vectors above.)
+static void wakeOnChange(uint8_t pin) {
+  PORT_t* port = digitalPinToPortStruct(pin);
+  volatile uint8_t* ctrl = &port->PIN0CTRL + digitalPinToBitPosition(pin);
+  *ctrl = (*ctrl & ~PORT_ISC_gm) | PORT_ISC_BOTHEDGES_gc;
+}
+
+static void initLowPower() {
+  const uint8_t inputs[] = {IN_1A, IN_1B, IN_1C, IN_2A, IN_2B, IN_3A, IN_3B, IN_4A, IN_4B, IN_4C};
+  for (uint8_t i = 0; i < sizeof(inputs); ++i) wakeOnChange(inputs[i]);
+  PORTA.INTFLAGS = 0xFF;
+  PORTB.INTFLAGS = 0xFF;
+
+  while (RTC.STATUS) {}
+  RTC.CLKSEL = RTC_CLKSEL_INT32K_gc;
+  while (RTC.PITSTATUS) {}
+  RTC.PITCTRLA   = HEARTBEAT_PIT | RTC_PITEN_bm;
+  RTC.PITINTCTRL = RTC_PI_bm;
+
+  // Keep the main oscillator running in standby: wake-up is then immediate,
+  // so sleeping adds nothing to input-to-output latency.
+  _PROTECTED_WRITE(CLKCTRL.OSC20MCTRLA, CLKCTRL_RUNSTDBY_bm);
+  set_sleep_mode(SLEEP_MODE_STANDBY);
+}
+#endif
+
 void setup() {
   // Inputs: plain INPUT (external pulldowns provide bias)
   pinMode(IN_1A, INPUT); pinMode(IN_1B, INPUT); pinMode(IN_1C, INPUT);
@@ -97,9 +152,17 @@ void setup() {
   leds.begin();
   leds.clear();
   ledsShowSafe();
+
+#if LOW_POWER
+  initLowPower();
+#endif
 }
 
 void loop() {
+#if LOW_POWER
+  g_inputEvent = false;  // cleared before sampling: an edge during this pass runs another
+#endif
+
   // Row aggregation (row = OR of that row's pins)
   const uint8_t row1[] = {IN_1A, IN_1B, IN_1C};
   bool in1 = rowOR_arr(row1, 3);
@@ -128,9 +191,27 @@ void loop() {
   leds.setPixelColor(LED_NAND, nandOut ? leds.Color(64, 0, 0) : 0);
 
   // LED4 heartbeat (slow fade)
+#if LOW_POWER
+  uint8_t hb = (uint8_t)(g_pitTicks * HB_STEP) & 0x3F; // one quantum per PIT step (~1 s ramp)
+#else
   static uint16_t t = 0; t++;
   uint8_t hb = ((t >> 4) & 0x3F); // slowed down by shifting
+#endif
+  hb &= ~(HB_STEP - 1);           // quantise: 8 levels per ramp
   leds.setPixelColor(LED_CENTER, leds.Color(0, hb, hb)); // aqua-ish pulse
 
   ledsShowSafe();
+
+#if LOW_POWER
+  // Sleep until an input edge or the next heartbeat step.
+  // sei; sleep is atomic on AVR, so an edge can't slip in between check and sleep.
+  noInterrupts();
+  if (!g_inputEvent) {
+    sleep_enable();
+    interrupts();
+    sleep_cpu();
+    sleep_disable();
+  }
+  interrupts();
+#endif
 }
@@ -8,13 +8,20 @@
   • Programs the BreadboarD Genius programmable logic gate into a universal logic gate
   • Optional SSD1306 OLED shows a D-shaped gate symbol with inputs/outputs.
   • WS2812 LEDs show input rows and outputs; center LED shows family color.
-  • Gate family (AND/NAND, OR/NOR, XOR/XNOR, MAJ/MIN, Dual NOT) persists in EEPROM.
+  • Gate family (AND/NAND, OR/NOR, XOR/XNOR, MAJ/MIN, Dual NOT, USER) persists in EEPROM.
+  • USER = any 4-input function: two 16-bit truth tables (Y, /Y) stored in EEPROM.
+  • All settings live in one CRC-checked config record (EE_CONFIG), which the programmer
+    tool can rewrite over UPDI ("Set function") without reflashing.
+  • Sequential families: D latch, D flip-flop, JK flip-flop, T flip-flop (Q on O1*, /Q on O2*).
 
   MODES
   -----
   • With OLED connected (detected at boot):
       - Use 3-input logic (rows 1..3).
       - IN_4A acts as a MODE button (short press cycles gate family; saved to EEPROM).
+      - Long press steps through pages: gate -> input filter for rows 1..3 -> capture
+        -> performance -> gate. On a filter page, a short press cycles that row's filter
+        preset.
   • Without OLED:
       - Use 4-input logic (rows 1..4); row 4 = IN_4A/B/C.
       - No button; IN_4A remains a normal input pin.
@@ -31,20 +38,28 @@
   • XOR/XNOR → Magenta-ish (R=32, B=48)
   • MAJORITY/MINORITY → Yellow (R=48, G=48)
   • Dual NOT → Cyan-ish (G=32, B=48)
+  • USER truth table → Dim white (R=G=B=24)
+  • D latch / D FF / JK FF / T FF → shades of blue
 
   TIMING / ROBUSTNESS
   -------------------
   • 1-second startup delay before OLED probe (many modules need ~>500 ms).
   • During I²C probe, PB1/PB0 are pulled up internally to fight the 100 kΩ pulldowns.
+  • OLED traffic uses hardware TWI0 at OLED_TWI_HZ, queued and sent from its ISR.
   • WS2812 updates respect latch timing (ledsShowSafe()).
+  • With FAST_OUTPUT_ISR, input pin-change interrupts drive Y and /Y directly;
+    LEDs/OLED refresh in the background at LED_REFRESH_MS / OLED_REFRESH_MS.
+  • With HW_GATE (3-input mode), the CCL computes Y and /Y in hardware on part of the
+    output pins; the CPU only mirrors the rest and the LEDs/OLED.
 
   TUNE ME QUICKLY
   ----------------
   • Startup delay: see the 1 s loop in setup().
   • Center LED colors per family: setCenterColorByGate().
   • OLED layout (left/right shift, labels): renderOLED() constants (x0/x1/...).
-  • Debounce/read stability: readStable() (3 samples @ 80 µs spacing now).
-  • Gate families: enum GateFamily and the switch statements in loop().
+  • Input filtering per row (raw / N-of-M vote / integrator / timer debounce): filter pages
+    on the OLED (long-press MODE), stored in EEPROM; engine in "Input filters".
+  • Gate families: enum GateFamily and gateOut() (truth tables are built from it).
 
   HARDWARE EXPECTATIONS
   ---------------------
@@ -66,6 +81,9 @@
 #include <tinyNeoPixel.h>
 #include <EEPROM.h>
 #include <avr/pgmspace.h>
+#include <avr/sleep.h>
+#include <util/crc16.h>
+#include <stddef.h>
 #include <string.h>
 
 // ========================= Pin aliases =========================
@@ -100,10 +118,113 @@
 // Factory default gate family
 // Change this value to select which gate type new devices boot into
 // (used if EEPROM has no valid saved gate yet).
-// Options: GF_ANDNAND, GF_ORNOR, GF_XORXNOR, GF_MAJMIN, GF_DUALNOT
+// Options: GF_ANDNAND, GF_ORNOR, GF_XORXNOR, GF_MAJMIN, GF_DUALNOT, GF_CUSTOM,
+//          GF_DLATCH, GF_DFF, GF_JKFF, GF_TFF
 // =========================
 #define FACTORY_DEFAULT_GATE GF_ORNOR   // <--- user can change here
 
+// =========================
+// Output path
+// 1 = input pin-change interrupts on PORTA/PORTB evaluate the gate and drive
+//     O1*/O2* immediately; loop() only refreshes LEDs/OLED (rate-limited).
+// 0 = outputs are recomputed once per loop() pass only.
+// =========================
+#define FAST_OUTPUT_ISR 1
+#define LED_REFRESH_MS  20    // WS2812 push interval (each push masks IRQs ~220 µs)
+#define OLED_REFRESH_MS 50    // OLED redraw interval
+#define BTN_DEBOUNCE_MS 30    // MODE button must be stable this long
+#define BTN_LONG_MS     800   // hold this long for the next page
+
+// =========================
+// Low power
+// 1 = loop() sleeps between events instead of spinning. Inputs still wake the pin-change
+//     ISR, which drives the outputs exactly as before (no added latency); the RTC PIT
+//     (LOW_POWER_PIT, runs from the 32 kHz ULP in every sleep mode) paces LED updates.
+//     Without OLED or tick-filtered rows the MCU uses STANDBY, otherwise IDLE
+//     (millis(), TWI0 and TCB1 need the peripheral clock).
+// LOW_POWER_FAST_WAKE 1 keeps the 20 MHz oscillator running in standby so wake-up is
+//     immediate; 0 saves more current but adds the oscillator start-up to the first edge.
+// 0 = loop() spins (rate-limited by millis()).
+// =========================
+#define LOW_POWER           1
+#define LOW_POWER_FAST_WAKE 1
+#define LOW_POWER_PIT       RTC_PERIOD_CYC512_gc   // 32768 / 512 = 64 Hz (~LED_REFRESH_MS)
+#if LOW_POWER && !FAST_OUTPUT_ISR
+  #error "LOW_POWER needs FAST_OUTPUT_ISR (the pin-change ISR is the wake-up source)"
+#endif
+
+// =========================
+// Hardware gate (CCL)
+// 1 = in 3-input (OLED) mode, the gate is computed by the CCL look-up tables, so the
+//     outputs follow the inputs in tens of ns with no CPU involved:
+//       LUT0 = Y from IN_1A / IN_2A / IN_3A -> O1A + O1B (event outputs)
+//       LUT1 = /Y from Y, IN_2A, IN_3A      -> O2C
+//     O1C, O2A, O2B are still driven by the pin-change ISR (µs), as are the LEDs/OLED.
+//     Only the A pin of each row reaches the CCL, so rows are NOT OR'd in this mode.
+//     Falls back to the CPU path in 4-input mode, or for a USER /Y table that is not a
+//     function of (Y, row 2, row 3).
+// 0 = CPU path only (row-OR on every pin; shipping default).
+// Host Tests build it with -DHW_GATE=1 (sketch_universal_ccl) to check the CCL setup.
+// =========================
+#ifndef HW_GATE
+#define HW_GATE 0
+#endif
+
+// =========================
+// Logic-analyser capture
+// 1 = every change of the rows / Y / /Y seen by the output path is stored in a RAM ring
+//     buffer (g_cap), stamped by free-running TCB0 at F_CPU/2 (0.1 µs at 20 MHz).
+//     Stamped after the outputs are driven, so it adds nothing to input->output latency.
+//     Not armed at boot: TCB0 and a stamp per edge only run once it is.
+//     With OLED: long-press to the CAP page (waveform) to arm it, short press = RUN / HOLD.
+//     Any build: read over UPDI with the programmer tool (--dump-capture, writes a .vcd).
+//     Costs 335 bytes of RAM (CAPTURE_DEPTH 64) and the same again in flash for g_cap's
+//     initial image.
+// CAPTURE_AT_BOOT 1 = armed from boot, also without OLED (keeps the MCU in IDLE, not STANDBY).
+// 0 = compiled out.
+// =========================
+#ifndef CAPTURE
+#define CAPTURE         1
+#endif
+#define CAPTURE_DEPTH   64    // events, power of two (5 bytes each)
+#define CAPTURE_AT_BOOT 0
+
+// =========================
+// Phase trace (for cycle-level timing in a simulator or on a logic analyser)
+// 1 = write the current hot-path phase number to GPIOR0 on entry to each phase.
+//     An AVR simulator tracing GPIOR0 (e.g. a simavr VCD) then gives cycles per
+//     phase and per loop() pass. Costs one OUT instruction per mark.
+//     The host benchmark (Host Tests/gate_bench) builds with -DPHASE_TRACE=1.
+// 0 = marks compile away (shipping default).
+// =========================
+#ifndef PHASE_TRACE
+#define PHASE_TRACE 0
+#endif
+enum { PH_IDLE=0, PH_SAMPLE, PH_EVAL, PH_DRIVE, PH_LEDS, PH_OLED_RENDER, PH_OLED_FLUSH, PH_LOOP };
+#if PHASE_TRACE
+  #define PHASE(n)    (GPIOR0 = (n))
+  #define PHASE_GET() (GPIOR0)
+#else
+  #define PHASE(n)    ((void)(n))
+  #define PHASE_GET() (PH_IDLE)
+#endif
+
+// =========================
+// Performance counters
+// 1 = keep live timing stats: loop() passes per second, loop() pass time (recent mean and
+//     worst), time in ledsShowSafe() and oled_flush(), and the input->output latency of
+//     updateOutputs(). With OLED: long-press to the PERF page; short press clears them.
+//     The worst cases are also kept in EEPROM (EE_PERF), so they survive power cycles.
+//     Latency is stamped by free-running TCB0 (shared with CAPTURE, F_CPU/2).
+//     Costs 56 bytes of RAM, a few micros() reads per loop() pass and the PERF page code.
+// PERF_SAVE_MS = least time between two EEPROM updates of the worst cases.
+// 0 = compiled out (shipping default). Host Tests build it with -DPERF_STATS=1 (perf_test).
+// =========================
+#ifndef PERF_STATS
+#define PERF_STATS   0
+#endif
+#define PERF_SAVE_MS 60000UL
+
 // ========================= WS2812 LEDs =========================
 // 7 pixels total: 0..3 inputs, 4 center (family color), 5=Y, 6=/Y
 #define LED_PIN   PIN_PA4
@@ -113,66 +234,193 @@ tinyNeoPixel leds(LED_COUNT, LED_PIN, NEO_GRB + NEO_KHZ800);
 enum { LED_IN1=0, LED_IN2=1, LED_IN3=2, LED_IN4=3, LED_CENTER=4, LED_Y=5, LED_YBAR=6 };
 
 // ========================= Gate families =========================
-// To add another family, extend this enum AND update both switch() trees in loop().
-enum GateFamily : uint8_t { GF_ANDNAND=0, GF_ORNOR, GF_XORXNOR, GF_MAJMIN, GF_DUALNOT, GF__COUNT };
-
-// EEPROM storage locations (expand if you save more state later)
+// To add another family, extend this enum AND add its rule to gateOut().
+// Families after GF_CUSTOM are sequential (state + clock), see seqEval().
+//   row 1 = D / J / T, row 2 = CLK (latch: enable), row 3 = K, row 4 = clear (4-input mode)
+enum GateFamily : uint8_t { GF_ANDNAND=0, GF_ORNOR, GF_XORXNOR, GF_MAJMIN, GF_DUALNOT, GF_CUSTOM,
+                            GF_DLATCH, GF_DFF, GF_JKFF, GF_TFF, GF__COUNT };
+static inline bool isSeqFamily(uint8_t gf) { return gf >= GF_DLATCH && gf < GF__COUNT; }
+
+// EEPROM storage locations
+// Shipped layout before the config record: the family byte only. Still read to migrate old modules.
 #define EE_GATE_FAMILY 0
-
-// ========================= I2C (bit-banged) =========================
-// We roll our own to ensure the lines can double as inputs when no OLED is present.
+// Current layout: one ConfigRecord (see "Config record"), written by the MODE button and
+// by the programmer tool's "Set function" over UPDI.
+#define EE_CONFIG      16
+#define EE_PERF        32   // PerfRecord: worst cases seen (PERF_STATS), after the config record
+
+// ========================= I2C =========================
+// The boot probe is bit-banged so the lines can double as inputs when no OLED is present.
+// Once a display answers, TWI0 (PB1 = SDA, PB0 = SCL) takes over the same pins.
 #define SDA_PIN IN_4B
 #define SCL_PIN IN_4C
 
+// 400000 = Fast mode. 1000000 = Fast-mode Plus (needs real pull-ups on the OLED module;
+// the internal pull-ups alone are too weak for clean 1 MHz edges).
+#define OLED_TWI_HZ 400000
+
 static bool    g_hasOLED  = false; // set true after successful probe
 static uint8_t g_oledAddr = 0x3C;  // default, 0x3D as fallback
 static uint8_t g_gateFamily = FACTORY_DEFAULT_GATE;
+static uint8_t g_ledBrightness = 255;  // tinyNeoPixel scale, 255 = colors as written
 
 // ========================= Input reading helpers =========================
+// Every input row lives on PORTA or PORTB, so one read of VPORTA.IN + VPORTB.IN
+// captures all row pins at the same instant. Snapshot layout: PA in the low byte,
+// PB in the high byte. Row membership is precomputed from the IN_* aliases in
+// initInputMasks(), so changing the pin defines still “just works”.
+
+// Spacing between the snapshots of an N-of-M vote (FILT_VOTE rows, and the MODE button).
+// • If you want stronger debounce, increase the spacing.
+// • 0 gives the fastest response (back-to-back reads, still rejects 1-read spikes).
+#define IN_GLITCH_US 2
+
+static uint16_t g_rowMask[4];  // snapshot bits that make up rows 1..4 (row 4 = 0 when OLED present)
+static uint16_t g_btnMask;     // snapshot bit of IN_4A (MODE button when OLED present)
+
+// Bit of a pin inside the 16-bit PA|PB<<8 snapshot (0 if the pin is not on PA/PB).
+static uint16_t pinSnapBit(uint8_t pin) {
+  uint8_t port = digitalPinToPort(pin);
+  uint8_t mask = digitalPinToBitMask(pin);
+  if (port == PA) return mask;
+  if (port == PB) return (uint16_t)mask << 8;
+  return 0;
+}
 
-// Read a pin as a boolean. Separated out so you can add inversion if needed.
-static inline bool readPinLogical(uint8_t pin) { return digitalRead(pin); }
+// Build the row masks. Call after probeOLED(): row 4 is only an input without OLED.
+// With HW_GATE in 3-input mode the CCL only sees the A pins, so the CPU mirror does too.
+static void initInputMasks() {
+  g_rowMask[0] = pinSnapBit(IN_1A) | pinSnapBit(IN_1B) | pinSnapBit(IN_1C);
+  g_rowMask[1] = pinSnapBit(IN_2A) | pinSnapBit(IN_2B);
+  g_rowMask[2] = pinSnapBit(IN_3A) | pinSnapBit(IN_3B);
+  g_rowMask[3] = g_hasOLED ? 0 : (pinSnapBit(IN_4A) | pinSnapBit(IN_4B) | pinSnapBit(IN_4C));
+  g_btnMask    = pinSnapBit(IN_4A);
+#if HW_GATE
+  if (g_hasOLED) {
+    g_rowMask[0] = pinSnapBit(IN_1A);
+    g_rowMask[1] = pinSnapBit(IN_2A);
+    g_rowMask[2] = pinSnapBit(IN_3A);
+  }
+#endif
+}
 
-// Take 3 quick samples with small spacing to avoid single-sample glitches.
-// • If you want stronger debounce, increase samples or spacing.
-// • If your edges are slow and you care about speed, *reduce* spacing.
-static inline bool readStable(uint8_t pin) {
-  uint8_t s = 0;
-  s += readPinLogical(pin);
-  delayMicroseconds(80);
-  s += readPinLogical(pin);
-  delayMicroseconds(80);
-  s += readPinLogical(pin);
-  return s >= 2; // majority vote (2/3)
+// One coherent read of both input ports.
+static inline uint16_t readPortsSnapshot() {
+  return VPORTA.IN | ((uint16_t)VPORTB.IN << 8);
 }
 
-// OR a small set of pins to build a “row” (any asserted pin makes the row true).
-static inline bool rowOR_arr(const uint8_t* pins, uint8_t n) {
-  for (uint8_t i = 0; i < n; ++i) {
-    if (readStable(pins[i])) return true;
-  }
-  return false;
+// Take 3 whole-port snapshots and majority-vote every bit at once (2-of-3),
+// so a single-sample glitch on any pin is rejected in a few microseconds.
+static inline uint16_t readPortsStable() {
+  uint16_t a = readPortsSnapshot();
+  delayMicroseconds(IN_GLITCH_US);
+  uint16_t b = readPortsSnapshot();
+  delayMicroseconds(IN_GLITCH_US);
+  uint16_t c = readPortsSnapshot();
+  return (a & b) | (a & c) | (b & c);
+}
+
+// Fold a snapshot into row bits (bit0 = row 1 ... bit3 = row 4).
+// A row is true if any of its pins is asserted.
+static inline uint8_t rowsFromSnapshot(uint16_t s) {
+  uint8_t r = 0;
+  if (s & g_rowMask[0]) r |= 0x01;
+  if (s & g_rowMask[1]) r |= 0x02;
+  if (s & g_rowMask[2]) r |= 0x04;
+  if (s & g_rowMask[3]) r |= 0x08;
+  return r;
 }
 
+// ========================= Performance counters =========================
+// Written by loop(), ledsShowSafe(), oled_flush() and (lat) updateOutputs() in ISR context;
+// read with interrupts masked. The page and the EEPROM record are in "Performance page".
+#if PERF_STATS
+struct PerfStat {
+  uint32_t mean16;        // running mean x16, each sample weighs 1/16
+  uint16_t max;
+};
+
+struct PerfCounters {
+  PerfStat loop;          // loop() pass, µs (sleep excluded)
+  PerfStat leds;          // ledsShowSafe() pushes, µs (latch wait + show)
+  PerfStat flush;         // oled_flush(), µs
+  PerfStat lat;           // updateOutputs() on an input change, sample -> drive, TCB0 ticks
+  uint32_t passes;        // loop() passes in the current second
+  uint32_t perSec;        // loop() passes in the last full second
+};
+static PerfCounters g_perf;
+
+static inline void perfAdd(PerfStat& s, uint16_t v) {
+  s.mean16 = s.mean16 - (s.mean16 >> 4) + v;
+  if (v > s.max) s.max = v;
+}
+
+// µs since t0 (micros()), saturated to 16 bits.
+static inline uint16_t perfUs(uint32_t t0) {
+  uint32_t d = micros() - t0;
+  return d > 0xFFFF ? 0xFFFF : (uint16_t)d;
+}
+
+// TCB0 ticks (F_CPU/2) -> tenths of a µs, saturated to 16 bits (below 20 MHz a tick is
+// more than a tenth, so a full 16-bit tick count would not fit).
+static inline uint16_t perfTenths(uint16_t ticks) {
+  const uint32_t t = (uint32_t)ticks * 20 / (F_CPU / 1000000UL);
+  return t > 0xFFFF ? 0xFFFF : (uint16_t)t;
+}
+#endif
+
 // ========================= Output + LED helpers =========================
 
-// Drive the three pins of a bus in one call (keeps them coherent).
-static inline void setBus(uint8_t p1, uint8_t p2, uint8_t p3, bool val) {
-  digitalWrite(p1, val);
-  digitalWrite(p2, val);
-  digitalWrite(p3, val);
+// Output bus pins as per-port masks (index 0/1/2 = PORTA/B/C), built from the O1*/O2* aliases.
+// Writing OUTSET/OUTCLR is atomic, so the ISR and loop() can both drive the buses safely.
+static uint8_t g_o1Mask[3], g_o2Mask[3];
+
+static void addOutMask(uint8_t* m, uint8_t pin) {
+  uint8_t port = digitalPinToPort(pin);
+  if (port <= PC) m[port] |= digitalPinToBitMask(pin);
+}
+
+static void initOutputMasks() {
+  addOutMask(g_o1Mask, O1A); addOutMask(g_o1Mask, O1B); addOutMask(g_o1Mask, O1C);
+  addOutMask(g_o2Mask, O2A); addOutMask(g_o2Mask, O2B); addOutMask(g_o2Mask, O2C);
+}
+
+// Drive both buses: two register writes per port, no digitalWrite() overhead.
+static inline void driveOutputs(bool Y, bool Yb) {
+  PORT_t* const ports[3] = { &PORTA, &PORTB, &PORTC };
+  for (uint8_t i = 0; i < 3; i++) {
+    uint8_t all = g_o1Mask[i] | g_o2Mask[i];
+    if (!all) continue;
+    uint8_t hi = (Y ? g_o1Mask[i] : 0) | (Yb ? g_o2Mask[i] : 0);
+    ports[i]->OUTSET = hi;
+    ports[i]->OUTCLR = all & ~hi;
+  }
 }
 
 // WS2812 requires a ~50 µs latch between updates. This enforces a minimum gap.
 // If you push more pixels, increase the guard a touch.
+// The last frame sent is cached: an identical frame is skipped outright, so a pass where
+// nothing visible changed costs a 21-byte compare instead of ~220 µs with interrupts off.
 static inline void ledsShowSafe() {
+  static uint8_t shown[LED_COUNT * 3];
+  static bool shownValid = false;
+  const uint8_t* px = leds.getPixels();
+  if (shownValid && memcmp(px, shown, sizeof(shown)) == 0) return;
+  memcpy(shown, px, sizeof(shown));
+  shownValid = true;
+
+  PHASE(PH_LEDS);
   static uint32_t last = 0;
   uint32_t now = micros();
   if ((uint32_t)(now - last) < 300) {               // 300 µs is conservative & safe
     delayMicroseconds(300 - (now - last));
   }
   leds.show();
+#if PERF_STATS
+  perfAdd(g_perf.leds, perfUs(now));
+#endif
   last = micros();
+  PHASE(PH_LOOP);
 }
 
 // Family color for the center LED (steady after boot)
@@ -185,6 +433,11 @@ static inline void setCenterColorByGate(uint8_t gf){
     case GF_XORXNOR: r=32; b=48; break;    // magenta-ish
     case GF_MAJMIN:  r=48; g=48; break;    // yellow
     case GF_DUALNOT: g=32; b=48; break;    // cyan-ish
+    case GF_CUSTOM:  r=24; g=24; b=24; break; // dim white
+    case GF_DLATCH:  g=24; b=64; break;    // sky blue
+    case GF_DFF:     b=64; break;          // blue
+    case GF_JKFF:    r=16; b=64; break;    // violet-blue
+    case GF_TFF:     r=32; b=64; break;    // violet
   }
   leds.setPixelColor(LED_CENTER, leds.Color(r,g,b));
 }
@@ -194,7 +447,7 @@ static inline void showInputLED(uint8_t idx,bool on){
   leds.setPixelColor(idx, on ? leds.Color(0, 48, 0) : 0);
 }
 
-// ========================= Bit-bang I2C (SSD1306) =========================
+// ========================= Bit-bang I2C (OLED probe only) =========================
 // If SSD1306 probe fails, SDA/SCL revert to INPUT so they can be used as logic inputs.
 
 static inline void i2c_delay() { delayMicroseconds(8); } // ~100 kHz-ish with our toggles
@@ -245,198 +498,1252 @@ static bool probeOLED() {
   return found;
 }
 
+// ========================= Hardware TWI0 (SSD1306 traffic) =========================
+// Transfers are queued as jobs (control byte + pointer/length) and clocked out by the
+// TWI0 master interrupt, so callers return immediately. Job data must stay valid until
+// sent: we only queue const tables, oledWin[] and slices of oledFB.
+// Consecutive jobs are chained with a repeated START; STOP is sent when the queue drains.
+
+#define TWI_QLEN 20
+#define TWI_BAUD(f) ((F_CPU / (2UL * (f))) > 5 ? (F_CPU / (2UL * (f))) - 5 : 0)
+
+struct TwiJob { const uint8_t* data; uint8_t len; uint8_t ctrl; };
+static TwiJob twiQ[TWI_QLEN];
+static volatile uint8_t twiHead = 0;      // next job to send (ISR advances)
+static volatile uint8_t twiTail = 0;      // next free slot (loop advances)
+static volatile bool    twiBusy = false;  // a transaction is on the bus
+static uint8_t twiPos;                    // 0 = control byte next, n = data[n-1] next
+
+static inline uint8_t twiFree() { return (uint8_t)(twiHead + TWI_QLEN - twiTail - 1) % TWI_QLEN; }
+
+// Begin the job at twiHead (START, or repeated START while we still own the bus).
+static void twiStartJob() {
+  twiPos = 0;
+  TWI0.MADDR = (g_oledAddr << 1) | 0;
+}
+
+ISR(TWI0_TWIM_vect) {
+  uint8_t st = TWI0.MSTATUS;
+  const TwiJob& j = twiQ[twiHead];
+  if (st & (TWI_ARBLOST_bm | TWI_BUSERR_bm | TWI_RXACK_bm)) {
+    // NACK or bus trouble: drop this job, release the bus, let the next kick retry.
+    TWI0.MCTRLB = TWI_MCMD_STOP_gc;
+    twiHead = (twiHead + 1) % TWI_QLEN;
+    twiBusy = false;
+    return;
+  }
+  if (twiPos == 0)          { TWI0.MDATA = j.ctrl;            twiPos = 1; return; }
+  if (twiPos <= j.len)      { TWI0.MDATA = j.data[twiPos-1];  twiPos++;   return; }
+  twiHead = (twiHead + 1) % TWI_QLEN;                        // job complete
+  if (twiHead != twiTail) twiStartJob();
+  else { TWI0.MCTRLB = TWI_MCMD_STOP_gc; twiBusy = false; }
+}
+
+// Start the bus if it is idle and work is waiting.
+static void twiKick() {
+  noInterrupts();
+  if (!twiBusy && twiHead != twiTail &&
+      (TWI0.MSTATUS & TWI_BUSSTATE_gm) == TWI_BUSSTATE_IDLE_gc) {
+    twiBusy = true;
+    twiStartJob();
+  }
+  interrupts();
+}
+
+// Queue one transaction: ctrl 0x00 = command stream, 0x40 = display data.
+static bool twiQueue(uint8_t ctrl, const uint8_t* data, uint8_t len) {
+  uint8_t next = (twiTail + 1) % TWI_QLEN;
+  if (next == twiHead) return false;        // full
+  twiQ[twiTail].data = data;
+  twiQ[twiTail].len  = len;
+  twiQ[twiTail].ctrl = ctrl;
+  twiTail = next;                           // publish to the ISR
+  twiKick();
+  return true;
+}
+
+// Block until the queue drains (init only). Gives up after 50 ms so a dead bus can't hang us.
+static void twiWait() {
+  uint32_t t0 = millis();
+  while ((twiBusy || twiHead != twiTail) && (millis() - t0) < 50) twiKick();
+}
+
+// Hand PB1/PB0 to TWI0. Pins keep the internal pull-ups left on by the probe.
+static void twi_begin() {
+  TWI0.MBAUD = TWI_BAUD(OLED_TWI_HZ);
+#if OLED_TWI_HZ > 400000
+  TWI0.CTRLA |= TWI_FMPEN_bm;               // Fast-mode Plus drive strength
+#endif
+  TWI0.MCTRLA = TWI_WIEN_bm | TWI_ENABLE_bm;
+  TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc;      // force the bus state machine to idle
+}
+
 // ========================= Minimal SSD1306 driver =========================
-// Framebuffer is 128x64 / 8 = 1024 bytes. We blast full buffer on flush (simple & robust).
+// Framebuffer is 128x64 / 8 = 1024 bytes. Every write goes through oled_write(), which
+// records a dirty column range per page; oled_flush() queues only those ranges and
+// does nothing at all when the frame is unchanged.
 
 static uint8_t oledFB[1024];
 
-static void oled_cmd(uint8_t c) { i2c_start(); i2c_write((g_oledAddr<<1)|0); i2c_write(0x00); i2c_write(c); i2c_stop(); }
+// Dirty column range per page (clean when lo > hi). Starts fully dirty: panel RAM is random.
+static uint8_t oledDirtyLo[8];
+static uint8_t oledDirtyHi[8] = { 127,127,127,127,127,127,127,127 };
+
+// Per-page addressing windows; each must outlive its queued job, hence static storage.
+static uint8_t oledWin[8][6];
 
 // Basic init sequence (horizontal addressing)
+static const uint8_t OLED_INIT[] = {
+  0xAE,                                 // display off
+  0x20, 0x00,                           // horizontal addressing mode
+  0x40,                                 // set display start line
+  0xA1,                                 // segment remap (mirror X)
+  0xC8,                                 // COM scan direction (mirror Y)
+  0x81, 0x7F,                           // contrast
+  0xA4,                                 // resume to RAM content
+  0xA6,                                 // normal (not inverted)
+  0xD5, 0x80,                           // clock divide
+  0xD9, 0xF1,                           // pre-charge
+  0xDA, 0x12,                           // COM pins
+  0xDB, 0x40,                           // VCOM detect
+  0x8D, 0x14,                           // charge pump on
+  0xAF                                  // display on
+};
+
 static void oled_begin(){
-  oled_cmd(0xAE);                       // display off
-  oled_cmd(0x20); oled_cmd(0x00);       // horizontal addressing mode
-  oled_cmd(0x40);                       // set display start line
-  oled_cmd(0xA1);                       // segment remap (mirror X)
-  oled_cmd(0xC8);                       // COM scan direction (mirror Y)
-  oled_cmd(0x81); oled_cmd(0x7F);       // contrast
-  oled_cmd(0xA4);                       // resume to RAM content
-  oled_cmd(0xA6);                       // normal (not inverted)
-  oled_cmd(0xD5); oled_cmd(0x80);       // clock divide
-  oled_cmd(0xD9); oled_cmd(0xF1);       // pre-charge
-  oled_cmd(0xDA); oled_cmd(0x12);       // COM pins
-  oled_cmd(0xDB); oled_cmd(0x40);       // VCOM detect
-  oled_cmd(0x8D); oled_cmd(0x14);       // charge pump on
-  oled_cmd(0xAF);                       // display on
-}
-
-static void oled_clear(){ memset(oledFB,0,sizeof(oledFB)); }
+  twi_begin();
+  twiQueue(0x00, OLED_INIT, sizeof(OLED_INIT));
+  twiWait();
+}
+
+static inline void oled_markDirty(uint8_t page, uint8_t x){
+  if (x < oledDirtyLo[page]) oledDirtyLo[page] = x;
+  if (x > oledDirtyHi[page]) oledDirtyHi[page] = x;
+}
 
+// Store one framebuffer byte; only a real change makes the page dirty.
+static inline void oled_write(uint8_t page, uint8_t x, uint8_t v){
+  uint8_t* b = &oledFB[page*128 + x];
+  if (*b != v) { *b = v; oled_markDirty(page, x); }
+}
+
+// Blank the frame. Byte-wise through oled_write(), so only what was lit gets re-sent.
+static void oled_clear(){
+  for (uint8_t p=0;p<8;p++)
+    for (uint8_t x=0;x<128;x++) oled_write(p, x, 0);
+}
+
+// Queue the dirty column window of each dirty page (0x21/0x22 addressing) and return.
+// If the previous frame is still on the bus, do nothing; the dirty ranges keep until next time.
 static void oled_flush(){
-  oled_cmd(0x21); oled_cmd(0); oled_cmd(127); // columns
-  oled_cmd(0x22); oled_cmd(0); oled_cmd(7);   // pages
-  i2c_start(); i2c_write((g_oledAddr<<1)|0); i2c_write(0x40);
-  for (uint16_t i=0;i<1024;i++) i2c_write(oledFB[i]);
-  i2c_stop();
+  PHASE(PH_OLED_FLUSH);
+#if PERF_STATS
+  const uint32_t t0 = micros();
+#endif
+  twiKick();                                  // resume a queue left behind by a NACK
+  const bool busy = twiBusy || twiHead != twiTail;
+  for (uint8_t p=0;p<8 && !busy;p++){
+    uint8_t lo=oledDirtyLo[p], hi=oledDirtyHi[p];
+    if (lo > hi) continue;                    // page unchanged
+    if (twiFree() < 2) break;                 // rest goes out next flush
+    uint8_t* w = oledWin[p];
+    w[0]=0x21; w[1]=lo; w[2]=hi;              // columns
+    w[3]=0x22; w[4]=p;  w[5]=p;               // this page only
+    twiQueue(0x00, w, 6);
+    twiQueue(0x40, &oledFB[p*128 + lo], hi - lo + 1);
+    oledDirtyLo[p]=0xFF; oledDirtyHi[p]=0;
+  }
+#if PERF_STATS
+  perfAdd(g_perf.flush, perfUs(t0));
+#endif
 }
 
-static inline void oled_pixel(uint8_t x,uint8_t y,bool on){
+// Replace h (<=16) vertical pixels of column x starting at y with 'bits' (LSB = top).
+// Whole framebuffer bytes (up to 3 pages); used for glyphs and the 0/1 cells, in place.
+static void oled_column(uint8_t x,uint8_t y,uint16_t bits,uint8_t h){
   if(x>127||y>63) return;
-  uint16_t i=(y>>3)*128 + x;
-  uint8_t  m=1<<(y&7);
-  if(on) oledFB[i]|=m; else oledFB[i]&=~m;
+  uint8_t  p=y>>3, sh=y&7;
+  uint32_t m=(((uint32_t)1<<h)-1) << sh;
+  uint32_t v=(uint32_t)bits << sh;
+  for (; m && p<8; p++, m>>=8, v>>=8)
+    if ((uint8_t)m) oled_write(p, x, (oledFB[p*128 + x] & ~(uint8_t)m) | (uint8_t)v);
 }
 
-// Simple line primitives (slow-but-simple: per-pixel loop)
+// Horizontal line: one mask, one byte write per column.
 static void oled_hline(uint8_t x0,uint8_t x1,uint8_t y,bool on){
   if(x1<x0) {uint8_t t=x0;x0=x1;x1=t;}
-  for(uint8_t x=x0;x<=x1;x++) oled_pixel(x,y,on);
-}
-static void oled_vline(uint8_t x,uint8_t y0,uint8_t y1,bool on){
-  if(y1<y0){uint8_t t=y0;y0=y1;y1=t;}
-  for(uint8_t y=y0;y<=y1;y++) oled_pixel(x,y,on);
+  if(y>63) return;
+  if(x1>127) x1=127;
+  const uint8_t p=y>>3, m=1<<(y&7);
+  const uint8_t* row=&oledFB[p*128];
+  for(uint8_t x=x0;x<=x1;x++) oled_write(p, x, on ? (row[x]|m) : (row[x]&~m));
 }
 
 // ========================= 5x7 font (subset) =========================
 // Add missing characters here as needed. Each glyph is 5 columns x 7 rows (LSB = top).
+// Characters must lie in FONT_FIRST..FONT_LAST (FONT_IDX is built from this table).
 struct G5x7 { char c; uint8_t col[5]; };
-static const G5x7 FONT_5x7[] PROGMEM = {
-  {' ',{0,0,0,0,0}}, {'/',{0x02,0x04,0x08,0x10,0x20}},
+static constexpr G5x7 FONT_5x7[] PROGMEM = {
+  {' ',{0,0,0,0,0}}, {'/',{0x02,0x04,0x08,0x10,0x20}}, {'.',{0x00,0x60,0x60,0x00,0x00}},
   {'0',{0x3E,0x51,0x49,0x45,0x3E}}, {'1',{0x00,0x42,0x7F,0x40,0x00}},
-  {'A',{0x7E,0x11,0x11,0x11,0x7E}}, {'D',{0x7F,0x41,0x41,0x22,0x1C}},
+  {'2',{0x42,0x61,0x51,0x49,0x46}}, {'3',{0x21,0x41,0x45,0x4B,0x31}},
+  {'4',{0x18,0x14,0x12,0x7F,0x10}}, {'5',{0x27,0x45,0x45,0x45,0x39}},
+  {'6',{0x3C,0x4A,0x49,0x49,0x30}}, {'7',{0x01,0x71,0x09,0x05,0x03}},
+  {'8',{0x36,0x49,0x49,0x49,0x36}}, {'9',{0x06,0x49,0x49,0x29,0x1E}},
+  {'A',{0x7E,0x11,0x11,0x11,0x7E}}, {'C',{0x3E,0x41,0x41,0x41,0x22}},
+  {'D',{0x7F,0x41,0x41,0x22,0x1C}}, {'H',{0x7F,0x08,0x08,0x08,0x7F}},
+  {'E',{0x7F,0x49,0x49,0x49,0x41}}, {'F',{0x7F,0x09,0x09,0x09,0x01}},
   {'I',{0x00,0x41,0x7F,0x41,0x00}}, {'J',{0x20,0x40,0x41,0x3F,0x01}},
+  {'K',{0x7F,0x08,0x14,0x22,0x41}}, {'L',{0x7F,0x40,0x40,0x40,0x40}},
   {'M',{0x7F,0x04,0x18,0x04,0x7F}}, {'N',{0x7F,0x08,0x10,0x20,0x7F}},
-  {'O',{0x3E,0x41,0x41,0x41,0x3E}}, {'R',{0x7F,0x09,0x19,0x29,0x46}},
-  {'T',{0x01,0x01,0x7F,0x01,0x01}}, {'X',{0x63,0x14,0x08,0x14,0x63}},
+  {'O',{0x3E,0x41,0x41,0x41,0x3E}}, {'P',{0x7F,0x09,0x09,0x09,0x06}},
+  {'Q',{0x3E,0x41,0x51,0x21,0x5E}},
+  {'R',{0x7F,0x09,0x19,0x29,0x46}},
+  {'S',{0x46,0x49,0x49,0x49,0x31}}, {'T',{0x01,0x01,0x7F,0x01,0x01}},
+  {'U',{0x3F,0x40,0x40,0x40,0x3F}}, {'W',{0x3F,0x40,0x38,0x40,0x3F}},
+  {'X',{0x63,0x14,0x08,0x14,0x63}},
   {'Y',{0x00,0x42,0x7F,0x40,0x00}}
 };
 
-// Draw text scaled by k (k=2 for labels inside the gate). Top-left at (x,y).
+// Direct lookup: FONT_IDX.i[ch - FONT_FIRST] = glyph number in FONT_5x7, 0xFF if missing.
+#define FONT_FIRST ' '
+#define FONT_LAST  'Y'
+#define FONT_GLYPHS (sizeof(FONT_5x7) / sizeof(FONT_5x7[0]))
+struct FontIndex { uint8_t i[FONT_LAST - FONT_FIRST + 1]; };
+constexpr FontIndex buildFontIndex(){
+  FontIndex f{};
+  for (uint8_t k = 0; k < sizeof(f.i); k++) f.i[k] = 0xFF;
+  for (uint8_t g = 0; g < FONT_GLYPHS; g++) f.i[FONT_5x7[g].c - FONT_FIRST] = g;
+  return f;
+}
+constexpr bool fontInRange(){
+  for (uint8_t g = 0; g < FONT_GLYPHS; g++)
+    if (FONT_5x7[g].c < FONT_FIRST || FONT_5x7[g].c > FONT_LAST) return false;
+  return true;
+}
+static_assert(fontInRange(), "FONT_5x7 glyph outside FONT_FIRST..FONT_LAST");
+static constexpr FontIndex FONT_IDX PROGMEM = buildFontIndex();
+
+// 2x scaling of a glyph column, a nibble at a time: DBL4[n] has every bit of n doubled.
+struct Dbl4 { uint8_t v[16]; };
+constexpr Dbl4 buildDbl4(){
+  Dbl4 d{};
+  for (uint8_t n = 0; n < 16; n++)
+    for (uint8_t b = 0; b < 4; b++) if (n & (1 << b)) d.v[n] |= 3 << (2*b);
+  return d;
+}
+static constexpr Dbl4 DBL4 PROGMEM = buildDbl4();
+
+// Glyph columns for ch in PROGMEM, or 0 if the font has no such character.
+static const uint8_t* findGlyph(char ch){
+  if (ch < FONT_FIRST || ch > FONT_LAST) return 0;
+  uint8_t g = pgm_read_byte(&FONT_IDX.i[ch - FONT_FIRST]);
+  return (g == 0xFF) ? 0 : FONT_5x7[g].col;
+}
+
+// Draw text scaled by k (1, or 2 for labels inside the gate). Top-left at (x,y).
+// Each glyph column is one oled_column() write (k=2: doubled via DBL4, written twice);
+// cells are replaced, not OR'd, including the 1-column gap between glyphs.
 static void text57_scaled(uint8_t x, uint8_t y, const char* s, uint8_t k){
   for (; *s; s++){
-    char ch = *s; const uint8_t* g = 0; uint8_t i;
-    for (i=0;i<sizeof(FONT_5x7)/sizeof(FONT_5x7[0]);i++){
-      if (pgm_read_byte(&FONT_5x7[i].c)==ch){ g = FONT_5x7[i].col; break; }
-    }
-    if (!g){ x += 6*k; continue; } // unknown char: skip width
-    for (uint8_t cx=0; cx<5; cx++){
-      uint8_t col = pgm_read_byte(&g[cx]);
-      for (uint8_t ry=0; ry<7; ry++){
-        if (col & (1<<ry)){
-          for (uint8_t dx=0; dx<k; dx++)
-            for (uint8_t dy=0; dy<k; dy++)
-              oled_pixel(x + cx*k + dx, y + ry*k + dy, true);
-        }
+    const uint8_t* g = findGlyph(*s);
+    if (g){
+      for (uint8_t cx=0; cx<5; cx++){
+        uint16_t col = pgm_read_byte(&g[cx]);
+        if (k == 2) col = pgm_read_byte(&DBL4.v[col & 15]) | (uint16_t)pgm_read_byte(&DBL4.v[col >> 4]) << 8;
+        for (uint8_t dx=0; dx<k; dx++) oled_column(x + cx*k + dx, y, col, 7*k);
       }
     }
+    if (s[1]) for (uint8_t dx=0; dx<k; dx++) oled_column(x + 5*k + dx, y, 0, 7*k);
     x += 6*k; // 5px glyph + 1px space, scaled
   }
 }
 
 // ========================= Gate drawing on OLED =========================
 
-// Draw a D-shaped gate body between (x0,y0) and (x1,y1).
+// --- Main geometry (nudge these to shift the whole drawing)
+static constexpr uint8_t GATE_X0 = 30;   // gate left edge
+static constexpr uint8_t GATE_X1 = 98;   // gate right edge
+static constexpr uint8_t GATE_Y0 = 10;   // top line
+static constexpr uint8_t GATE_Y1 = 54;   // bottom line
+
+// --- Outputs (right side). Keep these < 128 to stay on-screen.
+static constexpr uint8_t OUT_Y1 = 26, OUT_Y2 = 38;
+static constexpr uint8_t OUT_LINE_END = GATE_X1 + 12; // line length
+static constexpr uint8_t OUT_LBL_X    = GATE_X1 + 14; // label position
+static constexpr uint8_t OUT_BIT_X    = GATE_X1 + 25; // bit position ("0/1"), clear of the "/Y" label
+
+// --- Inputs (left side)
+static constexpr uint8_t IN_START = 14;            // where the legs begin
+static constexpr uint8_t IN_END   = GATE_X0 - 3;   // stop just before gate body
+static constexpr uint8_t IN_BIT_X = IN_START - 6;  // "0/1" indicator just left of the leg (avoid overlap)
+static constexpr uint8_t IN_Y[3]  = { 18, 32, 46 };
+
+// The D-shaped body and the two output lines are the same for every family, so they are
+// rendered at compile time into GATE_BG (PROGMEM): the framebuffer bytes of the window
+// columns BG_X0.. x pages BG_P0.., copied in byte by byte on a scene change.
 // If you want a wider/shorter body, tweak the loop that draws the curved end.
-static void drawDGateBody(uint8_t x0,uint8_t y0,uint8_t x1,uint8_t y1){
-  oled_hline(x0,x1-8,y0,true);
-  oled_hline(x0,x1-8,y1,true);
-  oled_vline(x0,y0,y1,true);
-  for(uint8_t i=0;i<14;i++){ // crude curve: a stack of short verticals
-    oled_vline(x1-8+i, y0+3+i/3, y1-3-i/3, true);
+static constexpr uint8_t BG_X0 = GATE_X0, BG_W = OUT_LINE_END - GATE_X0 + 1;
+static constexpr uint8_t BG_P0 = GATE_Y0 >> 3, BG_PAGES = (GATE_Y1 >> 3) - BG_P0 + 1;
+static_assert(GATE_X1 + 5 <= OUT_LINE_END && OUT_LINE_END < 128 && GATE_Y1 < 64, "gate outline leaves GATE_BG");
+
+struct GateBG { uint8_t b[BG_PAGES][BG_W]; };
+constexpr void bgPixel(GateBG& g, uint8_t x, uint8_t y){ g.b[(y >> 3) - BG_P0][x - BG_X0] |= 1 << (y & 7); }
+constexpr GateBG buildGateBG(){
+  GateBG g{};
+  for (uint8_t x = GATE_X0; x <= GATE_X1 - 8; x++) { bgPixel(g, x, GATE_Y0); bgPixel(g, x, GATE_Y1); }
+  for (uint8_t y = GATE_Y0; y <= GATE_Y1; y++) bgPixel(g, GATE_X0, y);
+  for (uint8_t i = 0; i < 14; i++)    // crude curve: a stack of short verticals
+    for (uint8_t y = GATE_Y0 + 3 + i/3; y <= GATE_Y1 - 3 - i/3; y++) bgPixel(g, GATE_X1 - 8 + i, y);
+  for (uint8_t x = GATE_X1; x <= OUT_LINE_END; x++) { bgPixel(g, x, OUT_Y1); bgPixel(g, x, OUT_Y2); }
+  return g;
+}
+static constexpr GateBG GATE_BG PROGMEM = buildGateBG();
+
+// Whole frame = GATE_BG inside its window, blank elsewhere. Only bytes that differ from
+// the current frame are marked dirty, so switching family re-sends little more than labels.
+static void oled_loadGateBG(){
+  for (uint8_t p=0;p<8;p++){
+    const bool inP = (uint8_t)(p - BG_P0) < BG_PAGES;
+    for (uint8_t x=0;x<128;x++){
+      uint8_t v = 0;
+      if (inP && (uint8_t)(x - BG_X0) < BG_W) v = pgm_read_byte(&GATE_BG.b[p - BG_P0][x - BG_X0]);
+      oled_write(p, x, v);
+    }
   }
 }
 
-// Helper to draw a single-bit "0/1" at (x,y)
+// Helper to draw a single-bit "0/1" at (x,y). Overwrites its 5x7 cell in place,
+// so an unchanged bit leaves the framebuffer (and the dirty ranges) untouched.
 static inline void drawBit(uint8_t x,uint8_t y,bool v){
-  if(v) text57_scaled(x,y,"1",1); else text57_scaled(x,y,"0",1);
+  const uint8_t* g = findGlyph(v ? '1' : '0');
+  for (uint8_t cx=0; cx<5; cx++) oled_column(x + cx, y, pgm_read_byte(&g[cx]), 7);
 }
 
-// Layout + labels. Adjust x0/x1 (and offsets) if you want to nudge things.
+// Layout + labels. Adjust GATE_X0/GATE_X1 (and offsets) if you want to nudge things.
 // In Dual NOT mode, only two input legs are drawn, aligned with outputs.
+// The static scene (GATE_BG, legs, labels) is only rebuilt when the family changes;
+// after that, each call just rewrites the 0/1 cells and flushes what changed.
+// Which scene is on the display (gate family, or OLED_SCENE_FILTER|...), for full redraws.
+#define OLED_SCENE_FILTER 0x80
+#define OLED_SCENE_CAPTURE 0x7F
+#define OLED_SCENE_PERF    0x7E
+static uint8_t g_oledScene = 0xFF;
+
 static void renderOLED(uint8_t gf, bool in1, bool in2, bool in3, bool /*in4_unused*/, bool Y, bool Yb){
-  oled_clear();
+  PHASE(PH_OLED_RENDER);
+  const bool full = (gf != g_oledScene);
+  g_oledScene = gf;
+
+  if (full) {
+    oled_loadGateBG();
+
+    // --- 4-char gate labels (padded with spaces), nudged left
+    const char* top="    ";
+    const char* bot="    ";
+    switch(gf){
+      case GF_ANDNAND: top = "AND "; bot = "NAND"; break;
+      case GF_ORNOR:   top = "OR  "; bot = "NOR "; break;
+      case GF_XORXNOR: top = "XOR "; bot = "XNOR"; break;
+      case GF_MAJMIN:  top = "MAJ "; bot = "MIN "; break;
+      case GF_DUALNOT: top = "NOT "; bot = "NOT "; break;
+      case GF_CUSTOM:  top = "USER"; bot = "LUT "; break;
+      case GF_DLATCH:  top = "D   "; bot = "LAT "; break;
+      case GF_DFF:     top = "D   "; bot = "FF  "; break;
+      case GF_JKFF:    top = "JK  "; bot = "FF  "; break;
+      case GF_TFF:     top = "T   "; bot = "FF  "; break;
+    }
+    text57_scaled(GATE_X0 + 8, 18, top, 2);  // move left/right by changing +8
+    text57_scaled(GATE_X0 + 8, 36, bot, 2);
+
+    if (gf == GF_DUALNOT) {
+      text57_scaled(OUT_LBL_X, OUT_Y1-2, "Y1", 1);
+      text57_scaled(OUT_LBL_X, OUT_Y2-2, "Y2", 1);
+      // Only two legs, aligned horizontally with outputs
+      oled_hline(IN_START, IN_END, OUT_Y1, true);
+      oled_hline(IN_START, IN_END, OUT_Y2, true);
+    } else {
+      const bool seq = isSeqFamily(gf);
+      text57_scaled(OUT_LBL_X, OUT_Y1-2, seq ? "Q"  : "Y",  1);
+      text57_scaled(OUT_LBL_X, OUT_Y2-2, seq ? "/Q" : "/Y", 1);
+      // Standard 3-input layout
+      for (uint8_t k=0; k<3; k++) oled_hline(IN_START, IN_END, IN_Y[k], true);
+    }
+  }
 
-  // --- Main geometry (nudge these to shift the whole drawing)
-  const uint8_t x0 = 30;   // gate left edge
-  const uint8_t x1 = 98;   // gate right edge
-  const uint8_t y0 = 10;   // top line
-  const uint8_t y1 = 54;   // bottom line
+  // --- Live bits (cheap; unchanged cells don't dirty anything)
+  drawBit(OUT_BIT_X, OUT_Y1-2, Y);
+  drawBit(OUT_BIT_X, OUT_Y2-2, Yb);
 
-  drawDGateBody(x0, y0, x1, y1);
+  if (gf == GF_DUALNOT) {
+    drawBit(IN_BIT_X, OUT_Y1-3, in1);
+    drawBit(IN_BIT_X, OUT_Y2-3, in2);
+  } else {
+    drawBit(IN_BIT_X, IN_Y[0]-3, in1);
+    drawBit(IN_BIT_X, IN_Y[1]-3, in2);
+    drawBit(IN_BIT_X, IN_Y[2]-3, in3);
+  }
 
-  // --- 4-char gate labels (padded with spaces), nudged left
-  const char* top="    ";
-  const char* bot="    ";
-  switch(gf){
-    case GF_ANDNAND: top = "AND "; bot = "NAND"; break;
-    case GF_ORNOR:   top = "OR  "; bot = "NOR "; break;
-    case GF_XORXNOR: top = "XOR "; bot = "XNOR"; break;
-    case GF_MAJMIN:  top = "MAJ "; bot = "MIN "; break;
-    case GF_DUALNOT: top = "NOT "; bot = "NOT "; break;
+  oled_flush();  // no-op when nothing changed
+  PHASE(PH_LOOP);
+}
+
+// ========================= Truth-table gate engine =========================
+// Each family is two 16-entry truth tables (Y and /Y). Table index = row bits
+// (bit0 = row 1 ... bit3 = row 4), exactly what rowsFromSnapshot() returns.
+// Built-in tables are generated at compile time from gateOut(); GF_CUSTOM comes
+// from EEPROM. In 3-input (OLED) mode row 4 reads as 0, so only entries 0..7 are used.
+
+// Rule for one output of a built-in family. 'four' = 4-input mode (no OLED).
+// These are written out so you can swap in different logic later (e.g. threshold k-of-n).
+constexpr bool gateOut(uint8_t gf, bool four, bool inv, uint8_t i) {
+  bool a = i & 1, b = i & 2, c = i & 4, d = four && (i & 8);
+  uint8_t n = a + b + c + d;
+  bool y = false;
+  switch (gf) {
+    case GF_ANDNAND: y = four ? (a & b & c & d) : (a & b & c); break;
+    case GF_ORNOR:   y = a | b | c | d;                        break;
+    case GF_XORXNOR: y = a ^ b ^ c ^ d;                        break;
+    case GF_MAJMIN:  y = n >= (four ? 3 : 2);                  break; // majority of 4 (>=3) / of 3
+    case GF_DUALNOT: return inv ? !c : !b;                            // two independent NOTs on rows 2 and 3
   }
-  text57_scaled(x0 + 8, 18, top, 2);  // move left/right by changing +8
-  text57_scaled(x0 + 8, 36, bot, 2);
+  return inv ? !y : y;
+}
 
-  // --- Outputs (right side). Keep these < 128 to stay on-screen.
-  const uint8_t oy1 = 26, oy2 = 38;
-  const uint8_t outLineEnd = x1 + 12; // line length
-  const uint8_t outLblX    = x1 + 14; // label position
-  const uint8_t outBitX    = x1 + 20; // bit position ("0/1")
+constexpr uint16_t buildTT(uint8_t gf, bool four, bool inv) {
+  uint16_t t = 0;
+  for (uint8_t i = 0; i < 16; i++) if (gateOut(gf, four, inv, i)) t |= (uint16_t)1 << i;
+  return t;
+}
 
-  oled_hline(x1, outLineEnd, oy1, true);
-  oled_hline(x1, outLineEnd, oy2, true);
+struct GateTT { uint16_t y, yb; };
+#define GATE_TT_ROW(four) { \
+  { buildTT(GF_ANDNAND, four, false), buildTT(GF_ANDNAND, four, true) }, \
+  { buildTT(GF_ORNOR,   four, false), buildTT(GF_ORNOR,   four, true) }, \
+  { buildTT(GF_XORXNOR, four, false), buildTT(GF_XORXNOR, four, true) }, \
+  { buildTT(GF_MAJMIN,  four, false), buildTT(GF_MAJMIN,  four, true) }, \
+  { buildTT(GF_DUALNOT, four, false), buildTT(GF_DUALNOT, four, true) } }
+static const GateTT GATE_TT[2][GF_CUSTOM] = { GATE_TT_ROW(false), GATE_TT_ROW(true) };
+
+// Build-time safety net: every family, every input combination, both modes.
+// Expected values are written out by hand (bit i = output when row bits == i), so a
+// slip in gateOut() fails the compile instead of shipping. In 3-input mode row 4 is
+// ignored, hence the repeated byte.
+#define CHECK_TT(gf, four, y, yb) \
+  static_assert(buildTT(gf, four, false) == (y) && buildTT(gf, four, true) == (yb), #gf " truth table")
+CHECK_TT(GF_ANDNAND, false, 0x8080, 0x7F7F);  // a&b&c
+CHECK_TT(GF_ORNOR,   false, 0xFEFE, 0x0101);  // a|b|c
+CHECK_TT(GF_XORXNOR, false, 0x9696, 0x6969);  // a^b^c
+CHECK_TT(GF_MAJMIN,  false, 0xE8E8, 0x1717);  // >=2 of 3
+CHECK_TT(GF_DUALNOT, false, 0x3333, 0x0F0F);  // !row2, !row3
+CHECK_TT(GF_ANDNAND, true,  0x8000, 0x7FFF);  // a&b&c&d
+CHECK_TT(GF_ORNOR,   true,  0xFFFE, 0x0001);  // a|b|c|d
+CHECK_TT(GF_XORXNOR, true,  0x6996, 0x9669);  // a^b^c^d
+CHECK_TT(GF_MAJMIN,  true,  0xE880, 0x177F);  // >=3 of 4
+CHECK_TT(GF_DUALNOT, true,  0x3333, 0x0F0F);  // !row2, !row3 (row 4 unused)
+#undef CHECK_TT
+
+static GateTT g_customTT = { 0x0000, 0xFFFF };  // loaded from EEPROM
+
+// Active lookup: g_lut[rows] = bit0 Y, bit1 /Y. One indexed load per evaluation.
+static uint8_t g_lut[16];
+
+// Last evaluated state, read by loop() for the LEDs/OLED.
+static volatile uint8_t g_rows = 0;   // bit0..3 = rows 1..4
+static volatile uint8_t g_outs = 0;   // bit0 = Y, bit1 = /Y
+
+// Sequential state. g_seq = active sequential family, or 0 for combinational (g_lut).
+static uint8_t g_seq = 0;
+static bool    g_q = false;        // CPU flip-flop (when the CCL sequencer isn't in use)
+static uint8_t g_prevRows = 0;     // rows at the previous evaluation, for clock edges
+
+// ========================= CCL hardware gate =========================
+// Routing is fixed by the silicon, so it only matches the V2 PCB pinout:
+//   LUT0: IN0 = EVENT0 <- ASYNCCH3 <- PA7 (row 3)
+//         IN1 = IO PA1 (row 1)
+//         IN2 = EVENT1 <- ASYNCCH0 <- PA5 (row 2)
+//         out -> ASYNCCH1 -> EVOUT1 (PB2 = O1A), EVOUT2 (PC2 = O1B)
+//   LUT1: IN0 = EVENT0 <- ASYNCCH3 (row 3), IN1 = EVENT1 <- ASYNCCH0 (row 2),
+//         IN2 = LINK (LUT0 output = Y), out -> alternate pin PC1 (O2C)
+// LUT0's own output pin (PA4) is the WS2812 data line, hence the event outputs.
+// Peripheral outputs override PORT OUT, so driveOutputs() can keep writing every pin.
+#if HW_GATE
+static_assert(IN_1A == PIN_PA1 && IN_2A == PIN_PA5 && IN_3A == PIN_PA7 &&
+              O1A == PIN_PB2 && O1B == PIN_PC2 && O2C == PIN_PC1,
+              "HW_GATE routing assumes the V2 PCB pinout");
+
+static bool g_hwGate = false;   // true while the CCL is driving O1A/O1B/O2C
+
+// Hand the CCL back to the CPU path.
+static void cclOff() {
+  CCL.CTRLA = 0;
+  CCL.SEQCTRL0 = CCL_SEQSEL_DISABLE_gc;
+  CCL.LUT0CTRLA = 0;
+  CCL.LUT1CTRLA = 0;
+  EVSYS.ASYNCUSER9  = EVSYS_ASYNCUSER_OFF_gc;
+  EVSYS.ASYNCUSER10 = EVSYS_ASYNCUSER_OFF_gc;
+  PORTMUX.CTRLA &= ~(PORTMUX_EVOUT1_bm | PORTMUX_EVOUT2_bm | PORTMUX_LUT1_bm);
+}
 
-  if (gf == GF_DUALNOT) {
-    text57_scaled(outLblX, oy1-2, "Y1", 1);
-    text57_scaled(outLblX, oy2-2, "Y2", 1);
+// Program both LUTs for a 3-input table (row bits index, bit0 = row 1).
+// Returns false (and leaves the CCL off) if /Y can't be built from LUT1's inputs.
+static bool cclConfigure(GateTT tt) {
+  uint8_t truth0 = 0, truth1 = 0, seen1 = 0;
+  for (uint8_t i = 0; i < 8; i++) {
+    bool r1 = i & 1, r2 = i & 2, r3 = i & 4;
+    bool y  = (tt.y  >> i) & 1;
+    bool yb = (tt.yb >> i) & 1;
+    uint8_t j0 = (uint8_t)r3 | ((uint8_t)r1 << 1) | ((uint8_t)r2 << 2);   // LUT0 index
+    uint8_t j1 = (uint8_t)r3 | ((uint8_t)r2 << 1) | ((uint8_t)y  << 2);   // LUT1 index
+    if (y) truth0 |= 1 << j0;
+    if ((seen1 >> j1) & 1) {
+      if (((truth1 >> j1) & 1) != yb) { cclOff(); return false; }   // /Y depends on row 1 alone
+    } else {
+      seen1 |= 1 << j1;
+      if (yb) truth1 |= 1 << j1;
+    }
+  }
+
+  CCL.CTRLA = 0;                  // LUT registers are enable-protected
+  EVSYS.ASYNCCH0 = EVSYS_ASYNCCH0_PORTA_PIN5_gc;   // row 2
+  EVSYS.ASYNCCH3 = EVSYS_ASYNCCH3_PORTA_PIN7_gc;   // row 3
+  EVSYS.ASYNCCH1 = EVSYS_ASYNCCH1_CCL_LUT0_gc;     // Y
+  EVSYS.ASYNCUSER2  = EVSYS_ASYNCUSER_ASYNCCH3_gc; // LUT0 EVENT0
+  EVSYS.ASYNCUSER4  = EVSYS_ASYNCUSER_ASYNCCH0_gc; // LUT0 EVENT1
+  EVSYS.ASYNCUSER3  = EVSYS_ASYNCUSER_ASYNCCH3_gc; // LUT1 EVENT0
+  EVSYS.ASYNCUSER5  = EVSYS_ASYNCUSER_ASYNCCH0_gc; // LUT1 EVENT1
+  EVSYS.ASYNCUSER9  = EVSYS_ASYNCUSER_ASYNCCH1_gc; // EVOUT1 = PB2
+  EVSYS.ASYNCUSER10 = EVSYS_ASYNCUSER_ASYNCCH1_gc; // EVOUT2 = PC2
+  PORTMUX.CTRLA |= PORTMUX_EVOUT1_bm | PORTMUX_EVOUT2_bm | PORTMUX_LUT1_bm;
+
+  CCL.SEQCTRL0  = CCL_SEQSEL_DISABLE_gc;
+  CCL.LUT0CTRLB = CCL_INSEL1_IO_gc | CCL_INSEL0_EVENT0_gc;
+  CCL.LUT0CTRLC = CCL_INSEL2_EVENT1_gc;
+  CCL.TRUTH0    = truth0;
+  CCL.LUT0CTRLA = CCL_ENABLE_bm;
+  CCL.LUT1CTRLB = CCL_INSEL1_EVENT1_gc | CCL_INSEL0_EVENT0_gc;
+  CCL.LUT1CTRLC = CCL_INSEL2_LINK_gc;
+  CCL.TRUTH1    = truth1;
+  CCL.LUT1CTRLA = CCL_OUTEN_bm | CCL_ENABLE_bm;
+  CCL.CTRLA = CCL_ENABLE_bm;
+  return true;
+}
+
+// Sequential families on the CCL sequencer. It takes LUT0 (D / J / T) and LUT1 (G / K),
+// is clocked by LUT0's IN2 (row 2), and its Q replaces LUT0's output on the event channel,
+// so Q reaches O1A/O1B with no CPU in the loop. /Q has no hardware pin here: LUT1 is busy
+// feeding the sequencer, so the PB2 (O1A) pin-change interrupt mirrors Q onto the O2 bus.
+//   LUT0: IN1 = IO PA1 (row 1), IN2 = EVENT1 <- ASYNCCH0 <- PA5 (row 2, clock)
+//   LUT1: IN0 = EVENT0 <- ASYNCCH3 <- PA7 (row 3, K) or PA1 (row 1, T)
+//         IN1 = EVENT1 <- ASYNCCH0 (row 2, latch enable)
+// Row 4 (clear) only exists in 4-input mode, where the CPU path runs instead.
+static bool cclConfigureSeq(uint8_t gf) {
+  uint8_t seq, truth1;
+  bool clocked = true;
+  switch (gf) {
+    case GF_DLATCH: seq = CCL_SEQSEL_LATCH_gc; truth1 = 0xCC; clocked = false; break; // G = row 2
+    case GF_DFF:    seq = CCL_SEQSEL_DFF_gc;   truth1 = 0xFF; break;                  // G = 1
+    case GF_JKFF:   seq = CCL_SEQSEL_JK_gc;    truth1 = 0xAA; break;                  // K = row 3
+    case GF_TFF:    seq = CCL_SEQSEL_JK_gc;    truth1 = 0xAA; break;                  // K = J = row 1
+    default: cclOff(); return false;
+  }
+
+  CCL.CTRLA = 0;                  // LUT registers are enable-protected
+  EVSYS.ASYNCCH0 = EVSYS_ASYNCCH0_PORTA_PIN5_gc;   // row 2
+  EVSYS.ASYNCCH3 = (gf == GF_TFF) ? EVSYS_ASYNCCH3_PORTA_PIN1_gc    // row 1 (T)
+                                  : EVSYS_ASYNCCH3_PORTA_PIN7_gc;   // row 3 (K)
+  EVSYS.ASYNCCH1 = EVSYS_ASYNCCH1_CCL_LUT0_gc;     // Q
+  EVSYS.ASYNCUSER2  = EVSYS_ASYNCUSER_OFF_gc;      // LUT0 EVENT0 unused
+  EVSYS.ASYNCUSER4  = EVSYS_ASYNCUSER_ASYNCCH0_gc; // LUT0 EVENT1 (clock)
+  EVSYS.ASYNCUSER3  = EVSYS_ASYNCUSER_ASYNCCH3_gc; // LUT1 EVENT0
+  EVSYS.ASYNCUSER5  = EVSYS_ASYNCUSER_ASYNCCH0_gc; // LUT1 EVENT1
+  EVSYS.ASYNCUSER9  = EVSYS_ASYNCUSER_ASYNCCH1_gc; // EVOUT1 = PB2
+  EVSYS.ASYNCUSER10 = EVSYS_ASYNCUSER_ASYNCCH1_gc; // EVOUT2 = PC2
+  PORTMUX.CTRLA = (PORTMUX.CTRLA & ~PORTMUX_LUT1_bm) | PORTMUX_EVOUT1_bm | PORTMUX_EVOUT2_bm;
+
+  CCL.LUT0CTRLB = CCL_INSEL1_IO_gc | CCL_INSEL0_MASK_gc;
+  CCL.LUT0CTRLC = CCL_INSEL2_EVENT1_gc;
+  CCL.TRUTH0    = 0xCC;           // = IN1 (row 1)
+  CCL.LUT0CTRLA = clocked ? (CCL_CLKSRC_bm | CCL_ENABLE_bm) : CCL_ENABLE_bm;
+  CCL.LUT1CTRLB = CCL_INSEL1_EVENT1_gc | CCL_INSEL0_EVENT0_gc;
+  CCL.LUT1CTRLC = CCL_INSEL2_MASK_gc;
+  CCL.TRUTH1    = truth1;
+  CCL.LUT1CTRLA = CCL_ENABLE_bm;  // feeds the sequencer only, no pin
+  CCL.SEQCTRL0  = seq;
+  CCL.CTRLA = CCL_ENABLE_bm;
+  return true;
+}
+#endif
+
+// Expand the active family's tables into g_lut. Call after probeOLED() (mode matters)
+// and whenever the family or custom tables change.
+static void applyGateFamily() {
+  const bool seq = isSeqFamily(g_gateFamily);
+  GateTT tt = { 0, 0 };
+  if (!seq) tt = (g_gateFamily == GF_CUSTOM) ? g_customTT : GATE_TT[g_hasOLED ? 0 : 1][g_gateFamily];
+  uint8_t lut[16];
+  for (uint8_t i = 0; i < 16; i++) {
+    lut[i] = ((tt.y >> i) & 1) | (((tt.yb >> i) & 1) << 1);
+  }
+  noInterrupts();                 // the output ISR reads g_lut / g_seq
+  memcpy(g_lut, lut, sizeof(lut));
+  g_seq = seq ? g_gateFamily : 0;
+  g_q = false;                    // flip-flops power up / switch in cleared
+  g_prevRows = g_rows;            // no phantom clock edge from the switch itself
+  interrupts();
+#if HW_GATE
+  // Hardware takes over in 3-input mode; 4-input needs row 4, which the CCL can't reach.
+  if (g_hasOLED) g_hwGate = seq ? cclConfigureSeq(g_gateFamily) : cclConfigure(tt);
+  else           { cclOff(); g_hwGate = false; }
+#if FAST_OUTPUT_ISR
+  // Sequencer output changes on its own (clock edge), so watch it to mirror /Q.
+  PORTB.PIN2CTRL = (PORTB.PIN2CTRL & ~PORT_ISC_gm) |
+                   ((g_hwGate && seq) ? PORT_ISC_BOTHEDGES_gc : PORT_ISC_INTDISABLE_gc);
+#endif
+#endif
+}
+
+// ========================= Input filters =========================
+// Each row has its own filter, one config byte (ConfigRecord.filter[row]):
+//   bits 7..6 = mode, bits 5..0 = parameter
+//   FILT_RAW   one snapshot, as seen by the pin-change ISR (gate-to-gate wiring)
+//   FILT_VOTE  N-of-M: M snapshots IN_GLITCH_US apart, true if >= N of them are (param N<<3 | M)
+//   FILT_INTEG integrating counter on the filter tick: +1 per high tick, -1 per low tick,
+//              output turns on at K and off at 0 (param K) - rides through contact bounce
+//   FILT_TICK  timer sampler: output follows once the input has read the same for K ticks
+//              in a row (param K)
+// INTEG/TICK rows are filtered all at once in the FILTER_TICK_US periodic interrupt (TCB1);
+// their pins stop raising pin-change interrupts, so bouncing jumpers cost nothing extra.
+// 0xFF (erased EEPROM) = "unset" -> FILT_DEFAULT, the old fixed 2-of-3 vote.
+#define FILT_RAW      0x00
+#define FILT_VOTE     0x40
+#define FILT_INTEG    0x80
+#define FILT_TICK     0xC0
+#define FILT_MODE_gm  0xC0
+#define FILT_PARAM_gm 0x3F
+#define FILT_NOFM(n, m) (FILT_VOTE | ((n) << 3) | (m))
+#define FILT_DEFAULT  FILT_NOFM(2, 3)
+#define FILTER_TICK_US 250
+
+static uint8_t g_filtCfg[4] = { FILT_DEFAULT, FILT_DEFAULT, FILT_DEFAULT, FILT_DEFAULT };
+
+// Derived by applyFilters(); read by updateOutputs() and the tick ISR.
+static uint8_t g_rawMask, g_voteMask, g_tickMask;   // row bits per filter kind (tick = INTEG|TICK)
+static uint8_t g_integMask;                          // tick rows that integrate (others: TICK)
+static uint8_t g_voteN[4], g_voteM[4], g_voteMaxM;
+static uint8_t g_tickK[4], g_tickCnt[4];
+static volatile uint8_t g_tickRows;                  // filtered state of INTEG/TICK rows
+
+// Presets offered on the OLED filter page (short press cycles them).
+struct FiltPreset { uint8_t cfg; const char* name; const char* detail; };
+static const FiltPreset FILT_PRESETS[] = {
+  { FILT_RAW,              "RAW ", "    " },
+  { FILT_NOFM(2, 3),       "2/3 ", "    " },
+  { FILT_NOFM(3, 5),       "3/5 ", "    " },
+  { FILT_NOFM(5, 7),       "5/7 ", "    " },
+  { FILT_INTEG | 8,        "INT ", "2MS " },   // 8 x 250 µs
+  { FILT_INTEG | 40,       "INT ", "10MS" },
+  { FILT_TICK  | 4,        "TMR ", "1MS " },
+  { FILT_TICK  | 20,       "TMR ", "5MS " },
+};
+#define FILT_PRESET_COUNT (sizeof(FILT_PRESETS) / sizeof(FILT_PRESETS[0]))
+
+// Index of cfg in FILT_PRESETS, or FILT_PRESET_COUNT if it was set some other way.
+static uint8_t filtPresetIndex(uint8_t cfg) {
+  for (uint8_t i = 0; i < FILT_PRESET_COUNT; i++) if (FILT_PRESETS[i].cfg == cfg) return i;
+  return FILT_PRESET_COUNT;
+}
+
+static bool filtValid(uint8_t cfg) {
+  uint8_t p = cfg & FILT_PARAM_gm;
+  switch (cfg & FILT_MODE_gm) {
+    case FILT_RAW:  return p == 0;
+    case FILT_VOTE: return (p & 7) && (p >> 3) && (p >> 3) <= (p & 7);
+    default:        return p != 0 && cfg != 0xFF;
+  }
+}
+
+// Read rows 1..4 through their filters. Interrupts must be masked (as for updateOutputs()).
+static inline uint8_t readRowsFiltered() {
+  uint8_t rows = rowsFromSnapshot(readPortsSnapshot());
+  uint8_t out = rows & g_rawMask;
+  if (g_voteMask) {
+    uint8_t cnt[4] = { 0, 0, 0, 0 };
+    for (uint8_t k = 0; k < g_voteMaxM; k++) {
+      if (k) { delayMicroseconds(IN_GLITCH_US); rows = rowsFromSnapshot(readPortsSnapshot()); }
+      for (uint8_t r = 0; r < 4; r++) if (k < g_voteM[r] && (rows & (1 << r))) cnt[r]++;
+    }
+    for (uint8_t r = 0; r < 4; r++)
+      if ((g_voteMask & (1 << r)) && cnt[r] >= g_voteN[r]) out |= 1 << r;
+  }
+  return out | (g_tickRows & g_tickMask);
+}
+
+// Rebuild the filter state from g_filtCfg. Call after initInputMasks() and on any change,
+// then enableInputInterrupts() so tick-filtered pins stop interrupting.
+static void applyFilters() {
+  uint8_t raw = rowsFromSnapshot(readPortsSnapshot());
+  noInterrupts();
+  g_rawMask = g_voteMask = g_tickMask = g_integMask = 0;
+  g_voteMaxM = 0;
+  uint8_t tickRows = 0;
+  for (uint8_t r = 0; r < 4; r++) {
+    uint8_t cfg = g_filtCfg[r], p = cfg & FILT_PARAM_gm, bit = 1 << r;
+    g_voteM[r] = 0;
+    switch (cfg & FILT_MODE_gm) {
+      case FILT_RAW:
+        g_rawMask |= bit;
+        break;
+      case FILT_VOTE:
+        g_voteMask |= bit;
+        g_voteN[r] = p >> 3;
+        g_voteM[r] = p & 7;
+        if (g_voteM[r] > g_voteMaxM) g_voteMaxM = g_voteM[r];
+        break;
+      default:                    // INTEG / TICK start settled on the current level
+        g_tickMask |= bit;
+        if ((cfg & FILT_MODE_gm) == FILT_INTEG) g_integMask |= bit;
+        g_tickK[r] = p;
+        g_tickCnt[r] = ((cfg & FILT_MODE_gm) == FILT_INTEG && (raw & bit)) ? p : 0;
+        tickRows |= raw & bit;
+        break;
+    }
+  }
+  g_tickRows = tickRows;
+  if (g_tickMask) {
+    TCB1.CCMP    = (F_CPU / 2000000UL) * FILTER_TICK_US - 1;
+    TCB1.CTRLB   = TCB_CNTMODE_INT_gc;
+    TCB1.INTCTRL = TCB_CAPT_bm;
+    TCB1.CTRLA   = TCB_CLKSEL_CLKDIV2_gc | TCB_ENABLE_bm;
   } else {
-    text57_scaled(outLblX, oy1-2, "Y",  1);
-    text57_scaled(outLblX, oy2-2, "/Y", 1);
+    TCB1.CTRLA   = 0;             // nothing to sample, no tick
+    TCB1.INTCTRL = 0;
   }
-  drawBit(outBitX, oy1-2, Y);
-  drawBit(outBitX, oy2-2, Yb);
+  interrupts();
+}
 
-  // --- Inputs (left side)
-  const uint8_t inStart = 14;           // where the legs begin
-  const uint8_t inEnd   = x0 - 3;       // stop just before gate body
-  const uint8_t bitX    = inEnd - 16;   // "0/1" indicator left of line end (avoid overlap)
+// OLED page for one row's filter (long-press MODE to get here). Shows the preset and the
+// row's live filtered level.
+static void renderFilterPage(uint8_t row, bool level) {
+  PHASE(PH_OLED_RENDER);
+  const uint8_t idx   = filtPresetIndex(g_filtCfg[row]);
+  const uint8_t scene = OLED_SCENE_FILTER | (row << 4) | idx;
+  if (scene != g_oledScene) {
+    g_oledScene = scene;
+    oled_clear();
+    char title[5] = "IN1 ";
+    title[2] = '1' + row;
+    text57_scaled(8, 4, title, 2);
+    text57_scaled(8, 26, idx < FILT_PRESET_COUNT ? FILT_PRESETS[idx].name   : "USER", 2);
+    text57_scaled(8, 46, idx < FILT_PRESET_COUNT ? FILT_PRESETS[idx].detail : "    ", 2);
+  }
+  drawBit(112, 30, level);
+  oled_flush();
+  PHASE(PH_LOOP);
+}
 
-  if (gf == GF_DUALNOT) {
-    // Only two legs, aligned horizontally with outputs
-    const uint8_t iy2[2] = { oy1, oy2 };
-    for (uint8_t k=0; k<2; k++) oled_hline(inStart, inEnd, iy2[k], true);
-    drawBit(bitX, oy1-3, in1);
-    drawBit(bitX, oy2-3, in2);
+// ========================= Capture (logic analyser) =========================
+// g_cap is laid out for the host: the programmer tool finds it in SRAM over UPDI by its
+// magic and decodes the header + events (little-endian). Keep the two in step.
+//   event.state: bit0..3 = rows 1..4, bit4 = Y, bit5 = /Y
+//   event time : hi:lo = TCB0 ticks (tickHz) since capture start, wraps after ~7 min
+#if CAPTURE
+static_assert((CAPTURE_DEPTH & (CAPTURE_DEPTH - 1)) == 0 && CAPTURE_DEPTH <= 128, "CAPTURE_DEPTH: power of two, <= 128");
+
+struct CapEvt { uint16_t lo, hi; uint8_t state; };
+struct CapBuf {
+  char     magic[4];       // "CAP1"
+  uint8_t  depth;          // CAPTURE_DEPTH
+  uint8_t  head;           // next slot to write
+  uint8_t  count;          // valid events (oldest = head - count)
+  uint8_t  running;        // 0 = HOLD
+  uint32_t tickHz;
+  CapEvt   e[CAPTURE_DEPTH];
+};
+static CapBuf g_cap = { {'C','A','P','1'}, CAPTURE_DEPTH, 0, 0, 0, F_CPU / 2, {} };
+static volatile uint16_t g_capHi;      // TCB0 wraps
+static uint8_t g_capLast = 0xFF;       // last recorded state (0xFF = record the next one)
+
+ISR(TCB0_INT_vect) {
+  TCB0.INTFLAGS = TCB_CAPT_bm;
+  g_capHi++;
+}
+
+// Current time in TCB0 ticks. Interrupts masked (a pending wrap is counted here).
+static inline uint32_t capNow() {
+  uint16_t lo = TCB0.CNT;
+  uint16_t hi = g_capHi;
+  if ((TCB0.INTFLAGS & TCB_CAPT_bm) && lo < 0x8000) hi++;
+  return ((uint32_t)hi << 16) | lo;
+}
+
+// Hot path (from updateOutputs(), interrupts masked). No change: a load and two compares.
+static inline void capRecord(uint8_t state) {
+  if (!g_cap.running || state == g_capLast) return;
+  g_capLast = state;
+  uint32_t t = capNow();
+  CapEvt& e = g_cap.e[g_cap.head];
+  e.lo = (uint16_t)t;
+  e.hi = (uint16_t)(t >> 16);
+  e.state = state;
+  g_cap.head = (g_cap.head + 1) & (CAPTURE_DEPTH - 1);
+  if (g_cap.count < CAPTURE_DEPTH) g_cap.count++;
+}
+
+// RUN starts a fresh recording from the current state; HOLD freezes the buffer.
+static void capSetRunning(bool run) {
+  noInterrupts();
+  if (run) {
+    TCB0.CTRLA = 0;
+    TCB0.CTRLB = TCB_CNTMODE_INT_gc;   // periodic: counts 0..CCMP, CAPT flag on wrap
+    TCB0.CCMP = 0xFFFF;
+    TCB0.CNT = 0;
+    TCB0.INTFLAGS = TCB_CAPT_bm;
+    TCB0.INTCTRL = TCB_CAPT_bm;
+    TCB0.CTRLA = TCB_CLKSEL_CLKDIV2_gc | TCB_ENABLE_bm;
+    g_capHi = 0;
+    g_cap.head = g_cap.count = 0;
+    g_capLast = 0xFF;
   } else {
-    // Standard 3-input layout
-    const uint8_t iy3[3] = { 18, 32, 46 };
-    for (uint8_t k=0; k<3; k++) oled_hline(inStart, inEnd, iy3[k], true);
-    drawBit(bitX, iy3[0]-3, in1);
-    drawBit(bitX, iy3[1]-3, in2);
-    drawBit(bitX, iy3[2]-3, in3);
+#if !PERF_STATS
+    TCB0.CTRLA = 0;                    // PERF_STATS keeps it counting for latency stamps
+#endif
+    TCB0.INTCTRL = 0;
   }
+  g_cap.running = run;
+  interrupts();
+}
+
+// OLED page: one trace per 8-px page (rows 1..3, Y, /Y), oldest event at the left edge,
+// newest (or 'now' while running) at the right. Each column is one byte per trace:
+// high = top line, low = bottom line, any edge inside the column = full-height bar,
+// so pulses shorter than a column still show. While running, the view may tear if
+// events arrive mid-render; HOLD gives a stable picture.
+#define CAP_X0 16   // waveform starts here (labels to the left)
+#define CAP_W  (128 - CAP_X0)
+
+static void renderCapturePage() {
+  PHASE(PH_OLED_RENDER);
+  if (g_oledScene != OLED_SCENE_CAPTURE) {
+    g_oledScene = OLED_SCENE_CAPTURE;
+    oled_clear();
+    static const char* const LBL[5] = { "1", "2", "3", "Y", "/Y" };
+    for (uint8_t t = 0; t < 5; t++) text57_scaled(0, 8 * (t + 1), LBL[t], 1);
+  }
+  text57_scaled(0, 0, g_cap.running ? "CAP RUN " : "CAP HOLD", 1);
+
+  noInterrupts();
+  const uint8_t count = g_cap.count, head = g_cap.head;
+  const uint32_t tNow = g_cap.running ? capNow() : 0;
+  interrupts();
+
+  const uint8_t first = (head - count) & (CAPTURE_DEPTH - 1);
+  auto evTime = [](uint8_t i) { return ((uint32_t)g_cap.e[i].hi << 16) | g_cap.e[i].lo; };
+  const uint32_t t0   = count ? evTime(first) : 0;
+  const uint32_t tEnd = g_cap.running ? tNow : (count ? evTime((head - 1) & (CAPTURE_DEPTH - 1)) : 0);
+  const uint32_t step = (tEnd - t0) / CAP_W + 1;
+
+  // Walk the events once, left to right.
+  uint8_t n = 0, i = first;
+  uint8_t state = count ? g_cap.e[first].state : 0;
+  uint32_t tc = t0;
+  for (uint8_t x = 0; x < CAP_W; x++, tc += step) {
+    uint8_t edges = 0;
+    while (n < count && evTime(i) <= tc) {
+      if (n) edges |= state ^ g_cap.e[i].state;
+      state = g_cap.e[i].state;
+      n++;
+      i = (i + 1) & (CAPTURE_DEPTH - 1);
+    }
+    for (uint8_t t = 0; t < 5; t++) {
+      const uint8_t bit = (t < 3) ? (1 << t) : (0x10 << (t - 3));
+      uint8_t v = 0;
+      if (count) v = (edges & bit) ? 0x7E : (state & bit) ? 0x02 : 0x40;
+      oled_write(t + 1, CAP_X0 + x, v);
+    }
+  }
+
+  // Span of the window: microseconds below 10 ms, else milliseconds.
+  uint32_t us = (tEnd - t0) / (g_cap.tickHz / 1000000UL);
+  char span[9] = "        ";
+  const bool ms = us >= 10000;
+  uint32_t v = ms ? us / 1000 : us;
+  uint8_t k = 5;
+  do { span[k--] = '0' + v % 10; v /= 10; } while (v && k < 6);
+  span[6] = ms ? 'M' : 'U';
+  span[7] = 'S';
+  text57_scaled(CAP_X0, 56, span, 1);
 
   oled_flush();
+  PHASE(PH_LOOP);
+}
+#endif
+
+// ========================= Gate evaluation + output path =========================
+// updateOutputs() is the whole input->output path: snapshot, row-OR, lookup, drive.
+// It runs from the PORTA/PORTB pin-change ISRs (FAST_OUTPUT_ISR) and once per loop()
+// pass with interrupts masked, so a missed edge or a family change is picked up too.
+
+// Sequential families: next Q from the rows (bit0 = D/J/T, bit1 = CLK/EN, bit2 = K, bit3 = CLR).
+// With the CCL sequencer active, Q is whatever the hardware put on O1A.
+// CPU fallback edges come from the pin-change ISR, so pulses shorter than its latency
+// (a few µs) can be missed; the hardware path has no such limit.
+static inline uint8_t seqEval(uint8_t rows) {
+  bool q;
+#if HW_GATE
+  if (g_hwGate) {
+    q = VPORTB.IN & PIN2_bm;      // O1A = PB2 (checked by the HW_GATE static_assert)
+  } else
+#endif
+  {
+    q = g_q;
+    const bool d = rows & 0x01, clk = rows & 0x02, k = rows & 0x04;
+    const bool rise = clk && !(g_prevRows & 0x02);
+    switch (g_seq) {
+      case GF_DLATCH: if (clk) q = d;                  break;
+      case GF_DFF:    if (rise) q = d;                 break;
+      case GF_JKFF:   if (rise) q = (d && !q) || (!k && q); break;
+      case GF_TFF:    if (rise && d) q = !q;           break;
+    }
+    if (rows & 0x08) q = false;   // row 4 = asynchronous clear
+    g_q = q;
+  }
+  g_prevRows = rows;
+  return q ? 0x01 : 0x02;
+}
+
+// Must run with interrupts masked (ISR context, or cli() in loop()).
+static void updateOutputs() {
+  uint8_t ph = PHASE_GET();        // may have interrupted another phase
+#if PERF_STATS
+  const uint16_t t0 = TCB0.CNT;
+#endif
+  PHASE(PH_SAMPLE);
+  uint8_t rows = readRowsFiltered();
+  PHASE(PH_EVAL);
+  uint8_t outs = g_seq ? seqEval(rows) : g_lut[rows];
+  PHASE(PH_DRIVE);
+  driveOutputs(outs & 0x01, outs & 0x02);
+#if PERF_STATS
+  if (rows != g_rows) perfAdd(g_perf.lat, TCB0.CNT - t0);
+#endif
+  g_rows = rows;
+  g_outs = outs;
+#if CAPTURE
+  capRecord(rows | (outs << 4));
+#endif
+  PHASE(ph);
+}
+
+// Enable both-edge sensing on every pin that feeds a row. Row 4 is excluded when the
+// OLED is present, so I2C traffic and the MODE button never trigger the output path.
+// Rows filtered on the tick (FILT_INTEG/FILT_TICK) are left to the tick interrupt.
+// Safe to call again after applyFilters().
+// NOTE: don't use attachInterrupt() in this sketch; it would claim the same port vectors.
+static void enableInputInterrupts() {
+  uint16_t all = g_rowMask[0] | g_rowMask[1] | g_rowMask[2] | g_rowMask[3];
+  uint16_t m = 0;
+  for (uint8_t r = 0; r < 4; r++) if (!(g_tickMask & (1 << r))) m |= g_rowMask[r];
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    volatile uint8_t* ca = &PORTA.PIN0CTRL + bit;
+    volatile uint8_t* cb = &PORTB.PIN0CTRL + bit;
+    uint8_t isa = (m & (1u << bit))    ? PORT_ISC_BOTHEDGES_gc : PORT_ISC_INTDISABLE_gc;
+    uint8_t isb = (m & (0x100u << bit)) ? PORT_ISC_BOTHEDGES_gc : PORT_ISC_INTDISABLE_gc;
+    if (all & (1u << bit))     *ca = (*ca & ~PORT_ISC_gm) | isa;
+    if (all & (0x100u << bit)) *cb = (*cb & ~PORT_ISC_gm) | isb;
+  }
+  PORTA.INTFLAGS = 0xFF;
+  PORTB.INTFLAGS = 0xFF;
+}
+
+// Filter tick: sample every row once and advance the INTEG/TICK filters bit-parallel.
+// Only a change of a filtered row re-evaluates the gate.
+ISR(TCB1_INT_vect) {
+  TCB1.INTFLAGS = TCB_CAPT_bm;
+  uint8_t raw = rowsFromSnapshot(readPortsSnapshot());
+  uint8_t out = g_tickRows;
+  for (uint8_t r = 0; r < 4; r++) {
+    uint8_t bit = 1 << r;
+    if (!(g_tickMask & bit)) continue;
+    uint8_t& c = g_tickCnt[r];
+    if (g_integMask & bit) {
+      if (raw & bit) { if (c < g_tickK[r] && ++c == g_tickK[r]) out |= bit; }
+      else           { if (c > 0 && --c == 0) out &= ~bit; }
+    } else {
+      if ((raw ^ out) & bit) { if (++c >= g_tickK[r]) { out ^= bit; c = 0; } }
+      else c = 0;
+    }
+  }
+  if (out != g_tickRows) { g_tickRows = out; updateOutputs(); }
+}
+
+#if FAST_OUTPUT_ISR
+// Clear flags first so an edge arriving during evaluation re-fires the ISR.
+ISR(PORTA_PORT_vect) { PORTA.INTFLAGS = PORTA.INTFLAGS; updateOutputs(); }
+ISR(PORTB_PORT_vect) { PORTB.INTFLAGS = PORTB.INTFLAGS; updateOutputs(); }
+#endif
+
+// ========================= Low power =========================
+#if LOW_POWER
+static volatile uint8_t g_pitTicks = 0;   // LED pacing while millis() may be stopped
+
+ISR(RTC_PIT_vect) {
+  RTC.PITINTFLAGS = RTC_PI_bm;
+  g_pitTicks++;
+}
+
+static void initLowPower() {
+  while (RTC.STATUS) {}           // RTC registers sync to the 32 kHz domain
+  RTC.CLKSEL = RTC_CLKSEL_INT32K_gc;
+  while (RTC.PITSTATUS) {}
+  RTC.PITCTRLA   = LOW_POWER_PIT | RTC_PITEN_bm;
+  RTC.PITINTCTRL = RTC_PI_bm;
+#if LOW_POWER_FAST_WAKE
+  _PROTECTED_WRITE(CLKCTRL.OSC20MCTRLA, CLKCTRL_RUNSTDBY_bm);
+#endif
+}
+
+// Sleep until loop() has work: the next PIT tick (LED frame) or, with the OLED, the next
+// millis() tick (button, display). Any interrupt wakes the CPU: a row edge, the PIT, or
+// (IDLE only) millis/TWI/filter tick. Row edges and filtered-row changes have already
+// driven the outputs in their ISR, so those wakes (4000/s from the filter tick alone)
+// go straight back to sleep here instead of running a loop() pass each.
+// Row edges in standby: BOTHEDGES sensing wakes from every pin, not only the async ones.
+static void sleepUntilEvent() {
+  PHASE(PH_IDLE);
+  bool idle = g_hasOLED || g_tickMask;
+#if CAPTURE
+  idle = idle || g_cap.running;   // TCB0 stops in standby
+#endif
+  set_sleep_mode(idle ? SLEEP_MODE_IDLE : SLEEP_MODE_STANDBY);
+  const uint8_t pit = g_pitTicks;
+  const uint32_t ms = g_hasOLED ? millis() : 0;
+  bool due;
+  do {
+    // Check and sleep with interrupts off: a tick landing in between is taken at 'sei; sleep'
+    // and wakes the CPU at once, instead of being slept through until the next one.
+    noInterrupts();
+    due = g_pitTicks != pit || (g_hasOLED && millis() != ms);
+    if (!due) {
+      sleep_enable();
+      interrupts();
+      sleep_cpu();
+      sleep_disable();
+    }
+    interrupts();
+  } while (!due);
+}
+#endif
+
+// ========================= Config record =========================
+// Everything the user can set, as one 16-byte record at EE_CONFIG. The programmer tool
+// builds the same bytes (build_config_record() in BreadboarDGeniuSLogicGateProgrammer.py)
+// and writes them over UPDI; the new function takes effect at the reset that follows.
+// Multi-byte fields are little-endian. crc = CRC-16 (avr-libc _crc16_update, init 0xFFFF)
+// over all bytes before it. Newer versions may only append fields in 'reserved';
+// older firmware then still accepts the record and ignores them.
+#define CFG_MAGIC   0x47   // 'G'
+#define CFG_VERSION 1
+
+struct ConfigRecord {
+  uint8_t  magic;          // CFG_MAGIC
+  uint8_t  version;        // CFG_VERSION that wrote it
+  uint8_t  family;         // GateFamily
+  uint8_t  filter[4];      // FILT_* config of rows 1..4
+  uint8_t  brightness;     // WS2812 scale, 255 = full (0 = LEDs off)
+  uint16_t ttY, ttYb;      // GF_CUSTOM truth tables
+  uint8_t  reserved[2];    // 0xFF
+  uint16_t crc;
+};
+static_assert(sizeof(ConfigRecord) == 16 && offsetof(ConfigRecord, crc) == 14, "ConfigRecord layout is shared with the programmer tool");
+
+static uint16_t crc16(const void* data, uint8_t n){
+  const uint8_t* p = (const uint8_t*)data;
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < n; i++) crc = _crc16_update(crc, p[i]);
+  return crc;
 }
 
-// ========================= Logic helpers for 4-input mode =========================
-// These are factored so you can swap in different logic later if you want (e.g. threshold k-of-n).
-static inline bool evalY_AND(bool a,bool b,bool c,bool d){ return a & b & c & d; }
-static inline bool evalY_OR (bool a,bool b,bool c,bool d){ return a | b | c | d; }
-static inline bool evalY_XOR(bool a,bool b,bool c,bool d){ return (a ^ b ^ c ^ d); }
-static inline bool evalY_MAJ(bool a,bool b,bool c,bool d){ uint8_t s=a+b+c+d; return s >= 3; } // majority of 4
+static uint16_t cfgCrc(const ConfigRecord& c){ return crc16(&c, offsetof(ConfigRecord, crc)); }
 
 // ========================= EEPROM helpers =========================
 
-static inline void loadSettings(){
+// No valid record: erased EEPROM, or a module from before the record, which stored only
+// the family byte. Everything else takes its default (custom tables Y = 0, /Y = 1).
+static inline void loadLegacySettings(){
   uint8_t v = EEPROM.read(EE_GATE_FAMILY);
 	if (v >= GF__COUNT) v = FACTORY_DEFAULT_GATE;
   g_gateFamily = v;
+  g_customTT.y  = 0x0000;
+  g_customTT.yb = 0xFFFF;
+  for (uint8_t r = 0; r < 4; r++) g_filtCfg[r] = FILT_DEFAULT;
+}
+
+static inline void loadSettings(){
+  ConfigRecord c;
+  EEPROM.get(EE_CONFIG, c);
+  if (c.magic != CFG_MAGIC || c.version == 0 || c.crc != cfgCrc(c)) {
+    loadLegacySettings();   // erased EEPROM or an older module: family only, rest default
+    return;
+  }
+  // A valid record can still carry a value this build doesn't know (e.g. a newer family).
+  uint8_t v = c.family;
+  if (v >= GF__COUNT) v = FACTORY_DEFAULT_GATE;
+  g_gateFamily = v;
+  for (uint8_t r = 0; r < 4; r++) g_filtCfg[r] = filtValid(c.filter[r]) ? c.filter[r] : FILT_DEFAULT;
+  g_ledBrightness = c.brightness;
+  g_customTT.y  = c.ttY;
+  g_customTT.yb = c.ttYb;
 }
 
 static inline void saveSettings(){
-  EEPROM.update(EE_GATE_FAMILY, g_gateFamily);
+  ConfigRecord c;
+  c.magic = CFG_MAGIC;
+  c.version = CFG_VERSION;
+  c.family = g_gateFamily;
+  memcpy(c.filter, g_filtCfg, sizeof(c.filter));
+  c.brightness = g_ledBrightness;
+  c.ttY  = g_customTT.y;
+  c.ttYb = g_customTT.yb;
+  memset(c.reserved, 0xFF, sizeof(c.reserved));
+  c.crc = cfgCrc(c);
+  EEPROM.put(EE_CONFIG, c);   // byte-wise update: only changed bytes are written
+}
+
+// ========================= Performance page =========================
+// The worst cases are kept in EEPROM (EE_PERF) as one CRC-checked record, so a module can
+// be read back after a session in the field: on the PERF page, or over UPDI.
+// Wear: perfLoopEnd() checks at most every PERF_SAVE_MS, and only a worst case that grew
+// by more than 1/8 is written (EEPROM.put() updates byte-wise). Each field can therefore
+// only grow about 90 times between 1 µs and its 16-bit limit, however long the module runs.
+#if PERF_STATS
+#define PERF_MAGIC   0x50   // 'P'
+#define PERF_VERSION 1
+
+struct PerfRecord {
+  uint8_t  magic;          // PERF_MAGIC
+  uint8_t  version;        // PERF_VERSION that wrote it
+  uint16_t loopMax;        // µs
+  uint16_t ledsMax;        // µs
+  uint16_t flushMax;       // µs
+  uint16_t latMax;         // 0.1 µs
+  uint16_t crc;            // CRC-16 of the bytes before it, as ConfigRecord
+};
+static_assert(EE_PERF >= EE_CONFIG + sizeof(ConfigRecord), "EE_PERF overlaps the config record");
+
+static PerfRecord g_perfSaved;
+static uint32_t g_perfSecT, g_perfSaveT;
+
+static void perfLoad() {
+  EEPROM.get(EE_PERF, g_perfSaved);
+  if (g_perfSaved.magic != PERF_MAGIC || g_perfSaved.crc != crc16(&g_perfSaved, offsetof(PerfRecord, crc)))
+    memset(&g_perfSaved, 0, sizeof(g_perfSaved));   // erased EEPROM: nothing seen yet
+}
+
+// Larger than the saved worst case by more than 1/8?
+static inline bool perfGrew(uint16_t live, uint16_t& saved) {
+  if (live <= saved + (saved >> 3)) return false;
+  saved = live;
+  return true;
+}
+
+static void perfSave() {
+  noInterrupts();
+  const uint16_t lat = g_perf.lat.max;
+  interrupts();
+  PerfRecord r = g_perfSaved;
+  bool grew = perfGrew(g_perf.loop.max, r.loopMax);
+  grew |= perfGrew(g_perf.leds.max, r.ledsMax);
+  grew |= perfGrew(g_perf.flush.max, r.flushMax);
+  grew |= perfGrew(perfTenths(lat), r.latMax);
+  if (!grew) return;
+  r.magic = PERF_MAGIC;
+  r.version = PERF_VERSION;
+  r.crc = crc16(&r, offsetof(PerfRecord, crc));
+  EEPROM.put(EE_PERF, r);
+  g_perfSaved = r;
+}
+
+// Live counters start from here (boot, or a short press on the PERF page).
+// TCB0 runs free from 0 to 0xFFFF; CAPTURE may already have started it the same way.
+static void perfReset() {
+  noInterrupts();
+  if (!(TCB0.CTRLA & TCB_ENABLE_bm)) {
+    TCB0.CTRLB = TCB_CNTMODE_INT_gc;
+    TCB0.CCMP  = 0xFFFF;
+    TCB0.CTRLA = TCB_CLKSEL_CLKDIV2_gc | TCB_ENABLE_bm;
+  }
+  memset(&g_perf, 0, sizeof(g_perf));
+  interrupts();
+  g_perfSecT = millis();
+}
+
+// End of one loop() pass (just before it sleeps or returns).
+static void perfLoopEnd(uint32_t t0) {
+  perfAdd(g_perf.loop, perfUs(t0));
+  g_perf.passes++;
+  const uint32_t now = millis();     // stops in STANDBY: per awake second there
+  if (now - g_perfSecT >= 1000) {
+    g_perf.perSec = g_perf.passes;
+    g_perf.passes = 0;
+    g_perfSecT = now;
+  }
+  if (now - g_perfSaveT >= PERF_SAVE_MS) {
+    g_perfSaveT = now;
+    perfSave();                      // after this pass was measured
+  }
+}
+
+// v right-aligned in a 7-character field at x (1x font); tenths = one decimal place.
+static void perfField(uint8_t x, uint8_t y, uint32_t v, bool tenths) {
+  char s[8] = "       ";
+  uint8_t k = 6;
+  if (tenths) { s[k--] = '0' + v % 10; s[k--] = '.'; v /= 10; }
+  do { s[k] = '0' + v % 10; v /= 10; } while (v && k--);
+  text57_scaled(x, y, s, 1);
+}
+
+// OLED page: one line per counter, recent mean and worst since the last clear; the
+// bottom two lines are the worst cases saved in EEPROM. Numbers redraw every PERF_PAGE_MS.
+#define PERF_PAGE_MS 250
+#define PERF_X1 42    // mean column
+#define PERF_X2 84    // max column
+
+static void renderPerfPage() {
+  PHASE(PH_OLED_RENDER);
+  static uint32_t lastDraw = 0;
+  const bool full = g_oledScene != OLED_SCENE_PERF;
+  if (full) {
+    g_oledScene = OLED_SCENE_PERF;
+    oled_clear();
+    static const char* const LBL[6] = { "LOOP/S", "LOOP", "LED", "OLED", "LAT", "EE MAX" };
+    for (uint8_t i = 0; i < 6; i++) text57_scaled(0, 8 * (i + 1), LBL[i], 1);
+    text57_scaled(0, 0, "PERF US", 1);
+    text57_scaled(PERF_X1 + 18, 0, "MEAN", 1);
+    text57_scaled(PERF_X2 + 24, 0, "MAX", 1);
+    text57_scaled(PERF_X1 + 18, 48, "LOOP", 1);
+    text57_scaled(PERF_X2 + 24, 48, "LAT", 1);
+  }
+  if (full || millis() - lastDraw >= PERF_PAGE_MS) {
+    lastDraw = millis();
+    noInterrupts();
+    const PerfCounters c = g_perf;
+    interrupts();
+    perfField(PERF_X1, 8, c.perSec, false);
+    const PerfStat* const st[3] = { &c.loop, &c.leds, &c.flush };
+    for (uint8_t i = 0; i < 3; i++) {
+      perfField(PERF_X1, 16 + 8 * i, st[i]->mean16 >> 4, false);
+      perfField(PERF_X2, 16 + 8 * i, st[i]->max, false);
+    }
+    perfField(PERF_X1, 40, perfTenths(c.lat.mean16 >> 4), true);
+    perfField(PERF_X2, 40, perfTenths(c.lat.max), true);
+    perfField(PERF_X1, 56, g_perfSaved.loopMax, false);
+    perfField(PERF_X2, 56, g_perfSaved.latMax, true);
+  }
+  oled_flush();
+  PHASE(PH_LOOP);
 }
+#endif
 
 // ========================= Setup =========================
 
@@ -450,9 +1757,14 @@ void setup() {
   // Outputs
   pinMode(O1A, OUTPUT); pinMode(O1B, OUTPUT); pinMode(O1C, OUTPUT);
   pinMode(O2A, OUTPUT); pinMode(O2B, OUTPUT); pinMode(O2C, OUTPUT);
+  initOutputMasks();
+
+  // Restore last family and settings (defaults to FACTORY_DEFAULT_GATE on first boot)
+  loadSettings();
 
   // WS2812 init
   leds.begin();
+  leds.setBrightness(g_ledBrightness);
   leds.clear();
   ledsShowSafe();
 
@@ -467,72 +1779,156 @@ void setup() {
     delay(10);
   }
 
-  // Restore last family (defaults to AND/NAND on first boot)
-  loadSettings();
 
   // Probe OLED after the wait (using pull-ups on I2C lines)
   g_hasOLED = probeOLED();
   if (g_hasOLED) {
-    oled_begin();
+    oled_begin();   // switches PB1/PB0 over to TWI0
   }
+
+  // Row masks and the 3- vs 4-input truth tables depend on whether row 4 is free.
+  initInputMasks();
+  applyGateFamily();
+  applyFilters();
+
+#if CAPTURE
+  if (CAPTURE_AT_BOOT) capSetRunning(true);
+#endif
+
+#if PERF_STATS
+  perfLoad();
+  perfReset();    // boot (startup animation, OLED probe) is not counted
+#endif
+
+  // Drive the outputs once, then let pin changes take over.
+  noInterrupts(); updateOutputs(); interrupts();
+#if FAST_OUTPUT_ISR
+  enableInputInterrupts();
+#endif
+#if LOW_POWER
+  initLowPower();
+#endif
 }
 
 // ========================= Main loop =========================
 
-void loop() {
-  // ----- Read inputs and aggregate rows -----
-  // Rows: OR across pins in that row (any active pin makes that row=1).
-  const uint8_t row1[] = {IN_1A, IN_1B, IN_1C}; bool in1 = rowOR_arr(row1, 3);
-  const uint8_t row2[] = {IN_2A, IN_2B};        bool in2 = rowOR_arr(row2, 2);
-  const uint8_t row3[] = {IN_3A, IN_3B};        bool in3 = rowOR_arr(row3, 2);
-  bool in4 = false;
+#if CAPTURE
+  #define PAGE_CAPTURE 4
+#endif
+#if PERF_STATS
+  #define PAGE_PERF    (4 + CAPTURE)
+#endif
+#define PAGE_COUNT     (4 + CAPTURE + PERF_STATS)
 
-  if (!g_hasOLED) {
-    // Only use row-4 when OLED is NOT present (pins are free).
-    const uint8_t row4[] = {IN_4A, IN_4B, IN_4C};
-    in4 = rowOR_arr(row4, 3);
-  }
+void loop() {
+  PHASE(PH_LOOP);  // a PH_IDLE->PH_LOOP write marks the start of each pass
+#if PERF_STATS
+  const uint32_t perfT0 = micros();
+#endif
 
   // ----- Mode button (only when OLED present) -----
-  // IN_4A acts as a simple mode-cycle button (edge detect).
-  static bool lastBtn = false;
+  // IN_4A acts as the MODE button (debounced). Long press (BTN_LONG_MS) = next page,
+  // short press (on release) = next gate family / next filter preset for the page's row.
+  static bool lastBtn = false, rawBtn = false, longDone = false;
+  static uint32_t btnT = 0, pressT = 0;
+  static uint8_t page = 0;          // 0 = gate, 1..3 = input filter of row 1..3, PAGE_CAPTURE, PAGE_PERF
   if (g_hasOLED) {
-    bool btn = readStable(IN_4A);
-    if (btn && !lastBtn) {
-      g_gateFamily = (g_gateFamily + 1) % GF__COUNT;
-      saveSettings(); // persists across power cycles
+    bool b = readPortsStable() & g_btnMask;
+    if (b != rawBtn) { rawBtn = b; btnT = millis(); }
+    if (rawBtn != lastBtn && (millis() - btnT) >= BTN_DEBOUNCE_MS) {
+      lastBtn = rawBtn;
+      if (lastBtn) {
+        pressT = millis();
+        longDone = false;
+      } else if (!longDone) {
+        if (page == 0) {
+          g_gateFamily = (g_gateFamily + 1) % GF__COUNT;
+          saveSettings(); // persists across power cycles
+          applyGateFamily();
+#if CAPTURE
+        } else if (page == PAGE_CAPTURE) {
+          capSetRunning(!g_cap.running);
+#endif
+#if PERF_STATS
+        } else if (page == PAGE_PERF) {
+          perfReset();
+#endif
+        } else {
+          uint8_t r = page - 1;
+          uint8_t i = filtPresetIndex(g_filtCfg[r]) + 1;
+          if (i >= FILT_PRESET_COUNT) i = 0;
+          g_filtCfg[r] = FILT_PRESETS[i].cfg;
+          saveSettings();
+          applyFilters();
+#if FAST_OUTPUT_ISR
+          enableInputInterrupts();
+#endif
+        }
+      }
+    }
+    if (lastBtn && !longDone && (millis() - pressT) >= BTN_LONG_MS) {
+      longDone = true;
+      page = (page + 1) % PAGE_COUNT;
+#if CAPTURE
+      if (page == PAGE_CAPTURE && !g_cap.running && !g_cap.count) capSetRunning(true);  // arm on first visit
+#endif
     }
-    lastBtn = btn;
   }
 
-  // ----- Evaluate logic -----
-  // Two branches: 3-input mode (OLED present) vs. 4-input mode (no OLED).
-  bool Y=false, Yb=false;
-  if (g_hasOLED) {
-    // 3-input: rows 1..3 only
-    bool a=in1, b=in2, c=in3;
-    switch (g_gateFamily) {
-      case GF_ANDNAND: Y = (a & b & c);     Yb = !Y; break;
-      case GF_ORNOR:   Y = (a | b | c);     Yb = !Y; break;
-      case GF_XORXNOR: Y = (a ^ b ^ c);     Yb = !Y; break;
-      case GF_MAJMIN:  Y = ((a+b+c) >= 2);  Yb = !Y; break; // majority of 3
-      case GF_DUALNOT: Y = !b;              Yb = !c; break; // two independent NOTs on rows 1 and 2
-    }
-  } else {
-    // 4-input: rows 1..4
-    bool a=in1, b=in2, c=in3, d=in4;
-    switch (g_gateFamily) {
-      case GF_ANDNAND: Y = evalY_AND(a,b,c,d);  Yb = !Y; break;
-      case GF_ORNOR:   Y = evalY_OR(a,b,c,d);   Yb = !Y; break;
-      case GF_XORXNOR: Y = evalY_XOR(a,b,c,d);  Yb = !Y; break;
-      case GF_MAJMIN:  Y = evalY_MAJ(a,b,c,d);  Yb = !Y; break; // majority of 4 (>=3)
-      case GF_DUALNOT: Y = !b;                  Yb = !c; break; // two independent NOTs on rows 1 and 2
-    }
+  // ----- Inputs -> logic -> output buses -----
+  // With FAST_OUTPUT_ISR this is only a safety net; pin changes already drove the buses.
+  noInterrupts();
+  updateOutputs();
+  uint8_t rows = g_rows, outs = g_outs;
+  interrupts();
+
+  bool in1 = rows & 0x01;
+  bool in2 = rows & 0x02;
+  bool in3 = rows & 0x04;
+  bool in4 = rows & 0x08;
+  bool Y   = outs & 0x01;
+  bool Yb  = outs & 0x02;
+
+  // ----- Background refresh (rate-limited so it never holds up the logic) -----
+  uint32_t now = millis();
+
+  static uint32_t lastOled = 0;
+  if (g_hasOLED && (now - lastOled) >= OLED_REFRESH_MS) {
+    lastOled = now;
+    if (page == 0) renderOLED(g_gateFamily, in1,in2,in3,false, Y, Yb);
+#if CAPTURE
+    else if (page == PAGE_CAPTURE) renderCapturePage();
+#endif
+#if PERF_STATS
+    else if (page == PAGE_PERF)    renderPerfPage();
+#endif
+    else           renderFilterPage(page - 1, rows & (1 << (page - 1)));
   }
 
-  // ----- Drive output buses -----
-  setBus(O1A, O1B, O1C, Y);
-  setBus(O2A, O2B, O2C, Yb);
+#if LOW_POWER
+  // At most one LED frame per PIT tick, otherwise straight back to sleep
+  // (millis() doesn't advance in standby). ledsShowSafe() drops unchanged frames.
+  static uint8_t lastPit = 0;
+  const uint8_t pit = g_pitTicks;
+  if (pit == lastPit) {
+#if PERF_STATS
+    perfLoopEnd(perfT0);
+#endif
+    sleepUntilEvent();
+    return;
+  }
+  lastPit = pit;
+#else
+  static uint32_t lastLed = 0;
+  if ((now - lastLed) < LED_REFRESH_MS) {
+#if PERF_STATS
+    perfLoopEnd(perfT0);
+#endif
+    PHASE(PH_IDLE);
+    return;
+  }
+  lastLed = now;
+#endif
 
   // ----- Update LEDs -----
   showInputLED(LED_IN1, in1);
@@ -553,43 +1949,145 @@ void loop() {
   // Center LED = family color (steady after boot)
   setCenterColorByGate(g_gateFamily);
 
-  // ----- OLED UI (if present) -----
-  if (g_hasOLED) {
-    renderOLED(g_gateFamily, in1,in2,in3,false, Y, Yb);
-  }
-
   // ----- Push pixels (respecting latch time) -----
   ledsShowSafe();
+#if PERF_STATS
+  perfLoopEnd(perfT0);
+#endif
+#if LOW_POWER
+  sleepUntilEvent();
+#else
+  PHASE(PH_IDLE);
+#endif
 }
 
 /* ========================= Developer Notes =========================
 
 1) Faster/slower input feel?
-   - readStable() currently samples 3x with 80 µs spacing (total ~160 µs).
-   - Reduce spacing to ~20–40 µs for snappier response; increase for noise immunity.
-   - Or change majority threshold (e.g., 2-of-3) to be stricter/looser.
+   - Each row has its own filter (see "Input filters"). Long-press MODE to reach the
+     row's page, short-press to cycle: RAW, 2/3, 3/5, 5/7 vote, INT 2/10 ms, TMR 1/5 ms.
+   - RAW for rows driven by other gates (no added delay); INT or TMR for jumpers and
+     switches (bounce is absorbed by the tick interrupt, the pin stops interrupting).
+   - Votes take whole-port snapshots IN_GLITCH_US apart, so all rows vote at once.
+   - Row 4 (4-input mode) has no page; set it with the programmer's "Set function".
+   - Rows are OR'd with masks built in initInputMasks() from the IN_* aliases.
 
 2) OLED tweaks:
-   - Move the gate: change x0/x1 in renderOLED().
-   - Longer/shorter legs: inStart, inEnd.
-   - Move labels: the x0 + 8 offsets for text57_scaled().
+   - Move the gate: change GATE_X0/GATE_X1 (GATE_BG is re-rendered at compile time).
+   - Longer/shorter legs: IN_START, IN_END.
+   - Move labels: the GATE_X0 + 8 offsets for text57_scaled().
+   - A family change rebuilds the frame from GATE_BG with byte writes; a steady frame only
+     rewrites the five 0/1 cells (a few column bytes each).
    - Want bigger labels? Change the scale factor from 2 to 3 (and re-space).
 
 3) Add a new gate family:
-   - Append to GateFamily enum; bump GF__COUNT.
+   - Append to GateFamily enum before GF_CUSTOM; bump GF__COUNT.
    - Add color in setCenterColorByGate().
    - Add label text in renderOLED()’s switch.
-   - Add logic in both switch blocks in loop() (3-input and 4-input paths).
+   - Add its rule to gateOut() and a line to GATE_TT_ROW; the tables build at compile time.
+   - Or skip all that: select USER and write the two truth tables into the config record
+     (ttY / ttYb, bit i = output when row bits == i), e.g. with the programmer's "Set function".
+   - Sequential families go after GF_CUSTOM: add the rule to seqEval() and, for the
+     hardware path, a case to cclConfigureSeq().
 
 4) WS2812 current + brightness:
    - We drive modest intensities (64 max channel) to keep current reasonable.
+   - The config record's brightness scales all of them (255 = as written, 0 = LEDs off).
    - If you raise these, ensure your 5 V rail + decoupling can handle it.
 
-5) Startup delay:
+5) OLED bus speed:
+   - OLED_TWI_HZ selects 400 kHz or 1 MHz (Fast-mode Plus). A full 1 KB frame takes
+     ~25 ms at 400 kHz; a typical bit change is one short page window.
+   - The probe at boot is still bit-banged; if no display ACKs, TWI0 is never enabled
+     and PB1/PB0 go back to plain INPUT for row 4.
+
+6) Startup delay:
    - 1 s is safe for common SSD1306 modules. If your OLEDs are faster,
      shorten the loop in setup().
 
-6) EEPROM wear:
-   - We only write when family changes (EEPROM.update avoids redundant writes).
+7) EEPROM wear:
+   - We only write when family or a filter changes; EEPROM.put() updates byte-wise, so a
+     change costs the changed field plus the 2 CRC bytes.
+   - Old modules keep their family: with no valid record, loadSettings() reads the
+     legacy family byte (EE_GATE_FAMILY), and the first save writes the record.
+   - The PERF_STATS worst cases (EE_PERF) are written at most once per PERF_SAVE_MS, and
+     only when one has grown by more than 1/8; see "Performance page".
+
+8) Measuring timing:
+   - Set PHASE_TRACE 1 and record GPIOR0 in an AVR simulator (or mirror it to a pin).
+     PH_SAMPLE/PH_EVAL/PH_DRIVE bracket the input->output path, PH_LEDS the WS2812
+     push, PH_OLED_RENDER/PH_OLED_FLUSH the display. PH_IDLE->PH_LOOP = one loop() pass.
+   - Edge-to-output latency = input pin edge to O1A/O2A edge in the same trace.
+   - Host Tests/gate_bench does this on the host MCU model for every family, with and
+     without the OLED: scripted input edges, then min/mean/p99/max of the loop() pass,
+     edge->O1A/O2A and each phase, and a non-zero exit when one is above
+     Host Tests/bench_baseline.txt (ctest -L bench). The model only charges time for
+     waits, micros()/millis(), the WS2812 push and TWI bytes, so PH_EVAL/PH_DRIVE read 0
+     there; instruction-level cycles still need the simulator.
+
+9) Output latency:
+   - FAST_OUTPUT_ISR=1: a pin change fires PORTA/PORTB_PORT_vect, which re-samples,
+     evaluates and drives the O1/O2 buses in a few µs. Worst case it waits for a WS2812 push
+     (interrupts off ~220 µs), which only happens when a pixel changed, at most every
+     LED_REFRESH_MS.
+   - OLED traffic is sent by the TWI0 ISR (a few µs per byte), so it never delays the outputs.
+   - Raise LED_REFRESH_MS / OLED_REFRESH_MS for fewer stalls, lower them for snappier UI.
+   - ledsShowSafe() skips frames identical to the last one pushed, so a steady gate never
+     masks interrupts for the LEDs at all.
+
+10) Hardware gate (HW_GATE):
+   - O1A/O1B (Y) and O2C (/Y) come straight from the CCL: tens of ns, even while a WS2812
+     push has interrupts off. Use these pins when chaining gates for speed.
+   - O1C/O2A/O2B are mirrored by the ISR as in 9), and lag the hardware pins by µs.
+   - Only IN_1A/IN_2A/IN_3A count as inputs; the B/C pins of each row are ignored.
+   - The input filters only apply to the CPU side; the CCL sees the pins unfiltered.
+   - USER tables only go to hardware when /Y is a function of Y, row 2 and row 3
+     (e.g. any /Y = NOT Y); otherwise, and in 4-input mode, the CPU path runs as before.
+
+11) Sequential families (D latch, D FF, JK FF, T FF):
+   - Row 1 = D / J / T, row 2 = CLK (rising edge; enable for the latch), row 3 = K,
+     row 4 = clear (4-input mode only). Q on O1*, /Q on O2*. State starts cleared.
+   - With HW_GATE in 3-input mode the CCL sequencer does the clocking, and Q on O1A/O1B
+     changes within ns of the CLK edge; /Q follows via the PB2 interrupt (µs).
+   - Otherwise the pin-change ISR detects CLK edges and keeps Q in software.
+
+12) Supply current (LOW_POWER):
+   - Standby between events (4-input modules without tick filters): the CPU only wakes for
+     a row edge (ISR drives the outputs, as always) and 64x/s for the LED check.
+   - With OLED, or INT/TMR filters, IDLE instead: millis(), TWI0 and TCB1 keep running.
+     Their interrupts wake the CPU for a few µs each (TCB1: 4000/s), but sleepUntilEvent()
+     puts it straight back; loop() itself runs 64x/s, or once per millis() tick with OLED.
+   - LOW_POWER_FAST_WAKE 0 for the lowest standby current if a few µs of extra latency
+     on the first edge after a quiet period is acceptable.
+   - If you switch megaTinyCore's millis() timer to the RTC, pick another LED pacing source.
+
+13) Capture (CAPTURE):
+   - Every state change seen by updateOutputs() (rows 1..4, Y, /Y) goes into g_cap with a
+     32-bit TCB0 time stamp (F_CPU/2). The last CAPTURE_DEPTH events are kept.
+   - Not armed at boot (CAPTURE_AT_BOOT 1 arms it). OLED: long-press to the CAP page, which
+     arms it; short press toggles RUN/HOLD (RUN starts afresh).
+     The window spans the oldest to the newest event; its length is shown at the bottom.
+   - Host: 'BreadboarDGeniuSLogicGateProgrammer.py --dump-capture out.vcd' reads g_cap
+     over UPDI (the firmware keeps running) and writes a VCD for GTKWave/PulseView.
+     There is no UART dump: every pin is a row, an output or the LED/OLED bus.
+   - Time stamps are taken just after the outputs are driven, so they include the
+     input->output latency of the path that saw the edge (ISR or loop). Edges faster
+     than that path are merged into one event.
+   - TCB0 is shared with PERF_STATS (same free-running setup); it stops in STANDBY, so
+     capture keeps the MCU in IDLE.
+
+14) Performance counters (PERF_STATS):
+   - OLED: long-press to the PERF page; short press clears the live counters.
+     LOOP/S = loop() passes in the last second. LOOP, LED, OLED = µs per loop() pass,
+     per WS2812 push, per oled_flush(): recent mean and worst since the last clear.
+     LAT = updateOutputs() on an input change, from sampling the rows to driving the pins.
+   - LAT does not include the wait for the ISR itself. Add the LED max when the LEDs mask
+     interrupts, or the LOOP max with FAST_OUTPUT_ISR 0. The CCL pins (HW_GATE) are faster
+     than anything measured here.
+   - EE MAX = worst LOOP and LAT ever saved. The record (PerfRecord at EE_PERF, 12 bytes)
+     also holds the LED and OLED worst cases, and can be read over UPDI from modules
+     without an OLED. Erase the EEPROM to start it afresh.
+   - Cost: a few micros() reads per pass and two TCB0 reads per output update. The PERF
+     page redraws its numbers every PERF_PAGE_MS; that rendering shows up in LOOP too.
 
 ==================================================================== */